@@ -0,0 +1,133 @@
+#include "Attribute.hpp"
+#include "util/Parallel.hpp"
+#include <atomic>
+#include <cstring>
+
+namespace meshlib {
+
+AttributeColumn &AttributeColumn::operator=(const AttributeColumn &other) {
+    if (this == &other) {
+        return *this;
+    }
+    _name = other._name;
+    _valueSize = other._valueSize;
+    _size = other._size;
+    if (!other._chunks || resource() == other.resource()) {
+        _chunks = other._chunks;
+    } else {
+        _chunks = std::allocate_shared<Chunks>(std::pmr::polymorphic_allocator<Chunks>(resource()), *other._chunks);
+    }
+    return *this;
+}
+
+AttributeColumn &AttributeColumn::operator=(AttributeColumn &&other) {
+    if (resource() != other.resource()) {
+        return *this = other;
+    }
+    _name = std::move(other._name);
+    _valueSize = other._valueSize;
+    _size = other._size;
+    _chunks = std::move(other._chunks);
+    return *this;
+}
+
+AttributeColumn::Chunks &AttributeColumn::uniqueChunks() {
+    std::pmr::polymorphic_allocator<Chunks> allocator(resource());
+    if (!_chunks) {
+        _chunks = std::allocate_shared<Chunks>(allocator);
+    } else if (_chunks.use_count() != 1) {
+        _chunks = std::allocate_shared<Chunks>(allocator, *_chunks);
+    } else {
+        std::atomic_thread_fence(std::memory_order_acquire);
+    }
+    return *_chunks;
+}
+
+void AttributeColumn::resize(size_t count) {
+    size_t oldByteCount = _size * _valueSize;
+    size_t byteCount = count * _valueSize;
+    uniqueChunks().resize((byteCount + sizeof(Chunk) - 1) / sizeof(Chunk));
+    if (byteCount > oldByteCount) {
+        // the tail of the last chunk may hold values from before a shrink
+        memset(data() + oldByteCount, 0, byteCount - oldByteCount);
+    }
+    _size = count;
+}
+
+int AttributeSet::indexOf(std::string_view name) const {
+    for (size_t i = 0; i < _columns.size(); ++i) {
+        if (_columns[i].name() == name) {
+            return int(i);
+        }
+    }
+    return -1;
+}
+
+int AttributeSet::find(std::string_view name, size_t valueSize) const {
+    int index = indexOf(name);
+    return index >= 0 && _columns[index].valueSize() == valueSize ? index : -1;
+}
+
+int AttributeSet::add(std::string_view name, size_t valueSize) {
+    if (indexOf(name) >= 0) {
+        return find(name, valueSize);
+    }
+    auto &column = _columns.emplace_back(name, valueSize);
+    column.resize(_elementCount);
+    return int(_columns.size() - 1);
+}
+
+void AttributeSet::remove(std::string_view name) {
+    int index = indexOf(name);
+    if (index >= 0) {
+        _columns.erase(_columns.begin() + index);
+    }
+}
+
+void AttributeSet::resize(size_t elementCount) {
+    for (auto &column : _columns) {
+        column.resize(elementCount);
+    }
+    _elementCount = elementCount;
+}
+
+void AttributeSet::assignCompacted(const AttributeSet &source, const std::vector<int32_t> &newIndices, size_t newCount) {
+    _columns.clear();
+    _elementCount = newCount;
+    for (auto &sourceColumn : source._columns) {
+        auto &column = _columns.emplace_back(sourceColumn.name(), sourceColumn.valueSize());
+        column.resize(newCount);
+        size_t valueSize = column.valueSize();
+        auto data = column.data();
+        auto sourceData = sourceColumn.data();
+        parallelFor(0, newIndices.size(), [&](size_t i) {
+            if (newIndices[i] >= 0) {
+                memcpy(data + newIndices[i] * valueSize, sourceData + i * valueSize, valueSize);
+            }
+        });
+    }
+}
+
+void AttributeSet::append(const AttributeSet &other) {
+    size_t offset = _elementCount;
+    for (auto &otherColumn : other._columns) {
+        add(otherColumn.name(), otherColumn.valueSize());
+    }
+    resize(_elementCount + other._elementCount);
+    for (auto &otherColumn : other._columns) {
+        int index = find(otherColumn.name(), otherColumn.valueSize());
+        if (index < 0 || otherColumn.size() == 0) {
+            // same name with another value size, or nothing to copy
+            continue;
+        }
+        auto &column = _columns[index];
+        memcpy(column.data() + offset * column.valueSize(), otherColumn.data(), otherColumn.size() * otherColumn.valueSize());
+    }
+}
+
+void AttributeSet::clear() {
+    _columns.clear();
+    _elementCount = 0;
+}
+
+} // namespace meshlib
@@ -0,0 +1,112 @@
+#pragma once
+#include "Handle.hpp"
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace meshlib {
+
+// Typed reference to a custom attribute column of a Mesh, e.g. Attribute<VertexHandle, glm::vec4> for vertex colors.
+// Stays valid until an attribute of the same element type is removed.
+template <typename THandle, typename T>
+struct Attribute {
+    static_assert(std::is_trivially_copyable_v<T>, "attribute values are copied as bytes");
+    static_assert(alignof(T) <= 16, "attribute storage is 16-byte aligned");
+
+    Attribute() : index(-1) {}
+    explicit Attribute(int index) : index(index) {}
+    bool isValid() const { return index >= 0; }
+    int index;
+};
+
+// One value per element, stored as raw bytes so that the mesh can copy, compact and serialize columns of any type.
+// Copies with the same memory resource share the values until one of them writes (see CowVector); unlike the element
+// arrays a column is shared as a whole, so that data() stays one contiguous array.
+class AttributeColumn {
+  public:
+    using allocator_type = std::pmr::polymorphic_allocator<std::byte>;
+
+    AttributeColumn() = default;
+    explicit AttributeColumn(const allocator_type &allocator) : _name(allocator) {}
+    AttributeColumn(std::string_view name, size_t valueSize, const allocator_type &allocator)
+        : _name(name, allocator), _valueSize(valueSize) {}
+    AttributeColumn(const AttributeColumn &other, const allocator_type &allocator) : AttributeColumn(allocator) { *this = other; }
+    AttributeColumn(AttributeColumn &&other, const allocator_type &allocator) : AttributeColumn(allocator) { *this = std::move(other); }
+    // like the std::pmr containers, a plain copy uses the default resource
+    AttributeColumn(const AttributeColumn &other) : AttributeColumn(other, allocator_type()) {}
+    AttributeColumn(AttributeColumn &&) = default;
+    AttributeColumn &operator=(const AttributeColumn &other);
+    AttributeColumn &operator=(AttributeColumn &&other);
+
+    const std::pmr::string &name() const { return _name; }
+    size_t valueSize() const { return _valueSize; }
+    size_t size() const { return _size; }
+
+    // copies the values first if they are shared
+    std::byte *data() { return reinterpret_cast<std::byte *>(uniqueChunks().data()); }
+    const std::byte *data() const { return _chunks ? reinterpret_cast<const std::byte *>(_chunks->data()) : nullptr; }
+
+    // new values are zero
+    void resize(size_t count);
+
+  private:
+    struct alignas(16) Chunk {
+        std::byte bytes[16];
+    };
+    using Chunks = std::pmr::vector<Chunk>;
+
+    std::pmr::memory_resource *resource() const { return _name.get_allocator().resource(); }
+    Chunks &uniqueChunks();
+
+    std::pmr::string _name;
+    size_t _valueSize = 0;
+    size_t _size = 0;
+    std::shared_ptr<Chunks> _chunks;
+};
+
+// The custom attribute columns of one element type. Columns always have one value per element, including deleted
+// elements; Mesh keeps them in step when elements are added, compacted or merged.
+class AttributeSet {
+  public:
+    using allocator_type = std::pmr::polymorphic_allocator<std::byte>;
+
+    AttributeSet() = default;
+    explicit AttributeSet(const allocator_type &allocator) : _columns(allocator) {}
+    AttributeSet(const AttributeSet &other, const allocator_type &allocator) : AttributeSet(allocator) { *this = other; }
+    AttributeSet(AttributeSet &&other, const allocator_type &allocator) : AttributeSet(allocator) { *this = std::move(other); }
+    AttributeSet(const AttributeSet &) = default;
+    AttributeSet(AttributeSet &&) = default;
+    AttributeSet &operator=(const AttributeSet &) = default;
+    AttributeSet &operator=(AttributeSet &&) = default;
+
+    size_t columnCount() const { return _columns.size(); }
+    AttributeColumn &column(int index) { return _columns[index]; }
+    const AttributeColumn &column(int index) const { return _columns[index]; }
+
+    // index of the column with this name and value size, -1 if there is none
+    int find(std::string_view name, size_t valueSize) const;
+    // adds a zero-filled column, or returns the existing one with this name; -1 if that one has another value size
+    int add(std::string_view name, size_t valueSize);
+    // shifts the indices of the following columns
+    void remove(std::string_view name);
+
+  private:
+    friend class Mesh;
+
+    int indexOf(std::string_view name) const;
+    void resize(size_t elementCount);
+    // this = source without the elements mapped to -1 in newIndices
+    void assignCompacted(const AttributeSet &source, const std::vector<int32_t> &newIndices, size_t newCount);
+    // appends the elements of other; columns are matched by name, missing values are zero
+    void append(const AttributeSet &other);
+    void clear();
+
+    size_t _elementCount = 0;
+    std::pmr::vector<AttributeColumn> _columns;
+};
+
+} // namespace meshlib
@@ -11,6 +11,7 @@ struct Handle {
     explicit Handle(int index) : index(index) {}
     bool operator==(const Handle &other) const { return index == other.index; }
     bool operator!=(const Handle &other) const { return !operator==(other); }
+    bool operator<(const Handle &other) const { return index < other.index; }
     int index;
 };
 
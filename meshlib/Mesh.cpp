@@ -1,24 +1,153 @@
 #include "Mesh.hpp"
+#include "util/Instrumentation.hpp"
+#include "util/Parallel.hpp"
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <numeric>
+#include <tuple>
+#include <utility>
 #include <range/v3/action/erase.hpp>
 #include <range/v3/algorithm/find.hpp>
 #include <range/v3/algorithm/find_if.hpp>
 
 namespace meshlib {
 
+namespace {
+
+// Groups references by target with a counting sort; the sources of each target stay in ascending order
+template <typename TSource>
+class BackReferences {
+  public:
+    explicit BackReferences(size_t targetCount) : _offsets(targetCount + 1, 0) {}
+
+    void count(int target) { ++_offsets[target + 1]; }
+
+    void allocate() {
+        for (size_t i = 1; i < _offsets.size(); ++i) {
+            _offsets[i] += _offsets[i - 1];
+        }
+        _sources.resize(_offsets.back());
+        _positions.assign(_offsets.begin(), _offsets.end() - 1);
+    }
+
+    void add(int target, TSource source) { _sources[_positions[target]++] = source; }
+
+    template <typename TContainer>
+    void assignSources(size_t target, TContainer &container) const {
+        container.assign(_sources.begin() + _offsets[target], _sources.begin() + _offsets[target + 1]);
+    }
+
+  private:
+    std::vector<int> _offsets;
+    std::vector<int> _positions;
+    std::vector<TSource> _sources;
+};
+
+// Removes handles of deleted elements and renumbers the rest
+template <typename THandles>
+void remapHandles(THandles &handles, const std::vector<int32_t> &newIndices) {
+    auto out = handles.begin();
+    for (auto handle : handles) {
+        int newIndex = newIndices[handle.index];
+        if (newIndex >= 0) {
+            out->index = newIndex;
+            ++out;
+        }
+    }
+    handles.erase(out, handles.end());
+}
+
+template <typename TList, typename THandle>
+bool contains(const TList &list, THandle handle) {
+    return std::find(list.begin(), list.end(), handle) != list.end();
+}
+
+template <typename TList>
+bool hasDuplicates(const TList &list) {
+    if (list.size() > 16) {
+        // e.g. the pole of a sphere
+        std::vector<int> indices;
+        indices.reserve(list.size());
+        for (auto handle : list) {
+            indices.push_back(handle.index);
+        }
+        std::sort(indices.begin(), indices.end());
+        return std::adjacent_find(indices.begin(), indices.end()) != indices.end();
+    }
+    for (size_t i = 0; i < list.size(); ++i) {
+        for (size_t j = i + 1; j < list.size(); ++j) {
+            if (list[i] == list[j]) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+} // namespace
+
+const char *meshIssueTypeName(MeshIssue::Type type) {
+    switch (type) {
+    case MeshIssue::Type::InvalidReference:
+        return "InvalidReference";
+    case MeshIssue::Type::DeletedReference:
+        return "DeletedReference";
+    case MeshIssue::Type::MissingBackReference:
+        return "MissingBackReference";
+    case MeshIssue::Type::DuplicateReference:
+        return "DuplicateReference";
+    case MeshIssue::Type::DuplicateEdge:
+        return "DuplicateEdge";
+    case MeshIssue::Type::DuplicateFace:
+        return "DuplicateFace";
+    case MeshIssue::Type::DegenerateEdge:
+        return "DegenerateEdge";
+    case MeshIssue::Type::DegenerateFace:
+        return "DegenerateFace";
+    case MeshIssue::Type::NonManifoldEdge:
+        return "NonManifoldEdge";
+    case MeshIssue::Type::NonManifoldVertex:
+        return "NonManifoldVertex";
+    }
+    return "";
+}
+
+uint64_t Mesh::newTopologyVersion() {
+    static std::atomic<uint64_t> lastVersion{0};
+    return lastVersion.fetch_add(1, std::memory_order_relaxed) + 1;
+}
+
+Mesh::Mesh(std::pmr::memory_resource *resource)
+    : _vertices(resource), _uvPoints(resource), _edges(resource), _faces(resource), _positions(resource), _uvPositions(resource),
+      _selection(resource), _vertexAttributes(resource), _uvPointAttributes(resource), _edgeAttributes(resource),
+      _faceAttributes(resource) {}
+
+Mesh::Mesh(const Mesh &other, std::pmr::memory_resource *resource)
+    : _vertices(other._vertices, resource), _uvPoints(other._uvPoints, resource), _edges(other._edges, resource),
+      _faces(other._faces, resource), _positions(other._positions, resource), _uvPositions(other._uvPositions, resource),
+      _selection(other._selection, resource), _vertexAttributes(other._vertexAttributes, resource),
+      _uvPointAttributes(other._uvPointAttributes, resource), _edgeAttributes(other._edgeAttributes, resource),
+      _faceAttributes(other._faceAttributes, resource) {}
+
 VertexHandle Mesh::addVertex(glm::vec3 position) {
-    VertexData vertexData;
-    vertexData.position = position;
+    MESHLIB_COUNT(VerticesAdded, 1);
+    changeTopology();
     auto vertex = VertexHandle(uint32_t(_vertices.size()));
-    _vertices.push_back(vertexData);
+    _vertices.emplace_back();
+    _positions.push_back(position);
+    _selection.push_back(false);
+    _vertexAttributes.resize(_vertices.size());
     return vertex;
 }
 
 UVPointHandle Mesh::addUVPoint(VertexHandle v, glm::vec2 position) {
-    UVPointData uvPointData;
-    uvPointData.uvPosition = position;
-    uvPointData.vertex = v;
+    MESHLIB_COUNT(UVPointsAdded, 1);
+    changeTopology();
     auto uvPoint = UVPointHandle(uint32_t(_uvPoints.size()));
-    _uvPoints.push_back(uvPointData);
+    _uvPoints.emplace_back().vertex = v;
+    _uvPositions.push_back(position);
+    _uvPointAttributes.resize(_uvPoints.size());
     _vertices[v.index].uvPoints.push_back(uvPoint);
     return uvPoint;
 }
@@ -26,6 +155,7 @@ UVPointHandle Mesh::addUVPoint(VertexHandle v, glm::vec2 position) {
 EdgeHandle Mesh::addEdge(const std::array<VertexHandle, 2> &vertices) {
     // check if edge already exists
     for (auto edge : edges(vertices[0])) {
+        MESHLIB_COUNT(DuplicateCheckIterations, 1);
         auto edgeVertices = this->vertices(edge);
         if (edgeVertices == vertices || edgeVertices == std::array{vertices[1], vertices[0]}) {
             // same edge found
@@ -33,21 +163,30 @@ EdgeHandle Mesh::addEdge(const std::array<VertexHandle, 2> &vertices) {
         }
     }
 
-    EdgeData edgeData;
-    edgeData.vertices = vertices;
+    MESHLIB_COUNT(EdgesAdded, 1);
+    changeTopology();
     auto edge = EdgeHandle(uint32_t(_edges.size()));
-    _edges.push_back(edgeData);
+    _edges.emplace_back().vertices = vertices;
+    _edgeAttributes.resize(_edges.size());
     vertexData(vertices[0]).edges.push_back(edge);
     vertexData(vertices[1]).edges.push_back(edge);
 
     // split faces
     {
-        std::unordered_set<FaceHandle> facesToCheckSplit;
+        // called for every edge of every added face, so the candidate list lives on the stack
+        std::byte buffer[1024];
+        std::pmr::monotonic_buffer_resource temporaries(buffer, sizeof(buffer));
+        std::pmr::vector<FaceHandle> facesToCheckSplit(&temporaries);
         for (auto v : vertices) {
-            for (auto face : faces(v)) {
-                facesToCheckSplit.insert(face);
+            for (auto uvPoint : uvPoints(v)) {
+                for (auto face : faces(uvPoint)) {
+                    facesToCheckSplit.push_back(face);
+                }
             }
         }
+        std::sort(facesToCheckSplit.begin(), facesToCheckSplit.end());
+        facesToCheckSplit.erase(std::unique(facesToCheckSplit.begin(), facesToCheckSplit.end()), facesToCheckSplit.end());
+        MESHLIB_COUNT(FacesScannedForSplit, facesToCheckSplit.size());
 
         std::vector<FaceHandle> facesToRemove;
         std::vector<std::tuple<std::vector<UVPointHandle>, std::vector<UVPointHandle>, MaterialHandle>> faceAdditions;
@@ -87,7 +226,8 @@ EdgeHandle Mesh::addEdge(const std::array<VertexHandle, 2> &vertices) {
 FaceHandle Mesh::addFace(const std::vector<UVPointHandle> &uvPoints, MaterialHandle material) {
     // check if face already exists
     for (auto face : faces(uvPoints[0])) {
-        auto faceUVPoints = this->uvPoints(face) | ranges::to_vector;
+        MESHLIB_COUNT(DuplicateCheckIterations, 1);
+        auto &faceUVPoints = this->uvPoints(face);
         if (faceUVPoints.size() != uvPoints.size()) {
             continue;
         }
@@ -106,9 +246,10 @@ FaceHandle Mesh::addFace(const std::vector<UVPointHandle> &uvPoints, MaterialHan
         }
     }
 
-    FaceData faceData;
+    // built aside since addEdge may split (and add) faces
+    FaceData faceData(_faces.get_allocator());
     faceData.material = material;
-    faceData.uvPoints = uvPoints;
+    faceData.uvPoints.assign(uvPoints.begin(), uvPoints.end());
 
     for (size_t i = 0; i < uvPoints.size(); ++i) {
         auto uv0 = uvPoints[i];
@@ -116,17 +257,103 @@ FaceHandle Mesh::addFace(const std::vector<UVPointHandle> &uvPoints, MaterialHan
         faceData.edges.push_back(addEdge({vertex(uv0), vertex(uv1)}));
     }
 
+    MESHLIB_COUNT(FacesAdded, 1);
+    changeTopology();
     auto face = FaceHandle(uint32_t(_faces.size()));
-    _faces.push_back(faceData);
     for (auto uvPoint : faceData.uvPoints) {
         uvPointData(uvPoint).faces.push_back(face);
     }
     for (auto edge : faceData.edges) {
         edgeData(edge).faces.push_back(face);
     }
+    _faces.push_back(std::move(faceData));
+    _faceAttributes.resize(_faces.size());
     return face;
 }
 
+void Mesh::beginDirectBuild(size_t vertexCount, size_t uvPointCount, size_t edgeCount, size_t faceCount) {
+    changeTopology();
+    _vertices.resize(_vertices.size() + vertexCount);
+    _uvPoints.resize(_uvPoints.size() + uvPointCount);
+    _positions.resize(_vertices.size(), glm::vec3(0));
+    _uvPositions.resize(_uvPoints.size(), glm::vec2(0));
+    _selection.resize(_vertices.size(), false);
+    _edges.resize(_edges.size() + edgeCount);
+    _faces.resize(_faces.size() + faceCount);
+    _vertexAttributes.resize(_vertices.size());
+    _uvPointAttributes.resize(_uvPoints.size());
+    _edgeAttributes.resize(_edges.size());
+    _faceAttributes.resize(_faces.size());
+    // the setDirect*() calls may come from several threads
+    _vertices.makeUnique();
+    _uvPoints.makeUnique();
+    _edges.makeUnique();
+    _faces.makeUnique();
+    _positions.makeUnique();
+    _uvPositions.makeUnique();
+}
+
+void Mesh::endDirectBuild() {
+    MESHLIB_SCOPED_OPERATION("Mesh::endDirectBuild");
+    changeTopology();
+    // rebuilt for the whole mesh, so appending to a mesh created with addFace also works
+    BackReferences<UVPointHandle> vertexUVPoints(_vertices.size());
+    BackReferences<EdgeHandle> vertexEdges(_vertices.size());
+    BackReferences<FaceHandle> uvPointFaces(_uvPoints.size());
+    BackReferences<FaceHandle> edgeFaces(_edges.size());
+
+    for (auto &uvPointData : _uvPoints) {
+        vertexUVPoints.count(uvPointData.vertex.index);
+    }
+    for (auto &edgeData : _edges) {
+        vertexEdges.count(edgeData.vertices[0].index);
+        vertexEdges.count(edgeData.vertices[1].index);
+    }
+    for (auto &faceData : _faces) {
+        for (auto uvPoint : faceData.uvPoints) {
+            uvPointFaces.count(uvPoint.index);
+        }
+        for (auto edge : faceData.edges) {
+            edgeFaces.count(edge.index);
+        }
+    }
+    vertexUVPoints.allocate();
+    vertexEdges.allocate();
+    uvPointFaces.allocate();
+    edgeFaces.allocate();
+
+    for (size_t i = 0; i < _uvPoints.size(); ++i) {
+        vertexUVPoints.add(_uvPoints[i].vertex.index, UVPointHandle(int(i)));
+    }
+    for (size_t i = 0; i < _edges.size(); ++i) {
+        vertexEdges.add(_edges[i].vertices[0].index, EdgeHandle(int(i)));
+        vertexEdges.add(_edges[i].vertices[1].index, EdgeHandle(int(i)));
+    }
+    for (size_t i = 0; i < _faces.size(); ++i) {
+        for (auto uvPoint : _faces[i].uvPoints) {
+            uvPointFaces.add(uvPoint.index, FaceHandle(int(i)));
+        }
+        for (auto edge : _faces[i].edges) {
+            edgeFaces.add(edge.index, FaceHandle(int(i)));
+        }
+    }
+
+    // the per-element vectors are where the allocations happen
+    _vertices.makeUnique();
+    _uvPoints.makeUnique();
+    _edges.makeUnique();
+    parallelFor(0, _vertices.size(), [&](size_t i) {
+        vertexUVPoints.assignSources(i, _vertices[i].uvPoints);
+        vertexEdges.assignSources(i, _vertices[i].edges);
+    });
+    parallelFor(0, _uvPoints.size(), [&](size_t i) {
+        uvPointFaces.assignSources(i, _uvPoints[i].faces);
+    });
+    parallelFor(0, _edges.size(), [&](size_t i) {
+        edgeFaces.assignSources(i, _edges[i].faces);
+    });
+}
+
 void Mesh::removeVertex(VertexHandle v) {
     for (auto uv : vertexData(v).uvPoints) {
         removeUVPoint(uv);
@@ -134,31 +361,50 @@ void Mesh::removeVertex(VertexHandle v) {
     for (auto e : vertexData(v).edges) {
         removeEdge(e);
     }
+    record(HistoryField::VertexDeleted, v, std::as_const(*this).vertexData(v).isDeleted, true);
     vertexData(v).isDeleted = true;
+    changeTopology();
+    setSelected(v, false);
+    MESHLIB_COUNT(ElementsRemoved, 1);
 }
 
 void Mesh::removeUVPoint(UVPointHandle uv) {
     for (auto f : faces(uv)) {
         removeFace(f);
     }
+    record(HistoryField::UVPointDeleted, uv, std::as_const(*this).uvPointData(uv).isDeleted, true);
     uvPointData(uv).isDeleted = true;
+    changeTopology();
+    MESHLIB_COUNT(ElementsRemoved, 1);
 }
 
 void Mesh::removeEdge(EdgeHandle e) {
     for (auto f : faces(e)) {
         removeFace(f);
     }
+    record(HistoryField::EdgeDeleted, e, std::as_const(*this).edgeData(e).isDeleted, true);
     edgeData(e).isDeleted = true;
+    changeTopology();
+    MESHLIB_COUNT(ElementsRemoved, 1);
 }
 
 void Mesh::removeFace(FaceHandle f) {
+    record(HistoryField::FaceDeleted, f, std::as_const(*this).faceData(f).isDeleted, true);
     faceData(f).isDeleted = true;
+    changeTopology();
+    MESHLIB_COUNT(ElementsRemoved, 1);
 }
 
 Mesh Mesh::collectGarbage() const {
-    std::vector<VertexData> newVertices;
-    std::vector<int32_t> newVertexIndices(_vertices.size());
+    MESHLIB_SCOPED_OPERATION("Mesh::collectGarbage");
+    // the result keeps the memory resource of this mesh
+    Mesh mesh(memoryResource());
+    auto &newVertices = mesh._vertices;
+    auto &newUVPoints = mesh._uvPoints;
+    auto &newEdges = mesh._edges;
+    auto &newFaces = mesh._faces;
 
+    std::vector<int32_t> newVertexIndices(_vertices.size());
     for (size_t i = 0; i < _vertices.size(); ++i) {
         auto &vertexData = _vertices[i];
         if (vertexData.isDeleted) {
@@ -167,9 +413,10 @@ Mesh Mesh::collectGarbage() const {
         }
         newVertexIndices[i] = int32_t(newVertices.size());
         newVertices.push_back(vertexData);
+        mesh._positions.push_back(_positions[i]);
+        mesh._selection.push_back(_selection[i]);
     }
 
-    std::vector<UVPointData> newUVPoints;
     std::vector<int32_t> newUVPointIndices(_uvPoints.size());
     for (size_t i = 0; i < _uvPoints.size(); ++i) {
         auto &uvPointData = _uvPoints[i];
@@ -179,9 +426,9 @@ Mesh Mesh::collectGarbage() const {
         }
         newUVPointIndices[i] = int32_t(newUVPoints.size());
         newUVPoints.push_back(uvPointData);
+        mesh._uvPositions.push_back(_uvPositions[i]);
     }
 
-    std::vector<EdgeData> newEdges;
     std::vector<int32_t> newEdgeIndices(_edges.size());
     for (size_t i = 0; i < _edges.size(); ++i) {
         auto &edgeData = _edges[i];
@@ -193,7 +440,6 @@ Mesh Mesh::collectGarbage() const {
         newEdges.push_back(edgeData);
     }
 
-    std::vector<FaceData> newFaces;
     std::vector<int32_t> newFaceIndices(_faces.size());
     for (size_t i = 0; i < _faces.size(); ++i) {
         auto &faceData = _faces[i];
@@ -205,66 +451,302 @@ Mesh Mesh::collectGarbage() const {
         newFaces.push_back(faceData);
     }
 
-    for (auto &vertexData : newVertices) {
-        std::vector<UVPointHandle> newUVPoints;
-        for (auto uvPoint : vertexData.uvPoints) {
-            int newIndex = newUVPointIndices[uvPoint.index];
-            if (newIndex >= 0) {
-                newUVPoints.push_back(UVPointHandle(newIndex));
-            }
+    mesh._vertexAttributes.assignCompacted(_vertexAttributes, newVertexIndices, newVertices.size());
+    mesh._uvPointAttributes.assignCompacted(_uvPointAttributes, newUVPointIndices, newUVPoints.size());
+    mesh._edgeAttributes.assignCompacted(_edgeAttributes, newEdgeIndices, newEdges.size());
+    mesh._faceAttributes.assignCompacted(_faceAttributes, newFaceIndices, newFaces.size());
+
+    // the remaps only shrink the adjacency lists, so they allocate nothing and can run in parallel
+    parallelFor(0, newVertices.size(), [&](size_t i) {
+        auto &vertexData = newVertices[i];
+        remapHandles(vertexData.uvPoints, newUVPointIndices);
+        remapHandles(vertexData.edges, newEdgeIndices);
+    });
+    parallelFor(0, newUVPoints.size(), [&](size_t i) {
+        auto &uvPointData = newUVPoints[i];
+        uvPointData.vertex.index = newVertexIndices[uvPointData.vertex.index];
+        remapHandles(uvPointData.faces, newFaceIndices);
+    });
+    parallelFor(0, newEdges.size(), [&](size_t i) {
+        auto &edgeData = newEdges[i];
+        for (auto &vertex : edgeData.vertices) {
+            vertex.index = newVertexIndices[vertex.index];
+        }
+        remapHandles(edgeData.faces, newFaceIndices);
+    });
+    parallelFor(0, newFaces.size(), [&](size_t i) {
+        auto &faceData = newFaces[i];
+        for (auto &uvPoint : faceData.uvPoints) {
+            uvPoint.index = newUVPointIndices[uvPoint.index];
         }
-        vertexData.uvPoints = std::move(newUVPoints);
+        for (auto &edge : faceData.edges) {
+            edge.index = newEdgeIndices[edge.index];
+        }
+    });
+
+    return mesh;
+}
+
+std::vector<MeshIssue> Mesh::validate() const {
+    MESHLIB_SCOPED_OPERATION("Mesh::validate");
+    using Type = MeshIssue::Type;
+    using Element = MeshIssue::Element;
+
+    auto isValid = [](auto handle, const auto &elements) { return handle.index >= 0 && size_t(handle.index) < elements.size(); };
+
+    std::vector<MeshIssue> issues;
+    std::mutex issuesMutex;
 
-        std::vector<EdgeHandle> newEdges;
-        for (auto edge : vertexData.edges) {
-            int newIndex = newEdgeIndices[edge.index];
-            if (newIndex >= 0) {
-                newEdges.push_back(EdgeHandle(newIndex));
+    // whether the live faces around v are connected through its edges; invalid references are reported elsewhere
+    auto isFan = [&](VertexHandle v) {
+        SmallVector<int, 16> faces;
+        for (auto uv : vertexData(v).uvPoints) {
+            if (!isValid(uv, _uvPoints) || uvPointData(uv).isDeleted) {
+                continue;
+            }
+            for (auto f : uvPointData(uv).faces) {
+                if (isValid(f, _faces) && !faceData(f).isDeleted) {
+                    faces.push_back(f.index);
+                }
+            }
+        }
+        std::sort(faces.begin(), faces.end());
+        faces.erase(std::unique(faces.begin(), faces.end()), faces.end());
+        if (faces.size() < 2) {
+            return true;
+        }
+        // union-find over the positions in faces
+        SmallVector<int, 16> parents;
+        parents.resize(faces.size());
+        std::iota(parents.begin(), parents.end(), 0);
+        auto find = [&](int i) {
+            while (parents[i] != i) {
+                i = parents[i] = parents[parents[i]];
+            }
+            return i;
+        };
+        size_t fanCount = faces.size();
+        for (auto e : vertexData(v).edges) {
+            if (!isValid(e, _edges) || edgeData(e).isDeleted) {
+                continue;
+            }
+            int first = -1;
+            for (auto f : edgeData(e).faces) {
+                auto it = std::lower_bound(faces.begin(), faces.end(), f.index);
+                if (it == faces.end() || *it != f.index) {
+                    continue;
+                }
+                int root = find(int(it - faces.begin()));
+                if (first < 0) {
+                    first = root;
+                } else if (root != find(first)) {
+                    parents[root] = find(first);
+                    --fanCount;
+                }
+            }
+        }
+        return fanCount == 1;
+    };
+
+    // calls check(index, report) for each live element; each block collects its issues before taking the lock
+    auto sweep = [&](const auto &elements, Element element, auto &&check) {
+        parallelForBlocks(0, elements.size(), [&](size_t begin, size_t end) {
+            std::vector<MeshIssue> blockIssues;
+            for (size_t i = begin; i < end; ++i) {
+                if (elements[i].isDeleted) {
+                    continue;
+                }
+                check(int(i), [&](Type type) { blockIssues.push_back({type, element, int(i)}); });
+            }
+            if (!blockIssues.empty()) {
+                std::lock_guard lock(issuesMutex);
+                issues.insert(issues.end(), blockIssues.begin(), blockIssues.end());
+            }
+        });
+    };
+
+    sweep(_vertices, Element::Vertex, [&](int index, auto &&report) {
+        auto v = VertexHandle(index);
+        auto &data = _vertices[index];
+        for (auto uv : data.uvPoints) {
+            if (!isValid(uv, _uvPoints)) {
+                report(Type::InvalidReference);
+            } else if (!uvPointData(uv).isDeleted && uvPointData(uv).vertex != v) {
+                report(Type::MissingBackReference);
+            }
+        }
+        for (auto e : data.edges) {
+            if (!isValid(e, _edges)) {
+                report(Type::InvalidReference);
+            } else if (!edgeData(e).isDeleted && !contains(edgeData(e).vertices, v)) {
+                report(Type::MissingBackReference);
+            }
+        }
+        if (hasDuplicates(data.uvPoints) || hasDuplicates(data.edges)) {
+            report(Type::DuplicateReference);
+        }
+        if (!isFan(v)) {
+            report(Type::NonManifoldVertex);
+        }
+    });
+
+    sweep(_uvPoints, Element::UVPoint, [&](int index, auto &&report) {
+        auto uv = UVPointHandle(index);
+        auto &data = _uvPoints[index];
+        if (!isValid(data.vertex, _vertices)) {
+            report(Type::InvalidReference);
+        } else if (vertexData(data.vertex).isDeleted) {
+            report(Type::DeletedReference);
+        } else if (!contains(vertexData(data.vertex).uvPoints, uv)) {
+            report(Type::MissingBackReference);
+        }
+        for (auto f : data.faces) {
+            if (!isValid(f, _faces)) {
+                report(Type::InvalidReference);
+            } else if (!faceData(f).isDeleted && !contains(faceData(f).uvPoints, uv)) {
+                report(Type::MissingBackReference);
+            }
+        }
+        if (hasDuplicates(data.faces)) {
+            report(Type::DuplicateReference);
+        }
+    });
+
+    sweep(_edges, Element::Edge, [&](int index, auto &&report) {
+        auto e = EdgeHandle(index);
+        auto &data = _edges[index];
+        bool verticesValid = true;
+        for (auto v : data.vertices) {
+            if (!isValid(v, _vertices)) {
+                report(Type::InvalidReference);
+                verticesValid = false;
+            } else if (vertexData(v).isDeleted) {
+                report(Type::DeletedReference);
+            } else if (!contains(vertexData(v).edges, e)) {
+                report(Type::MissingBackReference);
+            }
+        }
+        if (verticesValid && data.vertices[0] == data.vertices[1]) {
+            report(Type::DegenerateEdge);
+        } else if (verticesValid) {
+            // a duplicate is in the edge lists of both vertices, so the shorter one is enough
+            auto v0 = data.vertices[0];
+            auto v1 = data.vertices[1];
+            if (vertexData(v1).edges.size() < vertexData(v0).edges.size()) {
+                std::swap(v0, v1);
+            }
+            for (auto other : vertexData(v0).edges) {
+                if (isValid(other, _edges) && other.index < index && !edgeData(other).isDeleted &&
+                    contains(edgeData(other).vertices, v1)) {
+                    report(Type::DuplicateEdge);
+                    break;
+                }
             }
         }
-        vertexData.edges = std::move(newEdges);
-    }
-    for (auto &uvPointData : newUVPoints) {
-        uvPointData.vertex.index = newVertexIndices[uvPointData.vertex.index];
 
-        std::vector<FaceHandle> newFaces;
-        for (auto face : uvPointData.faces) {
-            auto newIndex = newFaceIndices[face.index];
-            if (newIndex >= 0) {
-                newFaces.push_back(FaceHandle(newIndex));
+        int liveFaceCount = 0;
+        for (auto f : data.faces) {
+            if (!isValid(f, _faces)) {
+                report(Type::InvalidReference);
+            } else if (!faceData(f).isDeleted) {
+                ++liveFaceCount;
+                if (!contains(faceData(f).edges, e)) {
+                    report(Type::MissingBackReference);
+                }
             }
         }
-        uvPointData.faces = std::move(newFaces);
-    }
-    for (auto &edgeData : newEdges) {
-        for (auto &vertex : edgeData.vertices) {
-            vertex.index = newVertexIndices[vertex.index];
+        if (liveFaceCount > 2) {
+            report(Type::NonManifoldEdge);
+        }
+        if (hasDuplicates(data.faces)) {
+            report(Type::DuplicateReference);
+        }
+    });
+
+    sweep(_faces, Element::Face, [&](int index, auto &&report) {
+        auto f = FaceHandle(index);
+        auto &data = _faces[index];
+        size_t cornerCount = data.uvPoints.size();
+        if (cornerCount < 3 || data.edges.size() != cornerCount) {
+            report(Type::DegenerateFace);
         }
 
-        std::vector<FaceHandle> newFaces;
-        for (auto face : edgeData.faces) {
-            auto newIndex = newFaceIndices[face.index];
-            if (newIndex >= 0) {
-                newFaces.push_back(FaceHandle(newIndex));
+        bool uvPointsValid = true;
+        for (auto uv : data.uvPoints) {
+            if (!isValid(uv, _uvPoints) || !isValid(uvPointData(uv).vertex, _vertices)) {
+                report(Type::InvalidReference);
+                uvPointsValid = false;
+            } else if (uvPointData(uv).isDeleted) {
+                report(Type::DeletedReference);
+            } else if (!contains(uvPointData(uv).faces, f)) {
+                report(Type::MissingBackReference);
             }
         }
-        edgeData.faces = std::move(newFaces);
-    }
-    for (auto &faceData : newFaces) {
-        for (auto &uvPoint : faceData.uvPoints) {
-            uvPoint.index = newUVPointIndices[uvPoint.index];
+        for (size_t i = 0; i < data.edges.size(); ++i) {
+            auto e = data.edges[i];
+            if (!isValid(e, _edges)) {
+                report(Type::InvalidReference);
+                continue;
+            }
+            if (edgeData(e).isDeleted) {
+                report(Type::DeletedReference);
+            } else if (!contains(edgeData(e).faces, f)) {
+                report(Type::MissingBackReference);
+            }
+            if (uvPointsValid && data.edges.size() == cornerCount) {
+                auto v0 = uvPointData(data.uvPoints[i]).vertex;
+                auto v1 = uvPointData(data.uvPoints[(i + 1) % cornerCount]).vertex;
+                auto &edgeVertices = edgeData(e).vertices;
+                if (!(edgeVertices == std::array{v0, v1} || edgeVertices == std::array{v1, v0})) {
+                    report(Type::DegenerateFace);
+                }
+            }
         }
-        for (auto &edge : faceData.edges) {
-            edge.index = newEdgeIndices[edge.index];
+        if (hasDuplicates(data.uvPoints) || hasDuplicates(data.edges)) {
+            report(Type::DuplicateReference);
+        }
+        if (!uvPointsValid || cornerCount == 0) {
+            return;
         }
-    }
 
-    Mesh mesh;
-    mesh._vertices = std::move(newVertices);
-    mesh._uvPoints = std::move(newUVPoints);
-    mesh._edges = std::move(newEdges);
-    mesh._faces = std::move(newFaces);
-    return mesh;
+        SmallVector<int, 8> vertices;
+        for (auto uv : data.uvPoints) {
+            vertices.push_back(uvPointData(uv).vertex.index);
+        }
+        std::sort(vertices.begin(), vertices.end());
+        if (std::adjacent_find(vertices.begin(), vertices.end()) != vertices.end()) {
+            report(Type::DegenerateFace);
+        }
+
+        // another face through the first corner with the same cycle
+        for (auto other : uvPointData(data.uvPoints[0]).faces) {
+            if (!isValid(other, _faces) || other.index >= index || faceData(other).isDeleted) {
+                continue;
+            }
+            auto &otherUVPoints = faceData(other).uvPoints;
+            if (otherUVPoints.size() != cornerCount) {
+                continue;
+            }
+            auto offset = std::find(otherUVPoints.begin(), otherUVPoints.end(), data.uvPoints[0]) - otherUVPoints.begin();
+            bool isSame = true;
+            for (size_t i = 0; i < cornerCount; ++i) {
+                if (otherUVPoints[(i + offset) % cornerCount] != data.uvPoints[i]) {
+                    isSame = false;
+                    break;
+                }
+            }
+            if (isSame) {
+                report(Type::DuplicateFace);
+                break;
+            }
+        }
+    });
+
+    std::sort(issues.begin(), issues.end(), [](auto &a, auto &b) {
+        return std::tie(a.element, a.index, a.type) < std::tie(b.element, b.index, b.type);
+    });
+    issues.erase(std::unique(issues.begin(), issues.end()), issues.end());
+    return issues;
 }
 
 void Mesh::clear() {
@@ -272,24 +754,38 @@ void Mesh::clear() {
     _uvPoints.clear();
     _edges.clear();
     _faces.clear();
+    _positions.clear();
+    _uvPositions.clear();
+    _selection.clear();
+    _vertexAttributes.clear();
+    _uvPointAttributes.clear();
+    _edgeAttributes.clear();
+    _faceAttributes.clear();
+    // after the elements, so that an open operation starts over from the empty mesh
+    clearHistory();
+    changeTopology();
 }
 
 glm::vec3 Mesh::calculateNormal(FaceHandle face) const {
-    auto vertices = this->vertices(face);
+    // each corner below reads three positions, so look them up once
+    SmallVector<glm::vec3, 8> positions;
+    for (auto uvPoint : uvPoints(face)) {
+        positions.push_back(position(vertex(uvPoint)));
+    }
 
-    if (vertices.size() == 3) {
-        return normalize(cross(position(vertices[1]) - position(vertices[0]), position(vertices[2]) - position(vertices[0])));
+    if (positions.size() == 3) {
+        return normalize(cross(positions[1] - positions[0], positions[2] - positions[0]));
     }
 
     // find average vertex normal
     glm::vec3 normalSum(0);
     int sumCount = 0;
-    int vertexCount = int(vertices.size());
+    int vertexCount = int(positions.size());
 
     for (int i = 0; i < vertexCount; ++i) {
-        auto prev = position(vertices[i]);
-        auto curr = position(vertices[(i + 1) % vertexCount]);
-        auto next = position(vertices[(i + 2) % vertexCount]);
+        auto prev = positions[i];
+        auto curr = positions[(i + 1) % vertexCount];
+        auto next = positions[(i + 2) % vertexCount];
         auto crossValue = cross(next - curr, prev - curr);
         if (crossValue == glm::vec3(0)) {
             continue;
@@ -304,19 +800,106 @@ glm::vec3 Mesh::calculateNormal(FaceHandle face) const {
     return normalize(normalSum);
 }
 
+std::vector<glm::vec3> Mesh::calculateFaceNormals() const {
+    MESHLIB_SCOPED_OPERATION("Mesh::calculateFaceNormals");
+    std::vector<glm::vec3> normals(_faces.size(), glm::vec3(0));
+    parallelFor(0, _faces.size(), [&](size_t i) {
+        if (!_faces[i].isDeleted) {
+            normals[i] = calculateNormal(FaceHandle(int(i)));
+        }
+    });
+    return normals;
+}
+
+std::vector<glm::vec3> Mesh::calculateVertexNormals() const {
+    MESHLIB_SCOPED_OPERATION("Mesh::calculateVertexNormals");
+    auto faceNormals = calculateFaceNormals();
+    std::vector<glm::vec3> normals(_vertices.size(), glm::vec3(0));
+    // gathered per vertex, so that no two threads write to the same normal
+    parallelFor(0, _vertices.size(), [&](size_t i) {
+        if (_vertices[i].isDeleted) {
+            return;
+        }
+        glm::vec3 normalSum(0);
+        for (auto uvPoint : uvPoints(VertexHandle(int(i)))) {
+            for (auto face : faces(uvPoint)) {
+                normalSum += faceNormals[face.index];
+            }
+        }
+        if (normalSum != glm::vec3(0)) {
+            normals[i] = normalize(normalSum);
+        }
+    });
+    return normals;
+}
+
 void Mesh::selectAll() {
-    for (auto v : vertices()) {
-        setSelected(v, true);
+    if (_history.depth > 0) {
+        // an entry per changed vertex
+        for (auto v : allVertices()) {
+            setSelected(v, !isDeleted(v));
+        }
+        return;
     }
+    // deleted vertices are never selected; threads write to separate chunks
+    parallelFor(
+        0, _selection.chunkCount(), [&](size_t chunk) {
+            auto selection = _selection.chunkData(chunk);
+            size_t begin = chunk * ChunkSize;
+            for (size_t i = 0; i < _selection.chunkLength(chunk); ++i) {
+                selection[i] = !std::as_const(_vertices)[begin + i].isDeleted;
+            }
+        },
+        1);
 }
 
 void Mesh::deselectAll() {
-    for (auto v : vertices()) {
-        setSelected(v, false);
+    if (_history.depth > 0) {
+        for (auto v : allVertices()) {
+            setSelected(v, false);
+        }
+        return;
     }
+    parallelFor(
+        0, _selection.chunkCount(), [&](size_t chunk) {
+            std::fill_n(_selection.chunkData(chunk), _selection.chunkLength(chunk), uint8_t(0));
+        },
+        1);
+}
+
+std::pmr::vector<EdgeHandle> Mesh::selectedEdges(std::pmr::memory_resource *resource) const {
+    MESHLIB_SCOPED_OPERATION("Mesh::selectedEdges");
+    return parallelFilter<EdgeHandle>(
+        0, _edges.size(),
+        [&](size_t i) {
+            auto &edgeData = _edges[i];
+            return !edgeData.isDeleted && _selection[edgeData.vertices[0].index] && _selection[edgeData.vertices[1].index];
+        },
+        resource);
+}
+
+std::pmr::vector<FaceHandle> Mesh::selectedFaces(std::pmr::memory_resource *resource) const {
+    MESHLIB_SCOPED_OPERATION("Mesh::selectedFaces");
+    return parallelFilter<FaceHandle>(
+        0, _faces.size(),
+        [&](size_t i) {
+            auto &faceData = _faces[i];
+            if (faceData.isDeleted) {
+                return false;
+            }
+            for (auto uvPoint : faceData.uvPoints) {
+                if (!_selection[_uvPoints[uvPoint.index].vertex.index]) {
+                    return false;
+                }
+            }
+            return true;
+        },
+        resource);
 }
 
 void Mesh::merge(const Mesh &other) {
+    MESHLIB_SCOPED_OPERATION("Mesh::merge");
+    changeTopology();
     auto vertexOffset = uint32_t(_vertices.size());
     auto uvPointOffset = uint32_t(_uvPoints.size());
     auto edgeOffset = uint32_t(_edges.size());
@@ -326,40 +909,47 @@ void Mesh::merge(const Mesh &other) {
     _uvPoints.reserve(_uvPoints.size() + other._uvPoints.size());
     _edges.reserve(_edges.size() + other._edges.size());
     _faces.reserve(_faces.size() + other._faces.size());
-
-    for (auto vertexData : other._vertices) {
+    _positions.append(other._positions);
+    _uvPositions.append(other._uvPositions);
+    _selection.append(other._selection);
+    _vertexAttributes.append(other._vertexAttributes);
+    _uvPointAttributes.append(other._uvPointAttributes);
+    _edgeAttributes.append(other._edgeAttributes);
+    _faceAttributes.append(other._faceAttributes);
+
+    for (auto &otherVertexData : other._vertices) {
+        auto &vertexData = _vertices.emplace_back(otherVertexData);
         for (auto &uv : vertexData.uvPoints) {
             uv.index += uvPointOffset;
         }
         for (auto &e : vertexData.edges) {
             e.index += edgeOffset;
         }
-        _vertices.push_back(vertexData);
     }
-    for (auto uvPointData : other._uvPoints) {
+    for (auto &otherUvPointData : other._uvPoints) {
+        auto &uvPointData = _uvPoints.emplace_back(otherUvPointData);
         uvPointData.vertex.index += vertexOffset;
         for (auto &f : uvPointData.faces) {
             f.index += faceOffset;
         }
-        _uvPoints.push_back(uvPointData);
     }
-    for (auto edgeData : other._edges) {
+    for (auto &otherEdgeData : other._edges) {
+        auto &edgeData = _edges.emplace_back(otherEdgeData);
         for (auto &v : edgeData.vertices) {
             v.index += vertexOffset;
         }
         for (auto &f : edgeData.faces) {
             f.index += faceOffset;
         }
-        _edges.push_back(edgeData);
     }
-    for (auto faceData : other._faces) {
+    for (auto &otherFaceData : other._faces) {
+        auto &faceData = _faces.emplace_back(otherFaceData);
         for (auto &uv : faceData.uvPoints) {
             uv.index += uvPointOffset;
         }
         for (auto &e : faceData.edges) {
             e.index += edgeOffset;
         }
-        _faces.push_back(faceData);
     }
 }
 
@@ -1,47 +1,139 @@
 #pragma once
+#include "Attribute.hpp"
 #include "Handle.hpp"
+#include "RegionQuery.hpp"
+#include "util/CowVector.hpp"
+#include "util/Instrumentation.hpp"
+#include "util/SmallVector.hpp"
 #include <array>
 #include <glm/glm.hpp>
-#include <range/v3/action/join.hpp>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
 #include <range/v3/view/filter.hpp>
 #include <range/v3/view/iota.hpp>
+#include <range/v3/view/join.hpp>
 #include <range/v3/view/transform.hpp>
 #include <unordered_map>
 #include <unordered_set>
+#include <utility>
 #include <vector>
 
 namespace meshlib {
 
+// Inconsistency found by Mesh::validate(). element and index name the live element whose data is wrong.
+struct MeshIssue {
+    enum class Type {
+        // handle out of range
+        InvalidReference,
+        // live element referring to a deleted vertex, uvPoint or edge
+        DeletedReference,
+        // reference without the reciprocal one (e.g. an edge of a face that does not list the face)
+        MissingBackReference,
+        // same handle twice in an adjacency list
+        DuplicateReference,
+        // edge with the same vertices as an edge with a lower index
+        DuplicateEdge,
+        // face with the same uvPoint cycle as a face with a lower index
+        DuplicateFace,
+        // edge connecting a vertex to itself
+        DegenerateEdge,
+        // face with fewer than 3 corners, a repeated vertex, or an edge list not matching its corners
+        DegenerateFace,
+        // edge with more than 2 faces
+        NonManifoldEdge,
+        // vertex whose faces form several fans, joined only at the vertex (e.g. two cones tip to tip)
+        NonManifoldVertex,
+    };
+    enum class Element {
+        Vertex,
+        UVPoint,
+        Edge,
+        Face,
+    };
+
+    Type type;
+    Element element;
+    int index;
+
+    bool operator==(const MeshIssue &other) const { return type == other.type && element == other.element && index == other.index; }
+};
+
+const char *meshIssueTypeName(MeshIssue::Type type);
+
 class Mesh {
+    // Element data is allocator-aware so that std::pmr::vector passes the mesh's memory resource on to the adjacency
+    // lists; the allocator-extended copy and move go through assignment, which keeps the new element's resource
     struct VertexData {
+        using allocator_type = std::pmr::polymorphic_allocator<std::byte>;
+
+        VertexData() = default;
+        explicit VertexData(const allocator_type &allocator) : uvPoints(allocator), edges(allocator) {}
+        VertexData(const VertexData &other, const allocator_type &allocator) : VertexData(allocator) { *this = other; }
+        VertexData(VertexData &&other, const allocator_type &allocator) : VertexData(allocator) { *this = std::move(other); }
+        VertexData(const VertexData &) = default;
+        VertexData(VertexData &&) = default;
+        VertexData &operator=(const VertexData &) = default;
+        VertexData &operator=(VertexData &&) = default;
+
         bool isDeleted = false;
-        bool isSelected = false;
         float corner = 0;
-        glm::vec3 position = glm::vec3(0);
-        std::vector<UVPointHandle> uvPoints;
-        std::vector<EdgeHandle> edges;
+        SmallVector<UVPointHandle, 2> uvPoints;
+        SmallVector<EdgeHandle, 4> edges;
     };
 
     struct UVPointData {
+        using allocator_type = std::pmr::polymorphic_allocator<std::byte>;
+
+        UVPointData() = default;
+        explicit UVPointData(const allocator_type &allocator) : faces(allocator) {}
+        UVPointData(const UVPointData &other, const allocator_type &allocator) : UVPointData(allocator) { *this = other; }
+        UVPointData(UVPointData &&other, const allocator_type &allocator) : UVPointData(allocator) { *this = std::move(other); }
+        UVPointData(const UVPointData &) = default;
+        UVPointData(UVPointData &&) = default;
+        UVPointData &operator=(const UVPointData &) = default;
+        UVPointData &operator=(UVPointData &&) = default;
+
         bool isDeleted = false;
-        glm::vec2 uvPosition = glm::vec2(0);
         VertexHandle vertex;
-        std::vector<FaceHandle> faces;
+        SmallVector<FaceHandle, 4> faces;
     };
 
     struct EdgeData {
+        using allocator_type = std::pmr::polymorphic_allocator<std::byte>;
+
+        EdgeData() = default;
+        explicit EdgeData(const allocator_type &allocator) : faces(allocator) {}
+        EdgeData(const EdgeData &other, const allocator_type &allocator) : EdgeData(allocator) { *this = other; }
+        EdgeData(EdgeData &&other, const allocator_type &allocator) : EdgeData(allocator) { *this = std::move(other); }
+        EdgeData(const EdgeData &) = default;
+        EdgeData(EdgeData &&) = default;
+        EdgeData &operator=(const EdgeData &) = default;
+        EdgeData &operator=(EdgeData &&) = default;
+
         bool isDeleted = false;
         bool isSharp = false;
         float crease = 0;
         std::array<VertexHandle, 2> vertices;
-        std::vector<FaceHandle> faces;
+        SmallVector<FaceHandle, 2> faces;
     };
 
     struct FaceData {
+        using allocator_type = std::pmr::polymorphic_allocator<std::byte>;
+
+        FaceData() = default;
+        explicit FaceData(const allocator_type &allocator) : uvPoints(allocator), edges(allocator) {}
+        FaceData(const FaceData &other, const allocator_type &allocator) : FaceData(allocator) { *this = other; }
+        FaceData(FaceData &&other, const allocator_type &allocator) : FaceData(allocator) { *this = std::move(other); }
+        FaceData(const FaceData &) = default;
+        FaceData(FaceData &&) = default;
+        FaceData &operator=(const FaceData &) = default;
+        FaceData &operator=(FaceData &&) = default;
+
         bool isDeleted = false;
         MaterialHandle material;
-        std::vector<UVPointHandle> uvPoints;
-        std::vector<EdgeHandle> edges;
+        SmallVector<UVPointHandle, 4> uvPoints;
+        SmallVector<EdgeHandle, 4> edges;
     };
 
     auto &vertexData(VertexHandle handle) { return _vertices[handle.index]; }
@@ -56,17 +148,153 @@ class Mesh {
     auto &faceData(FaceHandle handle) { return _faces[handle.index]; }
     auto &faceData(FaceHandle handle) const { return _faces[handle.index]; }
 
-    std::vector<VertexData> _vertices;
-    std::vector<UVPointData> _uvPoints;
-    std::vector<EdgeData> _edges;
-    std::vector<FaceData> _faces;
+    template <typename THandles, typename TElements>
+    static size_t liveCount(const THandles &handles, const TElements &elements) {
+        size_t count = 0;
+        for (auto handle : handles) {
+            count += elements[handle.index].isDeleted ? 0 : 1;
+        }
+        return count;
+    }
+
+    // copies of the mesh share the chunks of these arrays until they write to them (see MeshSnapshot.hpp)
+    CowVector<VertexData> _vertices;
+    CowVector<UVPointData> _uvPoints;
+    CowVector<EdgeData> _edges;
+    CowVector<FaceData> _faces;
+
+    // parallel to _vertices and _uvPoints; kept apart so that bulk transforms stream over tightly packed data
+    CowVector<glm::vec3> _positions;
+    CowVector<glm::vec2> _uvPositions;
+    CowVector<uint8_t> _selection;
+
+    AttributeSet _vertexAttributes;
+    AttributeSet _uvPointAttributes;
+    AttributeSet _edgeAttributes;
+    AttributeSet _faceAttributes;
+
+    // see topologyVersion()
+    static uint64_t newTopologyVersion();
+    void changeTopology() { _topologyVersion = newTopologyVersion(); }
+    uint64_t _topologyVersion = newTopologyVersion();
+
+    // What the undo history records of a change to an element that existed when the operation began. Elements added
+    // by an operation need no entries: undo() truncates the element arrays back to their old sizes.
+    enum class HistoryField : uint8_t {
+        VertexDeleted,
+        Selected,
+        Corner,
+        Position,
+        UVPointDeleted,
+        UVPosition,
+        EdgeDeleted,
+        Sharp,
+        Crease,
+        FaceDeleted,
+        Material,
+        Attribute,
+        // whole position chunks and attribute columns handed out for writing, recorded once per operation
+        PositionChunk,
+        UVPositionChunk,
+        AttributeColumn,
+    };
+
+    // a step per outermost operation; defined in MeshHistory.cpp
+    struct HistoryStep;
+    struct History {
+        History() = default;
+        // a copy starts without history: the steps refer to element indices that the copies change independently
+        History(const History &) {}
+        History(History &&) = default;
+        History &operator=(const History &) { return *this = History(); }
+        History &operator=(History &&) = default;
+
+        // steps[0, doneCount) can be undone, the others redone
+        std::vector<std::shared_ptr<HistoryStep>> steps;
+        size_t doneCount = 0;
+        std::shared_ptr<HistoryStep> current;
+        int depth = 0;
+        // vertex, uvPoint, edge and face counts when the current operation began
+        std::array<uint32_t, 4> baseCounts{};
+        // recording may happen from several threads, e.g. positionChunk() in a parallel loop
+        std::unique_ptr<std::mutex> mutex;
+        size_t maxSteps = 100;
+        size_t maxBytes = size_t(256) << 20;
+        size_t bytes = 0;
+    };
+    History _history;
+
+    template <typename THandle>
+    static constexpr int elementIndex() {
+        if constexpr (std::is_same_v<THandle, VertexHandle>) {
+            return 0;
+        } else if constexpr (std::is_same_v<THandle, UVPointHandle>) {
+            return 1;
+        } else if constexpr (std::is_same_v<THandle, EdgeHandle>) {
+            return 2;
+        } else {
+            return 3;
+        }
+    }
+
+    template <typename THandle>
+    bool isRecorded(THandle handle) const {
+        return _history.depth > 0 && uint32_t(handle.index) < _history.baseCounts[elementIndex<THandle>()];
+    }
+
+    // records the change of a field of handle from before to after if the operation needs to
+    template <typename THandle, typename T>
+    void record(HistoryField field, THandle handle, const T &before, const T &after, int column = -1) {
+        if (isRecorded(handle)) {
+            recordChange(field, elementIndex<THandle>(), column, handle.index, &before, &after, sizeof(T));
+        }
+    }
+    void recordChange(HistoryField field, int element, int column, int index, const void *before, const void *after, size_t size);
+    // chunk of _positions or _uvPositions, or attribute column of element type element
+    void recordImage(HistoryField field, int element, int index);
+
+    template <typename THandle, typename T>
+    T *columnData(Attribute<THandle, T> attribute) { return reinterpret_cast<T *>(attributes<THandle>().column(attribute.index).data()); }
 
   public:
+    // Element and adjacency storage comes from resource; a plain copy uses the default resource like std::pmr containers.
+    // Copies with the same resource share storage until one side writes to it, so copying is cheap.
+    explicit Mesh(std::pmr::memory_resource *resource = std::pmr::get_default_resource());
+    Mesh(const Mesh &other, std::pmr::memory_resource *resource);
+    Mesh(const Mesh &other) = default;
+    Mesh(Mesh &&other) = default;
+    Mesh &operator=(const Mesh &other) = default;
+    Mesh &operator=(Mesh &&other) = default;
+
+    std::pmr::memory_resource *memoryResource() const { return _vertices.get_allocator().resource(); }
+
     VertexHandle addVertex(glm::vec3 position);
     UVPointHandle addUVPoint(VertexHandle v, glm::vec2 position);
     EdgeHandle addEdge(const std::array<VertexHandle, 2> &vertices);
     FaceHandle addFace(const std::vector<UVPointHandle> &uvPoints, MaterialHandle material);
 
+    // Direct construction for generators that know element counts and connectivity in advance.
+    // beginDirectBuild() appends default elements; each of them is then set exactly once with setDirect*() (different
+    // elements may be set from different threads) and endDirectBuild() fills the back references.
+    // There are no duplicate checks or face splits: edges[i] of a face must connect uvPoints[i] and uvPoints[i + 1].
+    void beginDirectBuild(size_t vertexCount, size_t uvPointCount, size_t edgeCount, size_t faceCount);
+    void setDirectVertex(VertexHandle v, glm::vec3 position) { _positions[v.index] = position; }
+    void setDirectUVPoint(UVPointHandle uv, VertexHandle v, glm::vec2 position) {
+        uvPointData(uv).vertex = v;
+        _uvPositions[uv.index] = position;
+    }
+    void setDirectEdge(EdgeHandle e, const std::array<VertexHandle, 2> &vertices) { edgeData(e).vertices = vertices; }
+    void setDirectFace(FaceHandle f, const std::vector<UVPointHandle> &uvPoints, const std::vector<EdgeHandle> &edges, MaterialHandle material) {
+        setDirectFace(f, uvPoints.data(), edges.data(), uvPoints.size(), material);
+    }
+    // count uvPoints and edges, e.g. slices of arrays holding the corners of all faces
+    void setDirectFace(FaceHandle f, const UVPointHandle *uvPoints, const EdgeHandle *edges, size_t count, MaterialHandle material) {
+        faceData(f).uvPoints.assign(uvPoints, uvPoints + count);
+        faceData(f).edges.assign(edges, edges + count);
+        faceData(f).material = material;
+    }
+    void endDirectBuild();
+
     void removeVertex(VertexHandle v);
     void removeUVPoint(UVPointHandle v);
     void removeEdge(EdgeHandle e);
@@ -74,8 +302,18 @@ class Mesh {
 
     Mesh collectGarbage() const;
 
+    // Checks that all reciprocal references agree, that live elements do not refer to deleted ones (back references to
+    // deleted elements are fine, the accessors skip them), and reports duplicates, degenerate and non-manifold edges and
+    // vertices.
+    // Runs in parallel in time linear in the mesh size; an empty result means the mesh is consistent.
+    std::vector<MeshIssue> validate() const;
+
     void clear();
 
+    // Changes whenever elements are added or removed, also by undo() and redo(), and is never reused by another mesh,
+    // so data derived from the connectivity can be cached against it. Copies keep the version of their source.
+    uint64_t topologyVersion() const { return _topologyVersion; }
+
     // TODO: exclude deleted items
     size_t allVertexCount() const { return _vertices.size(); }
     size_t allUVPointCount() const { return _uvPoints.size(); }
@@ -123,11 +361,12 @@ class Mesh {
         return uvPointData(p).faces | ranges::views::filter([this](auto handle) { return !faceData(handle).isDeleted; });
     }
 
+    // lazy, nothing is allocated
     auto faces(VertexHandle v) const {
         return uvPoints(v) | ranges::views::transform([this](UVPointHandle uvPoint) {
                    return faces(uvPoint);
                }) |
-               ranges::actions::join;
+               ranges::views::join;
     }
 
     auto &vertices(EdgeHandle e) const { return edgeData(e).vertices; }
@@ -144,63 +383,79 @@ class Mesh {
 
     auto &edges(FaceHandle f) const { return faceData(f).edges; }
 
-    CPP_template(typename TVertices)(requires ranges::range<TVertices>) auto edges(TVertices &&vertices) const {
-        std::unordered_map<EdgeHandle, size_t> edgeCounts;
-
-        for (auto v : vertices) {
-            for (auto e : edges(v)) {
-                if (edgeCounts.find(e) != edgeCounts.end()) {
-                    ++edgeCounts[e];
-                } else {
-                    edgeCounts[e] = 1;
-                }
-            }
+    // sizes of the ranges above, counted in place
+    size_t uvPointCount(VertexHandle v) const { return liveCount(vertexData(v).uvPoints, _uvPoints); }
+    size_t edgeCount(VertexHandle v) const { return liveCount(vertexData(v).edges, _edges); }
+    size_t faceCount(VertexHandle v) const {
+        size_t count = 0;
+        for (auto uvPoint : uvPoints(v)) {
+            count += faceCount(uvPoint);
         }
-        std::unordered_set<EdgeHandle> edges;
-
-        for (auto [edge, count] : edgeCounts) {
-            if (count == 2) {
-                edges.insert(edge);
-            }
-        }
-
-        return edges;
+        return count;
     }
+    size_t faceCount(UVPointHandle p) const { return liveCount(uvPointData(p).faces, _faces); }
+    size_t faceCount(EdgeHandle e) const { return liveCount(edgeData(e).faces, _faces); }
+    size_t vertexCount(FaceHandle f) const { return faceData(f).uvPoints.size(); }
 
-    CPP_template(typename TVertices)(requires ranges::range<TVertices>) auto faces(TVertices &&vertices) const {
-        std::unordered_map<FaceHandle, size_t> faceCounts;
+    // edges with both vertices in the range, sorted by index (see RegionQuery)
+    CPP_template(typename TVertices)(requires ranges::range<TVertices>) auto edges(TVertices &&vertices, std::pmr::memory_resource *resource = std::pmr::get_default_resource()) const {
+        return RegionQuery::forCurrentThread().edges(*this, std::forward<TVertices>(vertices), resource);
+    }
 
-        for (auto v : vertices) {
-            for (auto &f : faces(v)) {
-                if (faceCounts.find(f) != faceCounts.end()) {
-                    ++faceCounts[f];
-                } else {
-                    faceCounts[f] = 1;
-                }
-            }
-        }
-        std::unordered_set<FaceHandle> faces;
+    // faces with all vertices in the range, sorted by index (see RegionQuery)
+    CPP_template(typename TVertices)(requires ranges::range<TVertices>) auto faces(TVertices &&vertices, std::pmr::memory_resource *resource = std::pmr::get_default_resource()) const {
+        return RegionQuery::forCurrentThread().faces(*this, std::forward<TVertices>(vertices), resource);
+    }
 
-        for (auto [face, count] : faceCounts) {
-            if (count == this->vertices(face).size()) {
-                faces.insert(face);
-            }
-        }
+    bool isDeleted(VertexHandle v) const { return vertexData(v).isDeleted; }
+    bool isDeleted(UVPointHandle uv) const { return uvPointData(uv).isDeleted; }
+    bool isDeleted(EdgeHandle e) const { return edgeData(e).isDeleted; }
+    bool isDeleted(FaceHandle f) const { return faceData(f).isDeleted; }
 
-        return faces;
+    // removed vertices are deselected
+    bool isSelected(VertexHandle v) const { return _selection[v.index]; }
+    void setSelected(VertexHandle v, bool selected) {
+        record(HistoryField::Selected, v, std::as_const(_selection)[v.index], uint8_t(selected));
+        _selection[v.index] = selected;
     }
 
-    bool isSelected(VertexHandle v) const { return vertexData(v).isSelected; }
-    void setSelected(VertexHandle v, bool selected) { vertexData(v).isSelected = selected; }
-
     float corner(VertexHandle v) const { return vertexData(v).corner; }
-    void setCorner(VertexHandle v, float corner) { vertexData(v).corner = corner; }
+    void setCorner(VertexHandle v, float corner) {
+        record(HistoryField::Corner, v, std::as_const(*this).vertexData(v).corner, corner);
+        vertexData(v).corner = corner;
+    }
 
-    glm::vec3 position(VertexHandle v) const { return vertexData(v).position; }
-    void setPosition(VertexHandle v, glm::vec3 pos) { vertexData(v).position = pos; }
+    glm::vec3 position(VertexHandle v) const { return _positions[v.index]; }
+    void setPosition(VertexHandle v, glm::vec3 pos) {
+        record(HistoryField::Position, v, std::as_const(_positions)[v.index], pos);
+        _positions[v.index] = pos;
+    }
 
-    glm::vec2 uvPosition(UVPointHandle uv) const { return uvPointData(uv).uvPosition; }
-    void setUVPosition(UVPointHandle uv, glm::vec2 pos) { uvPointData(uv).uvPosition = pos; }
+    glm::vec2 uvPosition(UVPointHandle uv) const { return _uvPositions[uv.index]; }
+    void setUVPosition(UVPointHandle uv, glm::vec2 pos) {
+        record(HistoryField::UVPosition, uv, std::as_const(_uvPositions)[uv.index], pos);
+        _uvPositions[uv.index] = pos;
+    }
+
+    // Positions of allVertices() and allUVPoints() in handle order, in contiguous chunks of ChunkSize values (the last
+    // one may be shorter), for bulk operations (see algorithm/Transform.hpp)
+    static constexpr size_t ChunkSize = CowVector<glm::vec3>::ChunkSize;
+    size_t positionChunkCount() const { return _positions.chunkCount(); }
+    glm::vec3 *positionChunk(size_t chunk) {
+        if (_history.depth > 0) {
+            recordImage(HistoryField::PositionChunk, 0, int(chunk));
+        }
+        return _positions.chunkData(chunk);
+    }
+    const glm::vec3 *positionChunk(size_t chunk) const { return _positions.chunkData(chunk); }
+    size_t uvPositionChunkCount() const { return _uvPositions.chunkCount(); }
+    glm::vec2 *uvPositionChunk(size_t chunk) {
+        if (_history.depth > 0) {
+            recordImage(HistoryField::UVPositionChunk, 1, int(chunk));
+        }
+        return _uvPositions.chunkData(chunk);
+    }
+    const glm::vec2 *uvPositionChunk(size_t chunk) const { return _uvPositions.chunkData(chunk); }
 
     std::array<glm::vec3, 2> positions(EdgeHandle e) const {
         auto pos0 = position(vertices(e)[0]);
@@ -209,15 +464,82 @@ class Mesh {
     }
 
     bool isSharp(EdgeHandle edge) const { return edgeData(edge).isSharp; }
-    void setSharp(EdgeHandle edge, bool isSharp) { edgeData(edge).isSharp = isSharp; }
+    void setSharp(EdgeHandle edge, bool isSharp) {
+        record(HistoryField::Sharp, edge, std::as_const(*this).edgeData(edge).isSharp, isSharp);
+        edgeData(edge).isSharp = isSharp;
+    }
 
     float crease(EdgeHandle edge) const { return edgeData(edge).crease; }
-    void setCrease(EdgeHandle edge, float crease) { edgeData(edge).crease = crease; }
+    void setCrease(EdgeHandle edge, float crease) {
+        record(HistoryField::Crease, edge, std::as_const(*this).edgeData(edge).crease, crease);
+        edgeData(edge).crease = crease;
+    }
 
     MaterialHandle material(FaceHandle face) const { return faceData(face).material; }
-    void setMaterial(FaceHandle face, MaterialHandle material) { faceData(face).material = material; }
+    void setMaterial(FaceHandle face, MaterialHandle material) {
+        record(HistoryField::Material, face, std::as_const(*this).faceData(face).material, material);
+        faceData(face).material = material;
+    }
+
+    // Custom attributes: columns of trivially copyable values with one value per element of the type given by THandle,
+    // e.g. addAttribute<VertexHandle, glm::vec4>("color"). Values start at zero, also for elements that algorithms add
+    // later, and are carried along by collectGarbage(), merge() and MeshData.
+    template <typename THandle>
+    AttributeSet &attributes() {
+        if constexpr (std::is_same_v<THandle, VertexHandle>) {
+            return _vertexAttributes;
+        } else if constexpr (std::is_same_v<THandle, UVPointHandle>) {
+            return _uvPointAttributes;
+        } else if constexpr (std::is_same_v<THandle, EdgeHandle>) {
+            return _edgeAttributes;
+        } else {
+            static_assert(std::is_same_v<THandle, FaceHandle>, "attributes belong to vertices, uvPoints, edges or faces");
+            return _faceAttributes;
+        }
+    }
+    template <typename THandle>
+    const AttributeSet &attributes() const { return const_cast<Mesh *>(this)->attributes<THandle>(); }
+
+    // returns the existing attribute if there is one with this name; invalid if that one has another value size
+    template <typename THandle, typename T>
+    Attribute<THandle, T> addAttribute(std::string_view name) { return Attribute<THandle, T>(attributes<THandle>().add(name, sizeof(T))); }
+    // invalid if there is none
+    template <typename THandle, typename T>
+    Attribute<THandle, T> findAttribute(std::string_view name) const { return Attribute<THandle, T>(attributes<THandle>().find(name, sizeof(T))); }
+    // clears the history, whose steps refer to the columns by index
+    template <typename THandle>
+    void removeAttribute(std::string_view name) {
+        clearHistory();
+        attributes<THandle>().remove(name);
+    }
+
+    // values of allVertices(), allUVPoints(), allEdges() or allFaces() in handle order; within an operation the
+    // writable data is recorded as a whole column, setAttribute() records single values
+    template <typename THandle, typename T>
+    T *attributeData(Attribute<THandle, T> attribute) {
+        if (_history.depth > 0) {
+            recordImage(HistoryField::AttributeColumn, elementIndex<THandle>(), attribute.index);
+        }
+        return columnData(attribute);
+    }
+    template <typename THandle, typename T>
+    const T *attributeData(Attribute<THandle, T> attribute) const {
+        return reinterpret_cast<const T *>(attributes<THandle>().column(attribute.index).data());
+    }
+
+    template <typename THandle, typename T>
+    T attribute(Attribute<THandle, T> attribute, THandle handle) const { return attributeData(attribute)[handle.index]; }
+    template <typename THandle, typename T>
+    void setAttribute(Attribute<THandle, T> attribute, THandle handle, const T &value) {
+        record(HistoryField::Attribute, handle, this->attribute(attribute, handle), value, attribute.index);
+        columnData(attribute)[handle.index] = value;
+    }
 
     glm::vec3 calculateNormal(FaceHandle face) const;
+    // calculateNormal() of allFaces(), zero for deleted faces
+    std::vector<glm::vec3> calculateFaceNormals() const;
+    // normalized sum of the normals of the faces around each of allVertices(), zero for deleted and isolated vertices
+    std::vector<glm::vec3> calculateVertexNormals() const;
 
     void selectAll();
     void deselectAll();
@@ -225,14 +547,47 @@ class Mesh {
     auto selectedVertices() const {
         return vertices() | ranges::views::filter([this](auto handle) { return isSelected(handle); });
     }
-    auto selectedEdges() const {
-        return edges(selectedVertices());
-    }
-    auto selectedFaces() const {
-        return faces(selectedVertices());
-    }
+    // edges and faces with all vertices selected, sorted by index; found by a parallel scan over all edges or faces
+    std::pmr::vector<EdgeHandle> selectedEdges(std::pmr::memory_resource *resource = std::pmr::get_default_resource()) const;
+    std::pmr::vector<FaceHandle> selectedFaces(std::pmr::memory_resource *resource = std::pmr::get_default_resource()) const;
 
     void merge(const Mesh &other);
+
+    // Undo history. The changes between beginOperation() and the matching endOperation() make one undo step: an entry
+    // with the old and new value per changed field of an existing element, and the element counts, as elements are
+    // only ever appended. Operations nest, only the outermost one makes a step, and nothing is recorded outside of
+    // operations. Positions and attribute values written through positionChunk(), uvPositionChunk() or
+    // attributeData() are recorded as whole chunks or columns. Copies of a mesh start without history; clear() and
+    // removeAttribute() clear it, and within an operation restart its step, which then undoes to the cleared state.
+    void beginOperation(std::string_view name);
+    void endOperation();
+    bool canUndo() const { return _history.depth == 0 && _history.doneCount > 0; }
+    bool canRedo() const { return _history.depth == 0 && _history.doneCount < _history.steps.size(); }
+    // names of the steps that undo() and redo() would apply, empty if there are none
+    std::string_view undoName() const;
+    std::string_view redoName() const;
+    // false if there is nothing to undo or redo, or an operation is open
+    bool undo();
+    bool redo();
+    // The oldest steps are dropped when there are more than maxSteps, or their entries take more than maxBytes.
+    // Entries of a step for the same field of the same element are merged when the step ends.
+    void setHistoryLimits(size_t maxSteps, size_t maxBytes);
+    size_t historyStepCount() const { return _history.steps.size(); }
+    size_t historyBytes() const { return _history.bytes; }
+    void clearHistory();
+};
+
+// Mesh::beginOperation() for the lifetime of the scope
+class ScopedMeshOperation {
+  public:
+    ScopedMeshOperation(Mesh &mesh, std::string_view name) : _mesh(mesh) { _mesh.beginOperation(name); }
+    ~ScopedMeshOperation() { _mesh.endOperation(); }
+
+    ScopedMeshOperation(const ScopedMeshOperation &) = delete;
+    ScopedMeshOperation &operator=(const ScopedMeshOperation &) = delete;
+
+  private:
+    Mesh &_mesh;
 };
 
 } // namespace meshlib
@@ -18,6 +18,52 @@ std::vector<T> fromDataString(const std::string &dataString) {
     return data;
 }
 
+std::vector<meshlib::MeshData::AttributeArray> toAttributeArrays(const meshlib::AttributeSet &attributes) {
+    std::vector<meshlib::MeshData::AttributeArray> arrays;
+    for (size_t i = 0; i < attributes.columnCount(); ++i) {
+        auto &column = attributes.column(int(i));
+        auto bytes = reinterpret_cast<const uint8_t *>(column.data());
+        arrays.push_back({std::string(column.name()), int32_t(column.valueSize()), std::vector<uint8_t>(bytes, bytes + column.size() * column.valueSize())});
+    }
+    return arrays;
+}
+
+void addAttributeColumns(meshlib::AttributeSet &attributes, const std::vector<meshlib::MeshData::AttributeArray> &arrays) {
+    for (auto &array : arrays) {
+        int index = attributes.add(array.name, size_t(array.valueSize));
+        if (index < 0 || array.data.empty()) {
+            continue;
+        }
+        auto &column = attributes.column(index);
+        memcpy(column.data(), array.data.data(), std::min(array.data.size(), column.size() * column.valueSize()));
+    }
+}
+
+nlohmann::json toAttributesJSON(const std::vector<meshlib::MeshData::AttributeArray> &arrays) {
+    auto json = nlohmann::json::array();
+    for (auto &array : arrays) {
+        nlohmann::json attributeJSON;
+        attributeJSON["name"] = array.name;
+        attributeJSON["valueSize"] = array.valueSize;
+        attributeJSON["data"] = toDataString(array.data);
+        json.push_back(attributeJSON);
+    }
+    return json;
+}
+
+std::vector<meshlib::MeshData::AttributeArray> fromAttributesJSON(const nlohmann::json &json) {
+    std::vector<meshlib::MeshData::AttributeArray> arrays;
+    // not present in files written before custom attributes existed
+    if (!json.contains("attributes")) {
+        return arrays;
+    }
+    for (auto &attributeJSON : json["attributes"]) {
+        arrays.push_back({attributeJSON["name"].get<std::string>(), attributeJSON["valueSize"].get<int32_t>(),
+                          fromDataString<uint8_t>(attributeJSON["data"])});
+    }
+    return arrays;
+}
+
 } // namespace
 
 namespace meshlib {
@@ -48,6 +94,12 @@ MeshData::MeshData(const Mesh &origMesh) {
             faceUVPointArray.push_back(uv.index);
         }
     }
+
+    // the columns of the collected mesh are in the order of the arrays above
+    vertexAttributeArrays = toAttributeArrays(mesh.attributes<VertexHandle>());
+    uvPointAttributeArrays = toAttributeArrays(mesh.attributes<UVPointHandle>());
+    edgeAttributeArrays = toAttributeArrays(mesh.attributes<EdgeHandle>());
+    faceAttributeArrays = toAttributeArrays(mesh.attributes<FaceHandle>());
 }
 
 Mesh MeshData::toMesh() const {
@@ -89,6 +141,11 @@ Mesh MeshData::toMesh() const {
         mesh.addFace(uvPoints, material);
     }
 
+    addAttributeColumns(mesh.attributes<VertexHandle>(), vertexAttributeArrays);
+    addAttributeColumns(mesh.attributes<UVPointHandle>(), uvPointAttributeArrays);
+    addAttributeColumns(mesh.attributes<EdgeHandle>(), edgeAttributeArrays);
+    addAttributeColumns(mesh.attributes<FaceHandle>(), faceAttributeArrays);
+
     return mesh;
 }
 
@@ -96,34 +153,42 @@ void to_json(nlohmann::json &json, const MeshData &meshData) {
     json["vertex"]["position"] = toDataString(meshData.vertexPositionArray);
     json["vertex"]["selected"] = toDataString(meshData.vertexSelectedArray);
     json["vertex"]["corner"] = toDataString(meshData.vertexCornerArray);
+    json["vertex"]["attributes"] = toAttributesJSON(meshData.vertexAttributeArrays);
 
     json["uvPoint"]["position"] = toDataString(meshData.uvPositionArray);
     json["uvPoint"]["vertex"] = toDataString(meshData.uvVertexArray);
+    json["uvPoint"]["attributes"] = toAttributesJSON(meshData.uvPointAttributeArrays);
 
     json["edge"]["sharp"] = toDataString(meshData.edgeSharpArray);
     json["edge"]["vertices"] = toDataString(meshData.edgeVerticesArray);
     json["edge"]["crease"] = toDataString(meshData.edgeCreaseArray);
+    json["edge"]["attributes"] = toAttributesJSON(meshData.edgeAttributeArrays);
 
     json["face"]["material"] = toDataString(meshData.faceMaterialArray);
     json["face"]["vertexCount"] = toDataString(meshData.faceVertexCountArray);
     json["face"]["uvPoint"] = toDataString(meshData.faceUVPointArray);
+    json["face"]["attributes"] = toAttributesJSON(meshData.faceAttributeArrays);
 }
 
 void from_json(const nlohmann::json &json, MeshData &meshData) {
     meshData.vertexPositionArray = fromDataString<glm::vec3>(json["vertex"]["position"]);
     meshData.vertexSelectedArray = fromDataString<uint8_t>(json["vertex"]["selected"]);
     meshData.vertexCornerArray = fromDataString<float>(json["vertex"]["corner"]);
+    meshData.vertexAttributeArrays = fromAttributesJSON(json["vertex"]);
 
     meshData.uvPositionArray = fromDataString<glm::vec2>(json["uvPoint"]["position"]);
     meshData.uvVertexArray = fromDataString<int32_t>(json["uvPoint"]["vertex"]);
+    meshData.uvPointAttributeArrays = fromAttributesJSON(json["uvPoint"]);
 
     meshData.edgeSharpArray = fromDataString<uint8_t>(json["edge"]["sharp"]);
     meshData.edgeCreaseArray = fromDataString<float>(json["edge"]["crease"]);
     meshData.edgeVerticesArray = fromDataString<std::array<int32_t, 2>>(json["edge"]["vertices"]);
+    meshData.edgeAttributeArrays = fromAttributesJSON(json["edge"]);
 
     meshData.faceMaterialArray = fromDataString<int32_t>(json["face"]["material"]);
     meshData.faceVertexCountArray = fromDataString<int32_t>(json["face"]["vertexCount"]);
     meshData.faceUVPointArray = fromDataString<int32_t>(json["face"]["uvPoint"]);
+    meshData.faceAttributeArrays = fromAttributesJSON(json["face"]);
 }
 
 } // namespace meshlib
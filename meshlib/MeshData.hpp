@@ -1,6 +1,7 @@
 #pragma once
 #include <glm/glm.hpp>
 #include <nlohmann/json_fwd.hpp>
+#include <string>
 #include <vector>
 
 namespace meshlib {
@@ -8,20 +9,31 @@ namespace meshlib {
 class Mesh;
 
 struct MeshData {
+    // custom attribute column (see Mesh::addAttribute), one value of valueSize bytes per element
+    struct AttributeArray {
+        std::string name;
+        int32_t valueSize = 0;
+        std::vector<uint8_t> data;
+    };
+
     std::vector<glm::vec3> vertexPositionArray;
     std::vector<uint8_t> vertexSelectedArray;
     std::vector<float> vertexCornerArray;
+    std::vector<AttributeArray> vertexAttributeArrays;
 
     std::vector<glm::vec2> uvPositionArray;
     std::vector<int32_t> uvVertexArray;
+    std::vector<AttributeArray> uvPointAttributeArrays;
 
     std::vector<uint8_t> edgeSharpArray;
     std::vector<float> edgeCreaseArray;
     std::vector<std::array<int32_t, 2>> edgeVerticesArray;
+    std::vector<AttributeArray> edgeAttributeArrays;
 
     std::vector<int32_t> faceMaterialArray;
     std::vector<int32_t> faceVertexCountArray;
     std::vector<int32_t> faceUVPointArray;
+    std::vector<AttributeArray> faceAttributeArrays;
 
     explicit MeshData(const Mesh &mesh);
     Mesh toMesh() const;
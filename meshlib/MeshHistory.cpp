@@ -0,0 +1,460 @@
+#include "Mesh.hpp"
+#include <algorithm>
+#include <cstring>
+
+namespace meshlib {
+
+struct Mesh::HistoryStep {
+    struct Change {
+        HistoryField field;
+        uint8_t element;
+        // attribute column, -1 for the other fields
+        int32_t column;
+        // element, or chunk for PositionChunk and UVPositionChunk
+        int32_t index;
+        // bytes of each value
+        uint32_t size;
+        // offsets of the values in values. Chunks and columns keep one image, swapped with the mesh data by undo()
+        // and redo(), so that a bulk operation costs one copy of the data it touched.
+        size_t before;
+        size_t after;
+
+        bool isImage() const { return field >= HistoryField::PositionChunk; }
+        bool isSameField(const Change &other) const {
+            return field == other.field && element == other.element && column == other.column && index == other.index;
+        }
+    };
+
+    // the elements the step added, moved here by undo() and back by redo()
+    struct Added {
+        std::vector<VertexData> vertices;
+        std::vector<glm::vec3> positions;
+        std::vector<uint8_t> selection;
+        std::vector<UVPointData> uvPoints;
+        std::vector<glm::vec2> uvPositions;
+        std::vector<EdgeData> edges;
+        std::vector<FaceData> faces;
+        // values per element type and column
+        std::array<std::vector<std::vector<std::byte>>, 4> attributes;
+    };
+
+    std::string name;
+    std::array<uint32_t, 4> countsBefore{};
+    std::array<uint32_t, 4> countsAfter{};
+    std::vector<Change> changes;
+    std::vector<std::byte> values;
+    // indices of the chunk and column changes, each recorded once
+    std::vector<size_t> images;
+    Added added;
+    // bytes counted against History::maxBytes, fixed when the step ends
+    size_t bytes = 0;
+
+    static std::array<uint32_t, 4> elementCounts(const Mesh &mesh) {
+        return {uint32_t(mesh._vertices.size()), uint32_t(mesh._uvPoints.size()), uint32_t(mesh._edges.size()),
+                uint32_t(mesh._faces.size())};
+    }
+
+    static AttributeSet &attributeSet(Mesh &mesh, int element) {
+        std::array<AttributeSet *, 4> sets{&mesh._vertexAttributes, &mesh._uvPointAttributes, &mesh._edgeAttributes, &mesh._faceAttributes};
+        return *sets[element];
+    }
+
+    template <typename T>
+    static std::byte *bytesOf(T &value) {
+        return reinterpret_cast<std::byte *>(&value);
+    }
+
+    // where the value of change is stored in mesh
+    static std::byte *target(Mesh &mesh, const Change &change) {
+        int i = change.index;
+        switch (change.field) {
+        case HistoryField::VertexDeleted:
+            return bytesOf(mesh._vertices[i].isDeleted);
+        case HistoryField::Selected:
+            return bytesOf(mesh._selection[i]);
+        case HistoryField::Corner:
+            return bytesOf(mesh._vertices[i].corner);
+        case HistoryField::Position:
+            return bytesOf(mesh._positions[i]);
+        case HistoryField::UVPointDeleted:
+            return bytesOf(mesh._uvPoints[i].isDeleted);
+        case HistoryField::UVPosition:
+            return bytesOf(mesh._uvPositions[i]);
+        case HistoryField::EdgeDeleted:
+            return bytesOf(mesh._edges[i].isDeleted);
+        case HistoryField::Sharp:
+            return bytesOf(mesh._edges[i].isSharp);
+        case HistoryField::Crease:
+            return bytesOf(mesh._edges[i].crease);
+        case HistoryField::FaceDeleted:
+            return bytesOf(mesh._faces[i].isDeleted);
+        case HistoryField::Material:
+            return bytesOf(mesh._faces[i].material);
+        case HistoryField::Attribute:
+            return attributeSet(mesh, change.element).column(change.column).data() + size_t(i) * change.size;
+        case HistoryField::PositionChunk:
+            return bytesOf(*mesh._positions.chunkData(size_t(i)));
+        case HistoryField::UVPositionChunk:
+            return bytesOf(*mesh._uvPositions.chunkData(size_t(i)));
+        case HistoryField::AttributeColumn:
+            return attributeSet(mesh, change.element).column(change.column).data();
+        }
+        return nullptr;
+    }
+
+    void apply(Mesh &mesh, const Change &change, bool undo) {
+        std::byte *data = target(mesh, change);
+        if (change.isImage()) {
+            std::swap_ranges(data, data + change.size, values.data() + change.before);
+        } else {
+            std::memcpy(data, values.data() + (undo ? change.before : change.after), change.size);
+        }
+    }
+
+    // chunks and columns handed out for writing but left as they were
+    void dropUnchangedImages(Mesh &mesh) {
+        auto unchanged = [&](const Change &change) {
+            return change.isImage() && std::memcmp(target(mesh, change), values.data() + change.before, change.size) == 0;
+        };
+        if (std::none_of(changes.begin(), changes.end(), unchanged)) {
+            return;
+        }
+        std::vector<Change> kept;
+        std::vector<std::byte> keptValues;
+        images.clear();
+        for (auto change : changes) {
+            if (unchanged(change)) {
+                continue;
+            }
+            const std::byte *data = values.data() + change.before;
+            size_t size = change.isImage() ? change.size : 2 * size_t(change.size);
+            change.before = keptValues.size();
+            change.after = change.isImage() ? change.before : change.before + change.size;
+            keptValues.insert(keptValues.end(), data, data + size);
+            if (change.isImage()) {
+                images.push_back(kept.size());
+            }
+            kept.push_back(change);
+        }
+        changes = std::move(kept);
+        values = std::move(keptValues);
+    }
+
+    // Merges the changes of each field into one, dropping those that end where they began. Chunk and column images
+    // may overlap single changes, so steps with images keep their order.
+    void compact() {
+        if (!images.empty()) {
+            return;
+        }
+        std::stable_sort(changes.begin(), changes.end(), [](const Change &a, const Change &b) {
+            return std::tie(a.field, a.element, a.column, a.index) < std::tie(b.field, b.element, b.column, b.index);
+        });
+        std::vector<Change> merged;
+        std::vector<std::byte> mergedValues;
+        for (size_t begin = 0, end = 0; begin < changes.size(); begin = end) {
+            while (end < changes.size() && changes[end].isSameField(changes[begin])) {
+                ++end;
+            }
+            auto change = changes[begin];
+            const std::byte *before = values.data() + change.before;
+            const std::byte *after = values.data() + changes[end - 1].after;
+            if (std::memcmp(before, after, change.size) == 0) {
+                continue;
+            }
+            change.before = mergedValues.size();
+            change.after = change.before + change.size;
+            mergedValues.insert(mergedValues.end(), before, before + change.size);
+            mergedValues.insert(mergedValues.end(), after, after + change.size);
+            merged.push_back(change);
+        }
+        changes = std::move(merged);
+        values = std::move(mergedValues);
+    }
+};
+
+namespace {
+
+// removes the references to elements from count on, which are the last ones as elements are only appended
+template <typename THandles>
+void popAdded(THandles &handles, uint32_t count) {
+    while (!handles.empty() && uint32_t(handles.back().index) >= count) {
+        handles.pop_back();
+    }
+}
+
+} // namespace
+
+void Mesh::recordChange(HistoryField field, int element, int column, int index, const void *before, const void *after, size_t size) {
+    if (std::memcmp(before, after, size) == 0) {
+        return;
+    }
+    std::lock_guard lock(*_history.mutex);
+    auto &step = *_history.current;
+    size_t offset = step.values.size();
+    step.values.resize(offset + 2 * size);
+    std::memcpy(step.values.data() + offset, before, size);
+    std::memcpy(step.values.data() + offset + size, after, size);
+    step.changes.push_back({field, uint8_t(element), int32_t(column), int32_t(index), uint32_t(size), offset, offset + size});
+}
+
+void Mesh::recordImage(HistoryField field, int element, int index) {
+    // only the values of elements that existed when the operation began
+    size_t begin = field == HistoryField::AttributeColumn ? 0 : size_t(index) * ChunkSize;
+    size_t end = _history.baseCounts[element];
+    if (field != HistoryField::AttributeColumn) {
+        end = std::min(end, begin + ChunkSize);
+    }
+    if (begin >= end) {
+        return;
+    }
+    size_t valueSize = field == HistoryField::PositionChunk     ? sizeof(glm::vec3)
+                       : field == HistoryField::UVPositionChunk ? sizeof(glm::vec2)
+                                                                : HistoryStep::attributeSet(*this, element).column(index).valueSize();
+    std::lock_guard lock(*_history.mutex);
+    auto &step = *_history.current;
+    for (auto image : step.images) {
+        auto &change = step.changes[image];
+        if (change.field == field && change.element == element && change.index == (field == HistoryField::AttributeColumn ? -1 : index) &&
+            change.column == (field == HistoryField::AttributeColumn ? index : -1)) {
+            return;
+        }
+    }
+    HistoryStep::Change change{field, uint8_t(element), -1, index, uint32_t((end - begin) * valueSize), step.values.size(), step.values.size()};
+    if (field == HistoryField::AttributeColumn) {
+        change.column = index;
+        change.index = -1;
+    }
+    const std::byte *data = HistoryStep::target(*this, change);
+    step.values.insert(step.values.end(), data, data + change.size);
+    step.images.push_back(step.changes.size());
+    step.changes.push_back(change);
+}
+
+void Mesh::beginOperation(std::string_view name) {
+    if (_history.depth++ > 0) {
+        return;
+    }
+    if (!_history.mutex) {
+        _history.mutex = std::make_unique<std::mutex>();
+    }
+    _history.current = std::make_shared<HistoryStep>();
+    _history.current->name = name;
+    _history.current->countsBefore = HistoryStep::elementCounts(*this);
+    _history.baseCounts = _history.current->countsBefore;
+}
+
+void Mesh::endOperation() {
+    if (_history.depth == 0 || --_history.depth > 0) {
+        return;
+    }
+    auto step = std::move(_history.current);
+    step->countsAfter = HistoryStep::elementCounts(*this);
+    step->dropUnchangedImages(*this);
+    step->compact();
+    if (step->changes.empty() && step->countsAfter == step->countsBefore) {
+        return;
+    }
+    step->changes.shrink_to_fit();
+    step->values.shrink_to_fit();
+    step->images = {};
+    step->bytes = sizeof(HistoryStep) + step->name.capacity() + step->changes.capacity() * sizeof(HistoryStep::Change) +
+                  step->values.capacity();
+
+    // a new step replaces the undone ones
+    while (_history.steps.size() > _history.doneCount) {
+        _history.bytes -= _history.steps.back()->bytes;
+        _history.steps.pop_back();
+    }
+    _history.steps.push_back(std::move(step));
+    _history.bytes += _history.steps.back()->bytes;
+    ++_history.doneCount;
+    setHistoryLimits(_history.maxSteps, _history.maxBytes);
+}
+
+std::string_view Mesh::undoName() const {
+    return _history.doneCount > 0 ? std::string_view(_history.steps[_history.doneCount - 1]->name) : std::string_view();
+}
+
+std::string_view Mesh::redoName() const {
+    return _history.doneCount < _history.steps.size() ? std::string_view(_history.steps[_history.doneCount]->name) : std::string_view();
+}
+
+bool Mesh::undo() {
+    if (!canUndo()) {
+        return false;
+    }
+    MESHLIB_SCOPED_OPERATION("Mesh::undo");
+    changeTopology();
+    auto &step = *_history.steps[--_history.doneCount];
+    for (auto change = step.changes.rbegin(); change != step.changes.rend(); ++change) {
+        step.apply(*this, *change, true);
+    }
+
+    // move the added elements out, then drop the references the existing elements got to them
+    auto &before = step.countsBefore;
+    auto &added = step.added;
+    for (size_t i = before[0]; i < _vertices.size(); ++i) {
+        added.vertices.push_back(std::move(_vertices[i]));
+        added.positions.push_back(std::as_const(_positions)[i]);
+        added.selection.push_back(std::as_const(_selection)[i]);
+    }
+    for (size_t i = before[1]; i < _uvPoints.size(); ++i) {
+        added.uvPoints.push_back(std::move(_uvPoints[i]));
+        added.uvPositions.push_back(std::as_const(_uvPositions)[i]);
+    }
+    for (size_t i = before[2]; i < _edges.size(); ++i) {
+        added.edges.push_back(std::move(_edges[i]));
+    }
+    for (size_t i = before[3]; i < _faces.size(); ++i) {
+        added.faces.push_back(std::move(_faces[i]));
+    }
+    for (int element = 0; element < 4; ++element) {
+        auto &set = HistoryStep::attributeSet(*this, element);
+        auto &columns = added.attributes[element];
+        columns.resize(set.columnCount());
+        for (size_t c = 0; c < set.columnCount(); ++c) {
+            auto &column = std::as_const(set).column(int(c));
+            const std::byte *data = column.data() + before[element] * column.valueSize();
+            columns[c].assign(data, data + (column.size() - before[element]) * column.valueSize());
+        }
+        set.resize(before[element]);
+    }
+
+    for (auto &uvPoint : added.uvPoints) {
+        if (uint32_t(uvPoint.vertex.index) < before[0]) {
+            popAdded(_vertices[uvPoint.vertex.index].uvPoints, before[1]);
+        }
+    }
+    for (auto &edge : added.edges) {
+        for (auto v : edge.vertices) {
+            if (uint32_t(v.index) < before[0]) {
+                popAdded(_vertices[v.index].edges, before[2]);
+            }
+        }
+    }
+    for (auto &face : added.faces) {
+        for (auto uvPoint : face.uvPoints) {
+            if (uint32_t(uvPoint.index) < before[1]) {
+                popAdded(_uvPoints[uvPoint.index].faces, before[3]);
+            }
+        }
+        for (auto edge : face.edges) {
+            if (uint32_t(edge.index) < before[2]) {
+                popAdded(_edges[edge.index].faces, before[3]);
+            }
+        }
+    }
+
+    _vertices.resize(before[0]);
+    _positions.resize(before[0]);
+    _selection.resize(before[0]);
+    _uvPoints.resize(before[1]);
+    _uvPositions.resize(before[1]);
+    _edges.resize(before[2]);
+    _faces.resize(before[3]);
+    return true;
+}
+
+bool Mesh::redo() {
+    if (!canRedo()) {
+        return false;
+    }
+    MESHLIB_SCOPED_OPERATION("Mesh::redo");
+    changeTopology();
+    auto &step = *_history.steps[_history.doneCount++];
+    auto &before = step.countsBefore;
+    auto &added = step.added;
+
+    // the references of the existing elements to the added ones come in index order, as when they were added
+    for (size_t i = 0; i < added.uvPoints.size(); ++i) {
+        auto v = added.uvPoints[i].vertex;
+        if (uint32_t(v.index) < before[0]) {
+            _vertices[v.index].uvPoints.push_back(UVPointHandle(int(before[1] + i)));
+        }
+    }
+    for (size_t i = 0; i < added.edges.size(); ++i) {
+        for (auto v : added.edges[i].vertices) {
+            if (uint32_t(v.index) < before[0]) {
+                _vertices[v.index].edges.push_back(EdgeHandle(int(before[2] + i)));
+            }
+        }
+    }
+    for (size_t i = 0; i < added.faces.size(); ++i) {
+        auto face = FaceHandle(int(before[3] + i));
+        for (auto uvPoint : added.faces[i].uvPoints) {
+            if (uint32_t(uvPoint.index) < before[1]) {
+                _uvPoints[uvPoint.index].faces.push_back(face);
+            }
+        }
+        for (auto edge : added.faces[i].edges) {
+            if (uint32_t(edge.index) < before[2]) {
+                _edges[edge.index].faces.push_back(face);
+            }
+        }
+    }
+
+    for (size_t i = 0; i < added.vertices.size(); ++i) {
+        _vertices.push_back(std::move(added.vertices[i]));
+        _positions.push_back(added.positions[i]);
+        _selection.push_back(added.selection[i]);
+    }
+    for (size_t i = 0; i < added.uvPoints.size(); ++i) {
+        _uvPoints.push_back(std::move(added.uvPoints[i]));
+        _uvPositions.push_back(added.uvPositions[i]);
+    }
+    for (auto &edge : added.edges) {
+        _edges.push_back(std::move(edge));
+    }
+    for (auto &face : added.faces) {
+        _faces.push_back(std::move(face));
+    }
+    for (int element = 0; element < 4; ++element) {
+        auto &set = HistoryStep::attributeSet(*this, element);
+        set.resize(step.countsAfter[element]);
+        // columns added since undo() keep zeros
+        auto &columns = added.attributes[element];
+        for (size_t c = 0; c < std::min(columns.size(), set.columnCount()); ++c) {
+            auto &column = set.column(int(c));
+            std::copy(columns[c].begin(), columns[c].end(), column.data() + before[element] * column.valueSize());
+        }
+    }
+    added = {};
+
+    for (auto &change : step.changes) {
+        step.apply(*this, change, false);
+    }
+    return true;
+}
+
+void Mesh::setHistoryLimits(size_t maxSteps, size_t maxBytes) {
+    _history.maxSteps = maxSteps;
+    _history.maxBytes = maxBytes;
+    auto &steps = _history.steps;
+    while (!steps.empty() && (steps.size() > maxSteps || _history.bytes > maxBytes)) {
+        // the oldest step, or the last redo step if all are undone
+        if (_history.doneCount > 0) {
+            _history.bytes -= steps.front()->bytes;
+            steps.erase(steps.begin());
+            --_history.doneCount;
+        } else {
+            _history.bytes -= steps.back()->bytes;
+            steps.pop_back();
+        }
+    }
+}
+
+void Mesh::clearHistory() {
+    _history.steps.clear();
+    _history.doneCount = 0;
+    _history.bytes = 0;
+    // an open operation starts its step over from here, as what it recorded so far may refer to cleared data
+    if (_history.depth > 0) {
+        auto name = std::move(_history.current->name);
+        _history.current = std::make_shared<HistoryStep>();
+        _history.current->name = std::move(name);
+        _history.current->countsBefore = HistoryStep::elementCounts(*this);
+        _history.baseCounts = _history.current->countsBefore;
+    }
+}
+
+} // namespace meshlib
@@ -0,0 +1,42 @@
+#pragma once
+#include "Mesh.hpp"
+#include <memory>
+#include <mutex>
+
+namespace meshlib {
+
+// Immutable copy of a mesh that any number of threads can read with the full Mesh API while the original is edited.
+// It shares storage with the mesh chunk by chunk, so taking one costs O(element count / Mesh::ChunkSize) and the mesh
+// copies only the chunks it writes to afterwards. Custom attribute columns are shared and copied as a whole.
+// The memory resource of the mesh must outlive its snapshots.
+using MeshSnapshot = std::shared_ptr<const Mesh>;
+
+// Must be called on the thread that edits the mesh
+inline MeshSnapshot takeSnapshot(const Mesh &mesh) {
+    return std::make_shared<const Mesh>(mesh, mesh.memoryResource());
+}
+
+// Hands the latest snapshot of an edited mesh to reader threads; the lock is only held to copy or swap a pointer, so
+// neither side waits for the other beyond that.
+class MeshPublisher {
+  public:
+    // by the editing thread, typically after each edit
+    void publish(const Mesh &mesh) {
+        auto snapshot = takeSnapshot(mesh);
+        std::lock_guard<std::mutex> lock(_mutex);
+        _snapshot.swap(snapshot);
+        // the previous snapshot is released after unlocking
+    }
+
+    // by any thread; the snapshot stays valid while it is held, whatever is published later
+    MeshSnapshot latest() const {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _snapshot;
+    }
+
+  private:
+    mutable std::mutex _mutex;
+    MeshSnapshot _snapshot;
+};
+
+} // namespace meshlib
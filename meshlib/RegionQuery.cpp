@@ -0,0 +1,97 @@
+#include "RegionQuery.hpp"
+#include "Mesh.hpp"
+#include "util/Instrumentation.hpp"
+#include "util/Parallel.hpp"
+#include <algorithm>
+#include <mutex>
+
+namespace meshlib {
+
+namespace {
+
+// Calls emit(v, output) for each input vertex and returns the sorted output without duplicates
+template <typename THandle, typename TEmit>
+std::pmr::vector<THandle> gather(const VertexHandle *vertices, size_t count, bool parallel, std::pmr::memory_resource *resource,
+                                 TEmit &&emit) {
+    std::pmr::vector<THandle> result(resource);
+    if (parallel) {
+        std::mutex mutex;
+        parallelForBlocks(0, count, [&](size_t begin, size_t end) {
+            std::vector<THandle> blockResult;
+            for (size_t i = begin; i < end; ++i) {
+                emit(vertices[i], blockResult);
+            }
+            std::lock_guard lock(mutex);
+            result.insert(result.end(), blockResult.begin(), blockResult.end());
+        });
+    } else {
+        for (size_t i = 0; i < count; ++i) {
+            emit(vertices[i], result);
+        }
+    }
+    std::sort(result.begin(), result.end());
+    result.erase(std::unique(result.begin(), result.end()), result.end());
+    return result;
+}
+
+} // namespace
+
+std::pmr::vector<EdgeHandle> RegionQuery::edges(const Mesh &mesh, const VertexHandle *vertices, size_t count,
+                                                std::pmr::memory_resource *resource) {
+    MESHLIB_SCOPED_OPERATION("RegionQuery::edges");
+    mark(mesh, vertices, count);
+    return gather<EdgeHandle>(vertices, count, parallel, resource, [&](VertexHandle v, auto &output) {
+        for (auto e : mesh.edges(v)) {
+            auto &edgeVertices = mesh.vertices(e);
+            auto other = edgeVertices[0] == v ? edgeVertices[1] : edgeVertices[0];
+            // reported by the endpoint with the lower index
+            if (v.index < other.index && isMarked(other)) {
+                output.push_back(e);
+            }
+        }
+    });
+}
+
+std::pmr::vector<FaceHandle> RegionQuery::faces(const Mesh &mesh, const VertexHandle *vertices, size_t count,
+                                                std::pmr::memory_resource *resource) {
+    MESHLIB_SCOPED_OPERATION("RegionQuery::faces");
+    mark(mesh, vertices, count);
+    return gather<FaceHandle>(vertices, count, parallel, resource, [&](VertexHandle v, auto &output) {
+        for (auto uvPoint : mesh.uvPoints(v)) {
+            for (auto f : mesh.faces(uvPoint)) {
+                // reported by the corner vertex with the lowest index
+                bool isInside = true;
+                bool isLowest = true;
+                for (auto faceUVPoint : mesh.uvPoints(f)) {
+                    auto faceVertex = mesh.vertex(faceUVPoint);
+                    isInside = isInside && isMarked(faceVertex);
+                    isLowest = isLowest && faceVertex.index >= v.index;
+                }
+                if (isInside && isLowest) {
+                    output.push_back(f);
+                }
+            }
+        }
+    });
+}
+
+RegionQuery &RegionQuery::forCurrentThread() {
+    static thread_local RegionQuery query;
+    return query;
+}
+
+void RegionQuery::mark(const Mesh &mesh, const VertexHandle *vertices, size_t count) {
+    if (_vertexStamps.size() < mesh.allVertexCount()) {
+        _vertexStamps.resize(mesh.allVertexCount(), 0);
+    }
+    if (++_stamp == 0) {
+        // wrapped around; stale stamps could match again
+        std::fill(_vertexStamps.begin(), _vertexStamps.end(), 0);
+        _stamp = 1;
+    }
+    for (size_t i = 0; i < count; ++i) {
+        _vertexStamps[vertices[i].index] = _stamp;
+    }
+}
+
+} // namespace meshlib
@@ -0,0 +1,71 @@
+#pragma once
+#include "Handle.hpp"
+#include <memory_resource>
+#include <type_traits>
+#include <vector>
+
+namespace meshlib {
+
+class Mesh;
+
+// Finds the edges and faces spanned by a vertex set. Vertices are marked in a stamp array that is kept between
+// queries and reset in O(1) by advancing the stamp, so a query costs O(size of the region) instead of hashing.
+// Results are sorted by index and free of duplicates. One instance serves any number of meshes, but not several
+// threads at once.
+class RegionQuery {
+  public:
+    // split the input vertices over threads for large regions
+    bool parallel = false;
+
+    // edges with both vertices in the set
+    std::pmr::vector<EdgeHandle> edges(const Mesh &mesh, const VertexHandle *vertices, size_t count,
+                                       std::pmr::memory_resource *resource = std::pmr::get_default_resource());
+    // faces with all vertices in the set
+    std::pmr::vector<FaceHandle> faces(const Mesh &mesh, const VertexHandle *vertices, size_t count,
+                                       std::pmr::memory_resource *resource = std::pmr::get_default_resource());
+
+    template <typename TVertices>
+    std::pmr::vector<EdgeHandle> edges(const Mesh &mesh, TVertices &&vertices, std::pmr::memory_resource *resource = std::pmr::get_default_resource()) {
+        if constexpr (isContiguous<TVertices>) {
+            return edges(mesh, vertices.data(), vertices.size(), resource);
+        } else {
+            auto list = collect(vertices, resource);
+            return edges(mesh, list.data(), list.size(), resource);
+        }
+    }
+
+    template <typename TVertices>
+    std::pmr::vector<FaceHandle> faces(const Mesh &mesh, TVertices &&vertices, std::pmr::memory_resource *resource = std::pmr::get_default_resource()) {
+        if constexpr (isContiguous<TVertices>) {
+            return faces(mesh, vertices.data(), vertices.size(), resource);
+        } else {
+            auto list = collect(vertices, resource);
+            return faces(mesh, list.data(), list.size(), resource);
+        }
+    }
+
+    // instance used by Mesh::edges(range) and Mesh::faces(range)
+    static RegionQuery &forCurrentThread();
+
+  private:
+    template <typename TVertices>
+    static constexpr bool isContiguous = std::is_same_v<std::decay_t<TVertices>, std::vector<VertexHandle>> ||
+                                         std::is_same_v<std::decay_t<TVertices>, std::pmr::vector<VertexHandle>>;
+
+    template <typename TVertices>
+    static std::pmr::vector<VertexHandle> collect(TVertices &&vertices, std::pmr::memory_resource *resource) {
+        std::pmr::vector<VertexHandle> list(resource);
+        for (auto v : vertices) {
+            list.push_back(v);
+        }
+        return list;
+    }
+
+    void mark(const Mesh &mesh, const VertexHandle *vertices, size_t count);
+    bool isMarked(VertexHandle v) const { return _vertexStamps[v.index] == _stamp; }
+
+    std::vector<uint32_t> _vertexStamps;
+    uint32_t _stamp = 0;
+};
+
+} // namespace meshlib
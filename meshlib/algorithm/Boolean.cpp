@@ -0,0 +1,801 @@
+#include "Boolean.hpp"
+#include "Triangulate.hpp"
+#include "../util/Instrumentation.hpp"
+#include "../util/Parallel.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <mutex>
+#include <numeric>
+#include <unordered_map>
+
+using namespace glm;
+
+namespace meshlib {
+
+namespace {
+
+// leaves of the hierarchy hold up to this many triangles
+constexpr uint32_t LeafSize = 8;
+// nodes further than this many radii from a query point count as a dipole in the winding number
+constexpr double FarFieldRatio = 2;
+
+// > 0 if d lies on the side of triangle a b c that its normal points to
+double orientation(const dvec3 &a, const dvec3 &b, const dvec3 &c, const dvec3 &d) {
+    return dot(cross(b - a, c - a), d - a);
+}
+
+// Sign of an orientation against edge a b, with ties broken by the vertex order of the edge. The two triangles of an
+// edge see it in opposite directions, so a segment through the edge crosses exactly one of them.
+bool isPositive(double orientation, int a, int b) {
+    return orientation > 0 || (orientation == 0 && a < b);
+}
+
+double solidAngle(const dvec3 &point, const dvec3 &p0, const dvec3 &p1, const dvec3 &p2) {
+    auto a = p0 - point;
+    auto b = p1 - point;
+    auto c = p2 - point;
+    double la = length(a);
+    double lb = length(b);
+    double lc = length(c);
+    double denominator = la * lb * lc + dot(a, b) * lc + dot(b, c) * la + dot(c, a) * lb;
+    return 2 * std::atan2(dot(a, cross(b, c)), denominator);
+}
+
+struct Box {
+    dvec3 min{std::numeric_limits<double>::max()};
+    dvec3 max{-std::numeric_limits<double>::max()};
+
+    void add(const dvec3 &point) {
+        min = glm::min(min, point);
+        max = glm::max(max, point);
+    }
+
+    bool overlaps(const Box &other) const {
+        return min.x <= other.max.x && other.min.x <= max.x && min.y <= other.max.y && other.min.y <= max.y &&
+               min.z <= other.max.z && other.min.z <= max.z;
+    }
+};
+
+// One input as triangles, with double positions for the intersection tests
+struct Side {
+    explicit Side(const Mesh &mesh) : mesh(mesh), triangulation(triangulate(mesh)) {
+        triangleFaces.resize(triangulation.triangleCount());
+        for (size_t f = 0; f < mesh.allFaceCount(); ++f) {
+            for (uint32_t t = triangulation.faceOffsets[f]; t < triangulation.faceOffsets[f + 1]; ++t) {
+                triangleFaces[t] = FaceHandle(int(f));
+            }
+        }
+        positions.resize(mesh.allVertexCount());
+        for (size_t v = 0; v < positions.size(); ++v) {
+            positions[v] = dvec3(mesh.position(VertexHandle(int(v))));
+        }
+        triangleVertices.resize(triangulation.triangles.size());
+        parallelFor(0, triangleVertices.size(), [&](size_t i) { triangleVertices[i] = mesh.vertex(triangulation.triangles[i]).index; });
+    }
+
+    size_t triangleCount() const { return triangleFaces.size(); }
+    UVPointHandle uvPoint(size_t triangle, int corner) const { return triangulation.triangles[3 * triangle + corner]; }
+    int vertex(size_t triangle, int corner) const { return triangleVertices[3 * triangle + corner]; }
+    const dvec3 &position(size_t triangle, int corner) const { return positions[vertex(triangle, corner)]; }
+
+    Box box(size_t triangle) const {
+        Box box;
+        for (int i = 0; i < 3; ++i) {
+            box.add(position(triangle, i));
+        }
+        return box;
+    }
+
+    const Mesh &mesh;
+    Triangulation triangulation;
+    std::vector<FaceHandle> triangleFaces;
+    std::vector<dvec3> positions;
+    // vertex indices of the corners of the triangles
+    std::vector<int32_t> triangleVertices;
+};
+
+// Bounding volume hierarchy over the triangles of a side. Nodes also keep the area weighted normal sum and centroid of
+// their triangles, which stand in for them in the winding number at points far enough away.
+class TriangleTree {
+  public:
+    explicit TriangleTree(const Side &side) : _side(side) {
+        _triangles.resize(side.triangleCount());
+        std::iota(_triangles.begin(), _triangles.end(), 0);
+        _centroids.resize(side.triangleCount());
+        for (size_t t = 0; t < _centroids.size(); ++t) {
+            _centroids[t] = (side.position(t, 0) + side.position(t, 1) + side.position(t, 2)) / 3.0;
+        }
+        if (!_triangles.empty()) {
+            build(0, uint32_t(_triangles.size()));
+        }
+    }
+
+    // calls func(triangle) for the triangles whose bounding boxes overlap box
+    template <typename TFunc>
+    void forEachOverlap(const Box &box, TFunc &&func) const {
+        SmallVector<uint32_t, 64> stack;
+        if (!_nodes.empty()) {
+            stack.push_back(0);
+        }
+        while (!stack.empty()) {
+            uint32_t index = stack.back();
+            stack.pop_back();
+            auto &node = _nodes[index];
+            if (!node.box.overlaps(box)) {
+                continue;
+            }
+            if (node.second != 0) {
+                stack.push_back(index + 1);
+                stack.push_back(node.second);
+                continue;
+            }
+            for (uint32_t i = node.begin; i < node.end; ++i) {
+                if (_side.box(_triangles[i]).overlaps(box)) {
+                    func(_triangles[i]);
+                }
+            }
+        }
+    }
+
+    // about 1 inside the closed surface, 0 outside
+    double windingNumber(const dvec3 &point) const {
+        double angle = 0;
+        SmallVector<uint32_t, 64> stack;
+        if (!_nodes.empty()) {
+            stack.push_back(0);
+        }
+        while (!stack.empty()) {
+            uint32_t index = stack.back();
+            stack.pop_back();
+            auto &node = _nodes[index];
+            auto offset = node.center - point;
+            double distance = length(offset);
+            if (node.second != 0 && distance > FarFieldRatio * node.radius) {
+                angle += dot(offset, node.areaNormal) / (distance * distance * distance);
+            } else if (node.second != 0) {
+                stack.push_back(index + 1);
+                stack.push_back(node.second);
+            } else {
+                for (uint32_t i = node.begin; i < node.end; ++i) {
+                    uint32_t t = _triangles[i];
+                    angle += solidAngle(point, _side.position(t, 0), _side.position(t, 1), _side.position(t, 2));
+                }
+            }
+        }
+        return angle / (4 * M_PI);
+    }
+
+  private:
+    struct Node {
+        Box box;
+        dvec3 center{0};
+        dvec3 areaNormal{0};
+        double area = 0;
+        double radius = 0;
+        uint32_t begin = 0;
+        uint32_t end = 0;
+        // the first child follows its parent; 0 for leaves
+        uint32_t second = 0;
+    };
+
+    const Side &_side;
+    std::vector<uint32_t> _triangles;
+    std::vector<dvec3> _centroids;
+    std::vector<Node> _nodes;
+
+    // the sums of a node come from its children, so that each triangle is measured once
+    uint32_t build(uint32_t begin, uint32_t end) {
+        uint32_t index = uint32_t(_nodes.size());
+        _nodes.emplace_back();
+        Node node;
+        node.begin = begin;
+        node.end = end;
+        dvec3 weightedCenter(0);
+        if (end - begin <= LeafSize) {
+            for (uint32_t i = begin; i < end; ++i) {
+                uint32_t t = _triangles[i];
+                auto normal = cross(_side.position(t, 1) - _side.position(t, 0), _side.position(t, 2) - _side.position(t, 0)) * 0.5;
+                node.areaNormal += normal;
+                node.area += length(normal);
+                weightedCenter += _centroids[t] * length(normal);
+                for (int c = 0; c < 3; ++c) {
+                    node.box.add(_side.position(t, c));
+                }
+            }
+        } else {
+            // median split along the longest axis of the centroids
+            Box centroidBox;
+            for (uint32_t i = begin; i < end; ++i) {
+                centroidBox.add(_centroids[_triangles[i]]);
+            }
+            auto extent = centroidBox.max - centroidBox.min;
+            int axis = extent.x >= extent.y && extent.x >= extent.z ? 0 : extent.y >= extent.z ? 1 : 2;
+            uint32_t middle = begin + (end - begin) / 2;
+            std::nth_element(_triangles.begin() + begin, _triangles.begin() + middle, _triangles.begin() + end,
+                             [&](uint32_t a, uint32_t b) { return _centroids[a][axis] < _centroids[b][axis]; });
+            build(begin, middle);
+            node.second = build(middle, end);
+            for (auto &child : {_nodes[index + 1], _nodes[node.second]}) {
+                node.box.add(child.box.min);
+                node.box.add(child.box.max);
+                node.areaNormal += child.areaNormal;
+                node.area += child.area;
+                weightedCenter += child.center * child.area;
+            }
+        }
+        node.center = node.area > 0 ? weightedCenter / node.area : (node.box.min + node.box.max) * 0.5;
+        // bounded by the farthest corner of the box
+        node.radius = length(glm::max(node.center - node.box.min, node.box.max - node.center));
+        _nodes[index] = node;
+        return index;
+    }
+};
+
+// Corner of an intersection curve: where edge v0 v1 (v0 < v1) of a triangle of side crosses triangle of the other
+// side. Neighbouring triangles compute the crossing of a shared edge alike, so they share the point.
+struct PointKey {
+    int32_t side;
+    int32_t v0;
+    int32_t v1;
+    uint32_t triangle;
+
+    bool operator==(const PointKey &other) const {
+        return side == other.side && v0 == other.v0 && v1 == other.v1 && triangle == other.triangle;
+    }
+};
+
+struct PointKeyHash {
+    size_t operator()(const PointKey &key) const {
+        uint64_t edge = uint64_t(uint32_t(key.v0)) << 32 | uint32_t(key.v1);
+        uint64_t other = uint64_t(key.triangle) << 1 | uint64_t(key.side);
+        return size_t((edge * 0x9E3779B97F4A7C15ull) ^ (other * 0xC2B2AE3D27D4EB4Full));
+    }
+};
+
+struct Crossing {
+    PointKey key;
+    dvec3 position;
+};
+
+// crossings of the edges of two triangles with each other; two for triangles in general position that intersect
+struct PairCrossings {
+    std::array<Crossing, 2> crossings;
+    int count = 0;
+};
+
+// adds the crossings of the edges of triangle edgeTriangle of edgeSide with the inside of faceTriangle of faceSide
+void crossEdges(const Side &edgeSide, int side, uint32_t edgeTriangle, const Side &faceSide, uint32_t faceTriangle,
+                PairCrossings &result) {
+    std::array<int, 3> faceVertices;
+    std::array<dvec3, 3> face;
+    for (int i = 0; i < 3; ++i) {
+        faceVertices[i] = faceSide.vertex(faceTriangle, i);
+        face[i] = faceSide.positions[faceVertices[i]];
+    }
+    for (int k = 0; k < 3; ++k) {
+        int v0 = edgeSide.vertex(edgeTriangle, k);
+        int v1 = edgeSide.vertex(edgeTriangle, (k + 1) % 3);
+        if (v0 > v1) {
+            std::swap(v0, v1);
+        }
+        auto &p = edgeSide.positions[v0];
+        auto &q = edgeSide.positions[v1];
+        double dp = orientation(face[0], face[1], face[2], p);
+        double dq = orientation(face[0], face[1], face[2], q);
+        if ((dp >= 0) == (dq >= 0)) {
+            continue;
+        }
+        bool s0 = isPositive(orientation(p, q, face[0], face[1]), faceVertices[0], faceVertices[1]);
+        bool s1 = isPositive(orientation(p, q, face[1], face[2]), faceVertices[1], faceVertices[2]);
+        bool s2 = isPositive(orientation(p, q, face[2], face[0]), faceVertices[2], faceVertices[0]);
+        if (s0 != s1 || s1 != s2) {
+            continue;
+        }
+        if (result.count < 2) {
+            result.crossings[result.count] = {{side, v0, v1, faceTriangle}, p + (q - p) * (dp / (dp - dq))};
+        }
+        ++result.count;
+    }
+}
+
+// A triangle crossed by the other mesh and the pieces it is split into. Local vertices 0 to 2 are the corners of the
+// triangle, the others the intersection points in points.
+struct Cut {
+    uint32_t triangle = 0;
+    std::vector<std::array<uint32_t, 2>> segments;
+    // the triangle of the other side crossing this one along each segment
+    std::vector<uint32_t> others;
+    std::vector<uint32_t> points;
+    // three local vertices per kept piece, wound like the triangle
+    std::vector<uint32_t> pieces;
+
+    uint32_t local(uint32_t point) const {
+        return uint32_t(3 + (std::lower_bound(points.begin(), points.end(), point) - points.begin()));
+    }
+};
+
+bool crossesProperly(dvec2 a, dvec2 b, dvec2 c, dvec2 d) {
+    auto side = [](dvec2 p, dvec2 q, dvec2 r) { return (q.x - p.x) * (r.y - p.y) - (q.y - p.y) * (r.x - p.x); };
+    double abc = side(a, b, c);
+    double abd = side(a, b, d);
+    double cda = side(c, d, a);
+    double cdb = side(c, d, b);
+    return ((abc > 0 && abd < 0) || (abc < 0 && abd > 0)) && ((cda > 0 && cdb < 0) || (cda < 0 && cdb > 0));
+}
+
+// Splits the triangle of cut along its segments: the boundary and the segments form a planar graph whose bounded
+// faces are triangulated. Curves that do not reach the boundary are first bridged to the nearest visible vertex, so
+// that each face is a single polygon. Faces are kept if they are inside the other side as keepInside says.
+void split(const Side &side, int sideIndex, const Side &otherSide, const TriangleTree &otherTree, const std::vector<dvec3> &points,
+           const std::vector<PointKey> &keys, bool keepInside, Cut &cut) {
+    uint32_t t = cut.triangle;
+    for (auto &segment : cut.segments) {
+        cut.points.push_back(segment[0]);
+        cut.points.push_back(segment[1]);
+    }
+    std::sort(cut.points.begin(), cut.points.end());
+    cut.points.erase(std::unique(cut.points.begin(), cut.points.end()), cut.points.end());
+
+    size_t count = 3 + cut.points.size();
+    std::vector<dvec3> positions(count);
+    for (int i = 0; i < 3; ++i) {
+        positions[i] = side.position(t, i);
+    }
+    for (size_t i = 0; i < cut.points.size(); ++i) {
+        positions[3 + i] = points[cut.points[i]];
+    }
+
+    // projection onto the axis plane closest to the triangle's, keeping its winding counter-clockwise
+    auto normal = cross(positions[1] - positions[0], positions[2] - positions[0]);
+    int axis = std::abs(normal.x) >= std::abs(normal.y) && std::abs(normal.x) >= std::abs(normal.z) ? 0
+               : std::abs(normal.y) >= std::abs(normal.z)                                         ? 1
+                                                                                                  : 2;
+    double flip = normal[axis] < 0 ? -1 : 1;
+    std::vector<dvec2> projected(count);
+    for (size_t i = 0; i < count; ++i) {
+        projected[i] = dvec2(positions[i][(axis + 1) % 3], flip * positions[i][(axis + 2) % 3]);
+    }
+
+    // boundary edges through the points on the triangle's edges, then the segments
+    std::vector<std::array<uint32_t, 2>> edges;
+    for (int k = 0; k < 3; ++k) {
+        int v0 = side.vertex(t, k);
+        int v1 = side.vertex(t, (k + 1) % 3);
+        SmallVector<uint32_t, 8> onEdge;
+        for (size_t i = 0; i < cut.points.size(); ++i) {
+            auto &key = keys[cut.points[i]];
+            if (key.side == sideIndex && key.v0 == std::min(v0, v1) && key.v1 == std::max(v0, v1)) {
+                onEdge.push_back(uint32_t(3 + i));
+            }
+        }
+        auto direction = positions[(k + 1) % 3] - positions[k];
+        std::sort(onEdge.begin(), onEdge.end(), [&](uint32_t a, uint32_t b) {
+            return dot(positions[a] - positions[k], direction) < dot(positions[b] - positions[k], direction);
+        });
+        uint32_t previous = uint32_t(k);
+        for (auto i : onEdge) {
+            edges.push_back({previous, i});
+            previous = i;
+        }
+        edges.push_back({previous, uint32_t((k + 1) % 3)});
+    }
+    for (auto &segment : cut.segments) {
+        uint32_t a = cut.local(segment[0]);
+        uint32_t b = cut.local(segment[1]);
+        edges.push_back({std::min(a, b), std::max(a, b)});
+    }
+    std::sort(edges.begin() + 3, edges.end());
+    edges.erase(std::unique(edges.begin() + 3, edges.end()), edges.end());
+    // unit normal of the other side's triangle crossing along each segment edge, zero for the other edges
+    std::vector<dvec3> otherNormals(edges.size(), dvec3(0));
+    for (size_t i = 0; i < cut.segments.size(); ++i) {
+        uint32_t a = cut.local(cut.segments[i][0]);
+        uint32_t b = cut.local(cut.segments[i][1]);
+        auto e = std::lower_bound(edges.begin() + 3, edges.end(), std::array<uint32_t, 2>{std::min(a, b), std::max(a, b)});
+        auto &o0 = otherSide.position(cut.others[i], 0);
+        auto n = cross(otherSide.position(cut.others[i], 1) - o0, otherSide.position(cut.others[i], 2) - o0);
+        otherNormals[e - edges.begin()] = n / length(n);
+    }
+
+    // bridges from the curves that do not touch the boundary
+    std::vector<uint32_t> components(count);
+    std::iota(components.begin(), components.end(), 0);
+    auto find = [&](uint32_t v) {
+        while (components[v] != v) {
+            v = components[v] = components[components[v]];
+        }
+        return v;
+    };
+    for (auto &edge : edges) {
+        components[find(edge[0])] = find(edge[1]);
+    }
+    for (uint32_t h = 3; h < count; ++h) {
+        if (find(h) == find(0)) {
+            continue;
+        }
+        std::vector<uint32_t> candidates;
+        for (uint32_t v = 0; v < count; ++v) {
+            if (find(v) != find(h)) {
+                candidates.push_back(v);
+            }
+        }
+        auto distanceTo = [&](uint32_t v) { return length(projected[v] - projected[h]); };
+        std::sort(candidates.begin(), candidates.end(), [&](uint32_t a, uint32_t b) { return distanceTo(a) < distanceTo(b); });
+        uint32_t bridge = candidates[0];
+        for (auto candidate : candidates) {
+            bool isVisible = std::none_of(edges.begin(), edges.end(), [&](const std::array<uint32_t, 2> &edge) {
+                return crossesProperly(projected[h], projected[candidate], projected[edge[0]], projected[edge[1]]);
+            });
+            if (isVisible) {
+                bridge = candidate;
+                break;
+            }
+        }
+        edges.push_back({h, bridge});
+        components[find(h)] = find(bridge);
+    }
+    // the bridges cross nothing
+    otherNormals.resize(edges.size(), dvec3(0));
+
+    // half edge 2 * e goes from edges[e][0] to edges[e][1], 2 * e + 1 back
+    auto origin = [&](uint32_t halfEdge) { return edges[halfEdge / 2][halfEdge % 2]; };
+    std::vector<SmallVector<uint32_t, 4>> outgoing(count);
+    for (uint32_t h = 0; h < 2 * edges.size(); ++h) {
+        outgoing[origin(h)].push_back(h);
+    }
+    std::vector<uint32_t> slots(2 * edges.size());
+    for (uint32_t v = 0; v < count; ++v) {
+        auto angle = [&](uint32_t h) {
+            auto d = projected[origin(h ^ 1)] - projected[v];
+            return std::atan2(d.y, d.x);
+        };
+        std::sort(outgoing[v].begin(), outgoing[v].end(), [&](uint32_t a, uint32_t b) { return angle(a) < angle(b); });
+        for (uint32_t i = 0; i < outgoing[v].size(); ++i) {
+            slots[outgoing[v][i]] = i;
+        }
+    }
+
+    // faces left of the half edges: the next half edge turns clockwise from the way back
+    std::vector<bool> visited(2 * edges.size(), false);
+    std::vector<glm::vec3> polygon;
+    std::vector<uint32_t> polygonVertices;
+    std::vector<uint32_t> corners;
+    for (uint32_t start = 0; start < visited.size(); ++start) {
+        if (visited[start]) {
+            continue;
+        }
+        polygonVertices.clear();
+        double area = 0;
+        // The other side crosses the plane of the triangle along the segments, so next to a segment the face is
+        // inside it if it lies behind the crossing triangle: the sine of the angle between the direction into the face
+        // and that triangle's normal is negative. The steepest crossing decides.
+        double crossing = 0;
+        for (uint32_t h = start; !visited[h];) {
+            visited[h] = true;
+            uint32_t from = origin(h);
+            uint32_t to = origin(h ^ 1);
+            polygonVertices.push_back(from);
+            area += projected[from].x * projected[to].y - projected[to].x * projected[from].y;
+            auto &otherNormal = otherNormals[h / 2];
+            if (otherNormal != dvec3(0)) {
+                auto inward = cross(normal, positions[to] - positions[from]);
+                double sine = dot(inward, otherNormal) / length(inward);
+                if (std::abs(sine) > std::abs(crossing)) {
+                    crossing = sine;
+                }
+            }
+            auto &around = outgoing[to];
+            h = around[(slots[h ^ 1] + around.size() - 1) % around.size()];
+        }
+        if (area <= 0 || polygonVertices.size() < 3) {
+            continue;
+        }
+        polygon.clear();
+        for (auto v : polygonVertices) {
+            polygon.push_back(vec3(positions[v]));
+        }
+        corners.resize(3 * (polygon.size() - 2));
+        triangulatePolygon(polygon.data(), polygon.size(), corners.data());
+        bool isInside;
+        if (crossing != 0) {
+            isInside = crossing < 0;
+        } else {
+            // only the boundary and bridges around the face
+            auto &p0 = positions[polygonVertices[corners[0]]];
+            isInside = otherTree.windingNumber((p0 + positions[polygonVertices[corners[1]]] + positions[polygonVertices[corners[2]]]) / 3.0) > 0.5;
+        }
+        if (isInside != keepInside) {
+            continue;
+        }
+        for (size_t i = 0; i < corners.size(); i += 3) {
+            std::array<uint32_t, 3> piece{polygonVertices[corners[i]], polygonVertices[corners[i + 1]], polygonVertices[corners[i + 2]]};
+            if (piece[0] != piece[1] && piece[1] != piece[2] && piece[2] != piece[0]) {
+                cut.pieces.insert(cut.pieces.end(), piece.begin(), piece.end());
+            }
+        }
+    }
+}
+
+// The cut triangles of a side, cuts[indices[t]] for triangle t if it has one
+struct Cuts {
+    std::vector<int32_t> indices;
+    std::vector<Cut> cuts;
+
+    explicit Cuts(size_t triangleCount) : indices(triangleCount, -1) {}
+
+    Cut &of(uint32_t triangle) {
+        if (indices[triangle] < 0) {
+            indices[triangle] = int32_t(cuts.size());
+            cuts.emplace_back().triangle = triangle;
+        }
+        return cuts[indices[triangle]];
+    }
+};
+
+// uv of point in triangle t by its barycentric coordinates
+vec2 interpolateUV(const Side &side, uint32_t t, const dvec3 &point) {
+    auto a = side.position(t, 0);
+    auto e0 = side.position(t, 1) - a;
+    auto e1 = side.position(t, 2) - a;
+    auto d = point - a;
+    double d00 = dot(e0, e0);
+    double d01 = dot(e0, e1);
+    double d11 = dot(e1, e1);
+    double d20 = dot(d, e0);
+    double d21 = dot(d, e1);
+    double denominator = d00 * d11 - d01 * d01;
+    if (denominator == 0) {
+        return side.mesh.uvPosition(side.uvPoint(t, 0));
+    }
+    double w1 = (d11 * d20 - d01 * d21) / denominator;
+    double w2 = (d00 * d21 - d01 * d20) / denominator;
+    auto uv = dvec2(side.mesh.uvPosition(side.uvPoint(t, 0))) * (1 - w1 - w2) + dvec2(side.mesh.uvPosition(side.uvPoint(t, 1))) * w1 +
+              dvec2(side.mesh.uvPosition(side.uvPoint(t, 2))) * w2;
+    return vec2(uv);
+}
+
+} // namespace
+
+Mesh booleanOperation(const Mesh &a, const Mesh &b, BooleanOperation operation) {
+    MESHLIB_SCOPED_OPERATION("booleanOperation");
+    std::array<Side, 2> sides{Side(a), Side(b)};
+    std::array<TriangleTree, 2> trees{TriangleTree(sides[0]), TriangleTree(sides[1])};
+    // per side, whether pieces inside the other mesh are kept, and whether they are turned inside out
+    std::array<bool, 2> keepInside{operation == BooleanOperation::Intersection, operation != BooleanOperation::Union};
+    std::array<bool, 2> isFlipped{false, operation == BooleanOperation::Difference};
+
+    // candidate pairs of triangles with overlapping bounding boxes
+    std::vector<std::array<uint32_t, 2>> pairs;
+    std::mutex pairsMutex;
+    parallelForBlocks(
+        0, sides[0].triangleCount(),
+        [&](size_t begin, size_t end) {
+            std::vector<std::array<uint32_t, 2>> found;
+            for (size_t t = begin; t < end; ++t) {
+                trees[1].forEachOverlap(sides[0].box(t), [&](uint32_t other) { found.push_back({uint32_t(t), other}); });
+            }
+            std::lock_guard lock(pairsMutex);
+            pairs.insert(pairs.end(), found.begin(), found.end());
+        },
+        256);
+    std::sort(pairs.begin(), pairs.end());
+
+    std::vector<PairCrossings> pairCrossings(pairs.size());
+    parallelFor(
+        0, pairs.size(),
+        [&](size_t i) {
+            crossEdges(sides[0], 0, pairs[i][0], sides[1], pairs[i][1], pairCrossings[i]);
+            crossEdges(sides[1], 1, pairs[i][1], sides[0], pairs[i][0], pairCrossings[i]);
+        },
+        256);
+
+    // intersection points, shared by the pairs that cross at them, and the segments between them
+    std::vector<dvec3> points;
+    std::vector<PointKey> keys;
+    std::unordered_map<PointKey, uint32_t, PointKeyHash> pointIndices;
+    auto pointIndex = [&](const Crossing &crossing) {
+        auto [it, isNew] = pointIndices.try_emplace(crossing.key, uint32_t(points.size()));
+        if (isNew) {
+            points.push_back(crossing.position);
+            keys.push_back(crossing.key);
+        }
+        return it->second;
+    };
+    std::vector<std::array<uint32_t, 2>> segments;
+    std::array<Cuts, 2> cuts{Cuts(sides[0].triangleCount()), Cuts(sides[1].triangleCount())};
+    for (size_t i = 0; i < pairs.size(); ++i) {
+        auto &crossings = pairCrossings[i];
+        if (crossings.count != 2) {
+            continue;
+        }
+        std::array<uint32_t, 2> segment{pointIndex(crossings.crossings[0]), pointIndex(crossings.crossings[1])};
+        if (segment[0] == segment[1]) {
+            continue;
+        }
+        segments.push_back(segment);
+        auto &cut0 = cuts[0].of(pairs[i][0]);
+        cut0.segments.push_back(segment);
+        cut0.others.push_back(pairs[i][1]);
+        auto &cut1 = cuts[1].of(pairs[i][1]);
+        cut1.segments.push_back(segment);
+        cut1.others.push_back(pairs[i][0]);
+    }
+
+    for (int s = 0; s < 2; ++s) {
+        parallelFor(
+            0, cuts[s].cuts.size(), [&](size_t i) { split(sides[s], s, sides[1 - s], trees[1 - s], points, keys, keepInside[s], cuts[s].cuts[i]); },
+            8);
+    }
+
+    // Faces that are not cut are classified per patch connected by their edges, as the other mesh crosses none of
+    // these edges; the uncut triangles of cut faces are classified alone
+    std::array<std::vector<uint8_t>, 2> keepTriangle;
+    std::array<std::vector<uint8_t>, 2> isFaceCut;
+    for (int s = 0; s < 2; ++s) {
+        auto &side = sides[s];
+        auto &mesh = side.mesh;
+        auto &offsets = side.triangulation.faceOffsets;
+        auto isKept = [&](uint32_t t) {
+            auto centroid = (side.position(t, 0) + side.position(t, 1) + side.position(t, 2)) / 3.0;
+            return (trees[1 - s].windingNumber(centroid) > 0.5) == keepInside[s];
+        };
+        keepTriangle[s].resize(side.triangleCount(), 0);
+        isFaceCut[s].resize(mesh.allFaceCount(), 0);
+        std::vector<FaceHandle> cutFaces;
+        for (auto &cut : cuts[s].cuts) {
+            auto face = side.triangleFaces[cut.triangle];
+            if (!isFaceCut[s][face.index]) {
+                isFaceCut[s][face.index] = 1;
+                cutFaces.push_back(face);
+            }
+        }
+
+        std::vector<uint32_t> patches(mesh.allFaceCount());
+        std::iota(patches.begin(), patches.end(), 0);
+        auto find = [&](uint32_t f) {
+            while (patches[f] != f) {
+                f = patches[f] = patches[patches[f]];
+            }
+            return f;
+        };
+        for (auto e : mesh.edges()) {
+            int first = -1;
+            for (auto f : mesh.faces(e)) {
+                if (isFaceCut[s][f.index]) {
+                    continue;
+                }
+                if (first < 0) {
+                    first = f.index;
+                } else {
+                    patches[find(uint32_t(f.index))] = find(uint32_t(first));
+                }
+            }
+        }
+        // per patch root: 0 dropped, 1 kept, 2 not classified yet
+        std::vector<uint8_t> patchKept(mesh.allFaceCount(), 2);
+        for (auto f : mesh.faces()) {
+            if (isFaceCut[s][f.index] || offsets[f.index] == offsets[f.index + 1]) {
+                continue;
+            }
+            uint32_t root = find(uint32_t(f.index));
+            if (patchKept[root] == 2) {
+                patchKept[root] = isKept(offsets[f.index]);
+            }
+            std::fill(keepTriangle[s].begin() + offsets[f.index], keepTriangle[s].begin() + offsets[f.index + 1], patchKept[root]);
+        }
+
+        parallelForEach(
+            cutFaces,
+            [&](FaceHandle f) {
+                for (uint32_t t = offsets[f.index]; t < offsets[f.index + 1]; ++t) {
+                    keepTriangle[s][t] = cuts[s].indices[t] < 0 && isKept(t);
+                }
+            },
+            64);
+    }
+
+    Mesh result;
+    std::vector<VertexHandle> pointVertices(points.size(), VertexHandle(-1));
+    std::vector<SmallVector<UVPointHandle, 2>> pointUVPoints(points.size());
+    std::vector<UVPointHandle> faceUVPoints;
+    for (int s = 0; s < 2; ++s) {
+        auto &side = sides[s];
+        auto &mesh = side.mesh;
+        auto &offsets = side.triangulation.faceOffsets;
+        std::vector<VertexHandle> vertices(mesh.allVertexCount(), VertexHandle(-1));
+        std::vector<UVPointHandle> uvPoints(mesh.allUVPointCount(), UVPointHandle(-1));
+        auto uvPointOf = [&](UVPointHandle uvPoint) {
+            if (uvPoints[uvPoint.index].index < 0) {
+                auto v = mesh.vertex(uvPoint);
+                if (vertices[v.index].index < 0) {
+                    vertices[v.index] = result.addVertex(mesh.position(v));
+                    result.setCorner(vertices[v.index], mesh.corner(v));
+                }
+                uvPoints[uvPoint.index] = result.addUVPoint(vertices[v.index], mesh.uvPosition(uvPoint));
+            }
+            return uvPoints[uvPoint.index];
+        };
+        auto pointUVPointOf = [&](uint32_t point, uint32_t t) {
+            if (pointVertices[point].index < 0) {
+                pointVertices[point] = result.addVertex(vec3(points[point]));
+            }
+            auto uv = interpolateUV(side, t, points[point]);
+            for (auto uvPoint : pointUVPoints[point]) {
+                if (result.uvPosition(uvPoint) == uv) {
+                    return uvPoint;
+                }
+            }
+            return pointUVPoints[point].emplace_back(result.addUVPoint(pointVertices[point], uv));
+        };
+        auto addFace = [&](FaceHandle face) {
+            if (isFlipped[s]) {
+                std::reverse(faceUVPoints.begin(), faceUVPoints.end());
+            }
+            result.addFace(faceUVPoints, mesh.material(face));
+        };
+
+        for (auto f : mesh.faces()) {
+            if (offsets[f.index] == offsets[f.index + 1]) {
+                continue;
+            }
+            if (!isFaceCut[s][f.index]) {
+                if (!keepTriangle[s][offsets[f.index]]) {
+                    continue;
+                }
+                faceUVPoints.clear();
+                for (auto uvPoint : mesh.uvPoints(f)) {
+                    faceUVPoints.push_back(uvPointOf(uvPoint));
+                }
+                addFace(f);
+                // sharp edges and creases of faces kept whole
+                for (auto edge : mesh.edges(f)) {
+                    if (!mesh.isSharp(edge) && mesh.crease(edge) == 0) {
+                        continue;
+                    }
+                    auto &edgeVertices = mesh.vertices(edge);
+                    auto resultEdge = result.addEdge({vertices[edgeVertices[0].index], vertices[edgeVertices[1].index]});
+                    result.setSharp(resultEdge, mesh.isSharp(edge));
+                    result.setCrease(resultEdge, mesh.crease(edge));
+                }
+                continue;
+            }
+            for (uint32_t t = offsets[f.index]; t < offsets[f.index + 1]; ++t) {
+                if (cuts[s].indices[t] < 0) {
+                    if (keepTriangle[s][t]) {
+                        faceUVPoints = {uvPointOf(side.uvPoint(t, 0)), uvPointOf(side.uvPoint(t, 1)), uvPointOf(side.uvPoint(t, 2))};
+                        addFace(f);
+                    }
+                    continue;
+                }
+                auto &cut = cuts[s].cuts[cuts[s].indices[t]];
+                for (size_t i = 0; i < cut.pieces.size(); i += 3) {
+                    faceUVPoints.clear();
+                    for (size_t c = i; c < i + 3; ++c) {
+                        uint32_t local = cut.pieces[c];
+                        faceUVPoints.push_back(local < 3 ? uvPointOf(side.uvPoint(t, int(local))) : pointUVPointOf(cut.points[local - 3], t));
+                    }
+                    addFace(f);
+                }
+            }
+        }
+    }
+
+    // the intersection curves
+    for (auto &segment : segments) {
+        auto v0 = pointVertices[segment[0]];
+        auto v1 = pointVertices[segment[1]];
+        if (v0.index < 0 || v1.index < 0) {
+            continue;
+        }
+        for (auto edge : result.edges(v0)) {
+            auto &edgeVertices = result.vertices(edge);
+            if (edgeVertices[0] == v1 || edgeVertices[1] == v1) {
+                result.setSharp(edge, true);
+            }
+        }
+    }
+    return result;
+}
+
+} // namespace meshlib
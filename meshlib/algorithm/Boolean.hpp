@@ -0,0 +1,24 @@
+#pragma once
+#include "../Mesh.hpp"
+
+namespace meshlib {
+
+enum class BooleanOperation {
+    Union,
+    Intersection,
+    // a minus b
+    Difference,
+};
+
+// Boolean of the solids bounded by two closed, consistently oriented meshes (e.g. from CubeBuilder and
+// CylinderBuilder). Faces are triangulated and intersected pairwise, with candidate pairs from a bounding volume
+// hierarchy; faces that cross the other mesh are split into triangles along the intersection curves, the others are
+// kept as they are. Pieces along the curves are kept or dropped by the side of the other mesh's crossing face they lie
+// on; the rest by the generalized winding number of the other mesh, once per patch of faces it does not cross, with
+// the far part of the mesh approximated by the dipole of each hierarchy node. New corners get uvs interpolated in
+// their face, faces keep their materials, and the edges along the intersection curves are sharp.
+// The inputs are assumed to be in general position: faces lying in the same plane as a face of the other mesh are not
+// cut against it.
+Mesh booleanOperation(const Mesh &a, const Mesh &b, BooleanOperation operation);
+
+} // namespace meshlib
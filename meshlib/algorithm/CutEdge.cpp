@@ -1,20 +1,33 @@
 #include "CutEdge.hpp"
+#include "../util/Instrumentation.hpp"
+#include <range/v3/algorithm/find_if.hpp>
 
 using namespace glm;
 
 namespace meshlib {
 
-VertexHandle cutEdge(Mesh &mesh, EdgeHandle edge, float t) {
-    auto pos = glm::mix(mesh.position(mesh.vertices(edge)[0]),
-                        mesh.position(mesh.vertices(edge)[1]),
-                        t);
+VertexHandle cutEdge(Mesh &mesh, EdgeHandle edge, float t, std::pmr::memory_resource *resource) {
+    MESHLIB_SCOPED_OPERATION("cutEdge");
+    ScopedMeshOperation operation(mesh, "cutEdge");
+    auto vertices = mesh.vertices(edge);
+    auto pos = glm::mix(mesh.position(vertices[0]), mesh.position(vertices[1]), t);
+    auto vertex = mesh.addVertex(pos);
 
-    auto uv = mesh.addUVPoint(mesh.addVertex(pos), dvec2(0)); // TODO: Use better UV position
+    mesh.addEdge({vertices[0], vertex});
+    mesh.addEdge({vertex, vertices[1]});
 
-    mesh.addEdge({mesh.vertices(edge)[0], mesh.vertex(uv)});
-    mesh.addEdge({mesh.vertex(uv), mesh.vertices(edge)[1]});
-
-    auto faces = mesh.faces(edge) | ranges::to_vector;
+    std::pmr::vector<FaceHandle> faces(resource);
+    for (auto face : mesh.faces(edge)) {
+        faces.push_back(face);
+    }
+    // the uvPoints of the ends of the edge in the faces, and the one added between them: faces that share both ends
+    // share it, while faces on either side of a UV seam each get their own
+    struct Split {
+        UVPointHandle uv0;
+        UVPointHandle uv1;
+        UVPointHandle uv;
+    };
+    std::pmr::vector<Split> splits(resource);
     for (auto &face : faces) {
         std::vector<UVPointHandle> newFaceUVPoints;
         auto &faceUVPoints = mesh.uvPoints(face);
@@ -24,22 +37,33 @@ VertexHandle cutEdge(Mesh &mesh, EdgeHandle edge, float t) {
 
             newFaceUVPoints.push_back(uv0);
 
-            // TODO: create separate uvpoint if possible when uv is split at the edge
-            if (mesh.vertex(uv0) == mesh.vertices(edge)[0] && mesh.vertex(uv1) == mesh.vertices(edge)[1]) {
-                newFaceUVPoints.push_back(uv);
-            } else if (mesh.vertex(uv1) == mesh.vertices(edge)[0] && mesh.vertex(uv0) == mesh.vertices(edge)[1]) {
-                newFaceUVPoints.push_back(uv);
+            bool isForward = mesh.vertex(uv0) == vertices[0] && mesh.vertex(uv1) == vertices[1];
+            bool isBackward = mesh.vertex(uv1) == vertices[0] && mesh.vertex(uv0) == vertices[1];
+            if (!isForward && !isBackward) {
+                continue;
+            }
+            if (isBackward) {
+                std::swap(uv0, uv1);
             }
+            auto split = ranges::find_if(splits, [&](auto &other) { return other.uv0 == uv0 && other.uv1 == uv1; });
+            if (split == splits.end()) {
+                auto uv = mesh.addUVPoint(vertex, glm::mix(mesh.uvPosition(uv0), mesh.uvPosition(uv1), t));
+                split = splits.insert(splits.end(), {uv0, uv1, uv});
+            }
+            newFaceUVPoints.push_back(split->uv);
         }
 
         mesh.addFace(newFaceUVPoints, mesh.material(face));
     }
+    if (faces.empty()) {
+        mesh.addUVPoint(vertex, vec2(0));
+    }
     for (auto &face : faces) {
         mesh.removeFace(face);
     }
     mesh.removeEdge(edge);
 
-    return mesh.vertex(uv);
+    return vertex;
 }
 
 } // namespace meshlib
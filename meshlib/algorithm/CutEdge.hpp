@@ -3,6 +3,8 @@
 
 namespace meshlib {
 
-VertexHandle cutEdge(Mesh &mesh, EdgeHandle edge, float t);
+// Splits edge at t from its first vertex into the faces around it. The uvs of the new vertex are interpolated in each
+// face, with one uvPoint for the faces on each side of a UV seam along the edge.
+VertexHandle cutEdge(Mesh &mesh, EdgeHandle edge, float t, std::pmr::memory_resource *resource = std::pmr::get_default_resource());
 
 }
@@ -0,0 +1,843 @@
+#include "Decimate.hpp"
+#include "../util/Instrumentation.hpp"
+#include "../util/Parallel.hpp"
+#include <algorithm>
+#include <queue>
+
+using namespace glm;
+
+namespace meshlib {
+
+namespace {
+
+struct Quadric {
+    double a00 = 0, a01 = 0, a02 = 0, a11 = 0, a12 = 0, a22 = 0;
+    double b0 = 0, b1 = 0, b2 = 0;
+    double c = 0;
+
+    static Quadric fromPlane(dvec3 n, double d, double weight) {
+        Quadric q;
+        q.a00 = weight * n.x * n.x;
+        q.a01 = weight * n.x * n.y;
+        q.a02 = weight * n.x * n.z;
+        q.a11 = weight * n.y * n.y;
+        q.a12 = weight * n.y * n.z;
+        q.a22 = weight * n.z * n.z;
+        q.b0 = weight * n.x * d;
+        q.b1 = weight * n.y * d;
+        q.b2 = weight * n.z * d;
+        q.c = weight * d * d;
+        return q;
+    }
+
+    Quadric &operator+=(const Quadric &other) {
+        a00 += other.a00;
+        a01 += other.a01;
+        a02 += other.a02;
+        a11 += other.a11;
+        a12 += other.a12;
+        a22 += other.a22;
+        b0 += other.b0;
+        b1 += other.b1;
+        b2 += other.b2;
+        c += other.c;
+        return *this;
+    }
+
+    double error(dvec3 p) const {
+        double e = a00 * p.x * p.x + 2 * a01 * p.x * p.y + 2 * a02 * p.x * p.z + a11 * p.y * p.y + 2 * a12 * p.y * p.z +
+                   a22 * p.z * p.z + 2 * (b0 * p.x + b1 * p.y + b2 * p.z) + c;
+        return std::max(e, 0.0);
+    }
+
+    // solves A p = -b
+    bool optimum(dvec3 &p) const {
+        double det = a00 * (a11 * a22 - a12 * a12) - a01 * (a01 * a22 - a12 * a02) + a02 * (a01 * a12 - a11 * a02);
+        double scale = std::max({std::abs(a00), std::abs(a11), std::abs(a22)});
+        if (std::abs(det) <= 1e-9 * scale * scale * scale) {
+            return false;
+        }
+        double inv00 = (a11 * a22 - a12 * a12) / det;
+        double inv01 = (a02 * a12 - a01 * a22) / det;
+        double inv02 = (a01 * a12 - a02 * a11) / det;
+        double inv11 = (a00 * a22 - a02 * a02) / det;
+        double inv12 = (a02 * a01 - a00 * a12) / det;
+        double inv22 = (a00 * a11 - a01 * a01) / det;
+        p = dvec3(-(inv00 * b0 + inv01 * b1 + inv02 * b2),
+                  -(inv01 * b0 + inv11 * b1 + inv12 * b2),
+                  -(inv02 * b0 + inv12 * b1 + inv22 * b2));
+        return true;
+    }
+};
+
+struct Candidate {
+    double cost;
+    int keep;
+    int remove;
+    uint32_t keepVersion;
+    uint32_t removeVersion;
+    dvec3 position;
+
+    bool operator<(const Candidate &other) const { return cost > other.cost; } // min-heap
+};
+
+class Decimator {
+  public:
+    Decimator(const Mesh &mesh, const DecimationOptions &options);
+    void run();
+    Mesh toMesh() const;
+
+  private:
+    int faceSize(int face) const { return _faceSizes[face]; }
+    int corner(int face, int i) const { return _faceOffsets[face] + i; }
+    int cornerOf(int face, int vertex) const;
+
+    template <typename TFunc>
+    void forEachNeighbour(int vertex, TFunc &&func) const;
+    bool isFeatureEdge(int a, int b) const;
+    int featureEdgeCount(int vertex) const;
+    void updateFeatureCounts(int vertex);
+
+    bool canCollapse(int remove, int keep, std::vector<std::pair<int, int>> &uvMap) const;
+    bool causesFlip(int remove, int keep, dvec3 position) const;
+    bool evaluate(int a, int b, Candidate &candidate) const;
+    int collapse(const Candidate &candidate, const std::vector<std::pair<int, int>> &uvMap);
+    bool isValid(const Candidate &candidate) const;
+    void collectRegion(const Candidate &candidate, std::vector<int> &region) const;
+
+    void runSerial(std::priority_queue<Candidate> &heap);
+    void runParallel(std::priority_queue<Candidate> &heap);
+
+    const DecimationOptions &_options;
+
+    std::vector<dvec3> _positions;
+    std::vector<float> _vertexCorners;
+    std::vector<uint8_t> _vertexSelected;
+    std::vector<uint8_t> _vertexAlive;
+    std::vector<uint32_t> _versions;
+    std::vector<Quadric> _quadrics;
+    std::vector<std::vector<int>> _vertexFaces;
+    std::vector<int> _featureCounts;
+
+    std::vector<vec2> _uvPositions;
+    std::vector<int> _uvVertices;
+
+    std::vector<int> _faceOffsets;
+    std::vector<int> _faceSizes;
+    std::vector<MaterialHandle> _faceMaterials;
+    std::vector<int> _cornerVertices;
+    std::vector<int> _cornerUVPoints;
+    // attributes of the edge from a corner to the next one
+    std::vector<uint8_t> _cornerSharp;
+    std::vector<float> _cornerCreases;
+
+    size_t _faceCount = 0;
+};
+
+Decimator::Decimator(const Mesh &mesh, const DecimationOptions &options) : _options(options) {
+    std::vector<int> vertexIndices(mesh.allVertexCount(), -1);
+    for (auto v : mesh.vertices()) {
+        vertexIndices[v.index] = int(_positions.size());
+        _positions.push_back(dvec3(mesh.position(v)));
+        _vertexCorners.push_back(mesh.corner(v));
+        _vertexSelected.push_back(mesh.isSelected(v));
+    }
+    std::vector<int> uvPointIndices(mesh.allUVPointCount(), -1);
+    for (auto uv : mesh.uvPoints()) {
+        uvPointIndices[uv.index] = int(_uvPositions.size());
+        _uvPositions.push_back(mesh.uvPosition(uv));
+        _uvVertices.push_back(vertexIndices[mesh.vertex(uv).index]);
+    }
+
+    _faceOffsets.push_back(0);
+    for (auto f : mesh.faces()) {
+        auto &uvPoints = mesh.uvPoints(f);
+        auto &edges = mesh.edges(f);
+        for (size_t i = 0; i < uvPoints.size(); ++i) {
+            _cornerUVPoints.push_back(uvPointIndices[uvPoints[i].index]);
+            _cornerVertices.push_back(vertexIndices[mesh.vertex(uvPoints[i]).index]);
+            _cornerSharp.push_back(mesh.isSharp(edges[i]));
+            _cornerCreases.push_back(mesh.crease(edges[i]));
+        }
+        _faceSizes.push_back(int(uvPoints.size()));
+        _faceOffsets.push_back(int(_cornerVertices.size()));
+        _faceMaterials.push_back(mesh.material(f));
+    }
+    _faceCount = _faceSizes.size();
+
+    size_t vertexCount = _positions.size();
+    _vertexAlive.assign(vertexCount, 1);
+    _versions.assign(vertexCount, 0);
+    _vertexFaces.resize(vertexCount);
+    for (size_t face = 0; face < _faceSizes.size(); ++face) {
+        for (int i = 0; i < faceSize(int(face)); ++i) {
+            _vertexFaces[_cornerVertices[corner(int(face), i)]].push_back(int(face));
+        }
+    }
+
+    // face plane quadrics, weighted by area
+    std::vector<Quadric> faceQuadrics(_faceSizes.size());
+    std::vector<dvec3> faceNormals(_faceSizes.size());
+    parallelFor(0, _faceSizes.size(), [&](size_t face) {
+        int n = faceSize(int(face));
+        dvec3 normal(0);
+        dvec3 center(0);
+        for (int i = 0; i < n; ++i) {
+            auto &p0 = _positions[_cornerVertices[corner(int(face), i)]];
+            auto &p1 = _positions[_cornerVertices[corner(int(face), (i + 1) % n)]];
+            normal += cross(p0, p1);
+            center += p0;
+        }
+        center /= double(n);
+        double len = length(normal);
+        if (len > 0) {
+            normal /= len;
+            faceQuadrics[face] = Quadric::fromPlane(normal, -dot(normal, center), len * 0.5);
+        }
+        faceNormals[face] = normal;
+    });
+
+    _quadrics.resize(vertexCount);
+    _featureCounts.resize(vertexCount);
+    parallelFor(0, vertexCount, [&](size_t v) {
+        _featureCounts[v] = featureEdgeCount(int(v));
+
+        auto &quadric = _quadrics[v];
+        for (int face : _vertexFaces[v]) {
+            quadric += faceQuadrics[face];
+
+            // constraint planes perpendicular to the face through incident feature edges
+            int n = faceSize(face);
+            int i = cornerOf(face, int(v));
+            for (int other : {_cornerVertices[corner(face, (i + 1) % n)], _cornerVertices[corner(face, (i + n - 1) % n)]}) {
+                if (!isFeatureEdge(int(v), other)) {
+                    continue;
+                }
+                auto edge = _positions[other] - _positions[v];
+                double edgeLength = length(edge);
+                auto planeNormal = cross(edge, faceNormals[face]);
+                double planeLength = length(planeNormal);
+                if (edgeLength == 0 || planeLength == 0) {
+                    continue;
+                }
+                planeNormal /= planeLength;
+                quadric += Quadric::fromPlane(planeNormal, -dot(planeNormal, _positions[v]),
+                                              _options.featureWeight * edgeLength * edgeLength);
+            }
+        }
+    });
+}
+
+int Decimator::cornerOf(int face, int vertex) const {
+    for (int i = 0; i < faceSize(face); ++i) {
+        if (_cornerVertices[corner(face, i)] == vertex) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+template <typename TFunc>
+void Decimator::forEachNeighbour(int vertex, TFunc &&func) const {
+    // grows on the heap past 64 neighbours, so that each of them is still visited once
+    SmallVector<int, 64> visited;
+    for (int face : _vertexFaces[vertex]) {
+        int n = faceSize(face);
+        int i = cornerOf(face, vertex);
+        for (int other : {_cornerVertices[corner(face, (i + 1) % n)], _cornerVertices[corner(face, (i + n - 1) % n)]}) {
+            if (std::find(visited.begin(), visited.end(), other) != visited.end()) {
+                continue;
+            }
+            visited.push_back(other);
+            func(other);
+        }
+    }
+}
+
+bool Decimator::isFeatureEdge(int a, int b) const {
+    int faces[2];
+    int edgeCorners[2];
+    int count = 0;
+    for (int face : _vertexFaces[a]) {
+        int n = faceSize(face);
+        int i = cornerOf(face, a);
+        int edgeCorner = -1;
+        if (_cornerVertices[corner(face, (i + 1) % n)] == b) {
+            edgeCorner = corner(face, i);
+        } else if (_cornerVertices[corner(face, (i + n - 1) % n)] == b) {
+            edgeCorner = corner(face, (i + n - 1) % n);
+        }
+        if (edgeCorner < 0) {
+            continue;
+        }
+        if (count == 2) {
+            return true; // non-manifold
+        }
+        faces[count] = face;
+        edgeCorners[count] = edgeCorner;
+        ++count;
+    }
+    if (count != 2) {
+        return true; // boundary
+    }
+    for (int c : edgeCorners) {
+        if (_cornerSharp[c] || _cornerCreases[c] > 0) {
+            return true;
+        }
+    }
+    if (_faceMaterials[faces[0]] != _faceMaterials[faces[1]]) {
+        return true;
+    }
+    for (int v : {a, b}) {
+        if (_cornerUVPoints[corner(faces[0], cornerOf(faces[0], v))] != _cornerUVPoints[corner(faces[1], cornerOf(faces[1], v))]) {
+            return true; // UV seam
+        }
+    }
+    return false;
+}
+
+int Decimator::featureEdgeCount(int vertex) const {
+    int count = 0;
+    forEachNeighbour(vertex, [&](int other) {
+        count += isFeatureEdge(vertex, other);
+    });
+    return count;
+}
+
+// a collapse changes the edges around the kept vertex and its neighbours
+void Decimator::updateFeatureCounts(int vertex) {
+    _featureCounts[vertex] = featureEdgeCount(vertex);
+    forEachNeighbour(vertex, [&](int other) {
+        _featureCounts[other] = featureEdgeCount(other);
+    });
+}
+
+bool Decimator::canCollapse(int remove, int keep, std::vector<std::pair<int, int>> &uvMap) const {
+    if (_vertexCorners[remove] > 0) {
+        return false;
+    }
+
+    // vertices on a feature line may only slide along it
+    int featureCount = _featureCounts[remove];
+    if (featureCount != 0 && !(featureCount == 2 && isFeatureEdge(remove, keep))) {
+        return false;
+    }
+
+    // link condition: every common neighbour must form a triangle with the edge
+    bool linkOK = true;
+    std::vector<int> keepNeighbours;
+    forEachNeighbour(keep, [&](int other) { keepNeighbours.push_back(other); });
+    forEachNeighbour(remove, [&](int other) {
+        if (other == keep || !linkOK ||
+            std::find(keepNeighbours.begin(), keepNeighbours.end(), other) == keepNeighbours.end()) {
+            return;
+        }
+        bool triangleFound = false;
+        for (int face : _vertexFaces[remove]) {
+            if (faceSize(face) == 3 && cornerOf(face, keep) >= 0 && cornerOf(face, other) >= 0) {
+                triangleFound = true;
+                break;
+            }
+        }
+        linkOK = triangleFound;
+    });
+    if (!linkOK) {
+        return false;
+    }
+
+    // map the uv points of the removed vertex to the uv points of the kept vertex across the edge faces
+    uvMap.clear();
+    for (int face : _vertexFaces[remove]) {
+        int n = faceSize(face);
+        int removeIndex = cornerOf(face, remove);
+        int keepIndex = cornerOf(face, keep);
+        if (keepIndex < 0) {
+            continue;
+        }
+        if ((removeIndex + 1) % n != keepIndex && (keepIndex + 1) % n != removeIndex) {
+            return false; // diagonal of a polygon
+        }
+        int removeUV = _cornerUVPoints[corner(face, removeIndex)];
+        int keepUV = _cornerUVPoints[corner(face, keepIndex)];
+        auto it = std::find_if(uvMap.begin(), uvMap.end(), [&](auto &pair) { return pair.first == removeUV; });
+        if (it != uvMap.end()) {
+            if (it->second != keepUV) {
+                return false;
+            }
+        } else {
+            if (std::find_if(uvMap.begin(), uvMap.end(), [&](auto &pair) { return pair.second == keepUV; }) != uvMap.end()) {
+                return false; // would merge two UV regions
+            }
+            uvMap.push_back({removeUV, keepUV});
+        }
+    }
+    for (int face : _vertexFaces[remove]) {
+        int removeUV = _cornerUVPoints[corner(face, cornerOf(face, remove))];
+        if (std::find_if(uvMap.begin(), uvMap.end(), [&](auto &pair) { return pair.first == removeUV; }) == uvMap.end()) {
+            return false;
+        }
+    }
+    return !uvMap.empty();
+}
+
+bool Decimator::causesFlip(int remove, int keep, dvec3 position) const {
+    auto checkFace = [&](int face) {
+        int n = faceSize(face);
+        bool hasRemove = cornerOf(face, remove) >= 0;
+        bool hasKeep = cornerOf(face, keep) >= 0;
+        if (hasRemove && hasKeep && n <= 3) {
+            return true; // face is collapsed away
+        }
+
+        dvec3 before(0), after(0);
+        dvec3 prevAfter(0);
+        bool hasPrevAfter = false;
+        dvec3 firstAfter(0);
+        for (int i = 0; i < n; ++i) {
+            int v0 = _cornerVertices[corner(face, i)];
+            int v1 = _cornerVertices[corner(face, (i + 1) % n)];
+            before += cross(_positions[v0], _positions[v1]);
+
+            if (hasRemove && hasKeep && v0 == remove) {
+                continue;
+            }
+            auto p = (v0 == remove || v0 == keep) ? position : _positions[v0];
+            if (hasPrevAfter) {
+                after += cross(prevAfter, p);
+            } else {
+                firstAfter = p;
+            }
+            prevAfter = p;
+            hasPrevAfter = true;
+        }
+        after += cross(prevAfter, firstAfter);
+
+        double beforeLength = length(before);
+        double afterLength = length(after);
+        if (beforeLength == 0) {
+            return true;
+        }
+        return afterLength > 0 && dot(before, after) > 0.2 * beforeLength * afterLength;
+    };
+
+    for (int face : _vertexFaces[remove]) {
+        if (!checkFace(face)) {
+            return true;
+        }
+    }
+    for (int face : _vertexFaces[keep]) {
+        if (cornerOf(face, remove) < 0 && !checkFace(face)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool Decimator::evaluate(int a, int b, Candidate &candidate) const {
+    std::vector<std::pair<int, int>> uvMap;
+    bool found = false;
+
+    for (auto [keep, remove] : {std::pair{a, b}, std::pair{b, a}}) {
+        if (!canCollapse(remove, keep, uvMap)) {
+            continue;
+        }
+
+        Quadric quadric = _quadrics[keep];
+        quadric += _quadrics[remove];
+
+        dvec3 position;
+        bool keepLocked = _vertexCorners[keep] > 0;
+        int keepFeatures = _featureCounts[keep];
+        if (keepLocked || keepFeatures > 2 || (keepFeatures > 0 && _featureCounts[remove] == 0)) {
+            position = _positions[keep];
+        } else {
+            auto mid = (_positions[keep] + _positions[remove]) * 0.5;
+            double edgeLength = distance(_positions[keep], _positions[remove]);
+            if (!quadric.optimum(position) || distance(position, mid) > edgeLength * 2) {
+                position = _positions[keep];
+                for (auto p : {_positions[remove], mid}) {
+                    if (quadric.error(p) < quadric.error(position)) {
+                        position = p;
+                    }
+                }
+            }
+        }
+
+        double cost = quadric.error(position);
+        if (found && cost >= candidate.cost) {
+            continue;
+        }
+        if (causesFlip(remove, keep, position)) {
+            continue;
+        }
+        candidate = {cost, keep, remove, _versions[keep], _versions[remove], position};
+        found = true;
+    }
+    return found;
+}
+
+bool Decimator::isValid(const Candidate &candidate) const {
+    return _vertexAlive[candidate.keep] && _vertexAlive[candidate.remove] &&
+           _versions[candidate.keep] == candidate.keepVersion && _versions[candidate.remove] == candidate.removeVersion;
+}
+
+int Decimator::collapse(const Candidate &candidate, const std::vector<std::pair<int, int>> &uvMap) {
+    int keep = candidate.keep;
+    int remove = candidate.remove;
+
+    auto edge = _positions[remove] - _positions[keep];
+    double edgeLengthSquared = dot(edge, edge);
+    float t = edgeLengthSquared > 0 ? float(std::clamp(dot(candidate.position - _positions[keep], edge) / edgeLengthSquared, 0.0, 1.0)) : 0.f;
+    for (auto [removeUV, keepUV] : uvMap) {
+        _uvPositions[keepUV] = mix(_uvPositions[keepUV], _uvPositions[removeUV], t);
+    }
+
+    _positions[keep] = candidate.position;
+    _quadrics[keep] += _quadrics[remove];
+
+    int removedFaces = 0;
+    std::vector<int> mergedVertices;
+    auto &keepFaces = _vertexFaces[keep];
+    for (int face : _vertexFaces[remove]) {
+        int n = faceSize(face);
+        int removeIndex = cornerOf(face, remove);
+        int keepIndex = cornerOf(face, keep);
+
+        if (keepIndex < 0) {
+            int c = corner(face, removeIndex);
+            _cornerVertices[c] = keep;
+            _cornerUVPoints[c] = std::find_if(uvMap.begin(), uvMap.end(), [&](auto &pair) { return pair.first == _cornerUVPoints[c]; })->second;
+            keepFaces.push_back(face);
+            continue;
+        }
+
+        if ((removeIndex + n - 1) % n == keepIndex) {
+            // keep -> remove -> next becomes keep -> next
+            _cornerSharp[corner(face, keepIndex)] = _cornerSharp[corner(face, removeIndex)];
+            _cornerCreases[corner(face, keepIndex)] = _cornerCreases[corner(face, removeIndex)];
+        }
+        for (int i = removeIndex; i < n - 1; ++i) {
+            int c = corner(face, i);
+            _cornerVertices[c] = _cornerVertices[c + 1];
+            _cornerUVPoints[c] = _cornerUVPoints[c + 1];
+            _cornerSharp[c] = _cornerSharp[c + 1];
+            _cornerCreases[c] = _cornerCreases[c + 1];
+        }
+        --_faceSizes[face];
+
+        if (_faceSizes[face] < 3) {
+            for (int i = 0; i < _faceSizes[face]; ++i) {
+                int vertex = _cornerVertices[corner(face, i)];
+                auto &faces = _vertexFaces[vertex];
+                faces.erase(std::remove(faces.begin(), faces.end(), face), faces.end());
+                if (vertex != keep) {
+                    mergedVertices.push_back(vertex);
+                }
+            }
+            _faceSizes[face] = 0;
+            ++removedFaces;
+        }
+    }
+
+    // a collapsed triangle merges its two remaining edges, which must end up with the same attributes
+    for (int vertex : mergedVertices) {
+        bool isSharp = false;
+        float crease = 0;
+        for (int pass = 0; pass < 2; ++pass) {
+            for (int face : keepFaces) {
+                int n = faceSize(face);
+                int i = cornerOf(face, keep);
+                int edgeCorner = -1;
+                if (_cornerVertices[corner(face, (i + 1) % n)] == vertex) {
+                    edgeCorner = corner(face, i);
+                } else if (_cornerVertices[corner(face, (i + n - 1) % n)] == vertex) {
+                    edgeCorner = corner(face, (i + n - 1) % n);
+                }
+                if (edgeCorner < 0) {
+                    continue;
+                }
+                if (pass == 0) {
+                    isSharp = isSharp || _cornerSharp[edgeCorner];
+                    crease = std::max(crease, _cornerCreases[edgeCorner]);
+                } else {
+                    _cornerSharp[edgeCorner] = isSharp;
+                    _cornerCreases[edgeCorner] = crease;
+                }
+            }
+        }
+    }
+
+    _vertexFaces[remove].clear();
+    _vertexFaces[remove].shrink_to_fit();
+    _vertexAlive[remove] = 0;
+    ++_versions[keep];
+    ++_versions[remove];
+    updateFeatureCounts(keep);
+    return removedFaces;
+}
+
+void Decimator::collectRegion(const Candidate &candidate, std::vector<int> &region) const {
+    region.clear();
+    for (int vertex : {candidate.keep, candidate.remove}) {
+        for (int face : _vertexFaces[vertex]) {
+            for (int i = 0; i < faceSize(face); ++i) {
+                region.push_back(_cornerVertices[corner(face, i)]);
+            }
+        }
+    }
+}
+
+void Decimator::run() {
+    // initial candidates, one per edge
+    std::vector<std::pair<int, int>> edges;
+    edges.reserve(_cornerVertices.size());
+    for (size_t face = 0; face < _faceSizes.size(); ++face) {
+        int n = faceSize(int(face));
+        for (int i = 0; i < n; ++i) {
+            int a = _cornerVertices[corner(int(face), i)];
+            int b = _cornerVertices[corner(int(face), (i + 1) % n)];
+            edges.push_back({std::min(a, b), std::max(a, b)});
+        }
+    }
+    std::sort(edges.begin(), edges.end());
+    edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+    std::vector<Candidate> candidates(edges.size());
+    std::vector<uint8_t> candidateFound(edges.size());
+    parallelFor(0, edges.size(), [&](size_t i) {
+        candidateFound[i] = evaluate(edges[i].first, edges[i].second, candidates[i]);
+    });
+
+    std::vector<Candidate> initialHeap;
+    initialHeap.reserve(edges.size());
+    for (size_t i = 0; i < edges.size(); ++i) {
+        if (candidateFound[i]) {
+            initialHeap.push_back(candidates[i]);
+        }
+    }
+    std::priority_queue<Candidate> heap(std::less<Candidate>(), std::move(initialHeap));
+
+    if (_options.parallel) {
+        runParallel(heap);
+    } else {
+        runSerial(heap);
+    }
+}
+
+void Decimator::runSerial(std::priority_queue<Candidate> &heap) {
+    std::vector<std::pair<int, int>> uvMap;
+    while (_faceCount > _options.targetFaceCount && !heap.empty()) {
+        auto candidate = heap.top();
+        if (candidate.cost > _options.maxError) {
+            break;
+        }
+        heap.pop();
+
+        // lazy update: skip entries whose vertices changed since they were pushed
+        if (!isValid(candidate) || !canCollapse(candidate.remove, candidate.keep, uvMap) ||
+            causesFlip(candidate.remove, candidate.keep, candidate.position)) {
+            continue;
+        }
+        _faceCount -= collapse(candidate, uvMap);
+
+        int keep = candidate.keep;
+        forEachNeighbour(keep, [&](int other) {
+            Candidate next;
+            if (evaluate(keep, other, next)) {
+                heap.push(next);
+            }
+        });
+    }
+}
+
+void Decimator::runParallel(std::priority_queue<Candidate> &heap) {
+    std::vector<uint32_t> marks(_positions.size(), 0);
+    uint32_t stamp = 0;
+    std::vector<int> region;
+
+    while (_faceCount > _options.targetFaceCount && !heap.empty()) {
+        // pick a batch of cheapest collapses whose neighbourhoods do not overlap
+        size_t batchLimit = std::max<size_t>(1, std::min<size_t>((_faceCount - _options.targetFaceCount) / 2, 4096));
+        std::vector<Candidate> batch;
+        std::vector<Candidate> deferred;
+        ++stamp;
+
+        // stop scanning once as many collapses were deferred as fit in the batch, the rest of the heap is too expensive
+        while (batch.size() < batchLimit && deferred.size() < batchLimit && !heap.empty()) {
+            auto candidate = heap.top();
+            if (candidate.cost > _options.maxError) {
+                break;
+            }
+            heap.pop();
+            if (!isValid(candidate)) {
+                continue;
+            }
+            collectRegion(candidate, region);
+            if (std::any_of(region.begin(), region.end(), [&](int v) { return marks[v] == stamp; })) {
+                deferred.push_back(candidate);
+                continue;
+            }
+            for (int v : region) {
+                marks[v] = stamp;
+            }
+            batch.push_back(candidate);
+        }
+        for (auto &candidate : deferred) {
+            heap.push(candidate);
+        }
+        if (batch.empty()) {
+            break;
+        }
+
+        // the regions are disjoint, so each collapse only touches its own vertices and faces
+        std::vector<int> removedFaces(batch.size(), -1);
+        parallelFor(
+            0, batch.size(), [&](size_t i) {
+                auto &candidate = batch[i];
+                std::vector<std::pair<int, int>> uvMap;
+                if (!canCollapse(candidate.remove, candidate.keep, uvMap) ||
+                    causesFlip(candidate.remove, candidate.keep, candidate.position)) {
+                    return;
+                }
+                removedFaces[i] = collapse(candidate, uvMap);
+            },
+            16);
+
+        // new candidates look beyond the regions, so they are evaluated once all collapses are done
+        std::vector<std::vector<Candidate>> nextCandidates(batch.size());
+        parallelFor(
+            0, batch.size(), [&](size_t i) {
+                if (removedFaces[i] < 0) {
+                    return;
+                }
+                int keep = batch[i].keep;
+                forEachNeighbour(keep, [&](int other) {
+                    Candidate next;
+                    if (evaluate(keep, other, next)) {
+                        nextCandidates[i].push_back(next);
+                    }
+                });
+            },
+            16);
+
+        for (size_t i = 0; i < batch.size(); ++i) {
+            _faceCount -= std::max(removedFaces[i], 0);
+            for (auto &candidate : nextCandidates[i]) {
+                heap.push(candidate);
+            }
+        }
+    }
+}
+
+Mesh Decimator::toMesh() const {
+    // numbers the live vertices, the used uvPoints (in order of first use) and the remaining faces
+    std::vector<int> vertices(_positions.size(), -1);
+    int vertexCount = 0;
+    for (size_t v = 0; v < _positions.size(); ++v) {
+        if (_vertexAlive[v]) {
+            vertices[v] = vertexCount++;
+        }
+    }
+    std::vector<int> uvPoints(_uvPositions.size(), -1);
+    std::vector<int> faces;
+    std::vector<int> sides; // the corners of the remaining faces, each starting the side to the next corner
+    int uvPointCount = 0;
+    for (size_t face = 0; face < _faceSizes.size(); ++face) {
+        int n = faceSize(int(face));
+        if (n < 3) {
+            continue;
+        }
+        faces.push_back(int(face));
+        for (int i = 0; i < n; ++i) {
+            int uv = _cornerUVPoints[corner(int(face), i)];
+            if (uvPoints[uv] < 0) {
+                uvPoints[uv] = uvPointCount++;
+            }
+            sides.push_back(corner(int(face), i));
+        }
+    }
+    std::vector<int> faceOffsets(faces.size() + 1, 0);
+    for (size_t f = 0; f < faces.size(); ++f) {
+        faceOffsets[f + 1] = faceOffsets[f] + faceSize(faces[f]);
+    }
+    auto sideEnd = [&](size_t f, int i) {
+        int n = faceSize(faces[f]);
+        return _cornerVertices[corner(faces[f], (i + 1) % n)];
+    };
+
+    // edges: sides sorted by their vertex pair, the first side of an edge sets its direction
+    std::vector<std::pair<uint64_t, int>> sideKeys(sides.size());
+    std::vector<std::array<int, 2>> sideVertices(sides.size());
+    parallelFor(0, faces.size(), [&](size_t f) {
+        for (int i = 0; i < faceSize(faces[f]); ++i) {
+            int side = faceOffsets[f] + i;
+            int v0 = vertices[_cornerVertices[sides[side]]];
+            int v1 = vertices[sideEnd(f, i)];
+            sideVertices[side] = {v0, v1};
+            sideKeys[side] = {uint64_t(uint32_t(std::min(v0, v1))) << 32 | uint32_t(std::max(v0, v1)), side};
+        }
+    });
+    std::sort(sideKeys.begin(), sideKeys.end());
+    std::vector<EdgeHandle> sideEdges(sides.size());
+    std::vector<std::array<VertexHandle, 2>> edgeVertices;
+    for (size_t i = 0; i < sideKeys.size(); ++i) {
+        int side = sideKeys[i].second;
+        if (i == 0 || sideKeys[i].first != sideKeys[i - 1].first) {
+            edgeVertices.push_back({VertexHandle(sideVertices[side][0]), VertexHandle(sideVertices[side][1])});
+        }
+        sideEdges[side] = EdgeHandle(int(edgeVertices.size() - 1));
+    }
+
+    std::vector<UVPointHandle> sideUVPoints(sides.size());
+    parallelFor(0, sides.size(), [&](size_t side) {
+        sideUVPoints[side] = UVPointHandle(uvPoints[_cornerUVPoints[sides[side]]]);
+    });
+
+    Mesh mesh;
+    mesh.beginDirectBuild(size_t(vertexCount), size_t(uvPointCount), edgeVertices.size(), faces.size());
+    parallelFor(0, _positions.size(), [&](size_t v) {
+        if (vertices[v] >= 0) {
+            mesh.setDirectVertex(VertexHandle(vertices[v]), vec3(_positions[v]));
+        }
+    });
+    parallelFor(0, _uvPositions.size(), [&](size_t uv) {
+        if (uvPoints[uv] >= 0) {
+            mesh.setDirectUVPoint(UVPointHandle(uvPoints[uv]), VertexHandle(vertices[_uvVertices[uv]]), _uvPositions[uv]);
+        }
+    });
+    parallelFor(0, edgeVertices.size(), [&](size_t e) { mesh.setDirectEdge(EdgeHandle(int(e)), edgeVertices[e]); });
+    parallelFor(0, faces.size(), [&](size_t f) {
+        mesh.setDirectFace(FaceHandle(int(f)), sideUVPoints.data() + faceOffsets[f], sideEdges.data() + faceOffsets[f],
+                           size_t(faceSize(faces[f])), _faceMaterials[faces[f]]);
+    });
+    mesh.endDirectBuild();
+
+    for (size_t v = 0; v < _positions.size(); ++v) {
+        if (vertices[v] >= 0) {
+            mesh.setCorner(VertexHandle(vertices[v]), _vertexCorners[v]);
+            mesh.setSelected(VertexHandle(vertices[v]), _vertexSelected[v]);
+        }
+    }
+    for (size_t side = 0; side < sides.size(); ++side) {
+        int c = sides[side];
+        if (!_cornerSharp[c] && _cornerCreases[c] == 0) {
+            continue;
+        }
+        auto edge = sideEdges[side];
+        mesh.setSharp(edge, mesh.isSharp(edge) || _cornerSharp[c]);
+        mesh.setCrease(edge, std::max(mesh.crease(edge), _cornerCreases[c]));
+    }
+
+    return mesh;
+}
+
+} // namespace
+
+Mesh decimate(const Mesh &mesh, const DecimationOptions &options) {
+    MESHLIB_SCOPED_OPERATION("decimate");
+    Decimator decimator(mesh, options);
+    decimator.run();
+    return decimator.toMesh();
+}
+
+} // namespace meshlib
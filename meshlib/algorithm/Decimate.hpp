@@ -0,0 +1,24 @@
+#pragma once
+#include "../Mesh.hpp"
+#include <limits>
+
+namespace meshlib {
+
+struct DecimationOptions {
+    // stop when the face count drops to this value
+    size_t targetFaceCount = 0;
+    // stop when the cheapest collapse has a larger quadric error (area-weighted squared distance)
+    float maxError = std::numeric_limits<float>::infinity();
+    // weight of the constraint planes along sharp edges, boundaries, UV seams and material boundaries
+    float featureWeight = 100.f;
+    // collapse batches of independent edges in parallel (results differ slightly from the serial order)
+    bool parallel = false;
+};
+
+// Quadric error metric edge-collapse simplification.
+// Works on arbitrary polygons (a collapsed quad becomes a triangle). Vertices on feature lines (isSharp or creased
+// edges, boundaries, UV seams, material boundaries) only slide along their feature line, feature corners and vertices
+// with a corner value are kept, and UV points are merged per side of a seam.
+Mesh decimate(const Mesh &mesh, const DecimationOptions &options = {});
+
+} // namespace meshlib
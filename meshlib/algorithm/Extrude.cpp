@@ -1,26 +1,31 @@
 #include "Extrude.hpp"
+#include "../util/Instrumentation.hpp"
+#include <algorithm>
 #include <range/v3/view/reverse.hpp>
 
 namespace meshlib {
 
-std::vector<VertexHandle> extrude(Mesh &mesh, const std::vector<VertexHandle> &vertices, bool addFlipFace) {
+std::vector<VertexHandle> extrude(Mesh &mesh, const std::vector<VertexHandle> &vertices, bool addFlipFace,
+                                  std::pmr::memory_resource *resource) {
+    MESHLIB_SCOPED_OPERATION("extrude");
+    ScopedMeshOperation operation(mesh, "extrude");
     std::vector<VertexHandle> newVertices;
-    std::unordered_map<VertexHandle, UVPointHandle> vertexToUV;
-    std::unordered_map<UVPointHandle, UVPointHandle> oldToNewUVPoints;
+    std::pmr::unordered_map<VertexHandle, UVPointHandle> vertexToUV(resource);
+    std::pmr::unordered_map<UVPointHandle, UVPointHandle> oldToNewUVPoints(resource);
 
-    auto edges = mesh.edges(vertices);
-    auto faces = mesh.faces(vertices);
+    auto edges = mesh.edges(vertices, resource);
+    auto faces = mesh.faces(vertices, resource);
 
-    std::unordered_set<EdgeHandle> openEdges;
+    std::pmr::vector<EdgeHandle> openEdges(resource);
     for (auto &&edge : edges) {
         int faceCount = 0;
         for (auto &&face : mesh.faces(edge)) {
-            if (faces.find(face) != faces.end()) {
+            if (std::binary_search(faces.begin(), faces.end(), face)) {
                 ++faceCount;
             }
         }
         if (faceCount <= 1) {
-            openEdges.insert(edge);
+            openEdges.push_back(edge);
         }
     }
 
@@ -46,7 +51,7 @@ std::vector<VertexHandle> extrude(Mesh &mesh, const std::vector<VertexHandle> &v
         MaterialHandle material;
 
         for (auto &face : mesh.faces(openEdge)) {
-            if (faces.find(face) != faces.end()) {
+            if (std::binary_search(faces.begin(), faces.end(), face)) {
                 material = mesh.material(face);
                 continue;
             }
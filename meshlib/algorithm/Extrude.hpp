@@ -4,6 +4,7 @@
 
 namespace meshlib {
 
-std::vector<VertexHandle> extrude(Mesh &mesh, const std::vector<VertexHandle> &vertices, bool addFlipFace = false);
+std::vector<VertexHandle> extrude(Mesh &mesh, const std::vector<VertexHandle> &vertices, bool addFlipFace = false,
+                                  std::pmr::memory_resource *resource = std::pmr::get_default_resource());
 
 } // namespace meshlib
@@ -1,4 +1,5 @@
 #include "FindBelt.hpp"
+#include "../util/Instrumentation.hpp"
 #include <optional>
 #include <range/v3/algorithm/find.hpp>
 #include <range/v3/algorithm/find_if.hpp>
@@ -6,12 +7,14 @@
 namespace meshlib {
 
 std::vector<BeltElement> findBelt(const Mesh &mesh, EdgeHandle edge) {
+    MESHLIB_SCOPED_OPERATION("findBelt");
     bool isEdgeReverse = false;
     std::vector<BeltElement> belt;
     std::optional<FaceHandle> lastFace;
 
     while (true) {
-        auto edgeFaces = mesh.faces(edge) | ranges::to_vector;
+        auto liveFaces = mesh.faces(edge);
+        SmallVector<FaceHandle, 2> edgeFaces(liveFaces.begin(), liveFaces.end());
 
         if (edgeFaces.size() != 2) {
             return {};
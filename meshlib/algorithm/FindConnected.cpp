@@ -1,4 +1,5 @@
 #include "FindConnected.hpp"
+#include "../util/Instrumentation.hpp"
 
 namespace meshlib {
 
@@ -22,6 +23,7 @@ void addConnectedRecursive(std::unordered_set<VertexHandle> &connectedVertices,
 } // namespace
 
 std::unordered_set<VertexHandle> findConnected(const Mesh &mesh, const std::vector<VertexHandle> &vertices) {
+    MESHLIB_SCOPED_OPERATION("findConnected");
     std::unordered_set<VertexHandle> connectedVertices;
 
     for (auto &&v : vertices) {
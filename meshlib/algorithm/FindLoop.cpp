@@ -1,15 +1,17 @@
 #include "FindLoop.hpp"
+#include "../util/Instrumentation.hpp"
 #include <range/v3/algorithm/find.hpp>
 
 namespace meshlib {
 
 std::vector<EdgeHandle> findLoop(const Mesh &mesh, EdgeHandle edge) {
+    MESHLIB_SCOPED_OPERATION("findLoop");
     std::vector<EdgeHandle> edges;
 
     auto vertex = mesh.vertices(edge)[0];
     edges.push_back(edge);
 
-    if (ranges::distance(mesh.faces(edge)) != 2) {
+    if (mesh.faceCount(edge) != 2) {
         // non-manifold edge
         return {};
     }
@@ -17,7 +19,7 @@ std::vector<EdgeHandle> findLoop(const Mesh &mesh, EdgeHandle edge) {
     while (true) {
         auto nextVertex = mesh.vertices(edge)[0] == vertex ? mesh.vertices(edge)[1] : mesh.vertices(edge)[0];
 
-        if (ranges::distance(mesh.faces(nextVertex)) != 4) {
+        if (mesh.faceCount(nextVertex) != 4) {
             // extraordinary vertex
             return {};
         }
@@ -27,7 +29,7 @@ std::vector<EdgeHandle> findLoop(const Mesh &mesh, EdgeHandle edge) {
         std::vector<FaceHandle> nextEdgeFaces;
 
         for (auto e : mesh.edges(nextVertex)) {
-            if (ranges::distance(mesh.faces(e)) != 2) {
+            if (mesh.faceCount(e) != 2) {
                 // non-manifold edge
                 continue;
             }
@@ -1,9 +1,12 @@
 #include "FlipFace.hpp"
+#include "../util/Instrumentation.hpp"
 #include <range/v3/view/reverse.hpp>
 
 namespace meshlib {
 
 FaceHandle flipFace(Mesh &mesh, FaceHandle face) {
+    MESHLIB_SCOPED_OPERATION("flipFace");
+    ScopedMeshOperation operation(mesh, "flipFace");
     auto reverseUVPoints = mesh.uvPoints(face) | ranges::views::reverse | ranges::to_vector;
     auto newFace = mesh.addFace(reverseUVPoints, mesh.material(face));
     mesh.removeFace(face);
@@ -0,0 +1,252 @@
+#include "Geodesic.hpp"
+#include "Triangulate.hpp"
+#include "../util/Instrumentation.hpp"
+#include "../util/Parallel.hpp"
+#include <algorithm>
+#include <limits>
+#include <numeric>
+
+using namespace glm;
+
+namespace meshlib {
+
+namespace {
+
+// triangles with less area than this times the squared mean edge length count as degenerate and are left out
+constexpr double MinRelativeArea = 1e-12;
+// added multiple of the mass matrix over the time, which makes the Laplacian of each part of the mesh definite
+constexpr double PoissonShift = 1e-6;
+
+} // namespace
+
+GeodesicDistance::GeodesicDistance(const Mesh &mesh, float timeScale) : _timeScale(timeScale) {
+    factor(mesh);
+}
+
+bool GeodesicDistance::update(const Mesh &mesh) {
+    if (mesh.topologyVersion() == _topologyVersion) {
+        return false;
+    }
+    factor(mesh);
+    return true;
+}
+
+void GeodesicDistance::factor(const Mesh &mesh) {
+    MESHLIB_SCOPED_OPERATION("GeodesicDistance::factor");
+    _topologyVersion = mesh.topologyVersion();
+    _vertexCount = mesh.allVertexCount();
+    auto triangulation = triangulate(mesh);
+    size_t triangleCount = triangulation.triangleCount();
+
+    std::vector<std::array<int, 3>> triangles(triangleCount);
+    std::vector<double> areas(triangleCount);
+    std::vector<double> edgeLengths(triangleCount);
+    parallelFor(0, triangleCount, [&](size_t t) {
+        std::array<dvec3, 3> p;
+        for (int i = 0; i < 3; ++i) {
+            triangles[t][i] = mesh.vertex(triangulation.triangles[3 * t + i]).index;
+            p[i] = dvec3(mesh.position(VertexHandle(triangles[t][i])));
+        }
+        areas[t] = length(cross(p[1] - p[0], p[2] - p[0])) / 2;
+        edgeLengths[t] = length(p[1] - p[0]) + length(p[2] - p[1]) + length(p[0] - p[2]);
+    });
+    double meanEdgeLength = triangleCount > 0 ? std::accumulate(edgeLengths.begin(), edgeLengths.end(), 0.0) / double(3 * triangleCount) : 0;
+    double minArea = MinRelativeArea * meanEdgeLength * meanEdgeLength;
+
+    // rows for the vertices of the triangles that are kept
+    _rows.assign(_vertexCount, -1);
+    _rowVertices.clear();
+    _triangles.clear();
+    std::vector<double> keptAreas;
+    for (size_t t = 0; t < triangleCount; ++t) {
+        if (!(areas[t] > minArea)) {
+            continue;
+        }
+        keptAreas.push_back(areas[t]);
+        auto &triangle = _triangles.emplace_back();
+        for (int i = 0; i < 3; ++i) {
+            int v = triangles[t][i];
+            if (_rows[v] < 0) {
+                _rows[v] = int(_rowVertices.size());
+                _rowVertices.push_back(v);
+            }
+            triangle[i] = _rows[v];
+        }
+    }
+    size_t rowCount = _rowVertices.size();
+    _positions.resize(rowCount);
+    parallelFor(0, rowCount, [&](size_t r) { _positions[r] = dvec3(mesh.position(VertexHandle(_rowVertices[r]))); });
+    _cotangents.resize(_triangles.size());
+    parallelFor(0, _triangles.size(), [&](size_t t) {
+        for (int i = 0; i < 3; ++i) {
+            auto &p = _positions[_triangles[t][i]];
+            auto e0 = _positions[_triangles[t][(i + 1) % 3]] - p;
+            auto e1 = _positions[_triangles[t][(i + 2) % 3]] - p;
+            _cotangents[t][i] = dot(e0, e1) / length(cross(e0, e1));
+        }
+    });
+
+    // parts of the mesh, which have no heat and no distance without a source of their own
+    _components.resize(rowCount);
+    std::iota(_components.begin(), _components.end(), 0);
+    auto find = [&](int r) {
+        while (_components[r] != r) {
+            r = _components[r] = _components[_components[r]];
+        }
+        return r;
+    };
+    for (auto &triangle : _triangles) {
+        _components[find(triangle[0])] = find(triangle[1]);
+        _components[find(triangle[1])] = find(triangle[2]);
+    }
+    std::vector<int> componentIndices(rowCount, -1);
+    _componentCount = 0;
+    for (size_t r = 0; r < rowCount; ++r) {
+        int root = find(int(r));
+        if (componentIndices[root] < 0) {
+            componentIndices[root] = _componentCount++;
+        }
+    }
+    for (size_t r = 0; r < rowCount; ++r) {
+        _components[r] = componentIndices[find(int(r))];
+    }
+
+    _cornerOffsets.assign(rowCount + 1, 0);
+    for (auto &triangle : _triangles) {
+        for (auto r : triangle) {
+            ++_cornerOffsets[r + 1];
+        }
+    }
+    std::partial_sum(_cornerOffsets.begin(), _cornerOffsets.end(), _cornerOffsets.begin());
+    _corners.resize(_cornerOffsets.back());
+    std::vector<int> next(_cornerOffsets.begin(), _cornerOffsets.end() - 1);
+    for (size_t t = 0; t < _triangles.size(); ++t) {
+        for (int i = 0; i < 3; ++i) {
+            _corners[next[_triangles[t][i]]++] = int(3 * t + i);
+        }
+    }
+
+    // half the cotangent of the opposite angle per edge, lower triangle by columns, and a third of the area per vertex
+    struct Entry {
+        int column;
+        int row;
+        double weight;
+    };
+    std::vector<Entry> entries;
+    entries.reserve(3 * _triangles.size());
+    std::vector<double> masses(rowCount, 0);
+    for (size_t t = 0; t < _triangles.size(); ++t) {
+        auto &triangle = _triangles[t];
+        for (int i = 0; i < 3; ++i) {
+            int a = triangle[(i + 1) % 3];
+            int b = triangle[(i + 2) % 3];
+            entries.push_back({std::min(a, b), std::max(a, b), _cotangents[t][i] / 2});
+            masses[triangle[i]] += keptAreas[t] / 3;
+        }
+    }
+    std::sort(entries.begin(), entries.end(), [](const Entry &a, const Entry &b) { return a.column != b.column ? a.column < b.column : a.row < b.row; });
+
+    SymmetricMatrix heat;
+    SymmetricMatrix poisson;
+    std::vector<double> weightSums(rowCount, 0);
+    for (auto &entry : entries) {
+        weightSums[entry.row] += entry.weight;
+        weightSums[entry.column] += entry.weight;
+    }
+    double time = double(_timeScale) * meanEdgeLength * meanEdgeLength;
+    double shift = PoissonShift / time;
+    heat.offsets.reserve(rowCount + 1);
+    for (size_t j = 0, e = 0; j < rowCount; ++j) {
+        // the diagonal first, then the merged entries of the column
+        heat.rows.push_back(int(j));
+        heat.values.push_back(masses[j] + time * weightSums[j]);
+        poisson.values.push_back(weightSums[j] + shift * masses[j]);
+        for (; e < entries.size() && entries[e].column == int(j); ++e) {
+            if (heat.rows.back() != entries[e].row) {
+                heat.rows.push_back(entries[e].row);
+                heat.values.push_back(0);
+                poisson.values.push_back(0);
+            }
+            heat.values.back() -= time * entries[e].weight;
+            poisson.values.back() -= entries[e].weight;
+        }
+        heat.offsets.push_back(int(heat.rows.size()));
+    }
+    poisson.offsets = heat.offsets;
+    poisson.rows = heat.rows;
+
+    _heat = SparseCholesky(heat, nestedDissectionOrder(heat));
+    _poisson = _heat;
+    bool isHeatFactored = false;
+    TaskGroup group;
+    group.run([&] { isHeatFactored = _heat.factor(heat); });
+    bool isPoissonFactored = _poisson.factor(poisson);
+    group.wait();
+    if (!isHeatFactored || !isPoissonFactored) {
+        // non-finite positions; no vertex is reached
+        _rows.assign(_vertexCount, -1);
+    }
+}
+
+std::vector<float> GeodesicDistance::distances(const std::vector<VertexHandle> &sources) const {
+    MESHLIB_SCOPED_OPERATION("GeodesicDistance::distances");
+    std::vector<float> result(_vertexCount, std::numeric_limits<float>::infinity());
+    size_t rowCount = _rowVertices.size();
+    std::vector<double> values(rowCount, 0);
+    std::vector<int> sourceRows;
+    for (auto source : sources) {
+        if (size_t(source.index) < _vertexCount && _rows[source.index] >= 0) {
+            sourceRows.push_back(_rows[source.index]);
+            values[sourceRows.back()] = 1;
+        }
+    }
+    if (sourceRows.empty()) {
+        return result;
+    }
+    _heat.solve(values.data());
+
+    // the integrated divergence at the corners of the unit vectors against the gradient of the heat
+    std::vector<double> cornerDivergences(3 * _triangles.size());
+    parallelFor(0, _triangles.size(), [&](size_t t) {
+        auto &triangle = _triangles[t];
+        std::array<dvec3, 3> p{_positions[triangle[0]], _positions[triangle[1]], _positions[triangle[2]]};
+        auto normal = cross(p[1] - p[0], p[2] - p[0]);
+        double doubleArea = length(normal);
+        normal /= doubleArea;
+        dvec3 gradient(0);
+        for (int i = 0; i < 3; ++i) {
+            gradient += values[triangle[i]] * cross(normal, p[(i + 2) % 3] - p[(i + 1) % 3]);
+        }
+        double gradientLength = length(gradient);
+        auto direction = gradientLength > 0 ? -gradient / gradientLength : dvec3(0);
+        for (int i = 0; i < 3; ++i) {
+            int j = (i + 1) % 3;
+            int k = (i + 2) % 3;
+            cornerDivergences[3 * t + i] =
+                (_cotangents[t][k] * dot(p[j] - p[i], direction) + _cotangents[t][j] * dot(p[k] - p[i], direction)) / 2;
+        }
+    });
+    parallelFor(0, rowCount, [&](size_t r) {
+        double divergence = 0;
+        for (int c = _cornerOffsets[r]; c < _cornerOffsets[r + 1]; ++c) {
+            divergence += cornerDivergences[_corners[c]];
+        }
+        values[r] = -divergence;
+    });
+    _poisson.solve(values.data());
+
+    // the distance is zero at the nearest source of each part
+    std::vector<double> offsets(_componentCount, std::numeric_limits<double>::infinity());
+    for (auto r : sourceRows) {
+        offsets[_components[r]] = std::min(offsets[_components[r]], values[r]);
+    }
+    parallelFor(0, rowCount, [&](size_t r) {
+        double offset = offsets[_components[r]];
+        if (offset != std::numeric_limits<double>::infinity()) {
+            result[_rowVertices[r]] = float(std::max(values[r] - offset, 0.0));
+        }
+    });
+    return result;
+}
+
+} // namespace meshlib
@@ -0,0 +1,49 @@
+#pragma once
+#include "../Mesh.hpp"
+#include "../util/SparseCholesky.hpp"
+
+namespace meshlib {
+
+// Distances along the surface by the heat method (Crane et al.): heat flowing from the sources for a short time
+// points the way to them, and the distance is the function whose gradient best follows that direction. Both steps
+// solve a system with the cotangent Laplacian of the triangulated faces, which is factored once, so a query costs two
+// pairs of triangular solves and two passes over the triangles.
+class GeodesicDistance {
+  public:
+    // timeScale multiplies the time the heat flows, the squared mean edge length; more smooths the distances
+    explicit GeodesicDistance(const Mesh &mesh, float timeScale = 1);
+
+    // Factors again if the mesh has another topologyVersion() than at the last factorization, and returns whether it
+    // did. Positions are only read when factoring, so while vertices move, e.g. when dragging a soft selection, the
+    // distances stay those over the shape they started from.
+    bool update(const Mesh &mesh);
+    // factors for the current positions
+    void factor(const Mesh &mesh);
+
+    // Distance of each of allVertices() to the nearest source; infinity for vertices in no face and on parts of the
+    // mesh without sources
+    std::vector<float> distances(const std::vector<VertexHandle> &sources) const;
+
+  private:
+    float _timeScale;
+    uint64_t _topologyVersion = 0;
+    size_t _vertexCount = 0;
+    // row of each of allVertices() in the systems, -1 for vertices in no face, and the vertex of each row
+    std::vector<int> _rows;
+    std::vector<int> _rowVertices;
+    std::vector<glm::dvec3> _positions;
+    // three rows per triangle, and the cotangents of their angles
+    std::vector<std::array<int, 3>> _triangles;
+    std::vector<glm::dvec3> _cotangents;
+    // connected part of the mesh of each row
+    std::vector<int> _components;
+    int _componentCount = 0;
+    // corners of the triangles by row, three per triangle numbered as in _triangles
+    std::vector<int> _cornerOffsets;
+    std::vector<int> _corners;
+    // (M + t L) for the heat and (L + epsilon M) for the distance, with M the lumped mass and L the cotangent Laplacian
+    SparseCholesky _heat;
+    SparseCholesky _poisson;
+};
+
+} // namespace meshlib
@@ -0,0 +1,185 @@
+#include "Laplacian.hpp"
+#include "Triangulate.hpp"
+#include "../util/Instrumentation.hpp"
+#include <algorithm>
+#include <numeric>
+
+using namespace glm;
+
+namespace meshlib {
+
+MeshLaplacian &MeshLaplacian::forCurrentThread() {
+    static thread_local MeshLaplacian laplacian;
+    return laplacian;
+}
+
+void MeshLaplacian::buildUniform(const Mesh &mesh) {
+    MESHLIB_SCOPED_OPERATION("MeshLaplacian::buildUniform");
+    size_t vertexCount = mesh.allVertexCount();
+    auto &uniform = _uniform;
+    uniform.offsets.assign(vertexCount + 1, 0);
+    parallelFor(0, vertexCount, [&](size_t v) {
+        auto vertex = VertexHandle(int(v));
+        uniform.offsets[v + 1] = mesh.isDeleted(vertex) ? 0 : int(mesh.edgeCount(vertex));
+    });
+    std::partial_sum(uniform.offsets.begin(), uniform.offsets.end(), uniform.offsets.begin());
+    uniform.vertices.resize(uniform.offsets.back());
+    uniform.edges.resize(uniform.offsets.back());
+    uniform.isBoundary.resize(uniform.offsets.back());
+    parallelFor(0, vertexCount, [&](size_t v) {
+        auto vertex = VertexHandle(int(v));
+        if (mesh.isDeleted(vertex)) {
+            return;
+        }
+        int k = uniform.offsets[v];
+        for (auto edge : mesh.edges(vertex)) {
+            auto &edgeVertices = mesh.vertices(edge);
+            uniform.vertices[k] = (edgeVertices[0] == vertex ? edgeVertices[1] : edgeVertices[0]).index;
+            uniform.edges[k] = edge;
+            // non-manifold edges count as boundaries, as in subdivision
+            uniform.isBoundary[k] = mesh.faceCount(edge) != 2;
+            ++k;
+        }
+    });
+    uniform.topologyVersion = mesh.topologyVersion();
+}
+
+void MeshLaplacian::buildCotangent(const Mesh &mesh) {
+    MESHLIB_SCOPED_OPERATION("MeshLaplacian::buildCotangent");
+    auto triangulation = triangulate(mesh);
+    auto &cotangent = _cotangent;
+    cotangent.triangles.resize(triangulation.triangleCount());
+    parallelFor(0, cotangent.triangles.size(), [&](size_t t) {
+        for (int i = 0; i < 3; ++i) {
+            cotangent.triangles[t][i] = mesh.vertex(triangulation.triangles[3 * t + i]).index;
+        }
+    });
+
+    // (vertex, neighbour) per directed triangle edge with the corner opposite it, grouped by vertex and neighbour
+    struct Entry {
+        uint64_t key;
+        int corner;
+    };
+    std::vector<Entry> entries(6 * cotangent.triangles.size());
+    parallelFor(0, cotangent.triangles.size(), [&](size_t t) {
+        auto &triangle = cotangent.triangles[t];
+        for (int i = 0; i < 3; ++i) {
+            uint64_t a = uint32_t(triangle[(i + 1) % 3]);
+            uint64_t b = uint32_t(triangle[(i + 2) % 3]);
+            entries[6 * t + 2 * i] = {a << 32 | b, int(3 * t + i)};
+            entries[6 * t + 2 * i + 1] = {b << 32 | a, int(3 * t + i)};
+        }
+    });
+    std::sort(entries.begin(), entries.end(), [](const Entry &a, const Entry &b) { return a.key < b.key; });
+
+    cotangent.offsets.assign(mesh.allVertexCount() + 1, 0);
+    cotangent.vertices.clear();
+    cotangent.cornerOffsets.assign(1, 0);
+    cotangent.corners.resize(entries.size());
+    for (size_t i = 0; i < entries.size(); ++i) {
+        if (i == 0 || entries[i].key != entries[i - 1].key) {
+            ++cotangent.offsets[(entries[i].key >> 32) + 1];
+            cotangent.vertices.push_back(int(entries[i].key & 0xffffffff));
+            cotangent.cornerOffsets.push_back(cotangent.cornerOffsets.back());
+        }
+        cotangent.corners[i] = entries[i].corner;
+        ++cotangent.cornerOffsets.back();
+    }
+    std::partial_sum(cotangent.offsets.begin(), cotangent.offsets.end(), cotangent.offsets.begin());
+    cotangent.topologyVersion = mesh.topologyVersion();
+}
+
+const StencilTable &MeshLaplacian::stencils(const Mesh &mesh, LaplacianWeights weights) {
+    MESHLIB_SCOPED_OPERATION("MeshLaplacian::stencils");
+    if (_uniform.topologyVersion != mesh.topologyVersion()) {
+        buildUniform(mesh);
+    }
+    bool isCotangent = weights == LaplacianWeights::Cotangent;
+    if (isCotangent && _cotangent.topologyVersion != mesh.topologyVersion()) {
+        buildCotangent(mesh);
+    }
+    auto &uniform = _uniform;
+    auto &cotangent = _cotangent;
+    size_t vertexCount = mesh.allVertexCount();
+
+    // rows of feature vertices hold their two neighbours along the feature line, or nothing
+    std::vector<uint8_t> isFeature(vertexCount);
+    auto &offsets = _stencils.offsets;
+    offsets.assign(vertexCount + 1, 0);
+    parallelFor(0, vertexCount, [&](size_t v) {
+        auto vertex = VertexHandle(int(v));
+        if (mesh.isDeleted(vertex) || mesh.corner(vertex) > 0) {
+            return;
+        }
+        int featureCount = 0;
+        for (int k = uniform.offsets[v]; k < uniform.offsets[v + 1]; ++k) {
+            featureCount += uniform.isBoundary[k] || mesh.isSharp(uniform.edges[k]) ? 1 : 0;
+        }
+        isFeature[v] = featureCount > 0;
+        if (featureCount == 0) {
+            auto &rows = isCotangent ? cotangent.offsets : uniform.offsets;
+            offsets[v + 1] = rows[v + 1] - rows[v];
+        } else if (featureCount == 2) {
+            offsets[v + 1] = 2;
+        }
+    });
+    std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+    _stencils.indices.resize(offsets.back());
+    _stencils.weights.resize(offsets.back());
+
+    std::vector<double> cornerWeights;
+    if (isCotangent) {
+        // half the cotangent of each corner of the triangles
+        cornerWeights.resize(3 * cotangent.triangles.size());
+        parallelFor(0, cotangent.triangles.size(), [&](size_t t) {
+            auto &triangle = cotangent.triangles[t];
+            for (int i = 0; i < 3; ++i) {
+                auto p = dvec3(mesh.position(VertexHandle(triangle[i])));
+                auto e0 = dvec3(mesh.position(VertexHandle(triangle[(i + 1) % 3]))) - p;
+                auto e1 = dvec3(mesh.position(VertexHandle(triangle[(i + 2) % 3]))) - p;
+                double sine = length(cross(e0, e1));
+                cornerWeights[3 * t + i] = sine > 0 ? dot(e0, e1) / sine / 2 : 0;
+            }
+        });
+    }
+
+    parallelFor(0, vertexCount, [&](size_t v) {
+        int row = offsets[v];
+        int size = offsets[v + 1] - row;
+        if (size == 0) {
+            return;
+        }
+        if (isFeature[v]) {
+            for (int k = uniform.offsets[v]; k < uniform.offsets[v + 1]; ++k) {
+                if (uniform.isBoundary[k] || mesh.isSharp(uniform.edges[k])) {
+                    _stencils.indices[row] = uniform.vertices[k];
+                    _stencils.weights[row++] = 0.5f;
+                }
+            }
+        } else if (!isCotangent) {
+            for (int k = uniform.offsets[v]; k < uniform.offsets[v + 1]; ++k) {
+                _stencils.indices[row] = uniform.vertices[k];
+                _stencils.weights[row++] = 1.f / float(size);
+            }
+        } else {
+            double sum = 0;
+            for (int k = cotangent.offsets[v]; k < cotangent.offsets[v + 1]; ++k) {
+                double weight = 0;
+                for (int c = cotangent.cornerOffsets[k]; c < cotangent.cornerOffsets[k + 1]; ++c) {
+                    weight += cornerWeights[cotangent.corners[c]];
+                }
+                weight = std::max(weight, 0.0);
+                _stencils.indices[row + k - cotangent.offsets[v]] = cotangent.vertices[k];
+                _stencils.weights[row + k - cotangent.offsets[v]] = float(weight);
+                sum += weight;
+            }
+            // all angles obtuse or degenerate: an even average instead
+            for (int k = row; k < row + size; ++k) {
+                _stencils.weights[k] = sum > 0 ? float(_stencils.weights[k] / sum) : 1.f / float(size);
+            }
+        }
+    });
+    return _stencils;
+}
+
+} // namespace meshlib
@@ -0,0 +1,50 @@
+#pragma once
+#include "SubdivisionLevel.hpp"
+
+namespace meshlib {
+
+enum class LaplacianWeights {
+    // every neighbour along an edge counts the same
+    Uniform,
+    // cotangents of the angles opposite the edges of the triangulated faces, so the neighbours include the opposite
+    // corners of polygons; negative ones count as zero
+    Cotangent,
+};
+
+// Laplacian stencils over allVertices(): row v averages the neighbours of v, its weights summing to 1. Vertices on
+// feature lines (isSharp or boundary edges) only average their two neighbours along the line, and vertices with a
+// corner value, at the end of a feature line or where several meet have empty rows, as do deleted and isolated ones.
+// The neighbourhoods are kept until the mesh has another topologyVersion(), so repeated calls only compute the
+// weights, from the current positions and sharp edges, in a parallel pass over contiguous arrays. One instance serves
+// any number of meshes, but not several threads at once.
+class MeshLaplacian {
+  public:
+    const StencilTable &stencils(const Mesh &mesh, LaplacianWeights weights);
+
+    // instance used by smoothPositions() and relaxPositions()
+    static MeshLaplacian &forCurrentThread();
+
+  private:
+    // rows over allVertices()
+    struct Neighbourhoods {
+        uint64_t topologyVersion = 0;
+        std::vector<int> offsets;
+        std::vector<int> vertices;
+        // uniform: the edge to each neighbour, and whether it is on the boundary
+        std::vector<EdgeHandle> edges;
+        std::vector<uint8_t> isBoundary;
+        // cotangent: the triangle corners opposite each neighbour, three per triangle
+        std::vector<int> cornerOffsets;
+        std::vector<int> corners;
+        std::vector<std::array<int, 3>> triangles;
+    };
+
+    void buildUniform(const Mesh &mesh);
+    void buildCotangent(const Mesh &mesh);
+
+    Neighbourhoods _uniform;
+    Neighbourhoods _cotangent;
+    StencilTable _stencils;
+};
+
+} // namespace meshlib
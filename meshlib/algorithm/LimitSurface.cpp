@@ -0,0 +1,307 @@
+#include "LimitSurface.hpp"
+#include <numeric>
+
+using namespace glm;
+
+namespace meshlib {
+
+namespace {
+
+bool isRegularVertex(const SubdivisionLevel &level, int vertex) {
+    if (level.vertexSharpness[vertex] > 0 || level.vertexEdgeCount(vertex) != 4 || level.vertexFaceCount(vertex) != 4) {
+        return false;
+    }
+    for (int i = level.vertexEdgeOffsets[vertex]; i < level.vertexEdgeOffsets[vertex + 1]; ++i) {
+        if (level.isSharpEdge(level.vertexEdges[i])) {
+            return false;
+        }
+    }
+    for (int i = level.vertexFaceOffsets[vertex]; i < level.vertexFaceOffsets[vertex + 1]; ++i) {
+        if (level.faceSize(level.vertexFaces[i]) != 4) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Collects the 4x4 B-spline control points of a face in a regular neighbourhood (row-major, v rows, u columns).
+// The face occupies rows and columns 1-2 with its corners at (1,1), (1,2), (2,2), (2,1).
+bool gatherRegularPatch(const SubdivisionLevel &level, int face, std::array<int, 16> &points) {
+    if (level.faceSize(face) != 4) {
+        return false;
+    }
+    int begin = level.faceOffsets[face];
+    std::array<int, 4> corners;
+    for (int k = 0; k < 4; ++k) {
+        corners[k] = level.faceVertices[begin + k];
+        if (!isRegularVertex(level, corners[k])) {
+            return false;
+        }
+    }
+
+    static constexpr int cornerSlots[4] = {5, 6, 10, 9};
+    // slots of the outer points next to corner i and corner i + 1 across edge i
+    static constexpr int edgeSlots[4][2] = {{1, 2}, {7, 11}, {14, 13}, {8, 4}};
+    static constexpr int diagonalSlots[4] = {0, 3, 15, 12};
+
+    for (int k = 0; k < 4; ++k) {
+        points[cornerSlots[k]] = corners[k];
+    }
+
+    std::array<int, 4> neighbours;
+    for (int i = 0; i < 4; ++i) {
+        int edge = level.faceEdges[begin + i];
+        int offset = level.edgeFaceOffsets[edge];
+        int neighbour = level.edgeFaces[offset] == face ? level.edgeFaces[offset + 1] : level.edgeFaces[offset];
+        if (neighbour == face) {
+            return false;
+        }
+        neighbours[i] = neighbour;
+
+        // the neighbour runs along the edge in the opposite direction
+        int neighbourBegin = level.faceOffsets[neighbour];
+        int j = -1;
+        for (int k = 0; k < 4; ++k) {
+            if (level.faceVertices[neighbourBegin + k] == corners[(i + 1) % 4] &&
+                level.faceVertices[neighbourBegin + (k + 1) % 4] == corners[i]) {
+                j = k;
+                break;
+            }
+        }
+        if (j < 0) {
+            return false;
+        }
+        points[edgeSlots[i][0]] = level.faceVertices[neighbourBegin + (j + 2) % 4];
+        points[edgeSlots[i][1]] = level.faceVertices[neighbourBegin + (j + 3) % 4];
+    }
+
+    for (int k = 0; k < 4; ++k) {
+        int vertex = corners[k];
+        int diagonal = -1;
+        for (int i = level.vertexFaceOffsets[vertex]; i < level.vertexFaceOffsets[vertex + 1]; ++i) {
+            int f = level.vertexFaces[i];
+            if (f != face && f != neighbours[k] && f != neighbours[(k + 3) % 4]) {
+                diagonal = f;
+            }
+        }
+        if (diagonal < 0) {
+            return false;
+        }
+        int diagonalBegin = level.faceOffsets[diagonal];
+        for (int m = 0; m < 4; ++m) {
+            if (level.faceVertices[diagonalBegin + m] == vertex) {
+                points[diagonalSlots[k]] = level.faceVertices[diagonalBegin + (m + 2) % 4];
+            }
+        }
+    }
+    return true;
+}
+
+void bsplineBasis(float t, float *basis, float *derivative) {
+    float s = 1.f - t;
+    basis[0] = s * s * s / 6.f;
+    basis[1] = (3.f * t * t * t - 6.f * t * t + 4.f) / 6.f;
+    basis[2] = (-3.f * t * t * t + 3.f * t * t + 3.f * t + 1.f) / 6.f;
+    basis[3] = t * t * t / 6.f;
+    derivative[0] = -s * s / 2.f;
+    derivative[1] = (3.f * t * t - 4.f * t) / 2.f;
+    derivative[2] = (-3.f * t * t + 2.f * t + 1.f) / 2.f;
+    derivative[3] = t * t / 2.f;
+}
+
+vec3 averagedNormal(const SubdivisionLevel &level, const std::vector<vec3> &points, int vertex) {
+    vec3 sum(0);
+    for (int i = level.vertexFaceOffsets[vertex]; i < level.vertexFaceOffsets[vertex + 1]; ++i) {
+        int face = level.vertexFaces[i];
+        int begin = level.faceOffsets[face];
+        int n = level.faceSize(face);
+        for (int k = 0; k < n; ++k) {
+            if (level.faceVertices[begin + k] == vertex) {
+                auto curr = points[vertex];
+                auto prev = points[level.faceVertices[begin + (k + n - 1) % n]];
+                auto next = points[level.faceVertices[begin + (k + 1) % n]];
+                sum += cross(next - curr, prev - curr);
+                break;
+            }
+        }
+    }
+    float len = length(sum);
+    return len > 0 ? sum / len : sum;
+}
+
+} // namespace
+
+LimitSurfaceEvaluator::LimitSurfaceEvaluator(const Mesh &cage, int level) {
+    level = std::max(level, 1);
+
+    std::vector<MaterialHandle> faceMaterials;
+    auto current = SubdivisionLevel::fromMesh(cage, _cageVertices, faceMaterials);
+    std::vector<int> activeFaces(current.faceCount());
+    std::iota(activeFaces.begin(), activeFaces.end(), 0);
+
+    for (int l = 0;; ++l) {
+        int resolution = 1 << (level - l);
+
+        std::vector<int> irregularFaces;
+        for (int face : activeFaces) {
+            Patch patch;
+            if (gatherRegularPatch(current, face, patch.points)) {
+                patch.level = l;
+                patch.resolution = resolution;
+                patch.firstPoint = uint32_t(_pointCount);
+                _pointCount += size_t(resolution + 1) * size_t(resolution + 1);
+                _quadCount += size_t(resolution) * size_t(resolution);
+                _patches.push_back(patch);
+            } else {
+                irregularFaces.push_back(face);
+            }
+        }
+        if (irregularFaces.empty()) {
+            break;
+        }
+
+        if (l == level) {
+            // evaluate the remaining quads at the limit positions of their corners
+            std::vector<std::pair<int, float>> stencil;
+            for (int face : irregularFaces) {
+                LimitQuad quad;
+                quad.firstPoint = uint32_t(_pointCount);
+                for (int k = 0; k < 4; ++k) {
+                    quad.points[k] = current.faceVertices[current.faceOffsets[face] + k];
+
+                    stencil.clear();
+                    current.limitStencil(quad.points[k], stencil);
+                    for (auto [index, weight] : stencil) {
+                        _limitStencils.indices.push_back(index);
+                        _limitStencils.weights.push_back(weight);
+                    }
+                    _limitStencils.offsets.push_back(int(_limitStencils.indices.size()));
+                }
+                _pointCount += 4;
+                ++_quadCount;
+                _limitQuads.push_back(quad);
+            }
+            _finalLevel = std::move(current);
+            break;
+        }
+
+        // refine the irregular faces together with their one-ring
+        std::vector<int> supportIndices(current.faceCount(), -1);
+        std::vector<int> support;
+        for (int face : irregularFaces) {
+            supportIndices[face] = int(support.size());
+            support.push_back(face);
+        }
+        for (int face : irregularFaces) {
+            for (int c = current.faceOffsets[face]; c < current.faceOffsets[face + 1]; ++c) {
+                int v = current.faceVertices[c];
+                for (int i = current.vertexFaceOffsets[v]; i < current.vertexFaceOffsets[v + 1]; ++i) {
+                    int neighbour = current.vertexFaces[i];
+                    if (supportIndices[neighbour] < 0) {
+                        supportIndices[neighbour] = int(support.size());
+                        support.push_back(neighbour);
+                    }
+                }
+            }
+        }
+
+        std::vector<int> vertexMap;
+        auto supportLevel = current.extractFaces(support, vertexMap);
+        auto supportPoints = StencilTable::identity(vertexMap.size());
+        supportPoints.indices = vertexMap;
+        _levelStencils.push_back(supportLevel.composeChildStencils(supportPoints));
+
+        // child faces are numbered by parent corner
+        std::vector<int> nextActiveFaces;
+        for (int face : irregularFaces) {
+            int s = supportIndices[face];
+            for (int c = supportLevel.faceOffsets[s]; c < supportLevel.faceOffsets[s + 1]; ++c) {
+                nextActiveFaces.push_back(c);
+            }
+        }
+        current = supportLevel.refine();
+        activeFaces = std::move(nextActiveFaces);
+    }
+}
+
+void LimitSurfaceEvaluator::quadIndices(uint32_t *indices) const {
+    for (auto &patch : _patches) {
+        uint32_t rowSize = uint32_t(patch.resolution + 1);
+        for (uint32_t j = 0; j < uint32_t(patch.resolution); ++j) {
+            for (uint32_t i = 0; i < uint32_t(patch.resolution); ++i) {
+                uint32_t base = patch.firstPoint + j * rowSize + i;
+                *indices++ = base;
+                *indices++ = base + 1;
+                *indices++ = base + rowSize + 1;
+                *indices++ = base + rowSize;
+            }
+        }
+    }
+    for (auto &quad : _limitQuads) {
+        for (uint32_t k = 0; k < 4; ++k) {
+            *indices++ = quad.firstPoint + k;
+        }
+    }
+}
+
+void LimitSurfaceEvaluator::evaluate(const Mesh &cage, vec3 *positions, vec3 *normals) const {
+    std::vector<std::vector<vec3>> levelPoints(_levelStencils.size() + 1);
+    levelPoints[0].resize(_cageVertices.size());
+    parallelFor(0, _cageVertices.size(), [&](size_t i) {
+        levelPoints[0][i] = cage.position(_cageVertices[i]);
+    });
+    for (size_t l = 0; l < _levelStencils.size(); ++l) {
+        levelPoints[l + 1].resize(_levelStencils[l].size());
+        _levelStencils[l].apply(levelPoints[l].data(), levelPoints[l + 1].data());
+    }
+
+    parallelFor(
+        0, _patches.size(), [&](size_t patchIndex) {
+            auto &patch = _patches[patchIndex];
+            auto &points = levelPoints[patch.level];
+            float step = 1.f / patch.resolution;
+
+            for (int j = 0; j <= patch.resolution; ++j) {
+                float bv[4], dv[4];
+                bsplineBasis(j * step, bv, dv);
+                for (int i = 0; i <= patch.resolution; ++i) {
+                    float bu[4], du[4];
+                    bsplineBasis(i * step, bu, du);
+
+                    vec3 position(0), tangentU(0), tangentV(0);
+                    for (int row = 0; row < 4; ++row) {
+                        for (int col = 0; col < 4; ++col) {
+                            auto &p = points[patch.points[row * 4 + col]];
+                            position += p * (bv[row] * bu[col]);
+                            tangentU += p * (bv[row] * du[col]);
+                            tangentV += p * (dv[row] * bu[col]);
+                        }
+                    }
+                    auto normal = cross(tangentU, tangentV);
+                    float len = length(normal);
+
+                    size_t index = patch.firstPoint + size_t(j) * (patch.resolution + 1) + i;
+                    positions[index] = position;
+                    normals[index] = len > 0 ? normal / len : normal;
+                }
+            }
+        },
+        16);
+
+    if (!_limitQuads.empty()) {
+        auto &finalPoints = levelPoints.back();
+        std::vector<vec3> limitPositions(_limitStencils.size());
+        _limitStencils.apply(finalPoints.data(), limitPositions.data());
+
+        // normals of the remaining quads are averaged over the final refinement level
+        parallelFor(0, _limitQuads.size(), [&](size_t i) {
+            auto &quad = _limitQuads[i];
+            for (int k = 0; k < 4; ++k) {
+                positions[quad.firstPoint + k] = limitPositions[i * 4 + k];
+                normals[quad.firstPoint + k] = averagedNormal(_finalLevel, finalPoints, quad.points[k]);
+            }
+        });
+    }
+}
+
+} // namespace meshlib
@@ -0,0 +1,47 @@
+#pragma once
+#include "SubdivisionLevel.hpp"
+
+namespace meshlib {
+
+// Evaluates the Catmull-Clark limit surface of a cage, tessellated as if subdivided `level` times, without building
+// the refined meshes.
+// Faces whose neighbourhood is regular (valence 4, no creases or corners) are evaluated directly as bicubic B-spline
+// patches; only faces around extraordinary vertices, creases and corners are refined further, and only together with
+// their one-ring. Each patch gets its own grid of output points, so points on patch borders are duplicated.
+class LimitSurfaceEvaluator {
+  public:
+    LimitSurfaceEvaluator(const Mesh &cage, int level);
+
+    size_t pointCount() const { return _pointCount; }
+    size_t quadCount() const { return _quadCount; }
+
+    // Writes 4 point indices per quad; depends only on the cage topology
+    void quadIndices(uint32_t *indices) const;
+
+    // Writes pointCount() limit positions and normals for the current positions of the cage
+    void evaluate(const Mesh &cage, glm::vec3 *positions, glm::vec3 *normals) const;
+
+  private:
+    struct Patch {
+        int level;
+        int resolution;
+        uint32_t firstPoint;
+        std::array<int, 16> points;
+    };
+
+    struct LimitQuad {
+        uint32_t firstPoint;
+        std::array<int, 4> points;
+    };
+
+    std::vector<VertexHandle> _cageVertices;
+    std::vector<StencilTable> _levelStencils; // points of level l + 1 over points of level l
+    std::vector<Patch> _patches;
+    std::vector<LimitQuad> _limitQuads;
+    SubdivisionLevel _finalLevel;
+    StencilTable _limitStencils; // 4 rows per limit quad over the points of the final level
+    size_t _pointCount = 0;
+    size_t _quadCount = 0;
+};
+
+} // namespace meshlib
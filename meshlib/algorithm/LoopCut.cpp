@@ -1,4 +1,5 @@
 #include "LoopCut.hpp"
+#include "../util/Instrumentation.hpp"
 #include "CutEdge.hpp"
 #include "FindBelt.hpp"
 #include <range/v3/algorithm/find.hpp>
@@ -6,13 +7,15 @@
 
 namespace meshlib {
 
-std::vector<VertexHandle> loopCut(Mesh &mesh, EdgeHandle edge, float cutPosition) {
+std::vector<VertexHandle> loopCut(Mesh &mesh, EdgeHandle edge, float cutPosition, std::pmr::memory_resource *resource) {
+    MESHLIB_SCOPED_OPERATION("loopCut");
+    ScopedMeshOperation operation(mesh, "loopCut");
     auto belt = findBelt(mesh, edge);
 
     std::vector<VertexHandle> vertices;
     vertices.reserve(belt.size());
     for (auto &[edge, face, isReverse] : belt) {
-        auto v = cutEdge(mesh, edge, isReverse ? (1.f - cutPosition) : cutPosition);
+        auto v = cutEdge(mesh, edge, isReverse ? (1.f - cutPosition) : cutPosition, resource);
         vertices.push_back(v);
     }
     for (size_t i = 0; i < vertices.size(); ++i) {
@@ -3,6 +3,6 @@
 
 namespace meshlib {
 
-std::vector<VertexHandle> loopCut(Mesh &mesh, EdgeHandle edge, float cutPosition);
+std::vector<VertexHandle> loopCut(Mesh &mesh, EdgeHandle edge, float cutPosition, std::pmr::memory_resource *resource = std::pmr::get_default_resource());
 
 } // namespace meshlib
@@ -0,0 +1,102 @@
+#include "Smooth.hpp"
+#include "../util/Instrumentation.hpp"
+#include "../util/Parallel.hpp"
+#include <algorithm>
+#include <cstring>
+
+using namespace glm;
+
+namespace meshlib {
+
+namespace {
+
+// vertices per block of an iteration; the rows are short, so blocks need many of them
+constexpr size_t MinVertexBlockSize = 4096;
+
+std::vector<vec3> packPositions(const Mesh &mesh) {
+    std::vector<vec3> positions(mesh.allVertexCount());
+    parallelForChunks(mesh.allVertexCount(), Mesh::ChunkSize, [&](size_t chunk, size_t begin, size_t end) {
+        std::copy(mesh.positionChunk(chunk), mesh.positionChunk(chunk) + (end - begin), positions.begin() + begin);
+    });
+    return positions;
+}
+
+// only the chunks that changed, so that the undo history keeps no copies of the others
+void unpackPositions(Mesh &mesh, const std::vector<vec3> &positions) {
+    parallelForChunks(mesh.allVertexCount(), Mesh::ChunkSize, [&](size_t chunk, size_t begin, size_t end) {
+        const Mesh &constMesh = mesh;
+        if (std::memcmp(constMesh.positionChunk(chunk), positions.data() + begin, (end - begin) * sizeof(vec3)) != 0) {
+            std::copy(positions.begin() + begin, positions.begin() + end, mesh.positionChunk(chunk));
+        }
+    });
+}
+
+// to[i] = from[i] + factor * (average of the neighbours - from[i]) for the vertices with neighbours that isMoved
+// accepts; with normals the move is projected onto the tangent plane
+template <typename TIsMoved>
+void smoothStep(const StencilTable &stencils, const vec3 *from, vec3 *to, float factor, const vec3 *normals, TIsMoved &&isMoved) {
+    parallelForBlocks(
+        0, stencils.size(),
+        [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                int rowBegin = stencils.offsets[i];
+                int rowEnd = stencils.offsets[i + 1];
+                vec3 average(0);
+                for (int k = rowBegin; k < rowEnd; ++k) {
+                    average += from[stencils.indices[k]] * stencils.weights[k];
+                }
+                vec3 move = rowBegin < rowEnd && isMoved(i) ? factor * (average - from[i]) : vec3(0);
+                if (normals) {
+                    move -= normals[i] * dot(normals[i], move);
+                }
+                to[i] = from[i] + move;
+            }
+        },
+        MinVertexBlockSize);
+}
+
+template <typename TIsMoved>
+void smooth(Mesh &mesh, LaplacianWeights weights, int iterations, float factor, float inflateFactor, bool isTangential, TIsMoved &&isMoved) {
+    auto &stencils = MeshLaplacian::forCurrentThread().stencils(mesh, weights);
+    std::vector<vec3> normals = isTangential ? mesh.calculateVertexNormals() : std::vector<vec3>();
+    auto positions = packPositions(mesh);
+    std::vector<vec3> next(positions.size());
+    for (int i = 0; i < iterations; ++i) {
+        smoothStep(stencils, positions.data(), next.data(), factor, isTangential ? normals.data() : nullptr, isMoved);
+        positions.swap(next);
+        if (inflateFactor != 0) {
+            smoothStep(stencils, positions.data(), next.data(), inflateFactor, nullptr, isMoved);
+            positions.swap(next);
+        }
+    }
+    unpackPositions(mesh, positions);
+}
+
+template <typename TFunc>
+void withMovedVertices(const Mesh &mesh, bool selectedOnly, TFunc &&func) {
+    if (selectedOnly) {
+        func([&](size_t i) { return mesh.isSelected(VertexHandle(int(i))); });
+    } else {
+        func([](size_t) { return true; });
+    }
+}
+
+} // namespace
+
+void smoothPositions(Mesh &mesh, const SmoothingOptions &options) {
+    MESHLIB_SCOPED_OPERATION("smoothPositions");
+    ScopedMeshOperation operation(mesh, "smoothPositions");
+    withMovedVertices(mesh, options.selectedOnly, [&](auto &&isMoved) {
+        smooth(mesh, options.weights, options.iterations, options.factor, options.inflateFactor, false, isMoved);
+    });
+}
+
+void relaxPositions(Mesh &mesh, int iterations, float factor, bool selectedOnly) {
+    MESHLIB_SCOPED_OPERATION("relaxPositions");
+    ScopedMeshOperation operation(mesh, "relaxPositions");
+    withMovedVertices(mesh, selectedOnly, [&](auto &&isMoved) {
+        smooth(mesh, LaplacianWeights::Uniform, iterations, factor, 0, true, isMoved);
+    });
+}
+
+} // namespace meshlib
@@ -0,0 +1,27 @@
+#pragma once
+#include "Laplacian.hpp"
+
+namespace meshlib {
+
+struct SmoothingOptions {
+    LaplacianWeights weights = LaplacianWeights::Uniform;
+    int iterations = 1;
+    // how far each iteration moves the vertices towards the average of their neighbours
+    float factor = 0.5f;
+    // Taubin's inflating step after each iteration, e.g. -0.53 with factor 0.5, against the shrinking of plain
+    // Laplacian smoothing; 0 for none
+    float inflateFactor = 0;
+    // only move the selected vertices; the others stay where they are and hold their neighbours in place
+    bool selectedOnly = false;
+};
+
+// Laplacian smoothing with the stencils of MeshLaplacian::forCurrentThread(), so vertices on feature lines slide
+// along them and corners stay put. The weights are computed once; the iterations run over a packed copy of the
+// positions in parallel, which is written back at the end.
+void smoothPositions(Mesh &mesh, const SmoothingOptions &options = {});
+
+// Moves the vertices towards the uniform average of their neighbours within their tangent planes, which evens out the
+// edge lengths and keeps the shape. The normals are those before the first iteration.
+void relaxPositions(Mesh &mesh, int iterations = 1, float factor = 0.5f, bool selectedOnly = false);
+
+} // namespace meshlib
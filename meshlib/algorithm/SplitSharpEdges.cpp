@@ -1,13 +1,16 @@
 #include "SplitSharpEdges.hpp"
+#include "../util/Instrumentation.hpp"
 #include <range/v3/algorithm/find.hpp>
 
 namespace meshlib {
 
-void splitSharpEdges(Mesh &mesh) {
+void splitSharpEdges(Mesh &mesh, std::pmr::memory_resource *resource) {
+    MESHLIB_SCOPED_OPERATION("splitSharpEdges");
+    ScopedMeshOperation operation(mesh, "splitSharpEdges");
     for (auto v : mesh.vertices()) {
         int nSharpEdges = 0;
         for (auto e : mesh.edges(v)) {
-            if (mesh.isSharp(e) || ranges::distance(mesh.faces(e)) >= 3) {
+            if (mesh.isSharp(e) || mesh.faceCount(e) >= 3) {
                 ++nSharpEdges;
             }
         }
@@ -15,18 +18,25 @@ void splitSharpEdges(Mesh &mesh) {
             continue;
         }
 
-        auto faces = mesh.faces(v) | ranges::to_vector;
-        auto edges = mesh.edges(v) | ranges::to_vector;
+        std::pmr::vector<FaceHandle> faces(resource);
+        for (auto f : mesh.faces(v)) {
+            faces.push_back(f);
+        }
+        std::pmr::vector<EdgeHandle> edges(resource);
+        for (auto e : mesh.edges(v)) {
+            edges.push_back(e);
+        }
 
         // 1. split faces into groups by sharp edges
         // 2. create separate vertices for each group
 
-        std::vector<std::array<FaceHandle, 2>> faceConnections;
+        std::pmr::vector<std::array<FaceHandle, 2>> faceConnections(resource);
         for (auto e : edges) {
             if (mesh.isSharp(e)) {
                 continue;
             }
-            auto edgeFaces = mesh.faces(e) | ranges::to_vector;
+            auto liveFaces = mesh.faces(e);
+            SmallVector<FaceHandle, 2> edgeFaces(liveFaces.begin(), liveFaces.end());
             if (edgeFaces.size() != 2) {
                 continue;
             }
@@ -45,7 +55,7 @@ void splitSharpEdges(Mesh &mesh) {
             return false;
         };
 
-        std::vector<std::vector<FaceHandle>> faceGroups;
+        std::pmr::vector<std::pmr::vector<FaceHandle>> faceGroups(resource);
         for (auto f : faces) {
             bool addedToGroup = false;
             for (auto &faceGroup : faceGroups) {
@@ -63,7 +73,7 @@ void splitSharpEdges(Mesh &mesh) {
                 }
             }
             if (!addedToGroup) {
-                faceGroups.push_back({f});
+                faceGroups.emplace_back(1, f);
             }
         }
 
@@ -74,7 +84,8 @@ void splitSharpEdges(Mesh &mesh) {
             for (auto f : faceGroup) {
                 auto vertices = mesh.vertices(f);
                 auto vertexIndex = ranges::find(vertices, v) - vertices.begin();
-                std::vector<UVPointHandle> uvPoints = mesh.uvPoints(f);
+                auto &faceUVPoints = mesh.uvPoints(f);
+                std::vector<UVPointHandle> uvPoints(faceUVPoints.begin(), faceUVPoints.end());
                 uvPoints[vertexIndex] = mesh.addUVPoint(newVertex, mesh.uvPosition(uvPoints[vertexIndex]));
                 auto material = mesh.material(f);
 
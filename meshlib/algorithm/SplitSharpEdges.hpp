@@ -3,6 +3,6 @@
 
 namespace meshlib {
 
-void splitSharpEdges(Mesh &mesh);
+void splitSharpEdges(Mesh &mesh, std::pmr::memory_resource *resource = std::pmr::get_default_resource());
 
 } // namespace meshlib
@@ -0,0 +1,126 @@
+#include "Subdivide.hpp"
+#include "../util/Instrumentation.hpp"
+#include "../util/Parallel.hpp"
+#include <algorithm>
+
+namespace meshlib {
+
+CatmullClarkSubdivider::CatmullClarkSubdivider(const Mesh &cage, int level) : _level(level) {
+    MESHLIB_SCOPED_OPERATION("CatmullClarkSubdivider");
+    auto positionLevel = SubdivisionLevel::fromMesh(cage, _cageVertices, _faceMaterials);
+    auto uvLevel = SubdivisionLevel::fromMeshUVPoints(cage, _cageUVPoints);
+
+    _vertexStencils = StencilTable::identity(positionLevel.vertexCount);
+    _uvPointStencils = StencilTable::identity(uvLevel.vertexCount);
+
+    for (int i = 0; i < level; ++i) {
+        _vertexStencils = positionLevel.composeChildStencils(_vertexStencils);
+        _uvPointStencils = uvLevel.composeChildStencils(_uvPointStencils);
+
+        // child faces are numbered by parent corner
+        std::vector<MaterialHandle> childMaterials(positionLevel.cornerCount());
+        for (int face = 0; face < positionLevel.faceCount(); ++face) {
+            for (int c = positionLevel.faceOffsets[face]; c < positionLevel.faceOffsets[face + 1]; ++c) {
+                childMaterials[c] = _faceMaterials[face];
+            }
+        }
+        _faceMaterials = std::move(childMaterials);
+
+        positionLevel = positionLevel.refine();
+        uvLevel = uvLevel.refine();
+    }
+
+    _uvPointVertices.resize(uvLevel.vertexCount);
+    for (int c = 0; c < uvLevel.cornerCount(); ++c) {
+        _uvPointVertices[uvLevel.faceVertices[c]] = positionLevel.faceVertices[c];
+    }
+
+    _refinedLevel = std::move(positionLevel);
+    _refinedUVLevel = std::move(uvLevel);
+}
+
+void CatmullClarkSubdivider::evaluate(const Mesh &cage, std::vector<glm::vec3> &positions, std::vector<glm::vec2> &uvPositions) const {
+    std::vector<glm::vec3> cagePositions(_cageVertices.size());
+    parallelFor(0, _cageVertices.size(), [&](size_t i) {
+        cagePositions[i] = cage.position(_cageVertices[i]);
+    });
+    std::vector<glm::vec2> cageUVPositions(_cageUVPoints.size());
+    parallelFor(0, _cageUVPoints.size(), [&](size_t i) {
+        cageUVPositions[i] = cage.uvPosition(_cageUVPoints[i]);
+    });
+
+    positions.resize(_vertexStencils.size());
+    uvPositions.resize(_uvPointStencils.size());
+    _vertexStencils.apply(cagePositions.data(), positions.data());
+    _uvPointStencils.apply(cageUVPositions.data(), uvPositions.data());
+}
+
+Mesh CatmullClarkSubdivider::subdivide(const Mesh &cage) const {
+    MESHLIB_SCOPED_OPERATION("CatmullClarkSubdivider::subdivide");
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec2> uvPositions;
+    evaluate(cage, positions, uvPositions);
+
+    // the refined levels already hold the edges and corners in Mesh order, so no lookups are needed
+    auto &level = _refinedLevel;
+    Mesh mesh;
+    mesh.beginDirectBuild(positions.size(), uvPositions.size(), size_t(level.edgeCount()), size_t(level.faceCount()));
+    parallelFor(0, positions.size(), [&](size_t i) { mesh.setDirectVertex(VertexHandle(int(i)), positions[i]); });
+    parallelFor(0, uvPositions.size(), [&](size_t i) {
+        mesh.setDirectUVPoint(UVPointHandle(int(i)), VertexHandle(_uvPointVertices[i]), uvPositions[i]);
+    });
+    parallelFor(0, size_t(level.edgeCount()), [&](size_t e) {
+        auto &vertices = level.edgeVertices[e];
+        mesh.setDirectEdge(EdgeHandle(int(e)), {VertexHandle(vertices[0]), VertexHandle(vertices[1])});
+    });
+    std::vector<UVPointHandle> cornerUVPoints(size_t(level.cornerCount()));
+    std::vector<EdgeHandle> cornerEdges(size_t(level.cornerCount()));
+    parallelFor(0, cornerUVPoints.size(), [&](size_t c) {
+        cornerUVPoints[c] = UVPointHandle(_refinedUVLevel.faceVertices[c]);
+        cornerEdges[c] = EdgeHandle(level.faceEdges[c]);
+    });
+    parallelFor(0, size_t(level.faceCount()), [&](size_t face) {
+        int begin = level.faceOffsets[face];
+        mesh.setDirectFace(FaceHandle(int(face)), cornerUVPoints.data() + begin, cornerEdges.data() + begin,
+                           size_t(level.faceOffsets[face + 1] - begin), _faceMaterials[face]);
+    });
+    mesh.endDirectBuild();
+
+    for (size_t i = 0; i < positions.size(); ++i) {
+        float sharpness = level.vertexSharpness[i];
+        if (sharpness > 0 && sharpness != infiniteSharpness) {
+            mesh.setCorner(VertexHandle(int(i)), sharpness);
+        }
+    }
+    for (int e = 0; e < level.edgeCount(); ++e) {
+        float sharpness = level.edgeSharpness[e];
+        if (sharpness == infiniteSharpness) {
+            mesh.setSharp(EdgeHandle(e), true);
+        } else if (sharpness > 0) {
+            mesh.setCrease(EdgeHandle(e), sharpness);
+        }
+    }
+
+    return mesh;
+}
+
+void CatmullClarkSubdivider::updatePositions(const Mesh &cage, Mesh &refined) const {
+    MESHLIB_SCOPED_OPERATION("CatmullClarkSubdivider::updatePositions");
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec2> uvPositions;
+    evaluate(cage, positions, uvPositions);
+
+    // whole chunks per task: refined can share them with copies and snapshots
+    parallelForChunks(positions.size(), Mesh::ChunkSize, [&](size_t chunk, size_t begin, size_t end) {
+        std::copy(positions.begin() + begin, positions.begin() + end, refined.positionChunk(chunk));
+    });
+    parallelForChunks(uvPositions.size(), Mesh::ChunkSize, [&](size_t chunk, size_t begin, size_t end) {
+        std::copy(uvPositions.begin() + begin, uvPositions.begin() + end, refined.uvPositionChunk(chunk));
+    });
+}
+
+Mesh subdivide(const Mesh &mesh, int level) {
+    return CatmullClarkSubdivider(mesh, level).subdivide(mesh);
+}
+
+} // namespace meshlib
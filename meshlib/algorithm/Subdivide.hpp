@@ -0,0 +1,41 @@
+#pragma once
+#include "SubdivisionLevel.hpp"
+
+namespace meshlib {
+
+// Semi-sharp Catmull-Clark subdivision.
+// Edge crease values are sharpnesses (number of levels the edge stays sharp), isSharp edges are infinitely sharp
+// and vertex corner values are vertex sharpnesses. UVs are interpolated face-varying, with UV seams kept as boundaries.
+// The refined points are precomputed as stencils over the cage, so re-evaluating after the cage vertices or uv points
+// have moved is a sparse matrix-vector product.
+class CatmullClarkSubdivider {
+  public:
+    CatmullClarkSubdivider(const Mesh &cage, int level);
+
+    // Builds the refined mesh with positions and UV positions evaluated from the cage
+    Mesh subdivide(const Mesh &cage) const;
+
+    // Re-evaluates a mesh returned by subdivide() after the cage has been edited without changing its topology
+    void updatePositions(const Mesh &cage, Mesh &refined) const;
+
+    int level() const { return _level; }
+    const StencilTable &vertexStencils() const { return _vertexStencils; }
+    const StencilTable &uvPointStencils() const { return _uvPointStencils; }
+
+  private:
+    void evaluate(const Mesh &cage, std::vector<glm::vec3> &positions, std::vector<glm::vec2> &uvPositions) const;
+
+    int _level;
+    std::vector<VertexHandle> _cageVertices;
+    std::vector<UVPointHandle> _cageUVPoints;
+    SubdivisionLevel _refinedLevel;
+    SubdivisionLevel _refinedUVLevel;
+    std::vector<int> _uvPointVertices;
+    std::vector<MaterialHandle> _faceMaterials;
+    StencilTable _vertexStencils;
+    StencilTable _uvPointStencils;
+};
+
+Mesh subdivide(const Mesh &mesh, int level);
+
+} // namespace meshlib
@@ -0,0 +1,479 @@
+#include "SubdivisionLevel.hpp"
+#include <algorithm>
+
+namespace meshlib {
+
+namespace {
+
+enum class VertexRule {
+    Smooth,
+    Crease,
+    Corner,
+};
+
+void buildOffsets(std::vector<int> &offsets, size_t count, const std::vector<int> &keys) {
+    offsets.assign(count + 1, 0);
+    for (int key : keys) {
+        ++offsets[key + 1];
+    }
+    for (size_t i = 0; i < count; ++i) {
+        offsets[i + 1] += offsets[i];
+    }
+}
+
+void mergeStencil(std::vector<std::pair<int, float>> &stencil) {
+    std::sort(stencil.begin(), stencil.end(), [](auto &a, auto &b) { return a.first < b.first; });
+    size_t count = 0;
+    for (size_t i = 0; i < stencil.size(); ++i) {
+        if (count > 0 && stencil[count - 1].first == stencil[i].first) {
+            stencil[count - 1].second += stencil[i].second;
+        } else {
+            stencil[count++] = stencil[i];
+        }
+    }
+    stencil.resize(count);
+}
+
+} // namespace
+
+StencilTable StencilTable::identity(size_t size) {
+    StencilTable table;
+    table.offsets.resize(size + 1);
+    table.indices.resize(size);
+    table.weights.assign(size, 1.f);
+    for (size_t i = 0; i < size; ++i) {
+        table.offsets[i + 1] = int(i + 1);
+        table.indices[i] = int(i);
+    }
+    return table;
+}
+
+void SubdivisionLevel::buildAdjacency() {
+    {
+        buildOffsets(edgeFaceOffsets, edgeVertices.size(), faceEdges);
+        edgeFaces.resize(edgeFaceOffsets.back());
+        std::vector<int> cursors(edgeFaceOffsets.begin(), edgeFaceOffsets.end() - 1);
+        for (int face = 0; face < faceCount(); ++face) {
+            for (int c = faceOffsets[face]; c < faceOffsets[face + 1]; ++c) {
+                edgeFaces[cursors[faceEdges[c]]++] = face;
+            }
+        }
+    }
+    {
+        vertexEdgeOffsets.assign(vertexCount + 1, 0);
+        for (auto &vertices : edgeVertices) {
+            ++vertexEdgeOffsets[vertices[0] + 1];
+            ++vertexEdgeOffsets[vertices[1] + 1];
+        }
+        for (int v = 0; v < vertexCount; ++v) {
+            vertexEdgeOffsets[v + 1] += vertexEdgeOffsets[v];
+        }
+        vertexEdges.resize(vertexEdgeOffsets.back());
+        std::vector<int> cursors(vertexEdgeOffsets.begin(), vertexEdgeOffsets.end() - 1);
+        for (int edge = 0; edge < edgeCount(); ++edge) {
+            vertexEdges[cursors[edgeVertices[edge][0]]++] = edge;
+            vertexEdges[cursors[edgeVertices[edge][1]]++] = edge;
+        }
+    }
+    {
+        buildOffsets(vertexFaceOffsets, vertexCount, faceVertices);
+        vertexFaces.resize(vertexFaceOffsets.back());
+        std::vector<int> cursors(vertexFaceOffsets.begin(), vertexFaceOffsets.end() - 1);
+        for (int face = 0; face < faceCount(); ++face) {
+            for (int c = faceOffsets[face]; c < faceOffsets[face + 1]; ++c) {
+                vertexFaces[cursors[faceVertices[c]]++] = face;
+            }
+        }
+    }
+}
+
+SubdivisionLevel SubdivisionLevel::refine() const {
+    int V = vertexCount;
+    int E = edgeCount();
+    int F = faceCount();
+    int C = cornerCount();
+
+    SubdivisionLevel child;
+    child.vertexCount = V + E + F;
+    child.faceOffsets.resize(C + 1);
+    child.faceVertices.resize(4 * C);
+    child.faceEdges.resize(4 * C);
+    child.edgeVertices.resize(2 * E + C);
+    child.edgeSharpness.resize(2 * E + C);
+    child.vertexSharpness.assign(child.vertexCount, 0.f);
+
+    auto halfEdge = [&](int edge, int vertex) {
+        return edgeVertices[edge][0] == vertex ? 2 * edge : 2 * edge + 1;
+    };
+
+    child.faceOffsets[0] = 0;
+    parallelFor(0, F, [&](size_t face) {
+        int begin = faceOffsets[face];
+        int n = faceSize(face);
+        for (int i = 0; i < n; ++i) {
+            int c = begin + i;
+            int prev = begin + (i + n - 1) % n;
+            int v = faceVertices[c];
+
+            child.faceOffsets[c + 1] = 4 * (c + 1);
+            child.faceVertices[4 * c] = v;
+            child.faceVertices[4 * c + 1] = V + faceEdges[c];
+            child.faceVertices[4 * c + 2] = V + E + int(face);
+            child.faceVertices[4 * c + 3] = V + faceEdges[prev];
+            child.faceEdges[4 * c] = halfEdge(faceEdges[c], v);
+            child.faceEdges[4 * c + 1] = 2 * E + c;
+            child.faceEdges[4 * c + 2] = 2 * E + prev;
+            child.faceEdges[4 * c + 3] = halfEdge(faceEdges[prev], v);
+
+            child.edgeVertices[2 * E + c] = {V + faceEdges[c], V + E + int(face)};
+            child.edgeSharpness[2 * E + c] = 0.f;
+        }
+    });
+    parallelFor(0, E, [&](size_t edge) {
+        float sharpness = std::max(edgeSharpness[edge] - 1.f, 0.f);
+        child.edgeVertices[2 * edge] = {edgeVertices[edge][0], V + int(edge)};
+        child.edgeVertices[2 * edge + 1] = {V + int(edge), edgeVertices[edge][1]};
+        child.edgeSharpness[2 * edge] = sharpness;
+        child.edgeSharpness[2 * edge + 1] = sharpness;
+    });
+    for (int v = 0; v < V; ++v) {
+        child.vertexSharpness[v] = std::max(vertexSharpness[v] - 1.f, 0.f);
+    }
+
+    child.buildAdjacency();
+    return child;
+}
+
+void SubdivisionLevel::childStencil(int child, std::vector<std::pair<int, float>> &stencil) const {
+    if (child < vertexCount) {
+        vertexPointStencil(child, stencil);
+    } else if (child < vertexCount + edgeCount()) {
+        edgePointStencil(child - vertexCount, stencil);
+    } else {
+        facePointStencil(child - vertexCount - edgeCount(), 1.f, stencil);
+    }
+}
+
+void SubdivisionLevel::facePointStencil(int face, float weight, std::vector<std::pair<int, float>> &stencil) const {
+    float w = weight / faceSize(face);
+    for (int c = faceOffsets[face]; c < faceOffsets[face + 1]; ++c) {
+        stencil.push_back({faceVertices[c], w});
+    }
+}
+
+void SubdivisionLevel::edgePointStencil(int edge, std::vector<std::pair<int, float>> &stencil) const {
+    auto &vertices = edgeVertices[edge];
+    // semi-sharp edges blend between the smooth and the sharp rule
+    float sharpWeight = edgeFaceCount(edge) == 2 ? std::min(edgeSharpness[edge], 1.f) : 1.f;
+    float smoothWeight = 1.f - sharpWeight;
+
+    float vertexWeight = 0.5f * sharpWeight + 0.25f * smoothWeight;
+    stencil.push_back({vertices[0], vertexWeight});
+    stencil.push_back({vertices[1], vertexWeight});
+    if (smoothWeight > 0) {
+        for (int i = edgeFaceOffsets[edge]; i < edgeFaceOffsets[edge + 1]; ++i) {
+            facePointStencil(edgeFaces[i], 0.25f * smoothWeight, stencil);
+        }
+    }
+}
+
+void SubdivisionLevel::vertexPointStencil(int vertex, std::vector<std::pair<int, float>> &stencil) const {
+    auto otherVertex = [&](int edge) {
+        return edgeVertices[edge][0] == vertex ? edgeVertices[edge][1] : edgeVertices[edge][0];
+    };
+    auto isChildSharpEdge = [&](int edge) {
+        return edgeSharpness[edge] > 1.f || edgeFaceCount(edge) != 2;
+    };
+
+    int sharpEdgeCount = 0;
+    int childSharpEdgeCount = 0;
+    for (int i = vertexEdgeOffsets[vertex]; i < vertexEdgeOffsets[vertex + 1]; ++i) {
+        int edge = vertexEdges[i];
+        sharpEdgeCount += isSharpEdge(edge);
+        childSharpEdgeCount += isChildSharpEdge(edge);
+    }
+
+    auto ruleFor = [&](float vertexSharpness, int sharpEdgeCount) {
+        if (vertexFaceCount(vertex) == 0 || vertexSharpness > 0 || sharpEdgeCount > 2) {
+            return VertexRule::Corner;
+        }
+        if (sharpEdgeCount == 2) {
+            return VertexRule::Crease;
+        }
+        return VertexRule::Smooth;
+    };
+    auto rule = ruleFor(vertexSharpness[vertex], sharpEdgeCount);
+    auto childRule = ruleFor(vertexSharpness[vertex] - 1.f, childSharpEdgeCount);
+
+    auto applyRule = [&](VertexRule rule, bool child, float weight) {
+        switch (rule) {
+        case VertexRule::Corner:
+            stencil.push_back({vertex, weight});
+            break;
+        case VertexRule::Crease:
+            stencil.push_back({vertex, weight * 0.75f});
+            for (int i = vertexEdgeOffsets[vertex]; i < vertexEdgeOffsets[vertex + 1]; ++i) {
+                int edge = vertexEdges[i];
+                if (child ? isChildSharpEdge(edge) : isSharpEdge(edge)) {
+                    stencil.push_back({otherVertex(edge), weight * 0.125f});
+                }
+            }
+            break;
+        case VertexRule::Smooth: {
+            // (Q + 2R + (n - 3)S) / n
+            float n = float(vertexEdgeCount(vertex));
+            int faceCount = vertexFaceCount(vertex);
+            stencil.push_back({vertex, weight * (n - 2.f) / n});
+            for (int i = vertexEdgeOffsets[vertex]; i < vertexEdgeOffsets[vertex + 1]; ++i) {
+                stencil.push_back({otherVertex(vertexEdges[i]), weight / (n * n)});
+            }
+            for (int i = vertexFaceOffsets[vertex]; i < vertexFaceOffsets[vertex + 1]; ++i) {
+                facePointStencil(vertexFaces[i], weight / (n * faceCount), stencil);
+            }
+            break;
+        }
+        }
+    };
+
+    if (rule == childRule) {
+        applyRule(rule, false, 1.f);
+        return;
+    }
+
+    // the rule changes at this level: blend by the fractional sharpness that is going away
+    float sharpnessSum = 0;
+    int sharpnessCount = 0;
+    if (vertexSharpness[vertex] > 0 && vertexSharpness[vertex] <= 1.f) {
+        sharpnessSum += vertexSharpness[vertex];
+        ++sharpnessCount;
+    }
+    for (int i = vertexEdgeOffsets[vertex]; i < vertexEdgeOffsets[vertex + 1]; ++i) {
+        int edge = vertexEdges[i];
+        if (isSharpEdge(edge) && !isChildSharpEdge(edge)) {
+            sharpnessSum += edgeSharpness[edge];
+            ++sharpnessCount;
+        }
+    }
+    float weight = sharpnessCount > 0 ? std::clamp(sharpnessSum / sharpnessCount, 0.f, 1.f) : 1.f;
+    applyRule(rule, false, weight);
+    applyRule(childRule, true, 1.f - weight);
+}
+
+void SubdivisionLevel::limitStencil(int vertex, std::vector<std::pair<int, float>> &stencil) const {
+    int sharpEdgeCount = 0;
+    for (int i = vertexEdgeOffsets[vertex]; i < vertexEdgeOffsets[vertex + 1]; ++i) {
+        sharpEdgeCount += isSharpEdge(vertexEdges[i]);
+    }
+    auto otherVertex = [&](int edge) {
+        return edgeVertices[edge][0] == vertex ? edgeVertices[edge][1] : edgeVertices[edge][0];
+    };
+
+    if (vertexFaceCount(vertex) == 0 || vertexSharpness[vertex] > 0 || sharpEdgeCount > 2) {
+        stencil.push_back({vertex, 1.f});
+        return;
+    }
+    if (sharpEdgeCount == 2) {
+        // limit of the cubic B-spline along the crease
+        stencil.push_back({vertex, 4.f / 6.f});
+        for (int i = vertexEdgeOffsets[vertex]; i < vertexEdgeOffsets[vertex + 1]; ++i) {
+            if (isSharpEdge(vertexEdges[i])) {
+                stencil.push_back({otherVertex(vertexEdges[i]), 1.f / 6.f});
+            }
+        }
+        return;
+    }
+
+    // (n^2 v + 4 sum(edge neighbours) + sum(diagonal neighbours)) / (n (n + 5))
+    float n = float(vertexEdgeCount(vertex));
+    float denominator = n * (n + 5.f);
+    stencil.push_back({vertex, n * n / denominator});
+    for (int i = vertexEdgeOffsets[vertex]; i < vertexEdgeOffsets[vertex + 1]; ++i) {
+        stencil.push_back({otherVertex(vertexEdges[i]), 4.f / denominator});
+    }
+    for (int i = vertexFaceOffsets[vertex]; i < vertexFaceOffsets[vertex + 1]; ++i) {
+        int face = vertexFaces[i];
+        int begin = faceOffsets[face];
+        for (int k = 0; k < 4; ++k) {
+            if (faceVertices[begin + k] == vertex) {
+                stencil.push_back({faceVertices[begin + (k + 2) % 4], 1.f / denominator});
+                break;
+            }
+        }
+    }
+}
+
+StencilTable SubdivisionLevel::composeChildStencils(const StencilTable &previous) const {
+    struct Block {
+        std::vector<int> sizes;
+        std::vector<int> indices;
+        std::vector<float> weights;
+    };
+
+    constexpr size_t blockSize = 4096;
+    size_t count = childCount();
+    std::vector<Block> blocks((count + blockSize - 1) / blockSize);
+
+    parallelFor(
+        0, blocks.size(), [&](size_t blockIndex) {
+            auto &block = blocks[blockIndex];
+            std::vector<std::pair<int, float>> local;
+            std::vector<std::pair<int, float>> composed;
+
+            size_t end = std::min(count, (blockIndex + 1) * blockSize);
+            for (size_t child = blockIndex * blockSize; child < end; ++child) {
+                local.clear();
+                childStencil(int(child), local);
+
+                composed.clear();
+                for (auto [index, weight] : local) {
+                    for (int k = previous.offsets[index]; k < previous.offsets[index + 1]; ++k) {
+                        composed.push_back({previous.indices[k], weight * previous.weights[k]});
+                    }
+                }
+                mergeStencil(composed);
+
+                block.sizes.push_back(int(composed.size()));
+                for (auto [index, weight] : composed) {
+                    block.indices.push_back(index);
+                    block.weights.push_back(weight);
+                }
+            }
+        },
+        1);
+
+    StencilTable table;
+    table.offsets.resize(count + 1);
+    std::vector<size_t> blockOffsets(blocks.size() + 1, 0);
+    size_t row = 0;
+    for (size_t b = 0; b < blocks.size(); ++b) {
+        for (int size : blocks[b].sizes) {
+            table.offsets[row + 1] = table.offsets[row] + size;
+            ++row;
+        }
+        blockOffsets[b + 1] = blockOffsets[b] + blocks[b].indices.size();
+    }
+    table.indices.resize(blockOffsets.back());
+    table.weights.resize(blockOffsets.back());
+    parallelFor(
+        0, blocks.size(), [&](size_t b) {
+            std::copy(blocks[b].indices.begin(), blocks[b].indices.end(), table.indices.begin() + blockOffsets[b]);
+            std::copy(blocks[b].weights.begin(), blocks[b].weights.end(), table.weights.begin() + blockOffsets[b]);
+        },
+        1);
+    return table;
+}
+
+SubdivisionLevel SubdivisionLevel::extractFaces(const std::vector<int> &faces, std::vector<int> &vertexMap) const {
+    SubdivisionLevel level;
+    std::vector<int> vertexIndices(vertexCount, -1);
+    std::vector<int> edgeIndices(edgeCount(), -1);
+
+    for (int face : faces) {
+        for (int c = faceOffsets[face]; c < faceOffsets[face + 1]; ++c) {
+            int v = faceVertices[c];
+            if (vertexIndices[v] < 0) {
+                vertexIndices[v] = int(vertexMap.size());
+                vertexMap.push_back(v);
+                level.vertexSharpness.push_back(vertexSharpness[v]);
+            }
+            level.faceVertices.push_back(vertexIndices[v]);
+        }
+        for (int c = faceOffsets[face]; c < faceOffsets[face + 1]; ++c) {
+            int e = faceEdges[c];
+            if (edgeIndices[e] < 0) {
+                edgeIndices[e] = level.edgeCount();
+                level.edgeVertices.push_back({vertexIndices[edgeVertices[e][0]], vertexIndices[edgeVertices[e][1]]});
+                level.edgeSharpness.push_back(edgeSharpness[e]);
+            }
+            level.faceEdges.push_back(edgeIndices[e]);
+        }
+        level.faceOffsets.push_back(int(level.faceVertices.size()));
+    }
+    level.vertexCount = int(vertexMap.size());
+    level.buildAdjacency();
+    return level;
+}
+
+SubdivisionLevel SubdivisionLevel::fromMesh(const Mesh &mesh, std::vector<VertexHandle> &vertices,
+                                            std::vector<MaterialHandle> &faceMaterials) {
+    SubdivisionLevel level;
+
+    std::vector<int> vertexIndices(mesh.allVertexCount(), -1);
+    for (auto v : mesh.vertices()) {
+        vertexIndices[v.index] = int(vertices.size());
+        vertices.push_back(v);
+        level.vertexSharpness.push_back(mesh.corner(v));
+    }
+    level.vertexCount = int(vertices.size());
+
+    std::vector<int> edgeIndices(mesh.allEdgeCount(), -1);
+    for (auto f : mesh.faces()) {
+        auto &uvPoints = mesh.uvPoints(f);
+        auto &edges = mesh.edges(f);
+        for (size_t i = 0; i < uvPoints.size(); ++i) {
+            level.faceVertices.push_back(vertexIndices[mesh.vertex(uvPoints[i]).index]);
+
+            auto edge = edges[i];
+            if (edgeIndices[edge.index] < 0) {
+                auto &edgeVertices = mesh.vertices(edge);
+                edgeIndices[edge.index] = level.edgeCount();
+                level.edgeVertices.push_back({vertexIndices[edgeVertices[0].index], vertexIndices[edgeVertices[1].index]});
+                level.edgeSharpness.push_back(mesh.isSharp(edge) ? infiniteSharpness : mesh.crease(edge));
+            }
+            level.faceEdges.push_back(edgeIndices[edge.index]);
+        }
+        level.faceOffsets.push_back(int(level.faceVertices.size()));
+        faceMaterials.push_back(mesh.material(f));
+    }
+
+    level.buildAdjacency();
+    return level;
+}
+
+SubdivisionLevel SubdivisionLevel::fromMeshUVPoints(const Mesh &mesh, std::vector<UVPointHandle> &uvPoints) {
+    SubdivisionLevel level;
+
+    std::vector<int> uvPointIndices(mesh.allUVPointCount(), -1);
+    std::unordered_map<uint64_t, int> uvEdgeIndices;
+
+    for (auto f : mesh.faces()) {
+        auto &faceUVPoints = mesh.uvPoints(f);
+        auto &edges = mesh.edges(f);
+        size_t begin = level.faceVertices.size();
+
+        for (auto uv : faceUVPoints) {
+            if (uvPointIndices[uv.index] < 0) {
+                uvPointIndices[uv.index] = int(uvPoints.size());
+                uvPoints.push_back(uv);
+                level.vertexSharpness.push_back(mesh.corner(mesh.vertex(uv)));
+            }
+            level.faceVertices.push_back(uvPointIndices[uv.index]);
+        }
+        for (size_t i = 0; i < faceUVPoints.size(); ++i) {
+            int uv0 = level.faceVertices[begin + i];
+            int uv1 = level.faceVertices[begin + (i + 1) % faceUVPoints.size()];
+            uint64_t key = (uint64_t(std::min(uv0, uv1)) << 32) | uint64_t(std::max(uv0, uv1));
+
+            auto [it, inserted] = uvEdgeIndices.insert({key, level.edgeCount()});
+            if (inserted) {
+                level.edgeVertices.push_back({uv0, uv1});
+                level.edgeSharpness.push_back(mesh.isSharp(edges[i]) ? infiniteSharpness : mesh.crease(edges[i]));
+            }
+            level.faceEdges.push_back(it->second);
+        }
+        level.faceOffsets.push_back(int(level.faceVertices.size()));
+    }
+    level.vertexCount = int(uvPoints.size());
+    level.buildAdjacency();
+
+    // keep UV island corners in place
+    for (int uv = 0; uv < level.vertexCount; ++uv) {
+        if (level.vertexFaceCount(uv) == 1) {
+            level.vertexSharpness[uv] = infiniteSharpness;
+        }
+    }
+
+    return level;
+}
+
+} // namespace meshlib
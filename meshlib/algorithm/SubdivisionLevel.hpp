@@ -0,0 +1,91 @@
+#pragma once
+#include "../Mesh.hpp"
+#include "../util/Parallel.hpp"
+#include <limits>
+
+namespace meshlib {
+
+constexpr float infiniteSharpness = std::numeric_limits<float>::infinity();
+
+// Sparse matrix in CSR form; each row is a linear combination of source points
+struct StencilTable {
+    std::vector<int> offsets{0};
+    std::vector<int> indices;
+    std::vector<float> weights;
+
+    size_t size() const { return offsets.size() - 1; }
+
+    static StencilTable identity(size_t size);
+
+    template <typename T>
+    void apply(const T *src, T *dst) const {
+        parallelFor(0, size(), [&](size_t i) {
+            T sum(0);
+            for (int k = offsets[i]; k < offsets[i + 1]; ++k) {
+                sum += src[indices[k]] * weights[k];
+            }
+            dst[i] = sum;
+        });
+    }
+};
+
+// Index-based Catmull-Clark refinement level.
+// Refining a level with V vertices, E edges and F faces produces V vertex points, E edge points and F face points
+// (in that order), and one quad per face corner, numbered by the parent corner.
+struct SubdivisionLevel {
+    int vertexCount = 0;
+    std::vector<int> faceOffsets{0};
+    std::vector<int> faceVertices;
+    std::vector<int> faceEdges; // edge from corner i to corner i + 1
+    std::vector<std::array<int, 2>> edgeVertices;
+    std::vector<float> edgeSharpness;
+    std::vector<float> vertexSharpness;
+
+    std::vector<int> edgeFaceOffsets;
+    std::vector<int> edgeFaces;
+    std::vector<int> vertexEdgeOffsets;
+    std::vector<int> vertexEdges;
+    std::vector<int> vertexFaceOffsets;
+    std::vector<int> vertexFaces;
+
+    int faceCount() const { return int(faceOffsets.size()) - 1; }
+    int edgeCount() const { return int(edgeVertices.size()); }
+    int cornerCount() const { return int(faceVertices.size()); }
+    int faceSize(int face) const { return faceOffsets[face + 1] - faceOffsets[face]; }
+    int edgeFaceCount(int edge) const { return edgeFaceOffsets[edge + 1] - edgeFaceOffsets[edge]; }
+    int vertexEdgeCount(int vertex) const { return vertexEdgeOffsets[vertex + 1] - vertexEdgeOffsets[vertex]; }
+    int vertexFaceCount(int vertex) const { return vertexFaceOffsets[vertex + 1] - vertexFaceOffsets[vertex]; }
+    int childCount() const { return vertexCount + edgeCount() + faceCount(); }
+
+    // boundary and non-manifold edges are always sharp
+    bool isSharpEdge(int edge) const { return edgeSharpness[edge] > 0 || edgeFaceCount(edge) != 2; }
+
+    // builds edge -> faces, vertex -> edges and vertex -> faces
+    void buildAdjacency();
+
+    SubdivisionLevel refine() const;
+
+    // Appends the weights of refined point `child` over the points of this level
+    void childStencil(int child, std::vector<std::pair<int, float>> &stencil) const;
+    // Appends the weights of the limit position of `vertex` over the points of this level (quad neighbourhoods only)
+    void limitStencil(int vertex, std::vector<std::pair<int, float>> &stencil) const;
+
+    // Stencils of the refined points over the cage, given the stencils of this level's points over the cage
+    StencilTable composeChildStencils(const StencilTable &previous) const;
+
+    // Level made of a subset of the faces; vertexMap receives the vertex of this level for each new vertex
+    SubdivisionLevel extractFaces(const std::vector<int> &faces, std::vector<int> &vertexMap) const;
+
+    // position level over the live faces of the mesh; vertices and edges are numbered densely
+    static SubdivisionLevel fromMesh(const Mesh &mesh, std::vector<VertexHandle> &vertices,
+                                     std::vector<MaterialHandle> &faceMaterials);
+    // face-varying level over the same faces, with uv points as vertices; UV seams become boundaries
+    static SubdivisionLevel fromMeshUVPoints(const Mesh &mesh, std::vector<UVPointHandle> &uvPoints);
+
+  private:
+    void vertexPointStencil(int vertex, std::vector<std::pair<int, float>> &stencil) const;
+    void edgePointStencil(int edge, std::vector<std::pair<int, float>> &stencil) const;
+    void facePointStencil(int face, float weight, std::vector<std::pair<int, float>> &stencil) const;
+};
+
+} // namespace meshlib
@@ -0,0 +1,172 @@
+#include "Transform.hpp"
+#include "../util/Instrumentation.hpp"
+#include "../util/Parallel.hpp"
+#include <mutex>
+
+namespace meshlib {
+
+namespace {
+
+// The kernels are plain loops over the packed coordinates: the selection is applied with a select instead of a
+// branch, so that the compiler can vectorize them without intrinsics.
+
+template <bool Projective, typename TIsAffected>
+void transformPositionBlock(glm::vec3 *positions, size_t begin, size_t end, const glm::mat4 &matrix, TIsAffected &&isAffected) {
+    // a local copy, otherwise the stores to positions force the coefficients to be reloaded
+    const glm::mat4 m = matrix;
+    for (size_t i = begin; i < end; ++i) {
+        float x = positions[i].x, y = positions[i].y, z = positions[i].z;
+        float newX = m[0][0] * x + m[1][0] * y + m[2][0] * z + m[3][0];
+        float newY = m[0][1] * x + m[1][1] * y + m[2][1] * z + m[3][1];
+        float newZ = m[0][2] * x + m[1][2] * y + m[2][2] * z + m[3][2];
+        if constexpr (Projective) {
+            float w = m[0][3] * x + m[1][3] * y + m[2][3] * z + m[3][3];
+            newX /= w;
+            newY /= w;
+            newZ /= w;
+        }
+        bool affected = isAffected(i);
+        positions[i] = glm::vec3(affected ? newX : x, affected ? newY : y, affected ? newZ : z);
+    }
+}
+
+template <typename TIsAffected>
+void transformUVPositionBlock(glm::vec2 *uvPositions, size_t begin, size_t end, const glm::mat3 &matrix, TIsAffected &&isAffected) {
+    const glm::mat3 m = matrix;
+    for (size_t i = begin; i < end; ++i) {
+        float u = uvPositions[i].x, v = uvPositions[i].y;
+        float newU = m[0][0] * u + m[1][0] * v + m[2][0];
+        float newV = m[0][1] * u + m[1][1] * v + m[2][1];
+        bool affected = isAffected(i);
+        uvPositions[i] = glm::vec2(affected ? newU : u, affected ? newV : v);
+    }
+}
+
+bool isAffine(const glm::mat4 &m) {
+    return m[0][3] == 0 && m[1][3] == 0 && m[2][3] == 0 && m[3][3] == 1;
+}
+
+template <typename TIsAffected>
+void transformPositions(Mesh &mesh, const glm::mat4 &matrix, TIsAffected &&isAffected) {
+    bool affine = isAffine(matrix);
+    parallelForChunks(mesh.allVertexCount(), Mesh::ChunkSize, [&](size_t chunk, size_t begin, size_t end) {
+        // the kernels index the chunk with element indices
+        auto positions = mesh.positionChunk(chunk) - begin;
+        if (affine) {
+            transformPositionBlock<false>(positions, begin, end, matrix, isAffected);
+        } else {
+            transformPositionBlock<true>(positions, begin, end, matrix, isAffected);
+        }
+    });
+}
+
+// Calls func(positions, begin, end, accumulator) with a fresh accumulator per chunk and merges the results
+template <typename TAccumulator, typename TFunc, typename TMerge>
+TAccumulator reducePositions(const Mesh &mesh, TFunc &&func, TMerge &&merge) {
+    TAccumulator result;
+    std::mutex resultMutex;
+    parallelForChunks(mesh.allVertexCount(), Mesh::ChunkSize, [&](size_t chunk, size_t begin, size_t end) {
+        TAccumulator accumulator;
+        func(mesh.positionChunk(chunk) - begin, begin, end, accumulator);
+        std::lock_guard<std::mutex> lock(resultMutex);
+        merge(result, accumulator);
+    });
+    return result;
+}
+
+} // namespace
+
+void transformPositions(Mesh &mesh, const glm::mat4 &matrix, bool selectedOnly) {
+    MESHLIB_SCOPED_OPERATION("transformPositions");
+    ScopedMeshOperation operation(mesh, "transformPositions");
+    if (selectedOnly) {
+        transformPositions(mesh, matrix, [&](size_t i) { return mesh.isSelected(VertexHandle(int(i))); });
+    } else {
+        transformPositions(mesh, matrix, [](size_t) { return true; });
+    }
+}
+
+void translatePositions(Mesh &mesh, glm::vec3 offset, bool selectedOnly) {
+    ScopedMeshOperation operation(mesh, "translatePositions");
+    glm::mat4 matrix(1);
+    matrix[3] = glm::vec4(offset, 1);
+    transformPositions(mesh, matrix, selectedOnly);
+}
+
+void scalePositions(Mesh &mesh, glm::vec3 scale, glm::vec3 pivot, bool selectedOnly) {
+    ScopedMeshOperation operation(mesh, "scalePositions");
+    // translate(pivot) * scale(scale) * translate(-pivot)
+    glm::mat4 matrix(1);
+    matrix[0][0] = scale.x;
+    matrix[1][1] = scale.y;
+    matrix[2][2] = scale.z;
+    matrix[3] = glm::vec4(pivot - pivot * scale, 1);
+    transformPositions(mesh, matrix, selectedOnly);
+}
+
+void transformUVPositions(Mesh &mesh, const glm::mat3 &matrix, bool selectedOnly) {
+    MESHLIB_SCOPED_OPERATION("transformUVPositions");
+    ScopedMeshOperation operation(mesh, "transformUVPositions");
+    parallelForChunks(mesh.allUVPointCount(), Mesh::ChunkSize, [&](size_t chunk, size_t begin, size_t end) {
+        auto uvPositions = mesh.uvPositionChunk(chunk) - begin;
+        if (selectedOnly) {
+            transformUVPositionBlock(uvPositions, begin, end, matrix, [&](size_t i) {
+                auto uv = UVPointHandle(int(i));
+                return !mesh.isDeleted(uv) && mesh.isSelected(mesh.vertex(uv));
+            });
+        } else {
+            transformUVPositionBlock(uvPositions, begin, end, matrix, [](size_t) { return true; });
+        }
+    });
+}
+
+BoundingBox boundingBox(const Mesh &mesh, bool selectedOnly) {
+    MESHLIB_SCOPED_OPERATION("boundingBox");
+    return reducePositions<BoundingBox>(
+        mesh,
+        [&](const glm::vec3 *positions, size_t begin, size_t end, BoundingBox &box) {
+            for (size_t i = begin; i < end; ++i) {
+                auto v = VertexHandle(int(i));
+                if (selectedOnly ? !mesh.isSelected(v) : mesh.isDeleted(v)) {
+                    continue;
+                }
+                box.min = glm::min(box.min, positions[i]);
+                box.max = glm::max(box.max, positions[i]);
+            }
+        },
+        [](BoundingBox &result, const BoundingBox &box) {
+            result.min = glm::min(result.min, box.min);
+            result.max = glm::max(result.max, box.max);
+        });
+}
+
+glm::vec3 centroid(const Mesh &mesh, bool selectedOnly) {
+    MESHLIB_SCOPED_OPERATION("centroid");
+    // summed in double so that large meshes far from the origin do not lose precision
+    struct Sum {
+        glm::dvec3 position = glm::dvec3(0);
+        size_t count = 0;
+    };
+    auto sum = reducePositions<Sum>(
+        mesh,
+        [&](const glm::vec3 *positions, size_t begin, size_t end, Sum &sum) {
+            for (size_t i = begin; i < end; ++i) {
+                auto v = VertexHandle(int(i));
+                if (selectedOnly ? !mesh.isSelected(v) : mesh.isDeleted(v)) {
+                    continue;
+                }
+                sum.position += glm::dvec3(positions[i]);
+                ++sum.count;
+            }
+        },
+        [](Sum &result, const Sum &sum) {
+            result.position += sum.position;
+            result.count += sum.count;
+        });
+    if (sum.count == 0) {
+        return glm::vec3(0);
+    }
+    return glm::vec3(sum.position / double(sum.count));
+}
+
+} // namespace meshlib
@@ -0,0 +1,32 @@
+#pragma once
+#include "../Mesh.hpp"
+#include <limits>
+
+namespace meshlib {
+
+// Empty if min > max
+struct BoundingBox {
+    glm::vec3 min = glm::vec3(std::numeric_limits<float>::infinity());
+    glm::vec3 max = glm::vec3(-std::numeric_limits<float>::infinity());
+
+    bool isEmpty() const { return min.x > max.x; }
+};
+
+// Bulk operations over the position chunks of a Mesh, split over threads for large meshes.
+// With selectedOnly they apply to the selected vertices and the uvPoints of the selected vertices, otherwise to all
+// vertices and uvPoints (transforms also move the deleted ones, which is harmless and keeps the loops branch-free).
+
+// p' = matrix * (p, 1); matrices with a projective row divide by w
+void transformPositions(Mesh &mesh, const glm::mat4 &matrix, bool selectedOnly = false);
+void translatePositions(Mesh &mesh, glm::vec3 offset, bool selectedOnly = false);
+void scalePositions(Mesh &mesh, glm::vec3 scale, glm::vec3 pivot, bool selectedOnly = false);
+
+// affine UV transform, uv' = matrix * (uv, 1); the last row of matrix is ignored
+void transformUVPositions(Mesh &mesh, const glm::mat3 &matrix, bool selectedOnly = false);
+
+// of the live (selected) vertices
+BoundingBox boundingBox(const Mesh &mesh, bool selectedOnly = false);
+// average live (selected) vertex position, 0 if there is none
+glm::vec3 centroid(const Mesh &mesh, bool selectedOnly = false);
+
+} // namespace meshlib
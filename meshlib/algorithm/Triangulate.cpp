@@ -0,0 +1,252 @@
+#include "Triangulate.hpp"
+#include "../util/Instrumentation.hpp"
+#include "../util/Parallel.hpp"
+#include <cmath>
+#include <limits>
+
+namespace meshlib {
+
+namespace {
+
+// polygons with more reflex corners than this bucket them in a grid for the ear tests
+constexpr size_t GridThreshold = 32;
+
+// > 0 if a, b, c turn counter-clockwise
+float orientation(glm::vec2 a, glm::vec2 b, glm::vec2 c) {
+    return (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+}
+
+bool contains(glm::vec2 a, glm::vec2 b, glm::vec2 c, glm::vec2 p) {
+    return orientation(a, b, p) >= 0 && orientation(b, c, p) >= 0 && orientation(c, a, p) >= 0;
+}
+
+// Ear clipping over a doubly linked list of the remaining corners. Only a reflex corner can lie inside an ear of a
+// simple polygon, so ears are tested against those, found through a uniform grid when there are many. Corners only
+// ever change from reflex to convex, so grid entries go stale instead of moving.
+class EarClipper {
+  public:
+    EarClipper(const glm::vec2 *points, size_t count) : _points(points), _count(count) {
+        _previous.resize(count);
+        _next.resize(count);
+        _reflex.resize(count);
+        for (size_t i = 0; i < count; ++i) {
+            _previous[i] = uint32_t(i == 0 ? count - 1 : i - 1);
+            _next[i] = uint32_t(i + 1 == count ? 0 : i + 1);
+        }
+        for (size_t i = 0; i < count; ++i) {
+            _reflex[i] = isReflex(uint32_t(i));
+            _reflexCount += _reflex[i] ? 1 : 0;
+        }
+    }
+
+    size_t reflexCount() const { return _reflexCount; }
+
+    void clip(uint32_t *corners) {
+        buildGrid();
+        uint32_t corner = 0;
+        size_t remaining = _count;
+        // corners tested since the last ear; a full round without one means the polygon is degenerate or
+        // self-intersecting, and the current corner is clipped anyway
+        size_t stalled = 0;
+        while (remaining > 3) {
+            uint32_t previous = _previous[corner];
+            uint32_t next = _next[corner];
+            if (stalled < remaining && !isEar(previous, corner, next)) {
+                corner = next;
+                ++stalled;
+                continue;
+            }
+            *corners++ = previous;
+            *corners++ = corner;
+            *corners++ = next;
+            _next[previous] = next;
+            _previous[next] = previous;
+            _reflex[corner] = false;
+            _reflex[previous] = _reflex[previous] && isReflex(previous);
+            _reflex[next] = _reflex[next] && isReflex(next);
+            --remaining;
+            corner = next;
+            stalled = 0;
+        }
+        *corners++ = _previous[corner];
+        *corners++ = corner;
+        *corners++ = _next[corner];
+    }
+
+  private:
+    const glm::vec2 *_points;
+    size_t _count;
+    SmallVector<uint32_t, 16> _previous;
+    SmallVector<uint32_t, 16> _next;
+    SmallVector<bool, 16> _reflex;
+    size_t _reflexCount = 0;
+
+    // the reflex corners of grid cell (x, y) are _cellCorners[_cellOffsets[y * _gridSize + x]...]
+    size_t _gridSize = 1;
+    glm::vec2 _gridMin{0};
+    glm::vec2 _gridScale{0};
+    SmallVector<uint32_t, 2> _cellOffsets;
+    SmallVector<uint32_t, 16> _cellCorners;
+
+    // flat corners count as reflex: they may lie on the diagonal of an ear, and a fan over them makes degenerate triangles
+    bool isReflex(uint32_t corner) const {
+        return orientation(_points[_previous[corner]], _points[corner], _points[_next[corner]]) <= 0;
+    }
+
+    glm::ivec2 cell(glm::vec2 point) const {
+        auto maxCell = glm::vec2(float(_gridSize - 1));
+        return glm::ivec2(glm::clamp((point - _gridMin) * _gridScale, glm::vec2(0), maxCell));
+    }
+
+    void buildGrid() {
+        _gridSize = _reflexCount > GridThreshold ? size_t(std::sqrt(float(_reflexCount))) : 1;
+        glm::vec2 gridMax = _points[0];
+        _gridMin = _points[0];
+        for (size_t i = 1; i < _count; ++i) {
+            _gridMin = glm::min(_gridMin, _points[i]);
+            gridMax = glm::max(gridMax, _points[i]);
+        }
+        auto extent = gridMax - _gridMin;
+        _gridScale = glm::vec2(float(_gridSize)) / glm::max(extent, glm::vec2(std::numeric_limits<float>::min()));
+
+        _cellOffsets.resize(_gridSize * _gridSize + 1, 0);
+        _cellCorners.resize(_reflexCount);
+        for (size_t i = 0; i < _count; ++i) {
+            if (_reflex[i]) {
+                auto c = cell(_points[i]);
+                ++_cellOffsets[size_t(c.y) * _gridSize + size_t(c.x) + 1];
+            }
+        }
+        for (size_t i = 1; i < _cellOffsets.size(); ++i) {
+            _cellOffsets[i] += _cellOffsets[i - 1];
+        }
+        SmallVector<uint32_t, 2> fill(_cellOffsets.begin(), _cellOffsets.end() - 1);
+        for (size_t i = 0; i < _count; ++i) {
+            if (_reflex[i]) {
+                auto c = cell(_points[i]);
+                _cellCorners[fill[size_t(c.y) * _gridSize + size_t(c.x)]++] = uint32_t(i);
+            }
+        }
+    }
+
+    bool isEar(uint32_t previous, uint32_t corner, uint32_t next) const {
+        auto a = _points[previous];
+        auto b = _points[corner];
+        auto c = _points[next];
+        if (orientation(a, b, c) <= 0) {
+            return false;
+        }
+        auto minCell = cell(glm::min(a, glm::min(b, c)));
+        auto maxCell = cell(glm::max(a, glm::max(b, c)));
+        for (int y = minCell.y; y <= maxCell.y; ++y) {
+            for (int x = minCell.x; x <= maxCell.x; ++x) {
+                size_t index = size_t(y) * _gridSize + size_t(x);
+                for (uint32_t i = _cellOffsets[index]; i < _cellOffsets[index + 1]; ++i) {
+                    uint32_t other = _cellCorners[i];
+                    auto p = _points[other];
+                    if (!_reflex[other] || other == previous || other == next || p == a || p == b || p == c) {
+                        continue;
+                    }
+                    if (contains(a, b, c, p)) {
+                        return false;
+                    }
+                }
+            }
+        }
+        return true;
+    }
+};
+
+} // namespace
+
+void triangulatePolygon(const glm::vec3 *positions, size_t count, uint32_t *corners) {
+    if (count < 3) {
+        return;
+    }
+    auto fan = [&] {
+        for (uint32_t i = 1; i + 1 < count; ++i) {
+            *corners++ = 0;
+            *corners++ = i;
+            *corners++ = i + 1;
+        }
+    };
+    if (count == 3) {
+        fan();
+        return;
+    }
+
+    // Newell normal, relative to the first corner for precision
+    glm::vec3 normal(0);
+    for (size_t i = 1; i + 1 < count; ++i) {
+        normal += cross(positions[i] - positions[0], positions[i + 1] - positions[0]);
+    }
+    if (normal == glm::vec3(0)) {
+        fan();
+        return;
+    }
+    normal = normalize(normal);
+    // u, v, normal are right-handed, so the polygon turns counter-clockwise in (u, v)
+    auto absNormal = glm::abs(normal);
+    glm::vec3 axis = absNormal.x <= absNormal.y && absNormal.x <= absNormal.z ? glm::vec3(1, 0, 0)
+                     : absNormal.y <= absNormal.z                             ? glm::vec3(0, 1, 0)
+                                                                              : glm::vec3(0, 0, 1);
+    auto u = normalize(cross(axis, normal));
+    auto v = cross(normal, u);
+    SmallVector<glm::vec2, 16> points;
+    points.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        auto offset = positions[i] - positions[0];
+        points[i] = glm::vec2(dot(offset, u), dot(offset, v));
+    }
+
+    EarClipper clipper(points.data(), count);
+    if (clipper.reflexCount() == 0) {
+        fan();
+    } else {
+        clipper.clip(corners);
+    }
+}
+
+void triangulateFace(const Mesh &mesh, FaceHandle face, UVPointHandle *triangles) {
+    auto &uvPoints = mesh.uvPoints(face);
+    size_t count = uvPoints.size();
+    if (count < 3) {
+        return;
+    }
+    if (count == 3) {
+        std::copy(uvPoints.begin(), uvPoints.end(), triangles);
+        return;
+    }
+    SmallVector<glm::vec3, 16> positions;
+    for (auto uvPoint : uvPoints) {
+        positions.push_back(mesh.position(mesh.vertex(uvPoint)));
+    }
+    SmallVector<uint32_t, 42> corners;
+    corners.resize(3 * (count - 2));
+    triangulatePolygon(positions.data(), count, corners.data());
+    for (size_t i = 0; i < corners.size(); ++i) {
+        triangles[i] = uvPoints[corners[i]];
+    }
+}
+
+Triangulation triangulate(const Mesh &mesh, std::pmr::memory_resource *resource) {
+    MESHLIB_SCOPED_OPERATION("triangulate");
+    Triangulation result{std::pmr::vector<UVPointHandle>(resource), std::pmr::vector<uint32_t>(mesh.allFaceCount() + 1, 0, resource)};
+    auto &offsets = result.faceOffsets;
+    for (auto f : mesh.faces()) {
+        size_t count = mesh.vertexCount(f);
+        offsets[f.index + 1] = count < 3 ? 0 : uint32_t(count - 2);
+    }
+    for (size_t i = 1; i < offsets.size(); ++i) {
+        offsets[i] += offsets[i - 1];
+    }
+    result.triangles.resize(3 * size_t(offsets.back()));
+    parallelFor(0, mesh.allFaceCount(), [&](size_t f) {
+        if (offsets[f + 1] > offsets[f]) {
+            triangulateFace(mesh, FaceHandle(int(f)), result.triangles.data() + 3 * size_t(offsets[f]));
+        }
+    });
+    return result;
+}
+
+} // namespace meshlib
@@ -0,0 +1,27 @@
+#pragma once
+#include "../Mesh.hpp"
+
+namespace meshlib {
+
+// Triangles of all faces, three uvPoints each, wound like their faces
+struct Triangulation {
+    std::pmr::vector<UVPointHandle> triangles;
+    // face f has triangles faceOffsets[f.index] to faceOffsets[f.index + 1] - 1; deleted faces have none
+    std::pmr::vector<uint32_t> faceOffsets;
+
+    size_t triangleCount() const { return triangles.size() / 3; }
+};
+
+// Splits polygon 0..count-1 into count - 2 triangles and writes their corner indices to corners. The polygon is
+// projected onto the plane of its Newell normal; convex polygons are fanned, others ear clipped, testing ears only
+// against the reflex corners (kept in a grid for large polygons). Self-intersecting polygons still give count - 2
+// triangles, some of them overlapping.
+void triangulatePolygon(const glm::vec3 *positions, size_t count, uint32_t *corners);
+
+// Writes 3 * (vertexCount(face) - 2) uvPoints of face to triangles
+void triangulateFace(const Mesh &mesh, FaceHandle face, UVPointHandle *triangles);
+
+// All faces in parallel
+Triangulation triangulate(const Mesh &mesh, std::pmr::memory_resource *resource = std::pmr::get_default_resource());
+
+} // namespace meshlib
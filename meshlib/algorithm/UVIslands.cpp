@@ -0,0 +1,388 @@
+#include "UVIslands.hpp"
+#include "../util/Instrumentation.hpp"
+#include "../util/Parallel.hpp"
+#include <algorithm>
+#include <limits>
+#include <numeric>
+#include <queue>
+
+using namespace glm;
+
+namespace meshlib {
+
+namespace {
+
+bool isSeparating(const Mesh &mesh, const std::vector<uint8_t> &isSeam, EdgeHandle edge) {
+    return isSeam[edge.index] || mesh.faceCount(edge) != 2;
+}
+
+// corner index of a face at a vertex
+struct Corner {
+    FaceHandle face;
+    int index;
+    UVPointHandle uvPoint;
+    // lowest corner of the fan, the corners connected to this one through edges that do not separate them
+    int fan;
+};
+using Corners = SmallVector<Corner, 16>;
+
+Corners findFans(const Mesh &mesh, const std::vector<uint8_t> &isSeam, VertexHandle v) {
+    Corners corners;
+    for (auto uvPoint : mesh.uvPoints(v)) {
+        for (auto face : mesh.faces(uvPoint)) {
+            auto &faceUVPoints = mesh.uvPoints(face);
+            for (int i = 0; i < int(faceUVPoints.size()); ++i) {
+                bool isListed = std::any_of(corners.begin(), corners.end(), [&](const Corner &c) { return c.face == face && c.index == i; });
+                if (faceUVPoints[i] == uvPoint && !isListed) {
+                    corners.push_back({face, i, uvPoint, int(corners.size())});
+                }
+            }
+        }
+    }
+    auto find = [&](int c) {
+        while (corners[c].fan != c) {
+            c = corners[c].fan = corners[corners[c].fan].fan;
+        }
+        return c;
+    };
+    // the two edges of the face at a corner
+    auto cornerEdges = [&](const Corner &c) {
+        auto &edges = mesh.edges(c.face);
+        return std::array<EdgeHandle, 2>{edges[c.index], edges[(c.index + edges.size() - 1) % edges.size()]};
+    };
+    for (int c = 0; c < int(corners.size()); ++c) {
+        for (auto edge : cornerEdges(corners[c])) {
+            if (isSeparating(mesh, isSeam, edge)) {
+                continue;
+            }
+            for (int d = 0; d < c; ++d) {
+                auto otherEdges = cornerEdges(corners[d]);
+                if (corners[d].face != corners[c].face && (otherEdges[0] == edge || otherEdges[1] == edge)) {
+                    int a = find(c);
+                    int b = find(d);
+                    corners[std::max(a, b)].fan = std::min(a, b);
+                }
+            }
+        }
+    }
+    for (int c = 0; c < int(corners.size()); ++c) {
+        corners[c].fan = find(c);
+    }
+    return corners;
+}
+
+// The uvPoint for each corner of the faces around v: the one of its fan, or -1 - k for the k-th new one. A fan keeps
+// the uvPoint all its corners have if no other fan uses it, otherwise takes the first unclaimed one among its corners.
+// Returns the number of new uvPoints.
+int assignFanUVPoints(const Corners &corners, int *targets, const std::vector<uint32_t> &cornerOffsets) {
+    SmallVector<int, 16> fanUVPoints;
+    fanUVPoints.resize(corners.size(), std::numeric_limits<int>::min());
+    auto isClaimed = [&](UVPointHandle uvPoint) { return std::find(fanUVPoints.begin(), fanUVPoints.end(), uvPoint.index) != fanUVPoints.end(); };
+    for (size_t c = 0; c < corners.size(); ++c) {
+        int fan = corners[c].fan;
+        if (fan != int(c)) {
+            continue;
+        }
+        bool isKept = std::all_of(corners.begin(), corners.end(), [&](const Corner &other) {
+            return (other.fan == fan) == (other.uvPoint == corners[c].uvPoint);
+        });
+        if (isKept) {
+            fanUVPoints[fan] = corners[c].uvPoint.index;
+        }
+    }
+    int newCount = 0;
+    for (size_t c = 0; c < corners.size(); ++c) {
+        int fan = corners[c].fan;
+        if (fan != int(c) || fanUVPoints[fan] != std::numeric_limits<int>::min()) {
+            continue;
+        }
+        auto unclaimed = std::find_if(corners.begin(), corners.end(), [&](const Corner &other) { return other.fan == fan && !isClaimed(other.uvPoint); });
+        fanUVPoints[fan] = unclaimed != corners.end() ? unclaimed->uvPoint.index : -1 - newCount++;
+    }
+    for (auto &corner : corners) {
+        targets[cornerOffsets[corner.face.index] + corner.index] = fanUVPoints[corner.fan];
+    }
+    return newCount;
+}
+
+// Vertex farthest from source along the edges of one island, with the edge towards the source from each vertex reached
+template <typename TIsIslandEdge>
+VertexHandle findFarthest(const Mesh &mesh, VertexHandle source, TIsIslandEdge &&isIslandEdge, std::vector<double> &distances,
+                          std::vector<EdgeHandle> &previous, std::vector<VertexHandle> &reached) {
+    for (auto v : reached) {
+        distances[v.index] = std::numeric_limits<double>::infinity();
+    }
+    reached.assign(1, source);
+    distances[source.index] = 0;
+    previous[source.index] = EdgeHandle();
+    using Entry = std::pair<double, int>;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> queue;
+    queue.push({0, source.index});
+    VertexHandle farthest = source;
+    while (!queue.empty()) {
+        auto [distance, index] = queue.top();
+        queue.pop();
+        auto v = VertexHandle(index);
+        if (distance > distances[index]) {
+            continue;
+        }
+        farthest = v;
+        for (auto edge : mesh.edges(v)) {
+            if (!isIslandEdge(edge)) {
+                continue;
+            }
+            auto &edgeVertices = mesh.vertices(edge);
+            auto other = edgeVertices[0] == v ? edgeVertices[1] : edgeVertices[0];
+            double otherDistance = distance + double(length(mesh.position(other) - mesh.position(v)));
+            if (otherDistance < distances[other.index]) {
+                if (distances[other.index] == std::numeric_limits<double>::infinity()) {
+                    reached.push_back(other);
+                }
+                distances[other.index] = otherDistance;
+                previous[other.index] = edge;
+                queue.push({otherDistance, other.index});
+            }
+        }
+    }
+    return farthest;
+}
+
+} // namespace
+
+UVIslands findUVIslands(const Mesh &mesh) {
+    MESHLIB_SCOPED_OPERATION("findUVIslands");
+    size_t uvPointCount = mesh.allUVPointCount();
+    std::vector<int> parents(uvPointCount);
+    std::iota(parents.begin(), parents.end(), 0);
+    auto find = [&](int i) {
+        while (parents[i] != i) {
+            i = parents[i] = parents[parents[i]];
+        }
+        return i;
+    };
+    for (auto face : mesh.faces()) {
+        auto &uvPoints = mesh.uvPoints(face);
+        int root = find(uvPoints[0].index);
+        for (size_t i = 1; i < uvPoints.size(); ++i) {
+            parents[find(uvPoints[i].index)] = root;
+        }
+    }
+
+    // islands in the order of their first faces
+    UVIslands islands;
+    std::vector<int> rootIslands(uvPointCount, -1);
+    std::vector<int> faceIslands(mesh.allFaceCount(), -1);
+    for (auto face : mesh.faces()) {
+        int root = find(mesh.uvPoints(face)[0].index);
+        if (rootIslands[root] < 0) {
+            rootIslands[root] = int(islands.size());
+            islands.offsets.push_back(0);
+        }
+        faceIslands[face.index] = rootIslands[root];
+        ++islands.offsets[rootIslands[root] + 1];
+    }
+    std::partial_sum(islands.offsets.begin(), islands.offsets.end(), islands.offsets.begin());
+    islands.faces.resize(islands.offsets.back());
+    std::vector<int> next(islands.offsets.begin(), islands.offsets.end() - 1);
+    for (auto face : mesh.faces()) {
+        islands.faces[next[faceIslands[face.index]]++] = face;
+    }
+    islands.uvPointIslands.resize(uvPointCount);
+    for (size_t i = 0; i < uvPointCount; ++i) {
+        auto uvPoint = UVPointHandle(int(i));
+        islands.uvPointIslands[i] = mesh.isDeleted(uvPoint) ? -1 : rootIslands[find(int(i))];
+    }
+    return islands;
+}
+
+void applyUVSeams(Mesh &mesh, const std::vector<uint8_t> &isSeam) {
+    MESHLIB_SCOPED_OPERATION("applyUVSeams");
+    ScopedMeshOperation operation(mesh, "applyUVSeams");
+    size_t faceCount = mesh.allFaceCount();
+    std::vector<uint32_t> cornerOffsets(faceCount + 1, 0);
+    parallelFor(0, faceCount, [&](size_t f) {
+        auto face = FaceHandle(int(f));
+        cornerOffsets[f + 1] = mesh.isDeleted(face) ? 0 : uint32_t(mesh.vertexCount(face));
+    });
+    std::partial_sum(cornerOffsets.begin(), cornerOffsets.end(), cornerOffsets.begin());
+
+    // the uvPoint of each corner as from assignFanUVPoints(), at first the current one
+    std::vector<int> targets(cornerOffsets.back());
+    parallelFor(0, faceCount, [&](size_t f) {
+        auto face = FaceHandle(int(f));
+        if (!mesh.isDeleted(face)) {
+            auto &uvPoints = mesh.uvPoints(face);
+            std::transform(uvPoints.begin(), uvPoints.end(), targets.begin() + cornerOffsets[f], [](auto uvPoint) { return uvPoint.index; });
+        }
+    });
+    std::vector<int> newCounts(mesh.allVertexCount(), 0);
+    parallelFor(0, mesh.allVertexCount(), [&](size_t v) {
+        auto vertex = VertexHandle(int(v));
+        if (!mesh.isDeleted(vertex)) {
+            newCounts[v] = assignFanUVPoints(findFans(mesh, isSeam, vertex), targets.data(), cornerOffsets);
+        }
+    });
+
+    std::vector<UVPointHandle> newUVPoints;
+    for (size_t v = 0; v < newCounts.size(); ++v) {
+        if (newCounts[v] == 0) {
+            continue;
+        }
+        auto vertex = VertexHandle(int(v));
+        newUVPoints.clear();
+        for (auto &corner : findFans(mesh, isSeam, vertex)) {
+            int &target = targets[cornerOffsets[corner.face.index] + corner.index];
+            if (target >= 0) {
+                continue;
+            }
+            size_t k = size_t(-1 - target);
+            if (k == newUVPoints.size()) {
+                newUVPoints.push_back(mesh.addUVPoint(vertex, mesh.uvPosition(corner.uvPoint)));
+            }
+            target = newUVPoints[k].index;
+        }
+    }
+
+    std::vector<UVPointHandle> oldUVPoints;
+    for (size_t f = 0; f < faceCount; ++f) {
+        auto face = FaceHandle(int(f));
+        if (mesh.isDeleted(face)) {
+            continue;
+        }
+        auto &faceUVPoints = mesh.uvPoints(face);
+        std::vector<UVPointHandle> uvPoints(faceUVPoints.begin(), faceUVPoints.end());
+        bool isChanged = false;
+        for (size_t i = 0; i < uvPoints.size(); ++i) {
+            auto target = UVPointHandle(targets[cornerOffsets[f] + i]);
+            if (target != uvPoints[i]) {
+                oldUVPoints.push_back(uvPoints[i]);
+                uvPoints[i] = target;
+                isChanged = true;
+            }
+        }
+        if (isChanged) {
+            auto material = mesh.material(face);
+            mesh.removeFace(face);
+            mesh.addFace(uvPoints, material);
+        }
+    }
+    for (auto uvPoint : oldUVPoints) {
+        if (!mesh.isDeleted(uvPoint) && mesh.faceCount(uvPoint) == 0) {
+            mesh.removeUVPoint(uvPoint);
+        }
+    }
+}
+
+void cutUVIslands(const Mesh &mesh, std::vector<uint8_t> &isSeam) {
+    MESHLIB_SCOPED_OPERATION("cutUVIslands");
+    // a seam only opens its island where it splits the corners around a vertex, so where two of them meet
+    std::vector<int> seamDegrees(mesh.allVertexCount(), 0);
+    for (auto edge : mesh.edges()) {
+        if (mesh.faceCount(edge) > 0 && isSeparating(mesh, isSeam, edge)) {
+            for (auto v : mesh.vertices(edge)) {
+                ++seamDegrees[v.index];
+            }
+        }
+    }
+
+    // spanning trees of the faces of the islands, breadth first from their lowest faces
+    std::vector<int> faceIslands(mesh.allFaceCount(), -1);
+    std::vector<uint8_t> isTreeEdge(mesh.allEdgeCount(), 0);
+    std::vector<FaceHandle> firstFaces;
+    std::vector<uint8_t> isClosed;
+    std::vector<FaceHandle> queue;
+    for (auto face : mesh.faces()) {
+        if (faceIslands[face.index] >= 0) {
+            continue;
+        }
+        int island = int(firstFaces.size());
+        firstFaces.push_back(face);
+        isClosed.push_back(true);
+        faceIslands[face.index] = island;
+        queue.assign(1, face);
+        for (size_t q = 0; q < queue.size(); ++q) {
+            for (auto edge : mesh.edges(queue[q])) {
+                if (isSeparating(mesh, isSeam, edge)) {
+                    auto &edgeVertices = mesh.vertices(edge);
+                    if (seamDegrees[edgeVertices[0].index] > 1 || seamDegrees[edgeVertices[1].index] > 1) {
+                        isClosed[island] = false;
+                    }
+                    continue;
+                }
+                for (auto other : mesh.faces(edge)) {
+                    if (faceIslands[other.index] < 0) {
+                        faceIslands[other.index] = island;
+                        isTreeEdge[edge.index] = 1;
+                        queue.push_back(other);
+                    }
+                }
+            }
+        }
+    }
+
+    // the edges not crossed by the trees, without the branches that end at a vertex
+    std::vector<uint8_t> isCutEdge(mesh.allEdgeCount(), 0);
+    std::vector<int> degrees(mesh.allVertexCount(), 0);
+    for (auto edge : mesh.edges()) {
+        if (!isTreeEdge[edge.index] && mesh.faceCount(edge) > 0) {
+            isCutEdge[edge.index] = 1;
+            for (auto v : mesh.vertices(edge)) {
+                ++degrees[v.index];
+            }
+        }
+    }
+    std::vector<VertexHandle> leaves;
+    for (auto v : mesh.vertices()) {
+        if (degrees[v.index] == 1) {
+            leaves.push_back(v);
+        }
+    }
+    while (!leaves.empty()) {
+        auto v = leaves.back();
+        leaves.pop_back();
+        if (degrees[v.index] != 1) {
+            continue;
+        }
+        for (auto edge : mesh.edges(v)) {
+            if (isCutEdge[edge.index]) {
+                isCutEdge[edge.index] = 0;
+                for (auto end : mesh.vertices(edge)) {
+                    if (--degrees[end.index] == 1) {
+                        leaves.push_back(end);
+                    }
+                }
+                break;
+            }
+        }
+    }
+    std::vector<uint8_t> isCut(firstFaces.size(), 0);
+    for (auto edge : mesh.edges()) {
+        if (isCutEdge[edge.index] && !isSeparating(mesh, isSeam, edge)) {
+            isSeam[edge.index] = 1;
+            isCut[faceIslands[mesh.faces(edge).front().index]] = 1;
+        }
+    }
+
+    // closed islands without handles: along the shortest path between the farthest vertex from one of theirs and the
+    // farthest vertex from that
+    std::vector<double> distances(mesh.allVertexCount(), std::numeric_limits<double>::infinity());
+    std::vector<EdgeHandle> previous(mesh.allVertexCount());
+    std::vector<VertexHandle> reached;
+    for (size_t island = 0; island < firstFaces.size(); ++island) {
+        if (!isClosed[island] || isCut[island]) {
+            continue;
+        }
+        auto isIslandEdge = [&](EdgeHandle edge) {
+            return !isSeparating(mesh, isSeam, edge) && faceIslands[mesh.faces(edge).front().index] == int(island);
+        };
+        auto start = findFarthest(mesh, mesh.vertex(mesh.uvPoints(firstFaces[island])[0]), isIslandEdge, distances, previous, reached);
+        for (auto v = findFarthest(mesh, start, isIslandEdge, distances, previous, reached); v != start;) {
+            auto edge = previous[v.index];
+            isSeam[edge.index] = 1;
+            auto &edgeVertices = mesh.vertices(edge);
+            v = edgeVertices[0] == v ? edgeVertices[1] : edgeVertices[0];
+        }
+    }
+}
+
+} // namespace meshlib
@@ -0,0 +1,30 @@
+#pragma once
+#include "../Mesh.hpp"
+
+namespace meshlib {
+
+// Faces connected through shared uvPoints, which is what a texture sees as one piece
+struct UVIslands {
+    // faces of island i are faces[offsets[i]] to faces[offsets[i + 1] - 1], in index order
+    std::vector<int> offsets{0};
+    std::vector<FaceHandle> faces;
+    // island of each of allUVPoints(), -1 for deleted ones and those in no face
+    std::vector<int> uvPointIslands;
+
+    size_t size() const { return offsets.size() - 1; }
+};
+
+UVIslands findUVIslands(const Mesh &mesh);
+
+// Makes the uvPoints follow the seams, given per allEdges(): the corners of the faces around a vertex share one
+// uvPoint exactly when they are connected through edges that are neither seams nor boundary or non-manifold ones.
+// uvPoints are kept where they already do, so that only the faces along changed seams are replaced, as in
+// splitSharpEdges(); new uvPoints start at the position of the one they split from, and unused ones are removed.
+void applyUVSeams(Mesh &mesh, const std::vector<uint8_t> &isSeam);
+
+// Adds seams until each island that the seams enclose is a disc, which a flat parameterization needs: the edges left
+// of a cut graph (the edges not crossed by a spanning tree of the faces, without their dangling branches) open up
+// handles and join holes, and closed islands of genus zero are cut between two vertices far apart.
+void cutUVIslands(const Mesh &mesh, std::vector<uint8_t> &isSeam);
+
+} // namespace meshlib
@@ -0,0 +1,226 @@
+#include "UVPack.hpp"
+#include "UVIslands.hpp"
+#include "../util/Instrumentation.hpp"
+#include "../util/Parallel.hpp"
+#include <algorithm>
+#include <limits>
+#include <numeric>
+
+using namespace glm;
+
+namespace meshlib {
+
+namespace {
+
+// bounds widths tried, from that of a square with the area of the rectangles up by WidthStep of it each
+constexpr int WidthCount = 16;
+constexpr float WidthStep = 0.05f;
+
+struct SkylineSegment {
+    float x;
+    float y;
+    float width;
+};
+
+// Places the rectangles in order within width; returns the size of their bounds
+vec2 packSkyline(const std::vector<vec2> &sizes, const std::vector<int> &order, float width, std::vector<vec2> &positions) {
+    std::vector<SkylineSegment> skyline{{0, 0, width}};
+    vec2 bounds(0);
+    for (int r : order) {
+        vec2 size = sizes[r];
+        size_t best = 0;
+        float bestY = 0;
+        float bestTop = std::numeric_limits<float>::infinity();
+        for (size_t i = 0; i < skyline.size() && (i == 0 || skyline[i].x + size.x <= width); ++i) {
+            float y = 0;
+            for (size_t j = i; j < skyline.size() && skyline[j].x < skyline[i].x + size.x; ++j) {
+                y = std::max(y, skyline[j].y);
+            }
+            if (y + size.y < bestTop) {
+                best = i;
+                bestY = y;
+                bestTop = y + size.y;
+            }
+        }
+        float left = skyline[best].x;
+        float right = left + size.x;
+        positions[r] = vec2(left, bestY);
+        bounds = max(bounds, vec2(right, bestTop));
+
+        // the rectangle's top replaces the outline below it
+        size_t end = best;
+        while (end < skyline.size() && skyline[end].x + skyline[end].width <= right) {
+            ++end;
+        }
+        if (end < skyline.size() && skyline[end].x < right) {
+            skyline[end].width -= right - skyline[end].x;
+            skyline[end].x = right;
+        }
+        skyline.erase(skyline.begin() + best, skyline.begin() + end);
+        skyline.insert(skyline.begin() + best, {left, bestTop, size.x});
+        if (best + 1 < skyline.size() && skyline[best + 1].y == bestTop) {
+            skyline[best].width += skyline[best + 1].width;
+            skyline.erase(skyline.begin() + best + 1);
+        }
+        if (best > 0 && skyline[best - 1].y == bestTop) {
+            skyline[best - 1].width += skyline[best].width;
+            skyline.erase(skyline.begin() + best);
+        }
+    }
+    return bounds;
+}
+
+// counterclockwise, by the monotone chain algorithm
+std::vector<vec2> convexHull(std::vector<vec2> points) {
+    std::sort(points.begin(), points.end(), [](vec2 a, vec2 b) { return a.x != b.x ? a.x < b.x : a.y < b.y; });
+    points.erase(std::unique(points.begin(), points.end()), points.end());
+    if (points.size() < 3) {
+        return points;
+    }
+    auto turn = [](vec2 a, vec2 b, vec2 c) { return (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x); };
+    std::vector<vec2> hull(2 * points.size());
+    size_t size = 0;
+    for (size_t i = 0; i < points.size(); ++i) {
+        while (size >= 2 && turn(hull[size - 2], hull[size - 1], points[i]) <= 0) {
+            --size;
+        }
+        hull[size++] = points[i];
+    }
+    for (size_t i = points.size() - 1, lower = size + 1; i-- > 0;) {
+        while (size >= lower && turn(hull[size - 2], hull[size - 1], points[i]) <= 0) {
+            --size;
+        }
+        hull[size++] = points[i];
+    }
+    hull.resize(size - 1);
+    return hull;
+}
+
+// The unit direction of the x axis that gives the hull the bounds of least area, which lie along one of its edges
+vec2 minAreaDirection(const std::vector<vec2> &hull) {
+    vec2 best(1, 0);
+    float bestArea = std::numeric_limits<float>::infinity();
+    for (size_t i = 0; i < hull.size(); ++i) {
+        vec2 edge = hull[(i + 1) % hull.size()] - hull[i];
+        float edgeLength = length(edge);
+        if (!(edgeLength > 0)) {
+            continue;
+        }
+        vec2 x = edge / edgeLength;
+        vec2 min(std::numeric_limits<float>::infinity());
+        vec2 max(-std::numeric_limits<float>::infinity());
+        for (auto point : hull) {
+            vec2 rotated(dot(point, x), x.x * point.y - x.y * point.x);
+            min = glm::min(min, rotated);
+            max = glm::max(max, rotated);
+        }
+        float area = (max.x - min.x) * (max.y - min.y);
+        if (area < bestArea) {
+            best = x;
+            bestArea = area;
+        }
+    }
+    return best;
+}
+
+} // namespace
+
+RectanglePacking packRectangles(const std::vector<vec2> &sizes, float gap) {
+    MESHLIB_SCOPED_OPERATION("packRectangles");
+    RectanglePacking packing;
+    size_t count = sizes.size();
+    packing.isRotated.resize(count);
+    std::vector<vec2> paddedSizes(count);
+    float area = 0;
+    float minWidth = 0;
+    for (size_t i = 0; i < count; ++i) {
+        packing.isRotated[i] = sizes[i].y > sizes[i].x;
+        paddedSizes[i] = (packing.isRotated[i] ? vec2(sizes[i].y, sizes[i].x) : sizes[i]) + gap;
+        area += paddedSizes[i].x * paddedSizes[i].y;
+        minWidth = std::max(minWidth, paddedSizes[i].x);
+    }
+    std::vector<int> order(count);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](int a, int b) {
+        return paddedSizes[a].y != paddedSizes[b].y ? paddedSizes[a].y > paddedSizes[b].y : paddedSizes[a].x > paddedSizes[b].x;
+    });
+
+    std::vector<std::vector<vec2>> positions(WidthCount, std::vector<vec2>(count));
+    std::vector<vec2> bounds(WidthCount);
+    parallelFor(
+        0, WidthCount, [&](size_t k) {
+            float width = std::max(minWidth, std::sqrt(area) * (1 + WidthStep * float(k)));
+            bounds[k] = packSkyline(paddedSizes, order, width, positions[k]);
+        },
+        1);
+    auto side = [&](int k) { return std::max(bounds[k].x, bounds[k].y); };
+    std::vector<int> widths(WidthCount);
+    std::iota(widths.begin(), widths.end(), 0);
+    int best = *std::min_element(widths.begin(), widths.end(), [&](int a, int b) { return side(a) < side(b); });
+    packing.positions = std::move(positions[best]);
+    // without the gap after the last rectangles
+    packing.size = max(bounds[best] - gap, vec2(0));
+    return packing;
+}
+
+void packUVIslands(Mesh &mesh, float margin) {
+    MESHLIB_SCOPED_OPERATION("packUVIslands");
+    ScopedMeshOperation operation(mesh, "packUVIslands");
+    auto islands = findUVIslands(mesh);
+    size_t islandCount = islands.size();
+    // each island is first turned to the bounds of least area
+    std::vector<vec2> directions(islandCount);
+    std::vector<vec2> mins(islandCount);
+    std::vector<vec2> sizes(islandCount);
+    parallelFor(
+        0, islandCount, [&](size_t i) {
+            std::vector<vec2> points;
+            for (int f = islands.offsets[i]; f < islands.offsets[i + 1]; ++f) {
+                for (auto uvPoint : mesh.uvPoints(islands.faces[f])) {
+                    points.push_back(mesh.uvPosition(uvPoint));
+                }
+            }
+            auto hull = convexHull(std::move(points));
+            vec2 x = minAreaDirection(hull);
+            vec2 min(std::numeric_limits<float>::infinity());
+            vec2 max(-std::numeric_limits<float>::infinity());
+            for (auto point : hull) {
+                vec2 rotated(dot(point, x), x.x * point.y - x.y * point.x);
+                min = glm::min(min, rotated);
+                max = glm::max(max, rotated);
+            }
+            directions[i] = x;
+            mins[i] = min;
+            sizes[i] = max - min;
+        },
+        16);
+    float area = std::accumulate(sizes.begin(), sizes.end(), 0.f, [](float sum, vec2 size) { return sum + size.x * size.y; });
+    if (!(area > 0)) {
+        return;
+    }
+
+    // the gap scales with the square, which the first packing estimates
+    auto packing = packRectangles(sizes, margin * std::sqrt(area));
+    packing = packRectangles(sizes, margin * std::max(packing.size.x, packing.size.y));
+    float scale = 1 / std::max(packing.size.x, packing.size.y);
+
+    parallelForChunks(mesh.allUVPointCount(), Mesh::ChunkSize, [&](size_t chunk, size_t begin, size_t end) {
+        auto uvPositions = mesh.uvPositionChunk(chunk) - begin;
+        for (size_t i = begin; i < end; ++i) {
+            int island = islands.uvPointIslands[i];
+            if (island < 0) {
+                continue;
+            }
+            vec2 x = directions[island];
+            vec2 point = uvPositions[i];
+            vec2 offset = vec2(dot(point, x), x.x * point.y - x.y * point.x) - mins[island];
+            if (packing.isRotated[island]) {
+                // a quarter turn counterclockwise, within the turned bounds
+                offset = vec2(sizes[island].y - offset.y, offset.x);
+            }
+            uvPositions[i] = (packing.positions[island] + offset) * scale;
+        }
+    });
+}
+
+} // namespace meshlib
@@ -0,0 +1,24 @@
+#pragma once
+#include "../Mesh.hpp"
+
+namespace meshlib {
+
+struct RectanglePacking {
+    // lower left corner of each rectangle
+    std::vector<glm::vec2> positions;
+    // turned by 90 degrees, which swaps its width and height
+    std::vector<uint8_t> isRotated;
+    // of the bounds from the origin
+    glm::vec2 size{0};
+};
+
+// Places rectangles without overlaps and at least gap apart by the skyline heuristic: turned to lie flat and sorted by
+// height, each goes where its top ends lowest on the outline of those placed before, leftmost among equals. Bounds of
+// several widths around that of a square are tried in parallel, and the one closest to a small square is kept.
+RectanglePacking packRectangles(const std::vector<glm::vec2> &sizes, float gap);
+
+// Moves the islands of findUVIslands() into the unit square by their bounds, each turned to the bounds of least area
+// around its convex hull, then packed keeping their relative scale, with margin times the side of the square between them
+void packUVIslands(Mesh &mesh, float margin = 0.002f);
+
+} // namespace meshlib
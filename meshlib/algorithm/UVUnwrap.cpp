@@ -0,0 +1,438 @@
+#include "UVUnwrap.hpp"
+#include "Triangulate.hpp"
+#include "UVIslands.hpp"
+#include "UVPack.hpp"
+#include "../util/Instrumentation.hpp"
+#include "../util/Parallel.hpp"
+#include "../util/SparseCholesky.hpp"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+using namespace glm;
+
+namespace meshlib {
+
+namespace {
+
+// Triangles with less area than this times the squared mean edge length of their island count as degenerate: their
+// cotangents are bounded as if they had that area, and they add nothing to the area term of the conformal energy.
+constexpr double MinRelativeArea = 1e-12;
+// added to the diagonals times their mean, so that points only in degenerate triangles keep the systems definite
+constexpr double Regularization = 1e-9;
+
+// an island with its uvPoints numbered from 0
+struct Island {
+    std::vector<UVPointHandle> points;
+    std::vector<dvec3> positions;
+    std::vector<std::array<int, 3>> triangles;
+    // cotangent of the angle at each corner
+    std::vector<dvec3> cotangents;
+    std::vector<uint8_t> isDegenerate;
+    // of the triangles that are not degenerate
+    double area = 0;
+    // the neighbours of point p are neighbours[offsets[p]] to neighbours[offsets[p + 1] - 1], sorted, each with half
+    // the summed cotangents of the angles opposite their edge, and the coefficient of u_p v_q in the signed area
+    std::vector<int> offsets;
+    std::vector<int> neighbours;
+    std::vector<double> weights;
+    std::vector<double> areaTerms;
+
+    int slot(int p, int q) const {
+        return int(std::lower_bound(neighbours.begin() + offsets[p], neighbours.begin() + offsets[p + 1], q) - neighbours.begin());
+    }
+};
+
+Island makeIsland(const Mesh &mesh, const UVIslands &islands, size_t i, const Triangulation &triangulation, std::vector<int> &localIndices) {
+    Island island;
+    for (int f = islands.offsets[i]; f < islands.offsets[i + 1]; ++f) {
+        auto face = islands.faces[f];
+        for (auto uvPoint : mesh.uvPoints(face)) {
+            if (localIndices[uvPoint.index] < 0) {
+                localIndices[uvPoint.index] = int(island.points.size());
+                island.points.push_back(uvPoint);
+                island.positions.push_back(dvec3(mesh.position(mesh.vertex(uvPoint))));
+            }
+        }
+        for (uint32_t t = triangulation.faceOffsets[face.index]; t < triangulation.faceOffsets[face.index + 1]; ++t) {
+            auto &triangle = island.triangles.emplace_back();
+            for (int k = 0; k < 3; ++k) {
+                triangle[k] = localIndices[triangulation.triangles[3 * t + k].index];
+            }
+        }
+    }
+
+    double edgeLengthSum = 0;
+    for (auto &triangle : island.triangles) {
+        for (int k = 0; k < 3; ++k) {
+            edgeLengthSum += length(island.positions[triangle[(k + 1) % 3]] - island.positions[triangle[k]]);
+        }
+    }
+    double meanEdgeLength = island.triangles.empty() ? 0 : edgeLengthSum / double(3 * island.triangles.size());
+    double minDoubleArea = 2 * MinRelativeArea * meanEdgeLength * meanEdgeLength;
+    island.cotangents.resize(island.triangles.size());
+    island.isDegenerate.resize(island.triangles.size());
+    for (size_t t = 0; t < island.triangles.size(); ++t) {
+        auto &triangle = island.triangles[t];
+        std::array<dvec3, 3> p{island.positions[triangle[0]], island.positions[triangle[1]], island.positions[triangle[2]]};
+        double doubleArea = length(cross(p[1] - p[0], p[2] - p[0]));
+        island.isDegenerate[t] = !(doubleArea > minDoubleArea);
+        if (!island.isDegenerate[t]) {
+            island.area += doubleArea / 2;
+        }
+        for (int k = 0; k < 3; ++k) {
+            island.cotangents[t][k] = dot(p[(k + 1) % 3] - p[k], p[(k + 2) % 3] - p[k]) / std::max(doubleArea, minDoubleArea);
+        }
+    }
+
+    size_t count = island.points.size();
+    island.offsets.assign(count + 1, 0);
+    for (auto &triangle : island.triangles) {
+        for (auto p : triangle) {
+            island.offsets[p + 1] += 2;
+        }
+    }
+    std::partial_sum(island.offsets.begin(), island.offsets.end(), island.offsets.begin());
+    island.neighbours.resize(island.offsets.back());
+    std::vector<int> next(island.offsets.begin(), island.offsets.end() - 1);
+    for (auto &triangle : island.triangles) {
+        for (int k = 0; k < 3; ++k) {
+            island.neighbours[next[triangle[k]]++] = triangle[(k + 1) % 3];
+            island.neighbours[next[triangle[k]]++] = triangle[(k + 2) % 3];
+        }
+    }
+    // sorted and without duplicates, in place
+    int size = 0;
+    for (size_t p = 0; p < count; ++p) {
+        auto begin = island.neighbours.begin() + island.offsets[p];
+        auto end = island.neighbours.begin() + island.offsets[p + 1];
+        island.offsets[p] = size;
+        std::sort(begin, end);
+        int previous = int(p);
+        for (auto it = begin; it != end; ++it) {
+            if (*it != previous && *it != int(p)) {
+                island.neighbours[size++] = previous = *it;
+            }
+        }
+    }
+    island.offsets[count] = size;
+    island.neighbours.resize(size);
+
+    island.weights.assign(size, 0);
+    island.areaTerms.assign(size, 0);
+    for (size_t t = 0; t < island.triangles.size(); ++t) {
+        auto &triangle = island.triangles[t];
+        for (int k = 0; k < 3; ++k) {
+            int p = triangle[(k + 1) % 3];
+            int q = triangle[(k + 2) % 3];
+            if (p == q) {
+                continue;
+            }
+            island.weights[island.slot(p, q)] += island.cotangents[t][k] / 2;
+            island.weights[island.slot(q, p)] += island.cotangents[t][k] / 2;
+            if (!island.isDegenerate[t]) {
+                // minus the signed area, half the sum of u_j v_l - u_l v_j over the edges j to l, split between Q_uv
+                // and Q_vu; inner edges cancel out
+                island.areaTerms[island.slot(triangle[k], p)] -= 0.25;
+                island.areaTerms[island.slot(p, triangle[k])] += 0.25;
+            }
+        }
+    }
+    return island;
+}
+
+// adds the regularization to the diagonals, which come first in their columns
+void regularize(SymmetricMatrix &matrix) {
+    double diagonalSum = 0;
+    for (size_t j = 0; j < matrix.size(); ++j) {
+        diagonalSum += matrix.values[matrix.offsets[j]];
+    }
+    double shift = matrix.size() > 0 ? Regularization * diagonalSum / double(matrix.size()) : 0;
+    for (size_t j = 0; j < matrix.size(); ++j) {
+        matrix.values[matrix.offsets[j]] += shift;
+    }
+}
+
+int findFarthest(const Island &island, int from) {
+    int farthest = from;
+    double farthestDistance = 0;
+    for (size_t p = 0; p < island.positions.size(); ++p) {
+        auto offset = island.positions[p] - island.positions[from];
+        double distance = dot(offset, offset);
+        if (distance > farthestDistance) {
+            farthest = int(p);
+            farthestDistance = distance;
+        }
+    }
+    return farthest;
+}
+
+// Minimizes the Dirichlet energy of u and v less the area they cover, which is zero for conformal maps, with two points
+// far apart pinned at their distance on the u axis; false if the system cannot be factored
+bool solveConformal(const Island &island, std::vector<dvec2> &uvs) {
+    size_t count = island.points.size();
+    int a = findFarthest(island, 0);
+    int b = findFarthest(island, a);
+    if (a == b) {
+        return false;
+    }
+    uvs.assign(count, dvec2(0));
+    uvs[b] = dvec2(length(island.positions[b] - island.positions[a]), 0);
+
+    // rows of the u of the free points, then of their v
+    std::vector<int> rows(count);
+    int freeCount = 0;
+    for (size_t p = 0; p < count; ++p) {
+        rows[p] = int(p) == a || int(p) == b ? -1 : freeCount++;
+    }
+    std::vector<double> rhs(2 * freeCount, 0);
+    // the lower triangle of the symmetric matrix of the energy, column by column: Q_uu and Q_vv are half the cotangent
+    // Laplacian and Q_uv is in areaTerms, with the pinned points moved to the right hand side
+    SymmetricMatrix matrix;
+    matrix.rows.reserve(size_t(freeCount) * 2 + island.neighbours.size() * 2);
+    matrix.values.reserve(matrix.rows.capacity());
+    auto diagonal = [&](int p, int row) {
+        double sum = 0;
+        for (int s = island.offsets[p]; s < island.offsets[p + 1]; ++s) {
+            sum += island.weights[s];
+        }
+        matrix.rows.push_back(row);
+        matrix.values.push_back(sum / 2);
+    };
+    for (int c = 0; c < 2; ++c) {
+        for (size_t p = 0; p < count; ++p) {
+            int row = rows[p];
+            if (row < 0) {
+                continue;
+            }
+            diagonal(int(p), row + c * freeCount);
+            for (int s = island.offsets[p]; s < island.offsets[p + 1]; ++s) {
+                int q = island.neighbours[s];
+                double value = -island.weights[s] / 2;
+                if (rows[q] < 0) {
+                    rhs[row + c * freeCount] -= value * uvs[q][c];
+                } else if (rows[q] > row) {
+                    matrix.rows.push_back(rows[q] + c * freeCount);
+                    matrix.values.push_back(value);
+                }
+            }
+            for (int s = island.offsets[p]; s < island.offsets[p + 1]; ++s) {
+                int q = island.neighbours[s];
+                double value = island.areaTerms[s];
+                if (value == 0) {
+                    continue;
+                }
+                if (c == 0 && rows[q] < 0) {
+                    rhs[row] -= value * uvs[q].y;
+                } else if (c == 0) {
+                    matrix.rows.push_back(rows[q] + freeCount);
+                    matrix.values.push_back(value);
+                } else if (rows[q] < 0) {
+                    // Q_vu is the transpose, and the area terms are antisymmetric
+                    rhs[row + freeCount] += value * uvs[q].x;
+                }
+            }
+            matrix.offsets.push_back(int(matrix.rows.size()));
+        }
+    }
+    regularize(matrix);
+
+    SparseCholesky cholesky(matrix, nestedDissectionOrder(matrix));
+    if (!cholesky.factor(matrix)) {
+        return false;
+    }
+    cholesky.solve(rhs.data());
+    for (size_t p = 0; p < count; ++p) {
+        if (rows[p] >= 0) {
+            uvs[p] = dvec2(rhs[rows[p]], rhs[rows[p] + freeCount]);
+        }
+    }
+    return true;
+}
+
+// projection onto the plane of the summed triangle normals, for islands the conformal map fails on
+void projectToPlane(const Island &island, std::vector<dvec2> &uvs) {
+    dvec3 normal(0);
+    for (auto &triangle : island.triangles) {
+        auto &p = island.positions;
+        normal += cross(p[triangle[1]] - p[triangle[0]], p[triangle[2]] - p[triangle[0]]);
+    }
+    normal = length(normal) > 0 ? normalize(normal) : dvec3(0, 0, 1);
+    auto tangent = normalize(cross(std::abs(normal.x) < 0.9 ? dvec3(1, 0, 0) : dvec3(0, 1, 0), normal));
+    auto bitangent = cross(normal, tangent);
+    uvs.resize(island.points.size());
+    for (size_t p = 0; p < uvs.size(); ++p) {
+        uvs[p] = dvec2(dot(island.positions[p], tangent), dot(island.positions[p], bitangent));
+    }
+}
+
+// Scales uvs to the area of the island, and mirrors them if they are mostly turned over
+void normalizeArea(const Island &island, std::vector<dvec2> &uvs) {
+    double uvArea = 0;
+    for (auto &triangle : island.triangles) {
+        auto e0 = uvs[triangle[1]] - uvs[triangle[0]];
+        auto e1 = uvs[triangle[2]] - uvs[triangle[0]];
+        uvArea += (e0.x * e1.y - e0.y * e1.x) / 2;
+    }
+    if (!(std::abs(uvArea) > 0) || !std::isfinite(uvArea)) {
+        return;
+    }
+    double scale = std::sqrt(island.area / std::abs(uvArea));
+    for (auto &uv : uvs) {
+        uv = dvec2(uvArea < 0 ? -uv.x : uv.x, uv.y) * scale;
+    }
+}
+
+// Local/global iterations: each triangle gets the rotation that best maps it, laid flat, onto its uvs, and the uvs
+// then follow the rotated triangles in the least squares sense with the cotangent weights, the first point pinned
+void solveRigid(const Island &island, int iterations, std::vector<dvec2> &uvs) {
+    size_t count = island.points.size();
+    size_t triangleCount = island.triangles.size();
+    std::vector<std::array<dvec2, 3>> flat(triangleCount);
+    for (size_t t = 0; t < triangleCount; ++t) {
+        auto &triangle = island.triangles[t];
+        auto e0 = island.positions[triangle[1]] - island.positions[triangle[0]];
+        auto e1 = island.positions[triangle[2]] - island.positions[triangle[0]];
+        double length0 = length(e0);
+        if (length0 > 0) {
+            flat[t] = {dvec2(0), dvec2(length0, 0), dvec2(dot(e1, e0) / length0, length(cross(e0, e1)) / length0)};
+        } else {
+            flat[t] = {dvec2(0), dvec2(0), dvec2(length(e1), 0)};
+        }
+    }
+
+    // rows p - 1 of the points but the pinned first one
+    SymmetricMatrix matrix;
+    matrix.rows.reserve(count + island.neighbours.size() / 2);
+    matrix.values.reserve(matrix.rows.capacity());
+    std::vector<dvec2> pinnedRhs(count - 1, dvec2(0));
+    for (size_t p = 1; p < count; ++p) {
+        double sum = 0;
+        for (int s = island.offsets[p]; s < island.offsets[p + 1]; ++s) {
+            sum += island.weights[s];
+        }
+        matrix.rows.push_back(int(p) - 1);
+        matrix.values.push_back(sum);
+        for (int s = island.offsets[p]; s < island.offsets[p + 1]; ++s) {
+            int q = island.neighbours[s];
+            if (q == 0) {
+                pinnedRhs[p - 1] += island.weights[s] * uvs[0];
+            } else if (q > int(p)) {
+                matrix.rows.push_back(q - 1);
+                matrix.values.push_back(-island.weights[s]);
+            }
+        }
+        matrix.offsets.push_back(int(matrix.rows.size()));
+    }
+    regularize(matrix);
+    SparseCholesky cholesky(matrix, nestedDissectionOrder(matrix));
+    if (!cholesky.factor(matrix)) {
+        return;
+    }
+
+    std::vector<double> u(count - 1);
+    std::vector<double> v(count - 1);
+    for (int iteration = 0; iteration < iterations; ++iteration) {
+        for (size_t r = 0; r < count - 1; ++r) {
+            u[r] = pinnedRhs[r].x;
+            v[r] = pinnedRhs[r].y;
+        }
+        for (size_t t = 0; t < triangleCount; ++t) {
+            auto &triangle = island.triangles[t];
+            // the rotation that best maps the flat edges onto the uv edges, by the weighted sums of their dot and cross
+            // products
+            double dotSum = 0;
+            double crossSum = 0;
+            for (int k = 0; k < 3; ++k) {
+                auto flatEdge = flat[t][(k + 1) % 3] - flat[t][(k + 2) % 3];
+                auto uvEdge = uvs[triangle[(k + 1) % 3]] - uvs[triangle[(k + 2) % 3]];
+                dotSum += island.cotangents[t][k] * dot(flatEdge, uvEdge);
+                crossSum += island.cotangents[t][k] * (flatEdge.x * uvEdge.y - flatEdge.y * uvEdge.x);
+            }
+            double angle = std::atan2(crossSum, dotSum);
+            double cosine = std::cos(angle);
+            double sine = std::sin(angle);
+            for (int k = 0; k < 3; ++k) {
+                int j = (k + 1) % 3;
+                int l = (k + 2) % 3;
+                auto edge = flat[t][j] - flat[t][l];
+                auto rotated = island.cotangents[t][k] / 2 * dvec2(cosine * edge.x - sine * edge.y, sine * edge.x + cosine * edge.y);
+                if (triangle[j] > 0) {
+                    u[triangle[j] - 1] += rotated.x;
+                    v[triangle[j] - 1] += rotated.y;
+                }
+                if (triangle[l] > 0) {
+                    u[triangle[l] - 1] -= rotated.x;
+                    v[triangle[l] - 1] -= rotated.y;
+                }
+            }
+        }
+        TaskGroup group;
+        group.run([&] { cholesky.solve(u.data()); });
+        cholesky.solve(v.data());
+        group.wait();
+        for (size_t p = 1; p < count; ++p) {
+            uvs[p] = dvec2(u[p - 1], v[p - 1]);
+        }
+    }
+}
+
+} // namespace
+
+void parameterizeUVIslands(Mesh &mesh, int rigidIterations) {
+    MESHLIB_SCOPED_OPERATION("parameterizeUVIslands");
+    ScopedMeshOperation operation(mesh, "parameterizeUVIslands");
+    auto islands = findUVIslands(mesh);
+    auto triangulation = triangulate(mesh);
+    size_t uvPointCount = mesh.allUVPointCount();
+    std::vector<int> localIndices(uvPointCount, -1);
+    std::vector<vec2> uvPositions(uvPointCount);
+    parallelFor(0, uvPointCount, [&](size_t i) { uvPositions[i] = mesh.uvPosition(UVPointHandle(int(i))); });
+
+    // each uvPoint is in one island at most, so they write to separate elements
+    parallelFor(
+        0, islands.size(), [&](size_t i) {
+            auto island = makeIsland(mesh, islands, i, triangulation, localIndices);
+            if (island.triangles.empty()) {
+                return;
+            }
+            std::vector<dvec2> uvs;
+            if (!solveConformal(island, uvs)) {
+                projectToPlane(island, uvs);
+            }
+            normalizeArea(island, uvs);
+            if (rigidIterations > 0 && island.points.size() > 1) {
+                solveRigid(island, rigidIterations, uvs);
+                normalizeArea(island, uvs);
+            }
+            for (size_t p = 0; p < uvs.size(); ++p) {
+                uvPositions[island.points[p].index] = vec2(uvs[p]);
+            }
+        },
+        1);
+
+    parallelForChunks(uvPointCount, Mesh::ChunkSize, [&](size_t chunk, size_t begin, size_t end) {
+        std::copy(uvPositions.begin() + begin, uvPositions.begin() + end, mesh.uvPositionChunk(chunk));
+    });
+}
+
+void unwrapUVs(Mesh &mesh, const UVUnwrapOptions &options) {
+    MESHLIB_SCOPED_OPERATION("unwrapUVs");
+    ScopedMeshOperation operation(mesh, "unwrapUVs");
+    std::vector<uint8_t> isSeam(mesh.allEdgeCount(), 0);
+    if (options.sharpEdgeSeams) {
+        parallelFor(0, isSeam.size(), [&](size_t e) {
+            auto edge = EdgeHandle(int(e));
+            isSeam[e] = !mesh.isDeleted(edge) && mesh.isSharp(edge);
+        });
+    }
+    for (auto edge : options.seams) {
+        isSeam[edge.index] = 1;
+    }
+    cutUVIslands(mesh, isSeam);
+    applyUVSeams(mesh, isSeam);
+    parameterizeUVIslands(mesh, options.rigidIterations);
+    packUVIslands(mesh, options.margin);
+}
+
+} // namespace meshlib
@@ -0,0 +1,27 @@
+#pragma once
+#include "../Mesh.hpp"
+
+namespace meshlib {
+
+struct UVUnwrapOptions {
+    // sharp edges are seams besides the given ones; boundary and non-manifold edges always are
+    bool sharpEdgeSeams = true;
+    std::vector<EdgeHandle> seams;
+    // local/global iterations towards an as-rigid-as-possible map after the conformal one, which trade some angle
+    // distortion for less area distortion; each costs a pass over the triangles and two solves
+    int rigidIterations = 0;
+    // see packUVIslands()
+    float margin = 0.002f;
+};
+
+// Flattens each island of findUVIslands() as it is: a least squares conformal map (Levy et al.) of its triangulated
+// faces, pinned at two points far apart and solved with a sparse Cholesky factorization, optionally followed by
+// as-rigid-as-possible iterations (Liu et al.) with one more factorization that all of them share. Each island is
+// scaled to the area of its faces. Islands are solved in parallel.
+void parameterizeUVIslands(Mesh &mesh, int rigidIterations = 0);
+
+// Replaces the uvPoints and their positions: the seams, with those of cutUVIslands() so that every island is a disc,
+// go to applyUVSeams(), then parameterizeUVIslands() and packUVIslands() lay the islands out in the unit square.
+void unwrapUVs(Mesh &mesh, const UVUnwrapOptions &options = {});
+
+} // namespace meshlib
@@ -0,0 +1,317 @@
+#include "../algorithm/Boolean.hpp"
+#include "../algorithm/Extrude.hpp"
+#include "../algorithm/FindLoop.hpp"
+#include "../algorithm/Geodesic.hpp"
+#include "../algorithm/LoopCut.hpp"
+#include "../algorithm/Smooth.hpp"
+#include "../algorithm/SplitSharpEdges.hpp"
+#include "../algorithm/Transform.hpp"
+#include "../algorithm/Triangulate.hpp"
+#include "../algorithm/UVPack.hpp"
+#include "../algorithm/UVUnwrap.hpp"
+#include "../builder/CubeBuilder.hpp"
+#include "../builder/CylinderBuilder.hpp"
+#include "BenchmarkUtil.hpp"
+
+using namespace meshlib;
+
+namespace {
+
+// SphereBuilder::build() adds the ring vertices first, ring by ring
+VertexHandle ringVertex(const SphereBuilder &builder, int ring, int i) {
+    return VertexHandle(ring * builder.segmentCount + i % builder.segmentCount);
+}
+
+EdgeHandle edgeBetween(const Mesh &mesh, VertexHandle v0, VertexHandle v1) {
+    for (auto e : mesh.edges(v0)) {
+        if (mesh.vertices(e)[0] == v1 || mesh.vertices(e)[1] == v1) {
+            return e;
+        }
+    }
+    return {};
+}
+
+// ring edge on the equator; its loop goes around the sphere
+EdgeHandle equatorEdge(const SphereBuilder &builder, const Mesh &mesh) {
+    int ring = (builder.ringCount - 2) / 2;
+    return edgeBetween(mesh, ringVertex(builder, ring, 0), ringVertex(builder, ring, 1));
+}
+
+// edge between the rings next to the equator; its belt goes around the sphere
+EdgeHandle meridianEdge(const SphereBuilder &builder, const Mesh &mesh) {
+    int ring = (builder.ringCount - 2) / 2;
+    return edgeBetween(mesh, ringVertex(builder, ring, 0), ringVertex(builder, ring + 1, 0));
+}
+
+// vertices of the hemisphere on the positive side of the builder axis
+std::vector<VertexHandle> hemisphere(const SphereBuilder &builder, const Mesh &mesh) {
+    std::vector<VertexHandle> vertices;
+    for (auto v : mesh.vertices()) {
+        if (mesh.position(v)[builder.axis] > 0) {
+            vertices.push_back(v);
+        }
+    }
+    return vertices;
+}
+
+void BM_FindLoop(benchmark::State &state) {
+    ScopedMemoryCounter counter;
+    auto builder = makeBuilder<SphereBuilder>(int(state.range(0)));
+    auto mesh = builder.build();
+    auto edge = equatorEdge(builder, mesh);
+    size_t loopSize = 0;
+    for (auto _ : state) {
+        auto loop = findLoop(mesh, edge);
+        loopSize = loop.size();
+        benchmark::DoNotOptimize(loop.data());
+    }
+    state.SetItemsProcessed(state.iterations() * int64_t(loopSize));
+    state.counters["loopEdges"] = double(loopSize);
+    counter.report(state);
+}
+
+// the input copy per iteration is excluded from the time; peakBytes includes the input and the copy
+void BM_LoopCut(benchmark::State &state) {
+    ScopedMemoryCounter counter;
+    auto builder = makeBuilder<SphereBuilder>(int(state.range(0)));
+    auto input = builder.build();
+    auto edge = meridianEdge(builder, input);
+    size_t cutCount = 0;
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto mesh = input;
+        state.ResumeTiming();
+        cutCount = loopCut(mesh, edge, 0.5f).size();
+    }
+    state.SetItemsProcessed(state.iterations() * int64_t(cutCount));
+    state.counters["cutEdges"] = double(cutCount);
+    counter.report(state);
+}
+
+// extrudes the upper hemisphere
+void BM_Extrude(benchmark::State &state) {
+    ScopedMemoryCounter counter;
+    auto builder = makeBuilder<SphereBuilder>(int(state.range(0)));
+    auto input = builder.build();
+    auto vertices = hemisphere(builder, input);
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto mesh = input;
+        state.ResumeTiming();
+        benchmark::DoNotOptimize(extrude(mesh, vertices).data());
+    }
+    state.SetItemsProcessed(state.iterations() * int64_t(vertices.size()));
+    state.counters["vertices"] = double(vertices.size());
+    counter.report(state);
+}
+
+// the equator loop and one meridian are sharp
+void BM_SplitSharpEdges(benchmark::State &state) {
+    ScopedMemoryCounter counter;
+    auto builder = makeBuilder<SphereBuilder>(int(state.range(0)));
+    auto input = builder.build();
+    for (auto e : findLoop(input, equatorEdge(builder, input))) {
+        input.setSharp(e, true);
+    }
+    for (int ring = 0; ring + 2 < builder.ringCount; ++ring) {
+        input.setSharp(edgeBetween(input, ringVertex(builder, ring, 0), ringVertex(builder, ring + 1, 0)), true);
+    }
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto mesh = input;
+        state.ResumeTiming();
+        splitSharpEdges(mesh);
+        benchmark::DoNotOptimize(mesh.allVertexCount());
+    }
+    state.SetItemsProcessed(state.iterations() * int64_t(input.allVertexCount()));
+    state.counters["vertices"] = double(input.allVertexCount());
+    counter.report(state);
+}
+
+void BM_Triangulate(benchmark::State &state) {
+    auto mesh = makeBuilder<SphereBuilder>(int(state.range(0))).build();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(triangulate(mesh).triangles.data());
+    }
+    state.SetItemsProcessed(state.iterations() * int64_t(mesh.allFaceCount()));
+}
+
+// star polygon with every other corner reflex, the worst case for ear clipping
+void BM_TriangulatePolygon(benchmark::State &state) {
+    size_t count = size_t(state.range(0));
+    std::vector<glm::vec3> positions;
+    for (size_t i = 0; i < count; ++i) {
+        float angle = float(M_PI) * 2.f * float(i) / float(count);
+        float radius = i % 2 == 0 ? 1.f : 0.5f;
+        positions.emplace_back(radius * std::cos(angle), radius * std::sin(angle), 0);
+    }
+    std::vector<uint32_t> corners(3 * (count - 2));
+    for (auto _ : state) {
+        triangulatePolygon(positions.data(), count, corners.data());
+        benchmark::DoNotOptimize(corners.data());
+    }
+    state.SetItemsProcessed(state.iterations() * int64_t(count));
+}
+
+// union of two overlapping spheres, crossing along a circle
+void BM_Boolean(benchmark::State &state) {
+    ScopedMemoryCounter counter;
+    auto a = makeBuilder<SphereBuilder>(int(state.range(0))).build();
+    auto b = a;
+    translatePositions(b, glm::vec3(0.5f, 0.3f, 0.2f));
+    for (auto _ : state) {
+        auto result = booleanOperation(a, b, BooleanOperation::Union);
+        benchmark::DoNotOptimize(result.allFaceCount());
+    }
+    state.SetItemsProcessed(state.iterations() * int64_t(a.allFaceCount() + b.allFaceCount()));
+    counter.report(state);
+}
+
+// difference of a cube and a thin cylinder piercing it; each crossing loop lies inside one triangle of a cube face, so
+// the split bridges it to the triangle's boundary. Fails if the result is not a valid closed mesh.
+void BM_BooleanInteriorLoop(benchmark::State &state) {
+    auto cube = CubeBuilder().build();
+    auto cylinder = makeBuilder<CylinderBuilder>(int(state.range(0)));
+    cylinder.radius = 0.05f;
+    cylinder.height = 3;
+    cylinder.axis = 1;
+    cylinder.center = glm::vec3(0.25f, 0, -0.2f);
+    auto b = cylinder.build();
+    auto check = booleanOperation(cube, b, BooleanOperation::Difference);
+    if (!check.validate().empty() ||
+        std::any_of(check.edges().begin(), check.edges().end(), [&](EdgeHandle e) { return check.faceCount(e) != 2; })) {
+        state.SkipWithError("invalid boolean result");
+        return;
+    }
+    for (auto _ : state) {
+        auto result = booleanOperation(cube, b, BooleanOperation::Difference);
+        benchmark::DoNotOptimize(result.allFaceCount());
+    }
+    state.SetItemsProcessed(state.iterations() * int64_t(cube.allFaceCount() + b.allFaceCount()));
+}
+
+void BM_GeodesicFactor(benchmark::State &state) {
+    auto mesh = makeBuilder<SphereBuilder>(int(state.range(0))).build();
+    for (auto _ : state) {
+        GeodesicDistance geodesic(mesh);
+        benchmark::DoNotOptimize(&geodesic);
+    }
+    state.SetItemsProcessed(state.iterations() * int64_t(mesh.allVertexCount()));
+}
+
+// a query with the factorization reused, as while dragging a soft selection
+void BM_GeodesicDistances(benchmark::State &state) {
+    auto mesh = makeBuilder<SphereBuilder>(int(state.range(0))).build();
+    GeodesicDistance geodesic(mesh);
+    std::vector<VertexHandle> sources{VertexHandle(0)};
+    for (auto _ : state) {
+        auto distances = geodesic.distances(sources);
+        benchmark::DoNotOptimize(distances.data());
+    }
+    state.SetItemsProcessed(state.iterations() * int64_t(mesh.allVertexCount()));
+}
+
+// ten iterations; the stencils are cached by the first run, so the time is the weights and the iterations
+void BM_SmoothPositions(benchmark::State &state) {
+    ScopedMemoryCounter counter;
+    auto input = makeBuilder<SphereBuilder>(int(state.range(0))).build();
+    SmoothingOptions options;
+    options.weights = state.range(1) ? LaplacianWeights::Cotangent : LaplacianWeights::Uniform;
+    options.iterations = 10;
+    options.inflateFactor = -0.53f;
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto mesh = input;
+        state.ResumeTiming();
+        smoothPositions(mesh, options);
+    }
+    state.SetItemsProcessed(state.iterations() * int64_t(input.allVertexCount()) * options.iterations);
+    counter.report(state);
+}
+
+void BM_RelaxPositions(benchmark::State &state) {
+    ScopedMemoryCounter counter;
+    auto input = makeBuilder<SphereBuilder>(int(state.range(0))).build();
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto mesh = input;
+        state.ResumeTiming();
+        relaxPositions(mesh, 10);
+    }
+    state.SetItemsProcessed(state.iterations() * int64_t(input.allVertexCount()) * 10);
+    counter.report(state);
+}
+
+// every spacing-th ring and meridian is sharp, which cuts the sphere into about (segments / spacing)^2 / 2 islands
+void setSharpGrid(const SphereBuilder &builder, Mesh &mesh, int spacing) {
+    for (int ring = 0; ring + 1 < builder.ringCount; ++ring) {
+        for (int i = 0; i < builder.segmentCount; ++i) {
+            if ((ring + 1) % spacing == 0) {
+                mesh.setSharp(edgeBetween(mesh, ringVertex(builder, ring, i), ringVertex(builder, ring, i + 1)), true);
+            }
+            if (i % spacing == 0 && ring + 2 < builder.ringCount) {
+                mesh.setSharp(edgeBetween(mesh, ringVertex(builder, ring, i), ringVertex(builder, ring + 1, i)), true);
+            }
+        }
+    }
+}
+
+// the second argument is the spacing of the sharp grid, or 0 for one island cut open by cutUVIslands()
+void BM_UnwrapUVs(benchmark::State &state) {
+    ScopedMemoryCounter counter;
+    auto builder = makeBuilder<SphereBuilder>(int(state.range(0)));
+    auto input = builder.build();
+    if (state.range(1) > 0) {
+        setSharpGrid(builder, input, int(state.range(1)));
+    }
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto mesh = input;
+        state.ResumeTiming();
+        unwrapUVs(mesh);
+        benchmark::DoNotOptimize(mesh.allUVPointCount());
+    }
+    state.SetItemsProcessed(state.iterations() * int64_t(input.allFaceCount()));
+    state.counters["faces"] = double(input.allFaceCount());
+    counter.report(state);
+}
+
+void BM_PackUVIslands(benchmark::State &state) {
+    ScopedMemoryCounter counter;
+    auto builder = makeBuilder<SphereBuilder>(int(state.range(0)));
+    auto input = builder.build();
+    setSharpGrid(builder, input, 4);
+    unwrapUVs(input);
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto mesh = input;
+        state.ResumeTiming();
+        packUVIslands(mesh);
+    }
+    state.SetItemsProcessed(state.iterations() * int64_t(input.allFaceCount()));
+    counter.report(state);
+}
+
+} // namespace
+
+BENCHMARK(BM_FindLoop)->RangeMultiplier(4)->Range(16, 1024)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_LoopCut)->RangeMultiplier(4)->Range(16, 256)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_Extrude)->RangeMultiplier(4)->Range(16, 256)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_SplitSharpEdges)->RangeMultiplier(4)->Range(16, 256)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_Triangulate)->RangeMultiplier(4)->Range(64, 1024)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_GeodesicFactor)->RangeMultiplier(4)->Range(16, 256)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_GeodesicDistances)->RangeMultiplier(4)->Range(16, 256)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_Boolean)->RangeMultiplier(4)->Range(16, 256)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_BooleanInteriorLoop)->RangeMultiplier(4)->Range(16, 256)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_TriangulatePolygon)->RangeMultiplier(8)->Range(8, 4096)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_SmoothPositions)->ArgsProduct({{16, 64, 256}, {0, 1}})->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_RelaxPositions)->RangeMultiplier(4)->Range(16, 256)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_UnwrapUVs)
+    ->Args({64, 0})
+    ->Args({256, 0})
+    ->Args({64, 16})
+    ->Args({256, 16})
+    ->Args({1024, 16})
+    ->Args({1448, 16})
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_PackUVIslands)->RangeMultiplier(4)->Range(64, 1024)->Unit(benchmark::kMillisecond);
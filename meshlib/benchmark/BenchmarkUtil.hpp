@@ -0,0 +1,82 @@
+#pragma once
+#include "../builder/SphereBuilder.hpp"
+#include <algorithm>
+#include <atomic>
+#include <benchmark/benchmark.h>
+#include <memory_resource>
+
+// Shared helpers for the Google Benchmark suites. Every suite links against benchmark_main; pass
+// --benchmark_out=<file> --benchmark_out_format=json for output that tools/compare.py from Google Benchmark can diff.
+
+namespace meshlib {
+
+// Forwards to the new/delete resource and counts what passes through. Thread-safe, since it is installed as the default
+// resource while parallel algorithms allocate from worker threads; relaxed counters are enough for totals read after
+// the work has joined.
+class CountingResource : public std::pmr::memory_resource {
+  public:
+    std::atomic<size_t> bytes = 0;
+    std::atomic<size_t> peakBytes = 0;
+    std::atomic<size_t> allocations = 0;
+
+    void reset() {
+        bytes = 0;
+        peakBytes = 0;
+        allocations = 0;
+    }
+
+  private:
+    void *do_allocate(size_t bytes, size_t alignment) override {
+        size_t liveBytes = this->bytes.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+        size_t peak = peakBytes.load(std::memory_order_relaxed);
+        while (peak < liveBytes && !peakBytes.compare_exchange_weak(peak, liveBytes, std::memory_order_relaxed)) {
+        }
+        allocations.fetch_add(1, std::memory_order_relaxed);
+        return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+    }
+    void do_deallocate(void *p, size_t bytes, size_t alignment) override {
+        this->bytes.fetch_sub(bytes, std::memory_order_relaxed);
+        std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+    }
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override { return this == &other; }
+};
+
+// Routes the default memory resource, and with it Mesh storage and algorithm temporaries, through a CountingResource
+// for the lifetime of the scope. Memory from plain std containers is not seen.
+class ScopedMemoryCounter {
+  public:
+    ScopedMemoryCounter() : _previous(std::pmr::set_default_resource(&_counting)) {}
+    ~ScopedMemoryCounter() { std::pmr::set_default_resource(_previous); }
+
+    ScopedMemoryCounter(const ScopedMemoryCounter &) = delete;
+    ScopedMemoryCounter &operator=(const ScopedMemoryCounter &) = delete;
+
+    CountingResource &counting() { return _counting; }
+
+    // peak live bytes since construction and allocations per iteration
+    void report(benchmark::State &state) const {
+        state.counters["peakBytes"] = double(_counting.peakBytes);
+        state.counters["allocations"] = benchmark::Counter(double(_counting.allocations), benchmark::Counter::kAvgIterations);
+    }
+
+  private:
+    CountingResource _counting;
+    std::pmr::memory_resource *_previous;
+};
+
+template <typename TBuilder>
+TBuilder makeBuilder(int resolution) {
+    TBuilder builder;
+    builder.segmentCount = resolution;
+    return builder;
+}
+
+template <>
+inline SphereBuilder makeBuilder<SphereBuilder>(int resolution) {
+    SphereBuilder builder;
+    builder.segmentCount = resolution;
+    builder.ringCount = resolution / 2;
+    return builder;
+}
+
+} // namespace meshlib
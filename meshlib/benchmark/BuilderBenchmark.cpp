@@ -0,0 +1,64 @@
+#include "../builder/CircleBuilder.hpp"
+#include "../builder/ConeBuilder.hpp"
+#include "../builder/CylinderBuilder.hpp"
+#include "../builder/PrimitiveCache.hpp"
+#include "../builder/SphereBuilder.hpp"
+#include "BenchmarkUtil.hpp"
+
+using namespace meshlib;
+
+namespace {
+
+template <typename TBuilder>
+void BM_Build(benchmark::State &state) {
+    auto builder = makeBuilder<TBuilder>(int(state.range(0)));
+    size_t faceCount = 0;
+    for (auto _ : state) {
+        auto mesh = builder.build();
+        faceCount = mesh.allFaceCount();
+        benchmark::DoNotOptimize(faceCount);
+    }
+    state.counters["faces"] = double(faceCount);
+}
+
+template <typename TBuilder>
+void BM_BuildDirect(benchmark::State &state) {
+    auto builder = makeBuilder<TBuilder>(int(state.range(0)));
+    size_t faceCount = 0;
+    for (auto _ : state) {
+        auto mesh = builder.buildDirect();
+        faceCount = mesh.allFaceCount();
+        benchmark::DoNotOptimize(faceCount);
+    }
+    state.counters["faces"] = double(faceCount);
+}
+
+// instancing from a warm cache, with a different placement per iteration
+template <typename TBuilder>
+void BM_PrimitiveCache(benchmark::State &state) {
+    auto builder = makeBuilder<TBuilder>(int(state.range(0)));
+    PrimitiveCache cache;
+    cache.build(builder);
+    size_t faceCount = 0;
+    for (auto _ : state) {
+        builder.center.x += 1.f;
+        auto mesh = cache.build(builder);
+        faceCount = mesh.allFaceCount();
+        benchmark::DoNotOptimize(faceCount);
+    }
+    state.counters["faces"] = double(faceCount);
+}
+
+} // namespace
+
+BENCHMARK_TEMPLATE(BM_Build, SphereBuilder)->RangeMultiplier(4)->Range(16, 1024)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_BuildDirect, SphereBuilder)->RangeMultiplier(4)->Range(16, 1024)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_PrimitiveCache, SphereBuilder)->RangeMultiplier(4)->Range(16, 1024)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_Build, CylinderBuilder)->RangeMultiplier(8)->Range(16, 8192)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_BuildDirect, CylinderBuilder)->RangeMultiplier(8)->Range(16, 8192)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_PrimitiveCache, CylinderBuilder)->RangeMultiplier(8)->Range(16, 8192)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_Build, ConeBuilder)->RangeMultiplier(8)->Range(16, 8192)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_BuildDirect, ConeBuilder)->RangeMultiplier(8)->Range(16, 8192)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_PrimitiveCache, ConeBuilder)->RangeMultiplier(8)->Range(16, 8192)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_Build, CircleBuilder)->RangeMultiplier(8)->Range(16, 8192)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_BuildDirect, CircleBuilder)->RangeMultiplier(8)->Range(16, 8192)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,124 @@
+#include "../io/GltfFormat.hpp"
+#include "../io/ObjFormat.hpp"
+#include "../io/PlyFormat.hpp"
+#include "BenchmarkUtil.hpp"
+
+using namespace meshlib;
+
+namespace {
+
+// A sphere of resolution n has n * n / 2 faces; 2048 gives 2M, 10240 gives 50M
+
+void BM_ReadOBJ(benchmark::State &state) {
+    auto text = writeOBJ(makeBuilder<SphereBuilder>(int(state.range(0))).build());
+    size_t faceCount = 0;
+    for (auto _ : state) {
+        auto result = readOBJ(text);
+        faceCount = result.mesh.allFaceCount();
+        benchmark::DoNotOptimize(faceCount);
+    }
+    state.SetItemsProcessed(state.iterations() * int64_t(faceCount));
+    state.SetBytesProcessed(state.iterations() * int64_t(text.size()));
+}
+
+void BM_WriteOBJ(benchmark::State &state) {
+    auto mesh = makeBuilder<SphereBuilder>(int(state.range(0))).build();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(writeOBJ(mesh).size());
+    }
+    state.SetItemsProcessed(state.iterations() * int64_t(mesh.allFaceCount()));
+}
+
+void BM_ReadPLY(benchmark::State &state) {
+    auto data = writePLY(makeBuilder<SphereBuilder>(int(state.range(0))).build());
+    size_t faceCount = 0;
+    for (auto _ : state) {
+        auto result = readPLY(data);
+        faceCount = result.mesh.allFaceCount();
+        benchmark::DoNotOptimize(faceCount);
+    }
+    state.SetItemsProcessed(state.iterations() * int64_t(faceCount));
+    state.SetBytesProcessed(state.iterations() * int64_t(data.size()));
+}
+
+void BM_WritePLY(benchmark::State &state) {
+    auto mesh = makeBuilder<SphereBuilder>(int(state.range(0))).build();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(writePLY(mesh).size());
+    }
+    state.SetItemsProcessed(state.iterations() * int64_t(mesh.allFaceCount()));
+}
+
+// Counts and drops what is written to it
+class NullBuffer : public std::streambuf {
+  public:
+    size_t size = 0;
+
+  protected:
+    std::streamsize xsputn(const char *, std::streamsize count) override {
+        size += size_t(count);
+        return count;
+    }
+    int overflow(int c) override {
+        ++size;
+        return c;
+    }
+};
+
+// arg 1 streams to an std::ostream instead of building the output in memory
+void BM_WriteGLB(benchmark::State &state) {
+    auto mesh = makeBuilder<SphereBuilder>(int(state.range(0))).build();
+    bool stream = state.range(1) != 0;
+    for (auto _ : state) {
+        if (stream) {
+            NullBuffer buffer;
+            std::ostream output(&buffer);
+            writeGLB(mesh, output);
+            benchmark::DoNotOptimize(buffer.size);
+        } else {
+            benchmark::DoNotOptimize(writeGLB(mesh).size());
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * int64_t(mesh.allFaceCount()));
+}
+
+// building the mesh of the indexed faces; arg 1 uses addVertex/addUVPoint/addFace per element as a baseline
+void BM_IndexedFacesToMesh(benchmark::State &state) {
+    auto faces = IndexedFaces::fromMesh(makeBuilder<SphereBuilder>(int(state.range(0))).build());
+    bool perFace = state.range(1) != 0;
+    for (auto _ : state) {
+        if (!perFace) {
+            benchmark::DoNotOptimize(faces.toMesh().allFaceCount());
+            continue;
+        }
+        Mesh mesh;
+        for (auto position : faces.positions) {
+            mesh.addVertex(position);
+        }
+        std::vector<UVPointHandle> uvPoints(faces.uvPositions.size(), UVPointHandle(-1));
+        std::vector<UVPointHandle> faceUVPoints;
+        size_t corner = 0;
+        for (size_t f = 0; f < faces.faceVertexCounts.size(); ++f) {
+            faceUVPoints.clear();
+            for (int32_t i = 0; i < faces.faceVertexCounts[f]; ++i, ++corner) {
+                auto &uvPoint = uvPoints[faces.cornerUVs[corner]];
+                if (uvPoint.index < 0) {
+                    uvPoint = mesh.addUVPoint(VertexHandle(faces.cornerVertices[corner]), faces.uvPositions[faces.cornerUVs[corner]]);
+                }
+                faceUVPoints.push_back(uvPoint);
+            }
+            mesh.addFace(faceUVPoints, MaterialHandle(faces.faceMaterials[f]));
+        }
+        benchmark::DoNotOptimize(mesh.allFaceCount());
+    }
+    state.SetItemsProcessed(state.iterations() * int64_t(faces.faceVertexCounts.size()));
+}
+
+} // namespace
+
+BENCHMARK(BM_ReadOBJ)->RangeMultiplier(4)->Range(128, 2048)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_WriteOBJ)->RangeMultiplier(4)->Range(128, 2048)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_ReadPLY)->RangeMultiplier(4)->Range(128, 2048)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_WritePLY)->RangeMultiplier(4)->Range(128, 2048)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_WriteGLB)->ArgsProduct({{128, 512, 2048}, {0, 1}})->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_IndexedFacesToMesh)->ArgsProduct({{128, 512}, {0, 1}})->Unit(benchmark::kMillisecond)->UseRealTime();
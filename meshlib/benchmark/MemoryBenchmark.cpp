@@ -0,0 +1,46 @@
+#include "BenchmarkUtil.hpp"
+
+using namespace meshlib;
+
+namespace {
+
+// Live bytes and allocations of a compact copy of a sphere, per face.
+// Element arrays are exactly sized by the copy, so the numbers only show the element and adjacency layout.
+void BM_SphereMemory(benchmark::State &state) {
+    auto sphere = makeBuilder<SphereBuilder>(int(state.range(0))).build();
+    CountingResource counting;
+    size_t bytes = 0;
+    size_t allocations = 0;
+    for (auto _ : state) {
+        counting.bytes = 0;
+        counting.allocations = 0;
+        Mesh mesh(sphere, &counting);
+        bytes = counting.bytes;
+        allocations = counting.allocations;
+        benchmark::DoNotOptimize(mesh.allFaceCount());
+    }
+    auto faceCount = double(sphere.allFaceCount());
+    state.counters["faces"] = faceCount;
+    state.counters["bytesPerFace"] = double(bytes) / faceCount;
+    state.counters["allocationsPerFace"] = double(allocations) / faceCount;
+}
+
+// Allocations taken from the default memory resource while building with addFace
+void BM_SphereBuildAllocations(benchmark::State &state) {
+    auto builder = makeBuilder<SphereBuilder>(int(state.range(0)));
+    size_t allocations = 0;
+    size_t faceCount = 0;
+    for (auto _ : state) {
+        ScopedMemoryCounter counter;
+        auto mesh = builder.build();
+        allocations = counter.counting().allocations;
+        faceCount = mesh.allFaceCount();
+    }
+    state.counters["faces"] = double(faceCount);
+    state.counters["allocationsPerFace"] = double(allocations) / double(faceCount);
+}
+
+} // namespace
+
+BENCHMARK(BM_SphereMemory)->RangeMultiplier(4)->Range(16, 1024)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_SphereBuildAllocations)->RangeMultiplier(4)->Range(16, 256)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,180 @@
+#include "../MeshData.hpp"
+#include "../MeshSnapshot.hpp"
+#include "../algorithm/Transform.hpp"
+#include "BenchmarkUtil.hpp"
+#include <unordered_map>
+
+using namespace meshlib;
+
+namespace {
+
+// resolution x resolution grid of quads built with addFace
+void BM_AddFace(benchmark::State &state) {
+    ScopedMemoryCounter counter;
+    int resolution = int(state.range(0));
+    for (auto _ : state) {
+        Mesh mesh;
+        for (int y = 0; y <= resolution; ++y) {
+            for (int x = 0; x <= resolution; ++x) {
+                auto v = mesh.addVertex(glm::vec3(x, y, 0));
+                mesh.addUVPoint(v, glm::vec2(x, y) / float(resolution));
+            }
+        }
+        auto uv = [&](int x, int y) { return UVPointHandle(y * (resolution + 1) + x); };
+        for (int y = 0; y < resolution; ++y) {
+            for (int x = 0; x < resolution; ++x) {
+                mesh.addFace({uv(x, y), uv(x + 1, y), uv(x + 1, y + 1), uv(x, y + 1)}, {});
+            }
+        }
+        benchmark::DoNotOptimize(mesh.allFaceCount());
+    }
+    state.SetItemsProcessed(state.iterations() * resolution * resolution);
+    state.counters["faces"] = double(resolution * resolution);
+    counter.report(state);
+}
+
+// sphere with every other face removed
+void BM_CollectGarbage(benchmark::State &state) {
+    ScopedMemoryCounter counter;
+    auto mesh = makeBuilder<SphereBuilder>(int(state.range(0))).build();
+    for (size_t i = 0; i < mesh.allFaceCount(); i += 2) {
+        mesh.removeFace(FaceHandle(int(i)));
+    }
+    for (auto _ : state) {
+        auto collected = mesh.collectGarbage();
+        benchmark::DoNotOptimize(collected.allFaceCount());
+    }
+    state.SetItemsProcessed(state.iterations() * int64_t(mesh.allFaceCount()));
+    state.counters["faces"] = double(mesh.allFaceCount());
+    counter.report(state);
+}
+
+void BM_MeshDataFromMesh(benchmark::State &state) {
+    ScopedMemoryCounter counter;
+    auto mesh = makeBuilder<SphereBuilder>(int(state.range(0))).build();
+    for (auto _ : state) {
+        MeshData data(mesh);
+        benchmark::DoNotOptimize(data.faceUVPointArray.data());
+    }
+    state.SetItemsProcessed(state.iterations() * int64_t(mesh.allFaceCount()));
+    state.counters["faces"] = double(mesh.allFaceCount());
+    counter.report(state);
+}
+
+void BM_MeshDataToMesh(benchmark::State &state) {
+    ScopedMemoryCounter counter;
+    MeshData data(makeBuilder<SphereBuilder>(int(state.range(0))).build());
+    for (auto _ : state) {
+        auto mesh = data.toMesh();
+        benchmark::DoNotOptimize(mesh.allFaceCount());
+    }
+    state.SetItemsProcessed(state.iterations() * int64_t(data.faceVertexCountArray.size()));
+    state.counters["faces"] = double(data.faceVertexCountArray.size());
+    counter.report(state);
+}
+
+// edge set of a hemisphere, as used by extrude
+void BM_EdgesOfVertices(benchmark::State &state) {
+    ScopedMemoryCounter counter;
+    auto builder = makeBuilder<SphereBuilder>(int(state.range(0)));
+    auto mesh = builder.build();
+    std::vector<VertexHandle> vertices;
+    for (auto v : mesh.vertices()) {
+        if (mesh.position(v)[builder.axis] > 0) {
+            vertices.push_back(v);
+        }
+    }
+    for (auto _ : state) {
+        auto edges = mesh.edges(vertices);
+        benchmark::DoNotOptimize(edges.size());
+    }
+    state.SetItemsProcessed(state.iterations() * int64_t(vertices.size()));
+    state.counters["vertices"] = double(vertices.size());
+    counter.report(state);
+}
+
+// sums a float vertex attribute; baseline: the same values in an unordered_map side table
+void BM_VertexAttributeSum(benchmark::State &state) {
+    auto mesh = makeBuilder<SphereBuilder>(int(state.range(0))).build();
+    auto weight = mesh.addAttribute<VertexHandle, float>("weight");
+    std::unordered_map<VertexHandle, float> weightMap;
+    for (auto v : mesh.vertices()) {
+        mesh.setAttribute(weight, v, 1.f);
+        weightMap[v] = 1.f;
+    }
+    bool useMap = state.range(1) != 0;
+    for (auto _ : state) {
+        float sum = 0;
+        for (auto v : mesh.vertices()) {
+            sum += useMap ? weightMap.at(v) : mesh.attribute(weight, v);
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * int64_t(mesh.allVertexCount()));
+}
+
+// sphere with every other face removed and a vertex and a face attribute
+void BM_CollectGarbageWithAttributes(benchmark::State &state) {
+    ScopedMemoryCounter counter;
+    auto mesh = makeBuilder<SphereBuilder>(int(state.range(0))).build();
+    mesh.addAttribute<VertexHandle, glm::vec4>("color");
+    mesh.addAttribute<FaceHandle, int32_t>("id");
+    for (size_t i = 0; i < mesh.allFaceCount(); i += 2) {
+        mesh.removeFace(FaceHandle(int(i)));
+    }
+    for (auto _ : state) {
+        auto collected = mesh.collectGarbage();
+        benchmark::DoNotOptimize(collected.allFaceCount());
+    }
+    state.SetItemsProcessed(state.iterations() * int64_t(mesh.allFaceCount()));
+    state.counters["faces"] = double(mesh.allFaceCount());
+    counter.report(state);
+}
+
+// snapshot of a sphere, then a vertex moved in the original: arg 1 compares against a deep copy per edit
+void BM_SnapshotAndEdit(benchmark::State &state) {
+    ScopedMemoryCounter counter;
+    auto mesh = makeBuilder<SphereBuilder>(int(state.range(0))).build();
+    bool deepCopy = state.range(1) != 0;
+    std::pmr::unsynchronized_pool_resource otherResource;
+    for (auto _ : state) {
+        // held until after the edit, so that the edit copies the chunk it writes to
+        MeshSnapshot snapshot = deepCopy ? std::make_shared<const Mesh>(mesh, &otherResource) : takeSnapshot(mesh);
+        mesh.setPosition(VertexHandle(0), mesh.position(VertexHandle(0)) + glm::vec3(0.001f));
+        benchmark::DoNotOptimize(snapshot->allFaceCount());
+    }
+    state.SetItemsProcessed(state.iterations() * int64_t(mesh.allVertexCount()));
+    counter.report(state);
+}
+
+// an edit of one vertex (arg 1 = 0) or a translation of the whole sphere (1), undone and redone
+void BM_UndoRedo(benchmark::State &state) {
+    auto mesh = makeBuilder<SphereBuilder>(int(state.range(0))).build();
+    bool translate = state.range(1) != 0;
+    for (auto _ : state) {
+        if (translate) {
+            translatePositions(mesh, glm::vec3(0.001f));
+        } else {
+            ScopedMeshOperation operation(mesh, "move vertex");
+            mesh.setPosition(VertexHandle(0), mesh.position(VertexHandle(0)) + glm::vec3(0.001f));
+        }
+        mesh.undo();
+        mesh.redo();
+    }
+    state.SetItemsProcessed(state.iterations());
+    // per step, against a full copy of the positions for translations
+    state.counters["stepBytes"] = double(mesh.historyBytes()) / double(mesh.historyStepCount());
+    state.counters["positionBytes"] = double(mesh.allVertexCount() * sizeof(glm::vec3));
+}
+
+} // namespace
+
+BENCHMARK(BM_AddFace)->RangeMultiplier(4)->Range(16, 1024)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_CollectGarbage)->RangeMultiplier(4)->Range(16, 1024)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_MeshDataFromMesh)->RangeMultiplier(4)->Range(16, 1024)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_MeshDataToMesh)->RangeMultiplier(4)->Range(16, 256)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_EdgesOfVertices)->RangeMultiplier(4)->Range(16, 1024)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_VertexAttributeSum)->ArgsProduct({{64, 256, 1024}, {0, 1}})->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_CollectGarbageWithAttributes)->RangeMultiplier(4)->Range(16, 1024)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_SnapshotAndEdit)->ArgsProduct({{64, 256, 1024}, {0, 1}})->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_UndoRedo)->ArgsProduct({{64, 256, 1024}, {0, 1}})->Unit(benchmark::kMicrosecond);
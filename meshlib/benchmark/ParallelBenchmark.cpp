@@ -0,0 +1,91 @@
+#include "../util/Parallel.hpp"
+#include "BenchmarkUtil.hpp"
+#include <thread>
+
+using namespace meshlib;
+
+namespace {
+
+// per-call cost of spreading a small loop over threads; arg 1 is the thread count
+void BM_ParallelForOverhead(benchmark::State &state) {
+    size_t threadCount = size_t(state.range(0));
+    std::vector<float> values(4096, 1.0f);
+    setConcurrencyLimit(threadCount);
+    for (auto _ : state) {
+        parallelFor(0, values.size(), [&](size_t i) { values[i] *= 1.0001f; }, 256);
+        benchmark::ClobberMemory();
+    }
+    setConcurrencyLimit(0);
+}
+
+// baseline: a thread started per block, as parallelFor did before the scheduler
+void BM_ThreadSpawnOverhead(benchmark::State &state) {
+    size_t threadCount = size_t(state.range(0));
+    std::vector<float> values(4096, 1.0f);
+    for (auto _ : state) {
+        size_t blockSize = values.size() / threadCount;
+        auto runBlock = [&](size_t block) {
+            for (size_t i = block * blockSize; i < (block + 1) * blockSize; ++i) {
+                values[i] *= 1.0001f;
+            }
+        };
+        std::vector<std::thread> threads;
+        for (size_t block = 1; block < threadCount; ++block) {
+            threads.emplace_back(runBlock, block);
+        }
+        runBlock(0);
+        for (auto &thread : threads) {
+            thread.join();
+        }
+        benchmark::ClobberMemory();
+    }
+}
+
+// nested loops, e.g. an algorithm running per mesh part
+void BM_NestedParallelFor(benchmark::State &state) {
+    setConcurrencyLimit(size_t(state.range(0)));
+    std::vector<float> values(64 * 4096, 1.0f);
+    for (auto _ : state) {
+        parallelFor(
+            0, 64,
+            [&](size_t part) {
+                parallelFor(part * 4096, (part + 1) * 4096, [&](size_t i) { values[i] *= 1.0001f; }, 1024);
+            },
+            1);
+        benchmark::ClobberMemory();
+    }
+    setConcurrencyLimit(0);
+}
+
+void BM_CalculateVertexNormals(benchmark::State &state) {
+    auto mesh = makeBuilder<SphereBuilder>(int(state.range(0))).build();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(mesh.calculateVertexNormals().data());
+    }
+    state.SetItemsProcessed(state.iterations() * int64_t(mesh.allVertexCount()));
+}
+
+// half of the vertices selected; arg 1 derives the faces through RegionQuery as selectedFaces() did before
+void BM_SelectedFaces(benchmark::State &state) {
+    auto mesh = makeBuilder<SphereBuilder>(int(state.range(0))).build();
+    for (auto v : mesh.vertices()) {
+        mesh.setSelected(v, v.index < int(mesh.allVertexCount() / 2));
+    }
+    bool regionQuery = state.range(1) != 0;
+    for (auto _ : state) {
+        if (regionQuery) {
+            benchmark::DoNotOptimize(mesh.faces(mesh.selectedVertices()).size());
+        } else {
+            benchmark::DoNotOptimize(mesh.selectedFaces().size());
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * int64_t(mesh.allFaceCount()));
+}
+
+} // namespace
+
+BENCHMARK(BM_ParallelForOverhead)->Arg(1)->Arg(2)->Arg(4)->Unit(benchmark::kMicrosecond)->UseRealTime();
+BENCHMARK(BM_ThreadSpawnOverhead)->Arg(1)->Arg(2)->Arg(4)->Unit(benchmark::kMicrosecond)->UseRealTime();
+BENCHMARK(BM_NestedParallelFor)->Arg(1)->Arg(4)->Unit(benchmark::kMicrosecond)->UseRealTime();
+BENCHMARK(BM_CalculateVertexNormals)->RangeMultiplier(4)->Range(64, 1024)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_SelectedFaces)->ArgsProduct({{64, 256, 1024}, {0, 1}})->Unit(benchmark::kMicrosecond);
@@ -0,0 +1,70 @@
+#include "../algorithm/LimitSurface.hpp"
+#include "../algorithm/Subdivide.hpp"
+#include "../builder/CubeBuilder.hpp"
+#include "../builder/SphereBuilder.hpp"
+#include <benchmark/benchmark.h>
+
+using namespace meshlib;
+
+namespace {
+
+template <typename TBuilder>
+void BM_LimitSurfaceSetup(benchmark::State &state) {
+    auto cage = TBuilder().build();
+    int level = int(state.range(0));
+    for (auto _ : state) {
+        LimitSurfaceEvaluator evaluator(cage, level);
+        benchmark::DoNotOptimize(evaluator.pointCount());
+    }
+}
+
+template <typename TBuilder>
+void BM_LimitSurfaceEvaluate(benchmark::State &state) {
+    auto cage = TBuilder().build();
+    LimitSurfaceEvaluator evaluator(cage, int(state.range(0)));
+    std::vector<glm::vec3> positions(evaluator.pointCount());
+    std::vector<glm::vec3> normals(evaluator.pointCount());
+
+    for (auto _ : state) {
+        evaluator.evaluate(cage, positions.data(), normals.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * int64_t(evaluator.pointCount()));
+    state.counters["points"] = double(evaluator.pointCount());
+    state.counters["quads"] = double(evaluator.quadCount());
+    state.counters["outputBytes"] = double(evaluator.pointCount() * 2 * sizeof(glm::vec3));
+}
+
+// uniform refinement materialized as Mesh, for comparison
+template <typename TBuilder>
+void BM_UniformSubdivide(benchmark::State &state) {
+    auto cage = TBuilder().build();
+    CatmullClarkSubdivider subdivider(cage, int(state.range(0)));
+    for (auto _ : state) {
+        auto mesh = subdivider.subdivide(cage);
+        benchmark::DoNotOptimize(mesh.allFaceCount());
+    }
+    state.counters["points"] = double(subdivider.vertexStencils().size());
+}
+
+template <typename TBuilder>
+void BM_UniformUpdatePositions(benchmark::State &state) {
+    auto cage = TBuilder().build();
+    CatmullClarkSubdivider subdivider(cage, int(state.range(0)));
+    auto mesh = subdivider.subdivide(cage);
+    for (auto _ : state) {
+        subdivider.updatePositions(cage, mesh);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * int64_t(subdivider.vertexStencils().size()));
+}
+
+} // namespace
+
+BENCHMARK_TEMPLATE(BM_LimitSurfaceSetup, SphereBuilder)->DenseRange(1, 5)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_LimitSurfaceSetup, CubeBuilder)->DenseRange(1, 5)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_LimitSurfaceEvaluate, SphereBuilder)->DenseRange(1, 5)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_LimitSurfaceEvaluate, CubeBuilder)->DenseRange(1, 5)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_UniformSubdivide, SphereBuilder)->DenseRange(1, 4)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_UniformSubdivide, CubeBuilder)->DenseRange(1, 4)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_UniformUpdatePositions, SphereBuilder)->DenseRange(1, 4)->Unit(benchmark::kMillisecond);
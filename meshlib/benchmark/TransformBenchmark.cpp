@@ -0,0 +1,73 @@
+#include "../algorithm/Transform.hpp"
+#include "BenchmarkUtil.hpp"
+
+using namespace meshlib;
+
+namespace {
+
+glm::mat4 gizmoMatrix() {
+    glm::mat4 matrix(1);
+    matrix[0][1] = 0.1f;
+    matrix[1][0] = -0.1f;
+    matrix[3] = glm::vec4(0.01f, 0.02f, 0.03f, 1);
+    return matrix;
+}
+
+// every other vertex selected
+Mesh selectedSphere(int resolution) {
+    auto mesh = makeBuilder<SphereBuilder>(resolution).build();
+    for (auto v : mesh.vertices()) {
+        mesh.setSelected(v, v.index % 2 == 0);
+    }
+    return mesh;
+}
+
+// baseline: per-vertex setPosition over selectedVertices()
+void BM_TransformPositionsLoop(benchmark::State &state) {
+    auto mesh = selectedSphere(int(state.range(0)));
+    auto matrix = gizmoMatrix();
+    for (auto _ : state) {
+        for (auto v : mesh.selectedVertices()) {
+            mesh.setPosition(v, glm::vec3(matrix * glm::vec4(mesh.position(v), 1)));
+        }
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * int64_t(mesh.allVertexCount()));
+}
+
+void BM_TransformPositions(benchmark::State &state) {
+    auto mesh = selectedSphere(int(state.range(0)));
+    auto matrix = gizmoMatrix();
+    bool selectedOnly = state.range(1) != 0;
+    for (auto _ : state) {
+        transformPositions(mesh, matrix, selectedOnly);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * int64_t(mesh.allVertexCount()));
+}
+
+void BM_TransformUVPositions(benchmark::State &state) {
+    auto mesh = selectedSphere(int(state.range(0)));
+    glm::mat3 matrix(1);
+    matrix[2] = glm::vec3(0.01f, 0.02f, 1);
+    for (auto _ : state) {
+        transformUVPositions(mesh, matrix, true);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * int64_t(mesh.allUVPointCount()));
+}
+
+void BM_BoundingBox(benchmark::State &state) {
+    auto mesh = selectedSphere(int(state.range(0)));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(boundingBox(mesh, true));
+    }
+    state.SetItemsProcessed(state.iterations() * int64_t(mesh.allVertexCount()));
+}
+
+} // namespace
+
+BENCHMARK(BM_TransformPositionsLoop)->RangeMultiplier(4)->Range(64, 2048)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_TransformPositions)->ArgsProduct({{64, 256, 1024, 2048}, {0, 1}})->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_TransformUVPositions)->RangeMultiplier(4)->Range(64, 2048)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_BoundingBox)->RangeMultiplier(4)->Range(64, 2048)->Unit(benchmark::kMicrosecond);
@@ -1,4 +1,5 @@
 #include "CircleBuilder.hpp"
+#include "../util/Parallel.hpp"
 #include <QtGlobal>
 
 using namespace glm;
@@ -27,4 +28,32 @@ Mesh CircleBuilder::build() const {
     return mesh;
 }
 
+Mesh CircleBuilder::buildDirect() const {
+    int segments = segmentCount;
+
+    Mesh mesh;
+    mesh.beginDirectBuild(segments, segments, segments, 1);
+
+    std::vector<UVPointHandle> uvPoints(segments);
+    std::vector<EdgeHandle> edges(segments);
+
+    float angleStep = float(M_PI) * 2.f / segmentCount;
+    parallelFor(0, segments, [&](size_t index) {
+        int i = int(index);
+        float angle = angleStep * i;
+        vec3 offset(0);
+        offset[(normalAxis + 1) % 3] = cos(angle);
+        offset[(normalAxis + 2) % 3] = sin(angle);
+        mesh.setDirectVertex(VertexHandle(i), center + offset * radius);
+        mesh.setDirectUVPoint(UVPointHandle(i), VertexHandle(i), vec2(0));
+        mesh.setDirectEdge(EdgeHandle(i), {VertexHandle(i), VertexHandle((i + 1) % segments)});
+        uvPoints[i] = UVPointHandle(i);
+        edges[i] = EdgeHandle(i);
+    });
+    mesh.setDirectFace(FaceHandle(0), std::move(uvPoints), std::move(edges), material);
+
+    mesh.endDirectBuild();
+    return mesh;
+}
+
 } // namespace meshlib
@@ -1,4 +1,5 @@
 #include "ConeBuilder.hpp"
+#include "../util/Parallel.hpp"
 #include <QtGlobal>
 
 using namespace glm;
@@ -38,4 +39,48 @@ Mesh ConeBuilder::build() const {
     return mesh;
 }
 
+Mesh ConeBuilder::buildDirect() const {
+    // vertices: base ring then top
+    // edges: base ring edges (i, i + 1), then edges (i, top)
+    // faces: reversed base, then the sides like build()
+    int segments = segmentCount;
+    int top = segments;
+    auto ringEdge = [&](int i) { return EdgeHandle((i + segments) % segments); };
+    auto sideEdge = [&](int i) { return EdgeHandle(segments + i % segments); };
+
+    Mesh mesh;
+    mesh.beginDirectBuild(segments + 1, segments + 1, segments * 2, segments + 1);
+
+    float angleStep = float(M_PI) * 2 / segmentCount;
+    parallelFor(0, segments, [&](size_t index) {
+        int i = int(index);
+        float angle = angleStep * i;
+        vec3 offset(0);
+        offset[(axis + 1) % 3] = cos(angle);
+        offset[(axis + 2) % 3] = sin(angle);
+        mesh.setDirectVertex(VertexHandle(i), center + offset * radius);
+        mesh.setDirectUVPoint(UVPointHandle(i), VertexHandle(i), vec2(0));
+        mesh.setDirectEdge(ringEdge(i), {VertexHandle(i), VertexHandle((i + 1) % segments)});
+        mesh.setDirectEdge(sideEdge(i), {VertexHandle(i), VertexHandle(top)});
+        mesh.setDirectFace(FaceHandle(i + 1), {UVPointHandle(i), UVPointHandle((i + 1) % segments), UVPointHandle(top)},
+                           {ringEdge(i), sideEdge(i + 1), sideEdge(i)}, material);
+    });
+
+    vec3 topPosition = center;
+    topPosition[axis] += height;
+    mesh.setDirectVertex(VertexHandle(top), topPosition);
+    mesh.setDirectUVPoint(UVPointHandle(top), VertexHandle(top), vec2(0));
+
+    std::vector<UVPointHandle> baseUVPoints(segments);
+    std::vector<EdgeHandle> baseEdges(segments);
+    for (int j = 0; j < segments; ++j) {
+        baseUVPoints[j] = UVPointHandle(segments - 1 - j);
+        baseEdges[j] = ringEdge(segments - 2 - j);
+    }
+    mesh.setDirectFace(FaceHandle(0), std::move(baseUVPoints), std::move(baseEdges), material);
+
+    mesh.endDirectBuild();
+    return mesh;
+}
+
 } // namespace meshlib
@@ -1,6 +1,7 @@
 #include "CylinderBuilder.hpp"
 #include "../algorithm/Extrude.hpp"
 #include "CircleBuilder.hpp"
+#include "../util/Parallel.hpp"
 #include <QtGlobal>
 
 using namespace glm;
@@ -27,4 +28,58 @@ Mesh CylinderBuilder::build() const {
     return mesh;
 }
 
+Mesh CylinderBuilder::buildDirect() const {
+    // vertices: bottom ring then top ring
+    // edges: bottom ring edges (i, i + 1), edges (i, top i), top ring edges
+    // faces: sides, top, reversed bottom
+    int segments = segmentCount;
+    auto bottomEdge = [&](int i) { return EdgeHandle((i + segments) % segments); };
+    auto sideEdge = [&](int i) { return EdgeHandle(segments + i % segments); };
+    auto topEdge = [&](int i) { return EdgeHandle(segments * 2 + i % segments); };
+
+    Mesh mesh;
+    mesh.beginDirectBuild(segments * 2, segments * 2, segments * 3, segments + 2);
+
+    vec3 extrudeOffset(0);
+    extrudeOffset[axis] = height;
+
+    float angleStep = float(M_PI) * 2.f / segmentCount;
+    parallelFor(0, segments, [&](size_t index) {
+        int i = int(index);
+        int next = (i + 1) % segments;
+        float angle = angleStep * i;
+        vec3 offset(0);
+        offset[(axis + 1) % 3] = cos(angle);
+        offset[(axis + 2) % 3] = sin(angle);
+        vec3 pos = center + offset * radius;
+
+        mesh.setDirectVertex(VertexHandle(i), pos);
+        mesh.setDirectVertex(VertexHandle(segments + i), pos + extrudeOffset);
+        mesh.setDirectUVPoint(UVPointHandle(i), VertexHandle(i), vec2(0));
+        mesh.setDirectUVPoint(UVPointHandle(segments + i), VertexHandle(segments + i), vec2(0));
+        mesh.setDirectEdge(bottomEdge(i), {VertexHandle(i), VertexHandle(next)});
+        mesh.setDirectEdge(sideEdge(i), {VertexHandle(i), VertexHandle(segments + i)});
+        mesh.setDirectEdge(topEdge(i), {VertexHandle(segments + i), VertexHandle(segments + next)});
+        mesh.setDirectFace(FaceHandle(i),
+                           {UVPointHandle(i), UVPointHandle(next), UVPointHandle(segments + next), UVPointHandle(segments + i)},
+                           {bottomEdge(i), sideEdge(i + 1), topEdge(i), sideEdge(i)}, material);
+    });
+
+    std::vector<UVPointHandle> topUVPoints(segments);
+    std::vector<EdgeHandle> topEdges(segments);
+    std::vector<UVPointHandle> bottomUVPoints(segments);
+    std::vector<EdgeHandle> bottomEdges(segments);
+    for (int j = 0; j < segments; ++j) {
+        topUVPoints[j] = UVPointHandle(segments + j);
+        topEdges[j] = topEdge(j);
+        bottomUVPoints[j] = UVPointHandle(segments - 1 - j);
+        bottomEdges[j] = bottomEdge(segments - 2 - j);
+    }
+    mesh.setDirectFace(FaceHandle(segments), std::move(topUVPoints), std::move(topEdges), material);
+    mesh.setDirectFace(FaceHandle(segments + 1), std::move(bottomUVPoints), std::move(bottomEdges), material);
+
+    mesh.endDirectBuild();
+    return mesh;
+}
+
 } // namespace meshlib
@@ -6,6 +6,9 @@ namespace meshlib {
 class CylinderBuilder {
   public:
     Mesh build() const;
+    // Same surface as build(), written with closed-form connectivity in parallel (no duplicate checks); unlike build()
+    // it does not keep the deleted circle face from the extrusion
+    Mesh buildDirect() const;
 
     glm::vec3 center{0};
     float radius{1};
@@ -0,0 +1,123 @@
+#include "PrimitiveCache.hpp"
+#include "../util/Parallel.hpp"
+
+using namespace glm;
+
+namespace meshlib {
+
+namespace {
+
+Mesh instantiate(const Mesh &canonical, vec3 scale, vec3 offset, MaterialHandle material) {
+    Mesh mesh = canonical;
+    // the copy shares its chunks with the canonical mesh, so each one is written by a single task
+    parallelForChunks(mesh.allVertexCount(), Mesh::ChunkSize, [&](size_t chunk, size_t begin, size_t end) {
+        auto positions = mesh.positionChunk(chunk);
+        for (size_t i = 0; i < end - begin; ++i) {
+            positions[i] = positions[i] * scale + offset;
+        }
+    });
+    if (material != MaterialHandle()) {
+        for (auto f : mesh.allFaces()) {
+            mesh.setMaterial(f, material);
+        }
+    }
+    return mesh;
+}
+
+vec3 axisScale(int axis, float axisValue, float otherValue) {
+    vec3 scale(otherValue);
+    scale[axis] = axisValue;
+    return scale;
+}
+
+} // namespace
+
+template <typename TBuildFunc>
+std::shared_ptr<const Mesh> PrimitiveCache::canonicalMesh(const Key &key, TBuildFunc &&buildFunc) {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        auto it = _meshes.find(key);
+        if (it != _meshes.end()) {
+            return it->second;
+        }
+    }
+    // built outside the lock; if another thread was faster its mesh is kept
+    auto mesh = std::make_shared<const Mesh>(buildFunc());
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _meshes.emplace(key, std::move(mesh)).first->second;
+}
+
+Mesh PrimitiveCache::build(const SphereBuilder &builder) {
+    auto canonical = canonicalMesh({Type::Sphere, builder.segmentCount, builder.ringCount, builder.axis}, [&] {
+        SphereBuilder unitBuilder;
+        unitBuilder.segmentCount = builder.segmentCount;
+        unitBuilder.ringCount = builder.ringCount;
+        unitBuilder.axis = builder.axis;
+        return unitBuilder.buildDirect();
+    });
+    return instantiate(*canonical, vec3(builder.radius), builder.center, builder.material);
+}
+
+Mesh PrimitiveCache::build(const CylinderBuilder &builder) {
+    auto canonical = canonicalMesh({Type::Cylinder, builder.segmentCount, 0, builder.axis}, [&] {
+        CylinderBuilder unitBuilder;
+        unitBuilder.segmentCount = builder.segmentCount;
+        unitBuilder.axis = builder.axis;
+        return unitBuilder.buildDirect();
+    });
+    return instantiate(*canonical, axisScale(builder.axis, builder.height, builder.radius), builder.center, builder.material);
+}
+
+Mesh PrimitiveCache::build(const ConeBuilder &builder) {
+    auto canonical = canonicalMesh({Type::Cone, builder.segmentCount, 0, builder.axis}, [&] {
+        ConeBuilder unitBuilder;
+        unitBuilder.segmentCount = builder.segmentCount;
+        unitBuilder.axis = builder.axis;
+        return unitBuilder.buildDirect();
+    });
+    return instantiate(*canonical, axisScale(builder.axis, builder.height, builder.radius), builder.center, builder.material);
+}
+
+Mesh PrimitiveCache::build(const CircleBuilder &builder) {
+    auto canonical = canonicalMesh({Type::Circle, builder.segmentCount, 0, builder.normalAxis}, [&] {
+        CircleBuilder unitBuilder;
+        unitBuilder.segmentCount = builder.segmentCount;
+        unitBuilder.normalAxis = builder.normalAxis;
+        return unitBuilder.buildDirect();
+    });
+    return instantiate(*canonical, vec3(builder.radius), builder.center, builder.material);
+}
+
+Mesh PrimitiveCache::build(const PlaneBuilder &builder) {
+    auto canonical = canonicalMesh({Type::Plane, 0, 0, builder.normalAxis}, [&] {
+        PlaneBuilder unitBuilder;
+        unitBuilder.normalAxis = builder.normalAxis;
+        return unitBuilder.build();
+    });
+    vec3 scale(1);
+    scale[(builder.normalAxis + 1) % 3] = builder.size.x;
+    scale[(builder.normalAxis + 2) % 3] = builder.size.y;
+    return instantiate(*canonical, scale, builder.center, builder.material);
+}
+
+Mesh PrimitiveCache::build(const CubeBuilder &builder) {
+    auto canonical = canonicalMesh({Type::Cube, 0, 0, 0}, [&] {
+        CubeBuilder unitBuilder;
+        unitBuilder.minPos = vec3(0);
+        unitBuilder.maxPos = vec3(1);
+        return unitBuilder.build();
+    });
+    return instantiate(*canonical, builder.maxPos - builder.minPos, builder.minPos, builder.material);
+}
+
+size_t PrimitiveCache::size() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _meshes.size();
+}
+
+void PrimitiveCache::clear() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _meshes.clear();
+}
+
+} // namespace meshlib
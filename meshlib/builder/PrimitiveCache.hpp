@@ -0,0 +1,60 @@
+#pragma once
+#include "CircleBuilder.hpp"
+#include "ConeBuilder.hpp"
+#include "CubeBuilder.hpp"
+#include "CylinderBuilder.hpp"
+#include "PlaneBuilder.hpp"
+#include "SphereBuilder.hpp"
+#include <map>
+#include <memory>
+#include <mutex>
+#include <tuple>
+
+namespace meshlib {
+
+// Keeps one canonical mesh (unit size at the origin) per builder type and topology parameters (segmentCount,
+// ringCount, axis) and creates primitives by copying it and scaling and translating the positions.
+// The result has the builder's geometry (up to float rounding) and topology, but sphere, cylinder, cone and circle come
+// from buildDirect(), so their element handles are ordered differently than in build() and may not be compared with
+// its output. Thread-safe.
+class PrimitiveCache {
+  public:
+    Mesh build(const SphereBuilder &builder);
+    Mesh build(const CylinderBuilder &builder);
+    Mesh build(const ConeBuilder &builder);
+    Mesh build(const CircleBuilder &builder);
+    Mesh build(const PlaneBuilder &builder);
+    Mesh build(const CubeBuilder &builder);
+
+    size_t size() const;
+    void clear();
+
+  private:
+    enum class Type {
+        Sphere,
+        Cylinder,
+        Cone,
+        Circle,
+        Plane,
+        Cube,
+    };
+
+    struct Key {
+        Type type;
+        int segmentCount;
+        int ringCount;
+        int axis;
+
+        bool operator<(const Key &other) const {
+            return std::tie(type, segmentCount, ringCount, axis) < std::tie(other.type, other.segmentCount, other.ringCount, other.axis);
+        }
+    };
+
+    template <typename TBuildFunc>
+    std::shared_ptr<const Mesh> canonicalMesh(const Key &key, TBuildFunc &&buildFunc);
+
+    mutable std::mutex _mutex;
+    std::map<Key, std::shared_ptr<const Mesh>> _meshes;
+};
+
+} // namespace meshlib
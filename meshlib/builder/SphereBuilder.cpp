@@ -1,10 +1,25 @@
 #include "SphereBuilder.hpp"
+#include "../util/Parallel.hpp"
 #include <QtGlobal>
 
 using namespace glm;
 
 namespace meshlib {
 
+namespace {
+
+vec3 ringPosition(const SphereBuilder &builder, int ring, int i) {
+    float longitude = float(M_PI) * (ring + 1 - builder.ringCount * 0.5f) / builder.ringCount;
+    float latitude = float(M_PI) * 2.f * (float(i) / builder.segmentCount);
+    vec3 offset;
+    offset[builder.axis] = sin(longitude);
+    offset[(builder.axis + 1) % 3] = cos(latitude) * cos(longitude);
+    offset[(builder.axis + 2) % 3] = sin(latitude) * cos(longitude);
+    return builder.center + offset * builder.radius;
+}
+
+} // namespace
+
 Mesh SphereBuilder::build() const {
     Mesh mesh;
 
@@ -13,15 +28,8 @@ Mesh SphereBuilder::build() const {
     for (int ring = 0; ring < ringCount - 1; ++ring) {
         std::vector<UVPointHandle> uvPoints;
 
-        float longitude = float(M_PI) * (ring + 1 - ringCount * 0.5f) / ringCount;
-
         for (int i = 0; i < segmentCount; ++i) {
-            float latitude = float(M_PI) * 2.f * (float(i) / segmentCount);
-            vec3 offset;
-            offset[axis] = sin(longitude);
-            offset[(axis + 1) % 3] = cos(latitude) * cos(longitude);
-            offset[(axis + 2) % 3] = sin(latitude) * cos(longitude);
-            vec3 pos = center + offset * radius;
+            vec3 pos = ringPosition(*this, ring, i);
             uvPoints.push_back(mesh.addUVPoint(mesh.addVertex(pos), dvec2(0)));
         }
 
@@ -45,4 +53,74 @@ Mesh SphereBuilder::build() const {
     return mesh;
 }
 
+Mesh SphereBuilder::buildDirect() const {
+    // vertex (and uv point) ring * segmentCount + i, then bottom and top
+    // edges: along each ring, between neighbouring rings, to the bottom, to the top
+    // faces: segmentCount columns of ringCount faces (bottom triangle, quads, top triangle) like build()
+    int segments = segmentCount;
+    int ringVertexCount = (ringCount - 1) * segments;
+    int bottom = ringVertexCount;
+    int top = ringVertexCount + 1;
+
+    auto vertex = [&](int ring, int i) { return ring * segments + i % segments; };
+    auto ringEdge = [&](int ring, int i) { return EdgeHandle(ring * segments + i % segments); };
+    auto verticalEdge = [&](int ring, int i) { return EdgeHandle((ringCount - 1 + ring) * segments + i % segments); };
+    auto bottomEdge = [&](int i) { return EdgeHandle((2 * ringCount - 3) * segments + i % segments); };
+    auto topEdge = [&](int i) { return EdgeHandle((2 * ringCount - 2) * segments + i % segments); };
+
+    Mesh mesh;
+    mesh.beginDirectBuild(ringVertexCount + 2, ringVertexCount + 2, (2 * ringCount - 1) * segments, ringCount * segments);
+
+    size_t ringsPerBlock = std::max(1, 1024 / segments);
+
+    parallelFor(
+        0, ringCount - 1, [&](size_t ringIndex) {
+            int ring = int(ringIndex);
+            for (int i = 0; i < segments; ++i) {
+                int v = vertex(ring, i);
+                mesh.setDirectVertex(VertexHandle(v), ringPosition(*this, ring, i));
+                mesh.setDirectUVPoint(UVPointHandle(v), VertexHandle(v), vec2(0));
+                mesh.setDirectEdge(ringEdge(ring, i), {VertexHandle(v), VertexHandle(vertex(ring, i + 1))});
+                if (ring < ringCount - 2) {
+                    mesh.setDirectEdge(verticalEdge(ring, i), {VertexHandle(v), VertexHandle(vertex(ring + 1, i))});
+                }
+            }
+        },
+        ringsPerBlock);
+
+    mesh.setDirectVertex(VertexHandle(bottom), center + vec3(0, -radius, 0));
+    mesh.setDirectUVPoint(UVPointHandle(bottom), VertexHandle(bottom), vec2(0));
+    mesh.setDirectVertex(VertexHandle(top), center + vec3(0, radius, 0));
+    mesh.setDirectUVPoint(UVPointHandle(top), VertexHandle(top), vec2(0));
+    for (int i = 0; i < segments; ++i) {
+        mesh.setDirectEdge(bottomEdge(i), {VertexHandle(bottom), VertexHandle(vertex(0, i))});
+        mesh.setDirectEdge(topEdge(i), {VertexHandle(vertex(ringCount - 2, i)), VertexHandle(top)});
+    }
+
+    parallelFor(
+        0, ringCount, [&](size_t row) {
+            for (int i = 0; i < segments; ++i) {
+                auto face = FaceHandle(i * ringCount + int(row));
+                if (row == 0) {
+                    mesh.setDirectFace(face, {UVPointHandle(bottom), UVPointHandle(vertex(0, i + 1)), UVPointHandle(vertex(0, i))},
+                                       {bottomEdge(i + 1), ringEdge(0, i), bottomEdge(i)}, material);
+                } else if (int(row) == ringCount - 1) {
+                    int ring = ringCount - 2;
+                    mesh.setDirectFace(face, {UVPointHandle(vertex(ring, i)), UVPointHandle(vertex(ring, i + 1)), UVPointHandle(top)},
+                                       {ringEdge(ring, i), topEdge(i + 1), topEdge(i)}, material);
+                } else {
+                    int ring = int(row) - 1;
+                    mesh.setDirectFace(face,
+                                       {UVPointHandle(vertex(ring, i)), UVPointHandle(vertex(ring, i + 1)),
+                                        UVPointHandle(vertex(ring + 1, i + 1)), UVPointHandle(vertex(ring + 1, i))},
+                                       {ringEdge(ring, i), verticalEdge(ring, i + 1), ringEdge(ring + 1, i), verticalEdge(ring, i)}, material);
+                }
+            }
+        },
+        ringsPerBlock);
+
+    mesh.endDirectBuild();
+    return mesh;
+}
+
 } // namespace meshlib
@@ -6,6 +6,8 @@ namespace meshlib {
 class SphereBuilder {
   public:
     Mesh build() const;
+    // Same mesh as build(), written with closed-form connectivity in parallel (no duplicate checks)
+    Mesh buildDirect() const;
 
     glm::vec3 center{0};
     float radius{1};
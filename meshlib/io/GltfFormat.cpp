@@ -0,0 +1,344 @@
+#include "GltfFormat.hpp"
+#include "../algorithm/Triangulate.hpp"
+#include "../util/Instrumentation.hpp"
+#include "../util/Parallel.hpp"
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <unordered_map>
+
+namespace meshlib {
+
+namespace {
+
+constexpr uint32_t GlbMagic = 0x46546C67; // "glTF"
+constexpr uint32_t JsonChunkType = 0x4E4F534A;
+constexpr uint32_t BinChunkType = 0x004E4942;
+constexpr uint32_t ArrayBufferTarget = 34962;
+constexpr uint32_t ElementArrayBufferTarget = 34963;
+constexpr uint32_t FloatComponent = 5126;
+constexpr uint32_t UnsignedIntComponent = 5125;
+// bytes passed to the output at a time
+constexpr size_t BlockSize = 1 << 20;
+
+bool isBigEndianHost() {
+    const uint16_t one = 1;
+    uint8_t firstByte;
+    std::memcpy(&firstByte, &one, 1);
+    return firstByte == 0;
+}
+
+template <typename T>
+void storeLittleEndian(char *p, T value) {
+    std::memcpy(p, &value, sizeof(T));
+    if (isBigEndianHost()) {
+        std::reverse(p, p + sizeof(T));
+    }
+}
+
+struct GltfPrimitive {
+    MaterialHandle material;
+    // glTF vertex i is uvPoints[i]
+    std::vector<UVPointHandle> uvPoints;
+    std::vector<FaceHandle> faces;
+    size_t indexCount = 0;
+    glm::vec3 min{std::numeric_limits<float>::max()};
+    glm::vec3 max{std::numeric_limits<float>::lowest()};
+
+    size_t positionBytes() const { return uvPoints.size() * sizeof(glm::vec3); }
+    size_t uvBytes() const { return uvPoints.size() * sizeof(glm::vec2); }
+    size_t indexBytes() const { return indexCount * sizeof(uint32_t); }
+    size_t bytes() const { return positionBytes() + uvBytes() + indexBytes(); }
+};
+
+// The primitives of a mesh in order of first use of their material, and the glTF vertex of each uvPoint in them.
+// Most uvPoints are in one primitive; the others are looked up in a map.
+class GltfLayout {
+  public:
+    std::vector<GltfPrimitive> primitives;
+
+    explicit GltfLayout(const Mesh &mesh)
+        : _mesh(mesh), _vertexIndices(mesh.allUVPointCount(), -1), _vertexPrimitives(mesh.allUVPointCount(), -1) {
+        std::map<MaterialHandle, int32_t> materialPrimitives;
+        int32_t primitive = -1;
+        for (auto f : mesh.faces()) {
+            auto &uvPoints = mesh.uvPoints(f);
+            if (uvPoints.size() < 3) {
+                continue;
+            }
+            auto material = mesh.material(f);
+            if (primitive < 0 || primitives[primitive].material != material) {
+                auto [found, inserted] = materialPrimitives.emplace(material, int32_t(primitives.size()));
+                if (inserted) {
+                    primitives.emplace_back().material = material;
+                }
+                primitive = found->second;
+            }
+            primitives[primitive].faces.push_back(f);
+            primitives[primitive].indexCount += (uvPoints.size() - 2) * 3;
+            for (auto uv : uvPoints) {
+                if (vertexIndex(uv, primitive) < 0) {
+                    addVertex(uv, primitive);
+                }
+            }
+        }
+    }
+
+    // -1 if the uvPoint is not in the primitive
+    int32_t vertexIndex(UVPointHandle uv, int32_t primitive) const {
+        if (_vertexPrimitives[uv.index] == primitive) {
+            return _vertexIndices[uv.index];
+        }
+        if (_vertexPrimitives[uv.index] < 0) {
+            return -1;
+        }
+        auto found = _otherVertexIndices.find(key(uv, primitive));
+        return found == _otherVertexIndices.end() ? -1 : found->second;
+    }
+
+  private:
+    const Mesh &_mesh;
+    std::vector<int32_t> _vertexIndices;
+    std::vector<int32_t> _vertexPrimitives;
+    std::unordered_map<uint64_t, int32_t> _otherVertexIndices;
+
+    static uint64_t key(UVPointHandle uv, int32_t primitive) { return uint64_t(uint32_t(uv.index)) << 32 | uint32_t(primitive); }
+
+    void addVertex(UVPointHandle uv, int32_t primitive) {
+        auto &data = primitives[primitive];
+        auto index = int32_t(data.uvPoints.size());
+        data.uvPoints.push_back(uv);
+        if (_vertexPrimitives[uv.index] < 0) {
+            _vertexPrimitives[uv.index] = primitive;
+            _vertexIndices[uv.index] = index;
+        } else {
+            _otherVertexIndices.emplace(key(uv, primitive), index);
+        }
+        auto position = _mesh.position(_mesh.vertex(uv));
+        data.min = glm::min(data.min, position);
+        data.max = glm::max(data.max, position);
+    }
+};
+
+template <typename T>
+void appendNumber(std::string &text, T value) {
+    char buffer[32];
+    auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    text.append(buffer, result.ptr);
+}
+
+void appendVector(std::string &text, glm::vec3 value) {
+    text += '[';
+    for (int i = 0; i < 3; ++i) {
+        if (i > 0) {
+            text += ',';
+        }
+        appendNumber(text, value[i]);
+    }
+    text += ']';
+}
+
+// The JSON chunk; bufferViews and accessors are positions, uvs and indices of each primitive in turn
+std::string gltfJson(const GltfLayout &layout, size_t binSize) {
+    std::string json = R"({"asset":{"version":"2.0","generator":"meshlib"},"scene":0,)";
+    if (layout.primitives.empty()) {
+        json += R"("scenes":[{}]})";
+        return json;
+    }
+    json += R"("scenes":[{"nodes":[0]}],"nodes":[{"mesh":0}],"meshes":[{"primitives":[)";
+    for (size_t p = 0; p < layout.primitives.size(); ++p) {
+        json += p > 0 ? "," : "";
+        json += R"({"attributes":{"POSITION":)";
+        appendNumber(json, 3 * p);
+        json += R"(,"TEXCOORD_0":)";
+        appendNumber(json, 3 * p + 1);
+        json += R"(},"indices":)";
+        appendNumber(json, 3 * p + 2);
+        json += R"(,"material":)";
+        appendNumber(json, p);
+        json += '}';
+    }
+    json += R"(]}],"materials":[)";
+    for (size_t p = 0; p < layout.primitives.size(); ++p) {
+        json += p > 0 ? "," : "";
+        json += R"({"name":"material)";
+        appendNumber(json, layout.primitives[p].material.index);
+        json += R"("})";
+    }
+    json += R"(],"buffers":[{"byteLength":)";
+    appendNumber(json, binSize);
+    json += R"(}],"bufferViews":[)";
+    size_t offset = 0;
+    auto appendView = [&](size_t length, uint32_t target) {
+        json += offset > 0 ? "," : "";
+        json += R"({"buffer":0,"byteOffset":)";
+        appendNumber(json, offset);
+        json += R"(,"byteLength":)";
+        appendNumber(json, length);
+        json += R"(,"target":)";
+        appendNumber(json, target);
+        json += '}';
+        offset += length;
+    };
+    for (auto &primitive : layout.primitives) {
+        appendView(primitive.positionBytes(), ArrayBufferTarget);
+        appendView(primitive.uvBytes(), ArrayBufferTarget);
+        appendView(primitive.indexBytes(), ElementArrayBufferTarget);
+    }
+    json += R"(],"accessors":[)";
+    for (size_t p = 0; p < layout.primitives.size(); ++p) {
+        auto &primitive = layout.primitives[p];
+        json += p > 0 ? "," : "";
+        json += R"({"bufferView":)";
+        appendNumber(json, 3 * p);
+        json += R"(,"componentType":)";
+        appendNumber(json, FloatComponent);
+        json += R"(,"count":)";
+        appendNumber(json, primitive.uvPoints.size());
+        json += R"(,"type":"VEC3","min":)";
+        appendVector(json, primitive.min);
+        json += R"(,"max":)";
+        appendVector(json, primitive.max);
+        json += R"(},{"bufferView":)";
+        appendNumber(json, 3 * p + 1);
+        json += R"(,"componentType":)";
+        appendNumber(json, FloatComponent);
+        json += R"(,"count":)";
+        appendNumber(json, primitive.uvPoints.size());
+        json += R"(,"type":"VEC2"},{"bufferView":)";
+        appendNumber(json, 3 * p + 2);
+        json += R"(,"componentType":)";
+        appendNumber(json, UnsignedIntComponent);
+        json += R"(,"count":)";
+        appendNumber(json, primitive.indexCount);
+        json += R"(,"type":"SCALAR"})";
+    }
+    json += "]}";
+    return json;
+}
+
+// Collects output in a block and passes it on to write(const char *, size_t) when full
+template <typename TWrite>
+class BlockWriter {
+  public:
+    explicit BlockWriter(TWrite &write) : _write(write), _block(BlockSize) {}
+
+    // room for size <= BlockSize bytes
+    char *reserve(size_t size) {
+        if (_size + size > _block.size()) {
+            flush();
+        }
+        char *p = _block.data() + _size;
+        _size += size;
+        return p;
+    }
+
+    // count items of itemSize bytes, filled in parallel by fill(i, p)
+    template <typename TFill>
+    void items(size_t count, size_t itemSize, TFill &&fill) {
+        size_t blockItems = BlockSize / itemSize;
+        for (size_t begin = 0; begin < count; begin += blockItems) {
+            size_t end = std::min(count, begin + blockItems);
+            char *p = reserve((end - begin) * itemSize);
+            parallelFor(begin, end, [&](size_t i) { fill(i, p + (i - begin) * itemSize); });
+        }
+    }
+
+    // false if a write failed
+    bool flush() {
+        if (_size > 0) {
+            _ok = _ok && _write(_block.data(), _size);
+            _size = 0;
+        }
+        return _ok;
+    }
+
+  private:
+    TWrite &_write;
+    std::vector<char> _block;
+    size_t _size = 0;
+    bool _ok = true;
+};
+
+template <typename TWrite>
+bool streamGLB(const Mesh &mesh, TWrite &&write) {
+    MESHLIB_SCOPED_OPERATION("writeGLB");
+    GltfLayout layout(mesh);
+    size_t binSize = 0;
+    for (auto &primitive : layout.primitives) {
+        binSize += primitive.bytes();
+    }
+    auto json = gltfJson(layout, binSize);
+    // chunks are 4 byte aligned; JSON is padded with spaces, the buffers are multiples of 4 bytes already
+    json.resize((json.size() + 3) / 4 * 4, ' ');
+
+    BlockWriter<std::remove_reference_t<TWrite>> writer(write);
+    char *header = writer.reserve(20);
+    storeLittleEndian(header, GlbMagic);
+    storeLittleEndian(header + 4, uint32_t(2));
+    storeLittleEndian(header + 8, uint32_t(20 + json.size() + (binSize > 0 ? 8 + binSize : 0)));
+    storeLittleEndian(header + 12, uint32_t(json.size()));
+    storeLittleEndian(header + 16, JsonChunkType);
+    writer.flush();
+    if (!write(json.data(), json.size())) {
+        return false;
+    }
+    if (binSize == 0) {
+        return true;
+    }
+    char *binHeader = writer.reserve(8);
+    storeLittleEndian(binHeader, uint32_t(binSize));
+    storeLittleEndian(binHeader + 4, BinChunkType);
+
+    for (size_t p = 0; p < layout.primitives.size(); ++p) {
+        auto &primitive = layout.primitives[p];
+        writer.items(primitive.uvPoints.size(), sizeof(glm::vec3), [&](size_t i, char *out) {
+            auto position = mesh.position(mesh.vertex(primitive.uvPoints[i]));
+            for (int k = 0; k < 3; ++k) {
+                storeLittleEndian(out + k * sizeof(float), position[k]);
+            }
+        });
+        writer.items(primitive.uvPoints.size(), sizeof(glm::vec2), [&](size_t i, char *out) {
+            auto uv = mesh.uvPosition(primitive.uvPoints[i]);
+            storeLittleEndian(out, uv.x);
+            storeLittleEndian(out + sizeof(float), 1.0f - uv.y);
+        });
+        SmallVector<UVPointHandle, 18> triangles;
+        for (auto f : primitive.faces) {
+            triangles.resize(3 * (mesh.vertexCount(f) - 2));
+            triangulateFace(mesh, f, triangles.data());
+            for (size_t t = 0; t < triangles.size(); t += 3) {
+                char *out = writer.reserve(3 * sizeof(uint32_t));
+                for (size_t k = 0; k < 3; ++k) {
+                    storeLittleEndian(out + k * sizeof(uint32_t), uint32_t(layout.vertexIndex(triangles[t + k], int32_t(p))));
+                }
+            }
+        }
+    }
+    return writer.flush();
+}
+
+} // namespace
+
+std::string writeGLB(const Mesh &mesh) {
+    std::string data;
+    streamGLB(mesh, [&](const char *p, size_t size) {
+        data.append(p, size);
+        return true;
+    });
+    return data;
+}
+
+bool writeGLB(const Mesh &mesh, std::ostream &stream) {
+    return streamGLB(mesh, [&](const char *p, size_t size) { return bool(stream.write(p, std::streamsize(size))); });
+}
+
+bool writeGLBFile(const Mesh &mesh, const std::string &path) {
+    std::ofstream file(path, std::ios::binary);
+    return writeGLB(mesh, file);
+}
+
+} // namespace meshlib
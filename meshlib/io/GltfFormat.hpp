@@ -0,0 +1,18 @@
+#pragma once
+#include "../Mesh.hpp"
+#include <ostream>
+#include <string>
+
+namespace meshlib {
+
+// Binary glTF 2.0 (.glb) with one primitive per material. The uvPoints of the faces become the glTF vertices, so they
+// are split at uv seams and, where a uvPoint is used by several materials, per material. Faces are split into
+// triangles by triangulateFace().
+// Each primitive has float POSITION and TEXCOORD_0 and uint32 indices; v is flipped, as glTF uvs start at the top left.
+// Materials are named "material<index>" as in writeOBJ().
+std::string writeGLB(const Mesh &mesh);
+// Streams the buffers in blocks instead of building the whole output first; false on a write error
+bool writeGLB(const Mesh &mesh, std::ostream &stream);
+bool writeGLBFile(const Mesh &mesh, const std::string &path);
+
+} // namespace meshlib
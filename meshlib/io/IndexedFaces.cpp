@@ -0,0 +1,217 @@
+#include "IndexedFaces.hpp"
+#include "../util/Instrumentation.hpp"
+#include "../util/Parallel.hpp"
+#include <fstream>
+
+namespace meshlib {
+
+namespace {
+
+// Groups items by key with a counting sort; the items of each key stay in ascending order
+class Buckets {
+  public:
+    template <typename TKey>
+    Buckets(size_t keyCount, size_t itemCount, TKey &&key) : _offsets(keyCount + 1, 0), _items(itemCount) {
+        for (size_t i = 0; i < itemCount; ++i) {
+            ++_offsets[key(i) + 1];
+        }
+        for (size_t k = 0; k < keyCount; ++k) {
+            _offsets[k + 1] += _offsets[k];
+        }
+        std::vector<int32_t> positions(_offsets.begin(), _offsets.end() - 1);
+        for (size_t i = 0; i < itemCount; ++i) {
+            _items[positions[key(i)]++] = int32_t(i);
+        }
+    }
+
+    const int32_t *begin(size_t key) const { return _items.data() + _offsets[key]; }
+    const int32_t *end(size_t key) const { return _items.data() + _offsets[key + 1]; }
+
+  private:
+    std::vector<int32_t> _offsets;
+    std::vector<int32_t> _items;
+};
+
+// turns per-key counts, stored at offsets[key + 1], into the first index of each key
+void accumulate(std::vector<int32_t> &offsets) {
+    for (size_t i = 1; i < offsets.size(); ++i) {
+        offsets[i] += offsets[i - 1];
+    }
+}
+
+} // namespace
+
+Mesh IndexedFaces::toMesh() const {
+    MESHLIB_SCOPED_OPERATION("IndexedFaces::toMesh");
+    size_t vertexCount = positions.size();
+    size_t faceCount = faceVertexCounts.size();
+    size_t cornerCount = cornerVertices.size();
+
+    std::vector<int32_t> faceOffsets(faceCount + 1, 0);
+    for (size_t f = 0; f < faceCount; ++f) {
+        faceOffsets[f + 1] = faceOffsets[f] + faceVertexCounts[f];
+    }
+
+    auto cornerUV = [&](size_t corner) {
+        int32_t uv = cornerUVs.empty() ? -1 : cornerUVs[corner];
+        return uv >= 0 ? uvPositions[uv] : glm::vec2(0);
+    };
+
+    // uvPoints: the corners of each vertex with the same uv position share one, numbered in order of first use
+    Buckets vertexCorners(vertexCount, cornerCount, [&](size_t corner) { return cornerVertices[corner]; });
+    std::vector<UVPointHandle> cornerUVPoints(cornerCount);
+    std::vector<int32_t> uvPointOffsets(vertexCount + 1, 0);
+    parallelFor(0, vertexCount, [&](size_t v) {
+        SmallVector<glm::vec2, 8> distinctUVs;
+        for (auto corner = vertexCorners.begin(v); corner != vertexCorners.end(v); ++corner) {
+            auto uv = cornerUV(*corner);
+            auto found = std::find(distinctUVs.begin(), distinctUVs.end(), uv);
+            cornerUVPoints[*corner].index = int(found - distinctUVs.begin());
+            if (found == distinctUVs.end()) {
+                distinctUVs.push_back(uv);
+            }
+        }
+        uvPointOffsets[v + 1] = int32_t(distinctUVs.size());
+    });
+    accumulate(uvPointOffsets);
+    size_t uvPointCount = size_t(uvPointOffsets.back());
+    std::vector<VertexHandle> uvPointVertices(uvPointCount);
+    std::vector<glm::vec2> uvPointPositions(uvPointCount);
+    parallelFor(0, vertexCount, [&](size_t v) {
+        for (auto corner = vertexCorners.begin(v); corner != vertexCorners.end(v); ++corner) {
+            auto &uvPoint = cornerUVPoints[*corner];
+            uvPoint.index += uvPointOffsets[v];
+            uvPointVertices[uvPoint.index] = VertexHandle(int(v));
+            uvPointPositions[uvPoint.index] = cornerUV(*corner);
+        }
+    });
+
+    // edges: side i of a face runs from corner i to corner i + 1; sides are grouped by their lower vertex
+    std::vector<int32_t> sideEnds(cornerCount);
+    parallelFor(0, faceCount, [&](size_t f) {
+        int32_t begin = faceOffsets[f];
+        int32_t end = faceOffsets[f + 1];
+        for (int32_t corner = begin; corner < end; ++corner) {
+            sideEnds[corner] = cornerVertices[corner + 1 < end ? corner + 1 : begin];
+        }
+    });
+    Buckets vertexSides(vertexCount, cornerCount,
+                        [&](size_t side) { return std::min(cornerVertices[side], sideEnds[side]); });
+    std::vector<EdgeHandle> sideEdges(cornerCount);
+    std::vector<int32_t> edgeOffsets(vertexCount + 1, 0);
+    parallelFor(0, vertexCount, [&](size_t v) {
+        SmallVector<int32_t, 8> otherVertices;
+        for (auto side = vertexSides.begin(v); side != vertexSides.end(v); ++side) {
+            int32_t other = std::max(cornerVertices[*side], sideEnds[*side]);
+            auto found = std::find(otherVertices.begin(), otherVertices.end(), other);
+            sideEdges[*side].index = int(found - otherVertices.begin());
+            if (found == otherVertices.end()) {
+                otherVertices.push_back(other);
+            }
+        }
+        edgeOffsets[v + 1] = int32_t(otherVertices.size());
+    });
+    accumulate(edgeOffsets);
+    size_t edgeCount = size_t(edgeOffsets.back());
+    std::vector<std::array<VertexHandle, 2>> edgeVertices(edgeCount);
+    parallelFor(0, vertexCount, [&](size_t v) {
+        for (auto side = vertexSides.begin(v); side != vertexSides.end(v); ++side) {
+            auto &edge = sideEdges[*side];
+            edge.index += edgeOffsets[v];
+            // the first side of an edge sets its direction
+            if (edgeVertices[edge.index][0] == edgeVertices[edge.index][1]) {
+                edgeVertices[edge.index] = {VertexHandle(cornerVertices[*side]), VertexHandle(sideEnds[*side])};
+            }
+        }
+    });
+
+    Mesh mesh;
+    mesh.beginDirectBuild(vertexCount, uvPointCount, edgeCount, faceCount);
+    parallelFor(0, vertexCount, [&](size_t v) { mesh.setDirectVertex(VertexHandle(int(v)), positions[v]); });
+    parallelFor(0, uvPointCount, [&](size_t uv) {
+        mesh.setDirectUVPoint(UVPointHandle(int(uv)), uvPointVertices[uv], uvPointPositions[uv]);
+    });
+    parallelFor(0, edgeCount, [&](size_t e) { mesh.setDirectEdge(EdgeHandle(int(e)), edgeVertices[e]); });
+    parallelFor(0, faceCount, [&](size_t f) {
+        auto material = faceMaterials.empty() ? MaterialHandle() : MaterialHandle(faceMaterials[f]);
+        mesh.setDirectFace(FaceHandle(int(f)), cornerUVPoints.data() + faceOffsets[f], sideEdges.data() + faceOffsets[f],
+                           size_t(faceVertexCounts[f]), material);
+    });
+    mesh.endDirectBuild();
+    return mesh;
+}
+
+IndexedFaces IndexedFaces::fromMesh(const Mesh &mesh) {
+    MESHLIB_SCOPED_OPERATION("IndexedFaces::fromMesh");
+    IndexedFaces result;
+
+    std::vector<int32_t> newVertexIndices(mesh.allVertexCount(), -1);
+    for (auto v : mesh.vertices()) {
+        newVertexIndices[v.index] = int32_t(result.positions.size());
+        result.positions.push_back(mesh.position(v));
+    }
+    std::vector<int32_t> newUVPointIndices(mesh.allUVPointCount(), -1);
+    for (auto uv : mesh.uvPoints()) {
+        newUVPointIndices[uv.index] = int32_t(result.uvPositions.size());
+        result.uvPositions.push_back(mesh.uvPosition(uv));
+    }
+
+    for (auto f : mesh.faces()) {
+        auto &uvPoints = mesh.uvPoints(f);
+        result.faceVertexCounts.push_back(int32_t(uvPoints.size()));
+        result.faceMaterials.push_back(mesh.material(f).index);
+        for (auto uv : uvPoints) {
+            result.cornerVertices.push_back(newVertexIndices[mesh.vertex(uv).index]);
+            result.cornerUVs.push_back(newUVPointIndices[uv.index]);
+        }
+    }
+    return result;
+}
+
+std::string IndexedFaces::validate() const {
+    size_t cornerCount = 0;
+    for (size_t f = 0; f < faceVertexCounts.size(); ++f) {
+        if (faceVertexCounts[f] < 3) {
+            return "face " + std::to_string(f) + " has fewer than 3 corners";
+        }
+        cornerCount += size_t(faceVertexCounts[f]);
+    }
+    if (cornerCount != cornerVertices.size()) {
+        return "the faces have " + std::to_string(cornerCount) + " corners, but there are " + std::to_string(cornerVertices.size()) +
+               " corner vertices";
+    }
+    if (!cornerUVs.empty() && cornerUVs.size() != cornerCount) {
+        return "there are " + std::to_string(cornerUVs.size()) + " corner uvs for " + std::to_string(cornerCount) + " corners";
+    }
+    if (!faceMaterials.empty() && faceMaterials.size() != faceVertexCounts.size()) {
+        return "there are " + std::to_string(faceMaterials.size()) + " face materials for " + std::to_string(faceVertexCounts.size()) +
+               " faces";
+    }
+    for (size_t corner = 0; corner < cornerCount; ++corner) {
+        if (cornerVertices[corner] < 0 || size_t(cornerVertices[corner]) >= positions.size()) {
+            return "corner " + std::to_string(corner) + " refers to vertex " + std::to_string(cornerVertices[corner]) + " of " +
+                   std::to_string(positions.size());
+        }
+        if (!cornerUVs.empty() && (cornerUVs[corner] < -1 || cornerUVs[corner] >= int64_t(uvPositions.size()))) {
+            return "corner " + std::to_string(corner) + " refers to uv " + std::to_string(cornerUVs[corner]) + " of " +
+                   std::to_string(uvPositions.size());
+        }
+    }
+    return {};
+}
+
+namespace detail {
+
+bool readFile(const std::string &path, std::string &contents) {
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file) {
+        return false;
+    }
+    contents.resize(size_t(file.tellg()));
+    file.seekg(0);
+    return bool(file.read(contents.data(), std::streamsize(contents.size())));
+}
+
+} // namespace detail
+
+} // namespace meshlib
@@ -0,0 +1,49 @@
+#pragma once
+#include "../Mesh.hpp"
+#include <string>
+#include <vector>
+
+namespace meshlib {
+
+// Faces as file formats store them: corner lists indexing into shared position and uv arrays
+struct IndexedFaces {
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec2> uvPositions;
+
+    std::vector<int32_t> faceVertexCounts;
+    // empty if all faces have the default material
+    std::vector<int32_t> faceMaterials;
+
+    // corners of all faces, face by face
+    std::vector<int32_t> cornerVertices;
+    // index into uvPositions per corner, -1 for uv (0, 0); empty if no corner has a uv
+    std::vector<int32_t> cornerUVs;
+
+    // Builds the mesh with one uvPoint per vertex and distinct uv position of its corners and one edge per distinct
+    // vertex pair, in parallel and without per-face duplicate checks. Indices must be in range (see validate()).
+    Mesh toMesh() const;
+
+    // live elements of mesh, renumbered; each uvPoint becomes a uv position
+    static IndexedFaces fromMesh(const Mesh &mesh);
+
+    // empty if toMesh() can build a mesh, otherwise the first problem found
+    std::string validate() const;
+};
+
+// Result of the file readers; on error the mesh is empty
+struct MeshReadResult {
+    Mesh mesh;
+    // e.g. "line 12: vertex index 40 out of range"
+    std::string error;
+
+    bool isValid() const { return error.empty(); }
+};
+
+namespace detail {
+
+// reads the whole file into contents; false if it cannot be read
+bool readFile(const std::string &path, std::string &contents);
+
+} // namespace detail
+
+} // namespace meshlib
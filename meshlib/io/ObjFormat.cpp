@@ -0,0 +1,432 @@
+#include "ObjFormat.hpp"
+#include "../util/Instrumentation.hpp"
+#include "../util/Parallel.hpp"
+#include <charconv>
+#include <cstring>
+#include <fstream>
+#include <unordered_map>
+
+namespace meshlib {
+
+namespace {
+
+// text per parse task; smaller files are parsed on the calling thread
+constexpr size_t MinChunkSize = 1 << 20;
+// lines per write task
+constexpr size_t LinesPerBlock = 1 << 16;
+
+// What one chunk of lines defines. Indices are 1-based as in the file, 0 for a corner without uv; indices relative to
+// the end (negative in the file) are recorded separately since the chunk does not know what comes before it.
+struct ObjChunk {
+    struct RelativeIndex {
+        size_t corner;
+        // 0-based, counted from the start of the chunk; negative for elements of earlier chunks
+        int32_t index;
+    };
+    struct MaterialSwitch {
+        size_t face;
+        std::string_view name;
+    };
+
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec2> uvPositions;
+    std::vector<int32_t> faceVertexCounts;
+    std::vector<int32_t> cornerVertices;
+    std::vector<int32_t> cornerUVs;
+    std::vector<RelativeIndex> relativeVertices;
+    std::vector<RelativeIndex> relativeUVs;
+    std::vector<MaterialSwitch> materialSwitches;
+    bool hasUVs = false;
+
+    size_t lineCount = 0;
+    // the first problem, with its line number within the chunk
+    std::string error;
+    size_t errorLine = 0;
+};
+
+bool isSpace(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+
+const char *skipSpaces(const char *p, const char *end) {
+    while (p < end && isSpace(*p)) {
+        ++p;
+    }
+    return p;
+}
+
+bool startsWord(const char *p, const char *end, std::string_view word) {
+    return size_t(end - p) > word.size() && std::memcmp(p, word.data(), word.size()) == 0 && isSpace(p[word.size()]);
+}
+
+template <typename T>
+bool parseNumber(const char *&p, const char *end, T &value) {
+    p = skipSpaces(p, end);
+    // from_chars does not take a leading plus
+    if (p < end && *p == '+') {
+        ++p;
+    }
+    auto result = std::from_chars(p, end, value);
+    if (result.ec != std::errc()) {
+        return false;
+    }
+    p = result.ptr;
+    return true;
+}
+
+class ObjChunkParser {
+  public:
+    explicit ObjChunkParser(ObjChunk &chunk) : _chunk(chunk) {}
+
+    void parse(const char *p, const char *end) {
+        while (p < end && _chunk.error.empty()) {
+            auto lineEnd = static_cast<const char *>(std::memchr(p, '\n', size_t(end - p)));
+            if (!lineEnd) {
+                lineEnd = end;
+            }
+            parseLine(p, lineEnd);
+            ++_chunk.lineCount;
+            p = lineEnd + 1;
+        }
+    }
+
+  private:
+    void fail(std::string message) {
+        _chunk.error = std::move(message);
+        _chunk.errorLine = _chunk.lineCount;
+    }
+
+    void parseLine(const char *p, const char *end) {
+        p = skipSpaces(p, end);
+        if (startsWord(p, end, "v")) {
+            glm::vec3 position;
+            p += 1;
+            if (!parseNumber(p, end, position.x) || !parseNumber(p, end, position.y) || !parseNumber(p, end, position.z)) {
+                return fail("invalid vertex position");
+            }
+            _chunk.positions.push_back(position);
+        } else if (startsWord(p, end, "vt")) {
+            glm::vec2 uv(0);
+            p += 2;
+            if (!parseNumber(p, end, uv.x)) {
+                return fail("invalid uv position");
+            }
+            // v is optional
+            parseNumber(p, end, uv.y);
+            _chunk.uvPositions.push_back(uv);
+        } else if (startsWord(p, end, "f")) {
+            parseFace(p + 1, end);
+        } else if (startsWord(p, end, "usemtl")) {
+            p = skipSpaces(p + 6, end);
+            auto nameEnd = end;
+            while (nameEnd > p && isSpace(nameEnd[-1])) {
+                --nameEnd;
+            }
+            _chunk.materialSwitches.push_back({_chunk.faceVertexCounts.size(), std::string_view(p, size_t(nameEnd - p))});
+        }
+    }
+
+    // v, v/vt, v//vn or v/vt/vn per corner
+    void parseFace(const char *p, const char *end) {
+        size_t firstCorner = _chunk.cornerVertices.size();
+        size_t firstRelativeVertex = _chunk.relativeVertices.size();
+        size_t firstRelativeUV = _chunk.relativeUVs.size();
+        while (true) {
+            p = skipSpaces(p, end);
+            if (p == end) {
+                break;
+            }
+            int32_t vertex = 0;
+            int32_t uv = 0;
+            if (!parseNumber(p, end, vertex)) {
+                return fail("invalid face corner");
+            }
+            if (p < end && *p == '/') {
+                ++p;
+                if (p < end && *p != '/' && !parseNumber(p, end, uv)) {
+                    return fail("invalid face corner");
+                }
+                if (p < end && *p == '/') {
+                    ++p;
+                    int32_t normal;
+                    if (!parseNumber(p, end, normal)) {
+                        return fail("invalid face corner");
+                    }
+                }
+            }
+            if (vertex == 0) {
+                return fail("vertex index 0 in face");
+            }
+            size_t corner = _chunk.cornerVertices.size();
+            if (vertex < 0) {
+                _chunk.relativeVertices.push_back({corner, int32_t(_chunk.positions.size()) + vertex});
+            }
+            if (uv < 0) {
+                _chunk.relativeUVs.push_back({corner, int32_t(_chunk.uvPositions.size()) + uv});
+            }
+            _chunk.hasUVs = _chunk.hasUVs || uv != 0;
+            _chunk.cornerVertices.push_back(vertex);
+            _chunk.cornerUVs.push_back(uv);
+        }
+        size_t count = _chunk.cornerVertices.size() - firstCorner;
+        if (count < 3) {
+            _chunk.cornerVertices.resize(firstCorner);
+            _chunk.cornerUVs.resize(firstCorner);
+            _chunk.relativeVertices.resize(firstRelativeVertex);
+            _chunk.relativeUVs.resize(firstRelativeUV);
+            return;
+        }
+        _chunk.faceVertexCounts.push_back(int32_t(count));
+    }
+
+    ObjChunk &_chunk;
+};
+
+// chunk boundaries at line starts, roughly evenly spaced
+std::vector<size_t> splitLines(std::string_view text) {
+    size_t chunkCount = std::max<size_t>(1, std::min(concurrencyLimit() * 4, text.size() / MinChunkSize));
+    std::vector<size_t> bounds{0};
+    for (size_t i = 1; i < chunkCount; ++i) {
+        size_t bound = text.find('\n', std::max(bounds.back(), i * text.size() / chunkCount));
+        if (bound == std::string_view::npos) {
+            break;
+        }
+        bounds.push_back(bound + 1);
+    }
+    bounds.push_back(text.size());
+    return bounds;
+}
+
+// Moves the chunks into faces; returns the first index out of range
+std::string mergeChunks(std::vector<ObjChunk> &chunks, IndexedFaces &faces) {
+    struct Offsets {
+        size_t vertex = 0;
+        size_t uv = 0;
+        size_t face = 0;
+        size_t corner = 0;
+    };
+    std::vector<Offsets> offsets(chunks.size() + 1);
+    bool hasUVs = false;
+    for (size_t i = 0; i < chunks.size(); ++i) {
+        offsets[i + 1].vertex = offsets[i].vertex + chunks[i].positions.size();
+        offsets[i + 1].uv = offsets[i].uv + chunks[i].uvPositions.size();
+        offsets[i + 1].face = offsets[i].face + chunks[i].faceVertexCounts.size();
+        offsets[i + 1].corner = offsets[i].corner + chunks[i].cornerVertices.size();
+        hasUVs = hasUVs || chunks[i].hasUVs;
+    }
+    auto &total = offsets.back();
+
+    // material handles in order of first use from 1; faces before the first "usemtl" keep the default handle 0
+    std::unordered_map<std::string_view, int32_t> materialIndices;
+    std::vector<int32_t> chunkMaterials(chunks.size() + 1, MaterialHandle().index);
+    for (size_t i = 0; i < chunks.size(); ++i) {
+        chunkMaterials[i + 1] = chunkMaterials[i];
+        for (auto &materialSwitch : chunks[i].materialSwitches) {
+            auto inserted = materialIndices.emplace(materialSwitch.name, int32_t(materialIndices.size()) + 1);
+            chunkMaterials[i + 1] = inserted.first->second;
+        }
+    }
+    bool hasMaterials = !materialIndices.empty();
+
+    faces.positions.resize(total.vertex);
+    faces.uvPositions.resize(total.uv);
+    faces.faceVertexCounts.resize(total.face);
+    faces.faceMaterials.resize(hasMaterials ? total.face : 0);
+    faces.cornerVertices.resize(total.corner);
+    faces.cornerUVs.resize(hasUVs ? total.corner : 0);
+
+    std::vector<std::string> errors(chunks.size());
+    parallelFor(
+        0, chunks.size(),
+        [&](size_t i) {
+            auto &chunk = chunks[i];
+            auto &offset = offsets[i];
+            std::copy(chunk.positions.begin(), chunk.positions.end(), faces.positions.begin() + offset.vertex);
+            std::copy(chunk.uvPositions.begin(), chunk.uvPositions.end(), faces.uvPositions.begin() + offset.uv);
+            std::copy(chunk.faceVertexCounts.begin(), chunk.faceVertexCounts.end(), faces.faceVertexCounts.begin() + offset.face);
+
+            if (hasMaterials) {
+                int32_t material = chunkMaterials[i];
+                size_t face = 0;
+                for (auto &materialSwitch : chunk.materialSwitches) {
+                    std::fill(faces.faceMaterials.begin() + offset.face + face, faces.faceMaterials.begin() + offset.face + materialSwitch.face,
+                              material);
+                    face = materialSwitch.face;
+                    material = materialIndices.at(materialSwitch.name);
+                }
+                std::fill(faces.faceMaterials.begin() + offset.face + face, faces.faceMaterials.begin() + offset.face + chunk.faceVertexCounts.size(),
+                          material);
+            }
+
+            for (auto &relative : chunk.relativeVertices) {
+                chunk.cornerVertices[relative.corner] = int32_t(offset.vertex) + relative.index + 1;
+            }
+            for (auto &relative : chunk.relativeUVs) {
+                chunk.cornerUVs[relative.corner] = int32_t(offset.uv) + relative.index + 1;
+            }
+            for (size_t corner = 0; corner < chunk.cornerVertices.size(); ++corner) {
+                int32_t vertex = chunk.cornerVertices[corner];
+                int32_t uv = chunk.cornerUVs[corner];
+                if (vertex < 1 || size_t(vertex) > total.vertex) {
+                    errors[i] = "vertex index " + std::to_string(vertex) + " out of range, there are " + std::to_string(total.vertex);
+                    return;
+                }
+                if (uv < 0 || size_t(uv) > total.uv) {
+                    errors[i] = "uv index " + std::to_string(uv) + " out of range, there are " + std::to_string(total.uv);
+                    return;
+                }
+                faces.cornerVertices[offset.corner + corner] = vertex - 1;
+                if (hasUVs) {
+                    faces.cornerUVs[offset.corner + corner] = uv - 1;
+                }
+            }
+        },
+        1);
+
+    for (auto &error : errors) {
+        if (!error.empty()) {
+            return error;
+        }
+    }
+    return {};
+}
+
+// appends the shortest text that reads back as value
+template <typename T>
+void appendNumber(std::string &text, T value) {
+    char buffer[32];
+    auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    text.append(buffer, result.ptr);
+}
+
+// calls format(begin, end, text) for blocks of lineCount lines in parallel and returns the texts in order
+template <typename TFormat>
+std::vector<std::string> formatBlocks(size_t lineCount, TFormat &&format) {
+    std::vector<std::string> blocks((lineCount + LinesPerBlock - 1) / LinesPerBlock);
+    parallelFor(
+        0, blocks.size(),
+        [&](size_t block) {
+            size_t begin = block * LinesPerBlock;
+            format(begin, std::min(lineCount, begin + LinesPerBlock), blocks[block]);
+        },
+        1);
+    return blocks;
+}
+
+std::vector<std::string> formatOBJ(const Mesh &mesh) {
+    auto faces = IndexedFaces::fromMesh(mesh);
+    std::vector<size_t> faceOffsets(faces.faceVertexCounts.size() + 1, 0);
+    for (size_t f = 0; f < faces.faceVertexCounts.size(); ++f) {
+        faceOffsets[f + 1] = faceOffsets[f] + size_t(faces.faceVertexCounts[f]);
+    }
+
+    std::vector<std::string> blocks{"# meshlib\n"};
+    auto append = [&](std::vector<std::string> &&newBlocks) {
+        blocks.insert(blocks.end(), std::make_move_iterator(newBlocks.begin()), std::make_move_iterator(newBlocks.end()));
+    };
+    append(formatBlocks(faces.positions.size(), [&](size_t begin, size_t end, std::string &text) {
+        for (size_t v = begin; v < end; ++v) {
+            auto &position = faces.positions[v];
+            text += "v ";
+            appendNumber(text, position.x);
+            text += ' ';
+            appendNumber(text, position.y);
+            text += ' ';
+            appendNumber(text, position.z);
+            text += '\n';
+        }
+    }));
+    append(formatBlocks(faces.uvPositions.size(), [&](size_t begin, size_t end, std::string &text) {
+        for (size_t uv = begin; uv < end; ++uv) {
+            text += "vt ";
+            appendNumber(text, faces.uvPositions[uv].x);
+            text += ' ';
+            appendNumber(text, faces.uvPositions[uv].y);
+            text += '\n';
+        }
+    }));
+    append(formatBlocks(faces.faceVertexCounts.size(), [&](size_t begin, size_t end, std::string &text) {
+        for (size_t f = begin; f < end; ++f) {
+            int32_t material = faces.faceMaterials[f];
+            if (material != (f > 0 ? faces.faceMaterials[f - 1] : 0)) {
+                text += "usemtl material";
+                appendNumber(text, material);
+                text += '\n';
+            }
+            text += 'f';
+            for (size_t corner = faceOffsets[f]; corner < faceOffsets[f + 1]; ++corner) {
+                text += ' ';
+                appendNumber(text, faces.cornerVertices[corner] + 1);
+                text += '/';
+                appendNumber(text, faces.cornerUVs[corner] + 1);
+            }
+            text += '\n';
+        }
+    }));
+    return blocks;
+}
+
+} // namespace
+
+MeshReadResult readOBJ(std::string_view text) {
+    MESHLIB_SCOPED_OPERATION("readOBJ");
+    auto bounds = splitLines(text);
+    std::vector<ObjChunk> chunks(bounds.size() - 1);
+    parallelFor(
+        0, chunks.size(),
+        [&](size_t i) { ObjChunkParser(chunks[i]).parse(text.data() + bounds[i], text.data() + bounds[i + 1]); },
+        1);
+
+    MeshReadResult result;
+    size_t lineOffset = 1;
+    for (auto &chunk : chunks) {
+        if (!chunk.error.empty()) {
+            result.error = "line " + std::to_string(lineOffset + chunk.errorLine) + ": " + chunk.error;
+            return result;
+        }
+        lineOffset += chunk.lineCount;
+    }
+
+    IndexedFaces faces;
+    result.error = mergeChunks(chunks, faces);
+    if (!result.isValid()) {
+        return result;
+    }
+    chunks.clear();
+    result.mesh = faces.toMesh();
+    return result;
+}
+
+MeshReadResult readOBJFile(const std::string &path) {
+    std::string text;
+    if (!detail::readFile(path, text)) {
+        MeshReadResult result;
+        result.error = "cannot read " + path;
+        return result;
+    }
+    return readOBJ(text);
+}
+
+std::string writeOBJ(const Mesh &mesh) {
+    MESHLIB_SCOPED_OPERATION("writeOBJ");
+    auto blocks = formatOBJ(mesh);
+    size_t size = 0;
+    for (auto &block : blocks) {
+        size += block.size();
+    }
+    std::string text;
+    text.reserve(size);
+    for (auto &block : blocks) {
+        text += block;
+    }
+    return text;
+}
+
+bool writeOBJFile(const Mesh &mesh, const std::string &path) {
+    MESHLIB_SCOPED_OPERATION("writeOBJ");
+    std::ofstream file(path, std::ios::binary);
+    for (auto &block : formatOBJ(mesh)) {
+        file.write(block.data(), std::streamsize(block.size()));
+    }
+    return bool(file);
+}
+
+} // namespace meshlib
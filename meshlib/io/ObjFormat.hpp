@@ -0,0 +1,21 @@
+#pragma once
+#include "IndexedFaces.hpp"
+#include <string>
+#include <string_view>
+
+namespace meshlib {
+
+// Wavefront OBJ. Reading maps "v" lines to vertices, "vt" lines to uv positions and the distinct uv positions that a
+// vertex has in the "f" lines to its uvPoints (see IndexedFaces::toMesh()). "usemtl" switches to the material handle
+// of the name in order of first use, starting at 1; faces before the first "usemtl" keep the default handle 0.
+// Normals, groups, lines and material libraries are ignored, as are faces with fewer than 3 corners. Large files are
+// parsed in parallel chunks.
+MeshReadResult readOBJ(std::string_view text);
+MeshReadResult readOBJFile(const std::string &path);
+
+// The live elements with one "vt" per uvPoint and "usemtl material<index>" where the material changes
+std::string writeOBJ(const Mesh &mesh);
+// false if the file cannot be written
+bool writeOBJFile(const Mesh &mesh, const std::string &path);
+
+} // namespace meshlib
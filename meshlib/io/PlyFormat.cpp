@@ -0,0 +1,507 @@
+#include "PlyFormat.hpp"
+#include "../util/Instrumentation.hpp"
+#include "../util/Parallel.hpp"
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+
+namespace meshlib {
+
+namespace {
+
+enum class PlyType { Int8, UInt8, Int16, UInt16, Int32, UInt32, Float32, Float64 };
+
+bool parseType(const std::string &name, PlyType &type) {
+    static const std::pair<const char *, PlyType> names[] = {
+        {"char", PlyType::Int8},     {"int8", PlyType::Int8},       {"uchar", PlyType::UInt8},   {"uint8", PlyType::UInt8},
+        {"short", PlyType::Int16},   {"int16", PlyType::Int16},     {"ushort", PlyType::UInt16}, {"uint16", PlyType::UInt16},
+        {"int", PlyType::Int32},     {"int32", PlyType::Int32},     {"uint", PlyType::UInt32},   {"uint32", PlyType::UInt32},
+        {"float", PlyType::Float32}, {"float32", PlyType::Float32}, {"double", PlyType::Float64}, {"float64", PlyType::Float64},
+    };
+    for (auto &[typeName, value] : names) {
+        if (name == typeName) {
+            type = value;
+            return true;
+        }
+    }
+    return false;
+}
+
+size_t typeSize(PlyType type) {
+    switch (type) {
+    case PlyType::Int8:
+    case PlyType::UInt8:
+        return 1;
+    case PlyType::Int16:
+    case PlyType::UInt16:
+        return 2;
+    case PlyType::Int32:
+    case PlyType::UInt32:
+    case PlyType::Float32:
+        return 4;
+    case PlyType::Float64:
+        return 8;
+    }
+    return 0;
+}
+
+bool isBigEndianHost() {
+    const uint16_t one = 1;
+    uint8_t firstByte;
+    std::memcpy(&firstByte, &one, 1);
+    return firstByte == 0;
+}
+
+template <typename T>
+T load(const char *p, bool swap) {
+    std::array<char, sizeof(T)> bytes;
+    std::memcpy(bytes.data(), p, sizeof(T));
+    if (swap) {
+        std::reverse(bytes.begin(), bytes.end());
+    }
+    T value;
+    std::memcpy(&value, bytes.data(), sizeof(T));
+    return value;
+}
+
+template <typename T>
+void store(char *p, T value, bool swap) {
+    std::array<char, sizeof(T)> bytes;
+    std::memcpy(bytes.data(), &value, sizeof(T));
+    if (swap) {
+        std::reverse(bytes.begin(), bytes.end());
+    }
+    std::memcpy(p, bytes.data(), sizeof(T));
+}
+
+template <typename T>
+T loadAs(const char *p, PlyType type, bool swap) {
+    switch (type) {
+    case PlyType::Int8:
+        return T(load<int8_t>(p, swap));
+    case PlyType::UInt8:
+        return T(load<uint8_t>(p, swap));
+    case PlyType::Int16:
+        return T(load<int16_t>(p, swap));
+    case PlyType::UInt16:
+        return T(load<uint16_t>(p, swap));
+    case PlyType::Int32:
+        return T(load<int32_t>(p, swap));
+    case PlyType::UInt32:
+        return T(load<uint32_t>(p, swap));
+    case PlyType::Float32:
+        return T(load<float>(p, swap));
+    case PlyType::Float64:
+        return T(load<double>(p, swap));
+    }
+    return T(0);
+}
+
+struct PlyProperty {
+    std::string name;
+    PlyType type = PlyType::Float32;
+    bool isList = false;
+    PlyType countType = PlyType::UInt8;
+};
+
+struct PlyElement {
+    std::string name;
+    size_t count = 0;
+    std::vector<PlyProperty> properties;
+
+    int find(std::string_view propertyName) const {
+        for (size_t i = 0; i < properties.size(); ++i) {
+            if (properties[i].name == propertyName) {
+                return int(i);
+            }
+        }
+        return -1;
+    }
+};
+
+struct PlyHeader {
+    bool swap = false;
+    std::vector<PlyElement> elements;
+    // bytes up to and including "end_header"
+    size_t size = 0;
+};
+
+std::string parseHeader(std::string_view data, PlyHeader &header) {
+    if (data.substr(0, 4) != "ply\n" && data.substr(0, 5) != "ply\r\n") {
+        return "not a PLY file";
+    }
+    size_t end = data.find("end_header");
+    if (end == std::string_view::npos) {
+        return "no end_header";
+    }
+    size_t lineEnd = data.find('\n', end);
+    header.size = lineEnd == std::string_view::npos ? data.size() : lineEnd + 1;
+
+    std::istringstream lines{std::string(data.substr(0, end))};
+    std::string line;
+    bool hasFormat = false;
+    while (std::getline(lines, line)) {
+        std::istringstream words(line);
+        std::string keyword;
+        words >> keyword;
+        if (keyword == "format") {
+            std::string format;
+            words >> format;
+            if (format == "binary_little_endian") {
+                header.swap = isBigEndianHost();
+            } else if (format == "binary_big_endian") {
+                header.swap = !isBigEndianHost();
+            } else {
+                return "unsupported format " + format;
+            }
+            hasFormat = true;
+        } else if (keyword == "element") {
+            PlyElement element;
+            words >> element.name >> element.count;
+            if (!words) {
+                return "invalid element: " + line;
+            }
+            header.elements.push_back(element);
+        } else if (keyword == "property") {
+            if (header.elements.empty()) {
+                return "property before element: " + line;
+            }
+            PlyProperty property;
+            std::string type;
+            words >> type;
+            if (type == "list") {
+                std::string countType;
+                property.isList = true;
+                words >> countType >> type;
+                if (!parseType(countType, property.countType)) {
+                    return "invalid property: " + line;
+                }
+            }
+            words >> property.name;
+            if (!words || !parseType(type, property.type)) {
+                return "invalid property: " + line;
+            }
+            header.elements.back().properties.push_back(property);
+        }
+    }
+    return hasFormat ? std::string() : "no format";
+}
+
+// Where the records of an element start; an element without list properties has a fixed stride
+class PlyRecords {
+  public:
+    // false if data ends before the element does
+    bool scan(const PlyElement &element, const char *begin, const char *end, bool swap) {
+        _element = &element;
+        _swap = swap;
+        _begin = begin;
+        _end = begin;
+        _stride = 0;
+        // each record holds at least its scalars and list counts, which bounds the count before anything is allocated
+        size_t available = size_t(end - begin);
+        size_t minRecordSize = 0;
+        bool hasLists = false;
+        for (auto &property : element.properties) {
+            hasLists = hasLists || property.isList;
+            _stride += typeSize(property.type);
+            minRecordSize += typeSize(property.isList ? property.countType : property.type);
+        }
+        if (element.count > available / std::max<size_t>(minRecordSize, 1)) {
+            return false;
+        }
+        if (!hasLists) {
+            _end = begin + element.count * _stride;
+            return true;
+        }
+        _stride = 0;
+        _starts.resize(element.count);
+        const char *p = begin;
+        for (size_t i = 0; i < element.count; ++i) {
+            _starts[i] = size_t(p - begin);
+            for (auto &property : element.properties) {
+                size_t size = typeSize(property.isList ? property.countType : property.type);
+                if (size_t(end - p) < size) {
+                    return false;
+                }
+                if (property.isList) {
+                    // as double, so that negative and huge counts of any type are rejected before p moves
+                    double listSize = loadAs<double>(p, property.countType, swap);
+                    p += size;
+                    size_t itemSize = typeSize(property.type);
+                    if (!(listSize >= 0) || listSize > double(size_t(end - p) / itemSize)) {
+                        return false;
+                    }
+                    p += size_t(listSize) * itemSize;
+                } else {
+                    p += size;
+                }
+            }
+        }
+        _end = p;
+        return true;
+    }
+
+    const char *end() const { return _end; }
+
+    // start of property index of record i
+    const char *property(size_t i, int index) const {
+        const char *p = _begin + (_stride > 0 ? i * _stride : _starts[i]);
+        for (int k = 0; k < index; ++k) {
+            auto &property = _element->properties[k];
+            if (property.isList) {
+                p += typeSize(property.countType) + loadAs<size_t>(p, property.countType, _swap) * typeSize(property.type);
+            } else {
+                p += typeSize(property.type);
+            }
+        }
+        return p;
+    }
+
+    size_t listSize(size_t i, int index) const {
+        return loadAs<size_t>(property(i, index), _element->properties[index].countType, _swap);
+    }
+
+    // item j of list property index of record i
+    template <typename T>
+    T listItem(size_t i, int index, size_t j) const {
+        auto &property = _element->properties[index];
+        return loadAs<T>(this->property(i, index) + typeSize(property.countType) + j * typeSize(property.type), property.type, _swap);
+    }
+
+    template <typename T>
+    T value(size_t i, int index) const {
+        return loadAs<T>(property(i, index), _element->properties[index].type, _swap);
+    }
+
+  private:
+    const PlyElement *_element = nullptr;
+    bool _swap = false;
+    const char *_begin = nullptr;
+    const char *_end = nullptr;
+    size_t _stride = 0;
+    std::vector<size_t> _starts;
+};
+
+std::string readVertices(const PlyElement &element, const PlyRecords &records, IndexedFaces &faces) {
+    int x = element.find("x");
+    int y = element.find("y");
+    int z = element.find("z");
+    if (x < 0 || y < 0 || z < 0) {
+        return "vertex element without x, y and z";
+    }
+    int u = -1;
+    int v = -1;
+    for (auto [uName, vName] : {std::pair{"s", "t"}, std::pair{"u", "v"}, std::pair{"texture_u", "texture_v"}}) {
+        if (u < 0 || v < 0) {
+            u = element.find(uName);
+            v = element.find(vName);
+        }
+    }
+    bool hasUVs = u >= 0 && v >= 0;
+    faces.positions.resize(element.count);
+    faces.uvPositions.resize(hasUVs ? element.count : 0);
+    parallelFor(0, element.count, [&](size_t i) {
+        faces.positions[i] = glm::vec3(records.value<float>(i, x), records.value<float>(i, y), records.value<float>(i, z));
+        if (hasUVs) {
+            faces.uvPositions[i] = glm::vec2(records.value<float>(i, u), records.value<float>(i, v));
+        }
+    });
+    return {};
+}
+
+std::string readFaces(const PlyElement &element, const PlyRecords &records, IndexedFaces &faces) {
+    int indices = element.find("vertex_indices");
+    if (indices < 0) {
+        indices = element.find("vertex_index");
+    }
+    if (indices < 0 || !element.properties[indices].isList) {
+        return "face element without vertex_indices list";
+    }
+    int texcoords = element.find("texcoord");
+    bool hasTexcoords = texcoords >= 0 && element.properties[texcoords].isList;
+    bool hasVertexUVs = !faces.uvPositions.empty();
+
+    // faces with fewer than 3 corners are dropped; face f is read from record faceRecords[f]
+    std::vector<int64_t> cornerOffsets;
+    std::vector<size_t> faceRecords;
+    cornerOffsets.push_back(0);
+    for (size_t i = 0; i < element.count; ++i) {
+        size_t count = records.listSize(i, indices);
+        if (count < 3) {
+            continue;
+        }
+        if (hasTexcoords && records.listSize(i, texcoords) != 2 * count) {
+            return "face " + std::to_string(i) + " has " + std::to_string(count) + " corners but not as many texcoords";
+        }
+        faceRecords.push_back(i);
+        cornerOffsets.push_back(cornerOffsets.back() + int64_t(count));
+    }
+    size_t faceCount = faceRecords.size();
+    size_t cornerCount = size_t(cornerOffsets.back());
+    faces.faceVertexCounts.resize(faceCount);
+    faces.cornerVertices.resize(cornerCount);
+    if (hasTexcoords) {
+        // replaces per-vertex uvs
+        faces.uvPositions.resize(cornerCount);
+        faces.cornerUVs.resize(cornerCount);
+    } else if (hasVertexUVs) {
+        faces.cornerUVs.resize(cornerCount);
+    }
+
+    std::mutex errorMutex;
+    std::string error;
+    parallelFor(0, faceCount, [&](size_t f) {
+        size_t record = faceRecords[f];
+        size_t begin = size_t(cornerOffsets[f]);
+        size_t count = size_t(cornerOffsets[f + 1]) - begin;
+        faces.faceVertexCounts[f] = int32_t(count);
+        for (size_t j = 0; j < count; ++j) {
+            auto vertex = records.listItem<int64_t>(record, indices, j);
+            if (vertex < 0 || size_t(vertex) >= faces.positions.size()) {
+                std::lock_guard lock(errorMutex);
+                error = "face " + std::to_string(record) + " refers to vertex " + std::to_string(vertex) + " of " +
+                        std::to_string(faces.positions.size());
+                return;
+            }
+            faces.cornerVertices[begin + j] = int32_t(vertex);
+            if (hasTexcoords) {
+                faces.uvPositions[begin + j] = glm::vec2(records.listItem<float>(record, texcoords, 2 * j),
+                                                         records.listItem<float>(record, texcoords, 2 * j + 1));
+                faces.cornerUVs[begin + j] = int32_t(begin + j);
+            } else if (hasVertexUVs) {
+                faces.cornerUVs[begin + j] = int32_t(vertex);
+            }
+        }
+    });
+    return error;
+}
+
+} // namespace
+
+MeshReadResult readPLY(std::string_view data) {
+    MESHLIB_SCOPED_OPERATION("readPLY");
+    MeshReadResult result;
+    PlyHeader header;
+    result.error = parseHeader(data, header);
+    if (!result.isValid()) {
+        return result;
+    }
+
+    IndexedFaces faces;
+    const char *p = data.data() + header.size;
+    const char *end = data.data() + data.size();
+    bool hasVertices = false;
+    for (auto &element : header.elements) {
+        PlyRecords records;
+        if (!records.scan(element, p, end, header.swap)) {
+            result.error = "file ends within element " + element.name;
+            return result;
+        }
+        if (element.name == "vertex") {
+            result.error = readVertices(element, records, faces);
+            hasVertices = true;
+        } else if (element.name == "face") {
+            if (!hasVertices) {
+                result.error = "face element before vertex element";
+            } else {
+                result.error = readFaces(element, records, faces);
+            }
+        }
+        if (!result.isValid()) {
+            return result;
+        }
+        p = records.end();
+    }
+    if (faces.cornerUVs.empty()) {
+        faces.uvPositions.clear();
+    }
+    result.mesh = faces.toMesh();
+    return result;
+}
+
+MeshReadResult readPLYFile(const std::string &path) {
+    std::string data;
+    if (!detail::readFile(path, data)) {
+        MeshReadResult result;
+        result.error = "cannot read " + path;
+        return result;
+    }
+    return readPLY(data);
+}
+
+std::string writePLY(const Mesh &mesh) {
+    MESHLIB_SCOPED_OPERATION("writePLY");
+    auto faces = IndexedFaces::fromMesh(mesh);
+    size_t faceCount = faces.faceVertexCounts.size();
+    int32_t maxCount = 0;
+    for (auto count : faces.faceVertexCounts) {
+        maxCount = std::max(maxCount, count);
+    }
+    // the texcoord list holds two floats per corner
+    bool byteCounts = 2 * maxCount <= 255;
+    size_t countSize = byteCounts ? 1 : 4;
+    const char *countType = byteCounts ? "uchar" : "int";
+
+    std::string header = "ply\nformat binary_little_endian 1.0\ncomment meshlib\nelement vertex " + std::to_string(faces.positions.size()) +
+                         "\nproperty float x\nproperty float y\nproperty float z\nelement face " + std::to_string(faceCount) +
+                         "\nproperty list " + countType + " int vertex_indices\nproperty list " + countType +
+                         " float texcoord\nend_header\n";
+
+    // record f starts at faceOffsets[f] within the face data and its corners at cornerOffsets[f]
+    std::vector<size_t> faceOffsets(faceCount + 1, 0);
+    std::vector<size_t> cornerOffsets(faceCount + 1, 0);
+    for (size_t f = 0; f < faceCount; ++f) {
+        size_t count = size_t(faces.faceVertexCounts[f]);
+        faceOffsets[f + 1] = faceOffsets[f] + 2 * countSize + count * 12;
+        cornerOffsets[f + 1] = cornerOffsets[f] + count;
+    }
+
+    std::string data(header.size() + faces.positions.size() * 12 + faceOffsets.back(), '\0');
+    std::memcpy(data.data(), header.data(), header.size());
+    bool swap = isBigEndianHost();
+    char *vertexData = data.data() + header.size();
+    char *faceData = vertexData + faces.positions.size() * 12;
+
+    parallelFor(0, faces.positions.size(), [&](size_t v) {
+        for (int k = 0; k < 3; ++k) {
+            store<float>(vertexData + v * 12 + size_t(k) * 4, faces.positions[v][k], swap);
+        }
+    });
+    parallelFor(0, faceCount, [&](size_t f) {
+        char *p = faceData + faceOffsets[f];
+        int32_t count = faces.faceVertexCounts[f];
+        auto storeCount = [&](int32_t listSize) {
+            if (byteCounts) {
+                store<uint8_t>(p, uint8_t(listSize), swap);
+            } else {
+                store<int32_t>(p, listSize, swap);
+            }
+            p += countSize;
+        };
+        storeCount(count);
+        for (size_t corner = cornerOffsets[f]; corner < cornerOffsets[f + 1]; ++corner) {
+            store<int32_t>(p, faces.cornerVertices[corner], swap);
+            p += 4;
+        }
+        storeCount(2 * count);
+        for (size_t corner = cornerOffsets[f]; corner < cornerOffsets[f + 1]; ++corner) {
+            auto uv = faces.uvPositions[faces.cornerUVs[corner]];
+            store<float>(p, uv.x, swap);
+            store<float>(p + 4, uv.y, swap);
+            p += 8;
+        }
+    });
+    return data;
+}
+
+bool writePLYFile(const Mesh &mesh, const std::string &path) {
+    auto data = writePLY(mesh);
+    std::ofstream file(path, std::ios::binary);
+    file.write(data.data(), std::streamsize(data.size()));
+    return bool(file);
+}
+
+} // namespace meshlib
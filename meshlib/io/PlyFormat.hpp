@@ -0,0 +1,20 @@
+#pragma once
+#include "IndexedFaces.hpp"
+#include <string>
+#include <string_view>
+
+namespace meshlib {
+
+// Binary PLY in either byte order. Reading takes the x, y, z vertex properties, per-vertex uvs from s/t, u/v or
+// texture_u/texture_v, and per-corner uvs from a "texcoord" face list, which take precedence; each distinct uv position
+// of a vertex becomes one of its uvPoints (see IndexedFaces::toMesh()). Other elements and properties are skipped, as
+// are faces with fewer than 3 corners. ASCII PLY is not supported.
+MeshReadResult readPLY(std::string_view data);
+MeshReadResult readPLYFile(const std::string &path);
+
+// Little endian, with float positions and the uvPoint positions in a per-face "texcoord" list
+std::string writePLY(const Mesh &mesh);
+// false if the file cannot be written
+bool writePLYFile(const Mesh &mesh, const std::string &path);
+
+} // namespace meshlib
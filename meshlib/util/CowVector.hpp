@@ -0,0 +1,212 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <memory_resource>
+#include <vector>
+
+namespace meshlib {
+
+// Vector stored in chunks of ChunkSize elements that copies share until one side writes to them: copying costs
+// O(size / ChunkSize) and the first write to a shared chunk copies that chunk only. Copies with another memory
+// resource are deep, so shared chunks never outlive the resource they were allocated from.
+// Shared chunks are never modified, so a copy can be read from other threads while the original is edited. Writes to
+// one CowVector from several threads need makeUnique() first, after which elements behave as in a plain vector.
+template <typename T, size_t ChunkShift = 10>
+class CowVector {
+    using Chunk = std::pmr::vector<T>;
+
+    struct Slot {
+        std::shared_ptr<Chunk> chunk;
+        // chunk->data(); chunks reserve ChunkSize elements up front, so it stays valid while the chunk fills up
+        T *data;
+    };
+
+    template <bool Const>
+    class Iterator {
+        using Vector = std::conditional_t<Const, const CowVector, CowVector>;
+
+      public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = std::conditional_t<Const, const T *, T *>;
+        using reference = std::conditional_t<Const, const T &, T &>;
+
+        Iterator() = default;
+        Iterator(Vector *vector, size_t index) : _vector(vector), _index(index) {}
+
+        reference operator*() const { return (*_vector)[_index]; }
+        pointer operator->() const { return &(*_vector)[_index]; }
+        Iterator &operator++() {
+            ++_index;
+            return *this;
+        }
+        Iterator operator++(int) {
+            auto old = *this;
+            ++_index;
+            return old;
+        }
+        bool operator==(const Iterator &other) const { return _index == other._index; }
+        bool operator!=(const Iterator &other) const { return _index != other._index; }
+
+      private:
+        Vector *_vector = nullptr;
+        size_t _index = 0;
+    };
+
+  public:
+    using allocator_type = std::pmr::polymorphic_allocator<std::byte>;
+    using value_type = T;
+    using iterator = Iterator<false>;
+    using const_iterator = Iterator<true>;
+
+    static constexpr size_t ChunkSize = size_t(1) << ChunkShift;
+
+    CowVector() = default;
+    explicit CowVector(const allocator_type &allocator) : _slots(allocator) {}
+    CowVector(const CowVector &other, const allocator_type &allocator) : _slots(allocator) { assign(other); }
+    CowVector(CowVector &&other, const allocator_type &allocator) : _slots(allocator) { *this = std::move(other); }
+    // like the std::pmr containers, a plain copy uses the default resource
+    CowVector(const CowVector &other) : CowVector(other, allocator_type()) {}
+    CowVector(CowVector &&other) noexcept : _slots(std::move(other._slots)), _size(other._size) { other._size = 0; }
+
+    CowVector &operator=(const CowVector &other) {
+        if (this != &other) {
+            assign(other);
+        }
+        return *this;
+    }
+    CowVector &operator=(CowVector &&other) {
+        if (resource() != other.resource()) {
+            assign(other);
+        } else if (this != &other) {
+            _slots = std::move(other._slots);
+            _size = other._size;
+            other._size = 0;
+        }
+        return *this;
+    }
+
+    allocator_type get_allocator() const { return allocator_type(resource()); }
+
+    size_t size() const { return _size; }
+    bool empty() const { return _size == 0; }
+
+    const T &operator[](size_t index) const { return _slots[index >> ChunkShift].data[index & (ChunkSize - 1)]; }
+    T &operator[](size_t index) { return uniqueSlot(index >> ChunkShift).data[index & (ChunkSize - 1)]; }
+
+    const_iterator begin() const { return {this, 0}; }
+    const_iterator end() const { return {this, _size}; }
+    iterator begin() { return {this, 0}; }
+    iterator end() { return {this, _size}; }
+
+    template <typename... TArgs>
+    T &emplace_back(TArgs &&...args) {
+        if ((_size & (ChunkSize - 1)) == 0) {
+            _slots.push_back(newSlot());
+        }
+        auto &item = uniqueSlot(_size >> ChunkShift).chunk->emplace_back(std::forward<TArgs>(args)...);
+        ++_size;
+        return item;
+    }
+    void push_back(const T &value) { emplace_back(value); }
+    void push_back(T &&value) { emplace_back(std::move(value)); }
+
+    // new elements are value-initialized
+    void resize(size_t size) {
+        resizeChunks(size, [](Chunk &chunk, size_t chunkSize) { chunk.resize(chunkSize); });
+    }
+    void resize(size_t size, const T &value) {
+        resizeChunks(size, [&](Chunk &chunk, size_t chunkSize) { chunk.resize(chunkSize, value); });
+    }
+
+    void reserve(size_t size) { _slots.reserve((size + ChunkSize - 1) >> ChunkShift); }
+
+    void clear() {
+        _slots.clear();
+        _size = 0;
+    }
+
+    void append(const CowVector &other) {
+        for (size_t i = 0; i < other._size; ++i) {
+            emplace_back(other[i]);
+        }
+    }
+
+    // copies all chunks that are shared with other vectors
+    void makeUnique() {
+        for (size_t i = 0; i < _slots.size(); ++i) {
+            uniqueSlot(i);
+        }
+    }
+
+    // Contiguous runs of elements: chunk i holds the elements from i * ChunkSize on
+    size_t chunkCount() const { return _slots.size(); }
+    size_t chunkLength(size_t chunk) const { return _slots[chunk].chunk->size(); }
+    const T *chunkData(size_t chunk) const { return _slots[chunk].data; }
+    T *chunkData(size_t chunk) { return uniqueSlot(chunk).data; }
+
+  private:
+    std::pmr::memory_resource *resource() const { return _slots.get_allocator().resource(); }
+
+    Slot newSlot() const {
+        // polymorphic_allocator constructs the chunk with the resource, and the chunk passes it on to the elements
+        auto chunk = std::allocate_shared<Chunk>(std::pmr::polymorphic_allocator<Chunk>(resource()));
+        chunk->reserve(ChunkSize);
+        return {chunk, chunk->data()};
+    }
+
+    Slot &uniqueSlot(size_t chunk) {
+        auto &slot = _slots[chunk];
+        if (slot.chunk.use_count() != 1) {
+            auto copy = newSlot();
+            copy.chunk->insert(copy.chunk->end(), slot.chunk->begin(), slot.chunk->end());
+            slot = copy;
+        } else {
+            // pairs with the release when another owner dropped the chunk, so its last reads happen before our writes
+            std::atomic_thread_fence(std::memory_order_acquire);
+        }
+        return slot;
+    }
+
+    void assign(const CowVector &other) {
+        if (resource() == other.resource()) {
+            _slots = other._slots;
+        } else {
+            _slots.clear();
+            for (auto &otherSlot : other._slots) {
+                auto slot = newSlot();
+                slot.chunk->insert(slot.chunk->end(), otherSlot.chunk->begin(), otherSlot.chunk->end());
+                _slots.push_back(slot);
+            }
+        }
+        _size = other._size;
+    }
+
+    template <typename TResizeChunk>
+    void resizeChunks(size_t size, TResizeChunk &&resizeChunk) {
+        size_t chunkCount = (size + ChunkSize - 1) >> ChunkShift;
+        if (chunkCount < _slots.size()) {
+            _slots.erase(_slots.begin() + chunkCount, _slots.end());
+        }
+        while (_slots.size() < chunkCount) {
+            _slots.push_back(newSlot());
+        }
+        // chunks before the one holding the smaller of the two sizes are full either way
+        for (size_t i = std::min(_size, size) >> ChunkShift; i < chunkCount; ++i) {
+            size_t chunkSize = std::min(ChunkSize, size - (i << ChunkShift));
+            if (_slots[i].chunk->size() != chunkSize) {
+                resizeChunk(*uniqueSlot(i).chunk, chunkSize);
+            }
+        }
+        _size = size;
+    }
+
+    std::pmr::vector<Slot> _slots;
+    size_t _size = 0;
+};
+
+} // namespace meshlib
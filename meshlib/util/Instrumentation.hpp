@@ -0,0 +1,191 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory_resource>
+#include <mutex>
+#include <string>
+
+// Opt-in operation profiling. Build with MESHLIB_INSTRUMENTATION defined to compile the hooks in; without it the
+// MESHLIB_SCOPED_OPERATION and MESHLIB_COUNT macros expand to nothing. When compiled in but no sink is set, a hook
+// costs an atomic load and a thread-local check.
+
+namespace meshlib {
+
+enum class InstrumentationCounter {
+    VerticesAdded,
+    UVPointsAdded,
+    EdgesAdded,
+    FacesAdded,
+    ElementsRemoved,
+    // existing edges and faces compared by the duplicate checks of addEdge and addFace
+    DuplicateCheckIterations,
+    // faces examined by addEdge for splitting
+    FacesScannedForSplit,
+    // allocations through an InstrumentedResource
+    Allocations,
+    AllocatedBytes,
+    Count,
+};
+
+inline const char *instrumentationCounterName(InstrumentationCounter counter) {
+    static const char *names[] = {
+        "verticesAdded",
+        "uvPointsAdded",
+        "edgesAdded",
+        "facesAdded",
+        "elementsRemoved",
+        "duplicateCheckIterations",
+        "facesScannedForSplit",
+        "allocations",
+        "allocatedBytes",
+    };
+    return names[size_t(counter)];
+}
+
+using InstrumentationCounters = std::array<uint64_t, size_t(InstrumentationCounter::Count)>;
+
+struct OperationRecord {
+    const char *name;
+    // nesting level, 0 for an outermost operation
+    int depth;
+    std::chrono::nanoseconds duration;
+    // includes the counts of nested operations
+    InstrumentationCounters counters;
+};
+
+class InstrumentationSink {
+  public:
+    virtual ~InstrumentationSink() = default;
+    // Called on the thread that ran the operation when it finishes; must be thread-safe if operations run on
+    // several threads
+    virtual void operationFinished(const OperationRecord &record) = 0;
+};
+
+namespace detail {
+inline std::atomic<InstrumentationSink *> instrumentationSink = nullptr;
+} // namespace detail
+
+// The sink must outlive all operations running while it is set; nullptr disables reporting
+inline void setInstrumentationSink(InstrumentationSink *sink) { detail::instrumentationSink.store(sink); }
+inline InstrumentationSink *instrumentationSink() { return detail::instrumentationSink.load(std::memory_order_relaxed); }
+
+// Times the enclosing scope and collects counts made on the same thread while it is open.
+// Work done on parallelFor worker threads is timed but not counted.
+class ScopedOperation {
+  public:
+    explicit ScopedOperation(const char *name) {
+        _sink = instrumentationSink();
+        if (!_sink) {
+            return;
+        }
+        _name = name;
+        _parent = current();
+        _depth = _parent ? _parent->_depth + 1 : 0;
+        current() = this;
+        _start = std::chrono::steady_clock::now();
+    }
+
+    ~ScopedOperation() {
+        if (!_sink) {
+            return;
+        }
+        auto duration = std::chrono::steady_clock::now() - _start;
+        current() = _parent;
+        if (_parent) {
+            for (size_t i = 0; i < _counters.size(); ++i) {
+                _parent->_counters[i] += _counters[i];
+            }
+        }
+        _sink->operationFinished({_name, _depth, std::chrono::duration_cast<std::chrono::nanoseconds>(duration), _counters});
+    }
+
+    ScopedOperation(const ScopedOperation &) = delete;
+    ScopedOperation &operator=(const ScopedOperation &) = delete;
+
+    static void count(InstrumentationCounter counter, uint64_t value) {
+        if (auto operation = current()) {
+            operation->_counters[size_t(counter)] += value;
+        }
+    }
+
+  private:
+    static ScopedOperation *&current() {
+        static thread_local ScopedOperation *operation = nullptr;
+        return operation;
+    }
+
+    InstrumentationSink *_sink;
+    const char *_name = nullptr;
+    ScopedOperation *_parent = nullptr;
+    int _depth = 0;
+    std::chrono::steady_clock::time_point _start;
+    InstrumentationCounters _counters{};
+};
+
+// Memory resource that counts allocations into the current operation, e.g. as the resource of a Mesh or of an
+// algorithm's temporaries
+class InstrumentedResource : public std::pmr::memory_resource {
+  public:
+    explicit InstrumentedResource(std::pmr::memory_resource *upstream = std::pmr::get_default_resource()) : _upstream(upstream) {}
+
+  private:
+    void *do_allocate(size_t bytes, size_t alignment) override {
+        ScopedOperation::count(InstrumentationCounter::Allocations, 1);
+        ScopedOperation::count(InstrumentationCounter::AllocatedBytes, bytes);
+        return _upstream->allocate(bytes, alignment);
+    }
+    void do_deallocate(void *p, size_t bytes, size_t alignment) override { _upstream->deallocate(p, bytes, alignment); }
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override { return this == &other; }
+
+    std::pmr::memory_resource *_upstream;
+};
+
+// Sink that sums up duration and counters per operation name
+class AggregatingSink : public InstrumentationSink {
+  public:
+    struct Entry {
+        uint64_t calls = 0;
+        std::chrono::nanoseconds duration{0};
+        InstrumentationCounters counters{};
+    };
+
+    void operationFinished(const OperationRecord &record) override {
+        std::lock_guard lock(_mutex);
+        auto &entry = _entries[record.name];
+        ++entry.calls;
+        entry.duration += record.duration;
+        for (size_t i = 0; i < entry.counters.size(); ++i) {
+            entry.counters[i] += record.counters[i];
+        }
+    }
+
+    std::map<std::string, Entry> entries() const {
+        std::lock_guard lock(_mutex);
+        return _entries;
+    }
+
+    void clear() {
+        std::lock_guard lock(_mutex);
+        _entries.clear();
+    }
+
+  private:
+    mutable std::mutex _mutex;
+    std::map<std::string, Entry> _entries;
+};
+
+} // namespace meshlib
+
+#define MESHLIB_CONCAT_IMPL(a, b) a##b
+#define MESHLIB_CONCAT(a, b) MESHLIB_CONCAT_IMPL(a, b)
+
+#ifdef MESHLIB_INSTRUMENTATION
+#define MESHLIB_SCOPED_OPERATION(name) ::meshlib::ScopedOperation MESHLIB_CONCAT(meshlibScopedOperation, __LINE__)(name)
+#define MESHLIB_COUNT(counter, value) ::meshlib::ScopedOperation::count(::meshlib::InstrumentationCounter::counter, value)
+#else
+#define MESHLIB_SCOPED_OPERATION(name) ((void)0)
+#define MESHLIB_COUNT(counter, value) ((void)0)
+#endif
@@ -0,0 +1,115 @@
+#pragma once
+#include "TaskScheduler.hpp"
+#include <algorithm>
+#include <atomic>
+#include <memory_resource>
+#include <vector>
+
+namespace meshlib {
+
+// Calls func(blockBegin, blockEnd) for contiguous blocks covering [begin, end), spread over up to concurrencyLimit()
+// threads of the task scheduler. There are a few blocks per thread and each thread claims the next free one, so
+// threads that finish early take over the rest. Ranges smaller than minBlockSize run inline on the calling thread.
+template <typename TFunc>
+void parallelForBlocks(size_t begin, size_t end, TFunc &&func, size_t minBlockSize = 1024) {
+    constexpr size_t BlocksPerThread = 4;
+    if (end <= begin) {
+        return;
+    }
+    size_t count = end - begin;
+    size_t maxBlockCount = (count + minBlockSize - 1) / minBlockSize;
+    size_t threadCount = std::min(concurrencyLimit(), maxBlockCount);
+    if (threadCount <= 1) {
+        func(begin, end);
+        return;
+    }
+
+    size_t blockCount = std::min(maxBlockCount, threadCount * BlocksPerThread);
+    size_t blockSize = (count + blockCount - 1) / blockCount;
+    std::atomic<size_t> nextBlock = 0;
+    auto runBlocks = [&] {
+        for (size_t block = nextBlock++; block < blockCount; block = nextBlock++) {
+            size_t blockBegin = begin + block * blockSize;
+            size_t blockEnd = std::min(end, blockBegin + blockSize);
+            if (blockBegin < blockEnd) {
+                func(blockBegin, blockEnd);
+            }
+        }
+    };
+
+    // the calling thread works too, and then takes back the helpers that no worker has started
+    TaskGroup group;
+    for (size_t i = 1; i < threadCount; ++i) {
+        group.run(runBlocks);
+    }
+    runBlocks();
+    group.wait();
+}
+
+// Calls func(i) for every i in [begin, end) in parallel
+template <typename TFunc>
+void parallelFor(size_t begin, size_t end, TFunc &&func, size_t minBlockSize = 1024) {
+    parallelForBlocks(
+        begin, end, [&](size_t blockBegin, size_t blockEnd) {
+            for (size_t i = blockBegin; i < blockEnd; ++i) {
+                func(i);
+            }
+        },
+        minBlockSize);
+}
+
+// Calls func(chunk, chunkBegin, chunkEnd) for the chunks of chunkSize elements covering [0, count) in parallel, each
+// chunk in one call, so that func can write whole copy-on-write chunks such as Mesh::positionChunk() without racing
+// other writers to them. The default block is large enough that a thread gets a few hundred KB of Mesh coordinates.
+template <typename TFunc>
+void parallelForChunks(size_t count, size_t chunkSize, TFunc &&func, size_t minBlockSize = 16) {
+    size_t chunkCount = (count + chunkSize - 1) / chunkSize;
+    parallelFor(
+        0, chunkCount, [&](size_t chunk) {
+            size_t chunkBegin = chunk * chunkSize;
+            func(chunk, chunkBegin, std::min(chunkBegin + chunkSize, count));
+        },
+        minBlockSize);
+}
+
+// Calls func(handle) for every handle of a random access range such as Mesh::allFaces() in parallel
+template <typename THandles, typename TFunc>
+void parallelForEach(const THandles &handles, TFunc &&func, size_t minBlockSize = 1024) {
+    auto first = handles.begin();
+    parallelFor(
+        0, size_t(handles.end() - first), [&](size_t i) { func(first[i]); }, minBlockSize);
+}
+
+// THandle(i) for the i in [begin, end) for which predicate(i) holds, in ascending order
+template <typename THandle, typename TPredicate>
+std::pmr::vector<THandle> parallelFilter(size_t begin, size_t end, TPredicate &&predicate,
+                                         std::pmr::memory_resource *resource = std::pmr::get_default_resource(),
+                                         size_t minBlockSize = 4096) {
+    size_t count = end > begin ? end - begin : 0;
+    size_t blockCount = (count + minBlockSize - 1) / minBlockSize;
+    std::vector<std::vector<THandle>> blockResults(blockCount);
+    parallelFor(
+        0, blockCount,
+        [&](size_t block) {
+            size_t blockBegin = begin + block * minBlockSize;
+            size_t blockEnd = std::min(end, blockBegin + minBlockSize);
+            for (size_t i = blockBegin; i < blockEnd; ++i) {
+                if (predicate(i)) {
+                    blockResults[block].push_back(THandle(int(i)));
+                }
+            }
+        },
+        1);
+    size_t resultCount = 0;
+    for (auto &blockResult : blockResults) {
+        resultCount += blockResult.size();
+    }
+    std::pmr::vector<THandle> result(resource);
+    result.reserve(resultCount);
+    for (auto &blockResult : blockResults) {
+        result.insert(result.end(), blockResult.begin(), blockResult.end());
+    }
+    return result;
+}
+
+} // namespace meshlib
@@ -0,0 +1,218 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <iterator>
+#include <memory_resource>
+#include <type_traits>
+
+namespace meshlib {
+
+// Vector of trivially copyable values that keeps up to N of them inline and moves to a std::pmr memory resource
+// beyond that. Allocator-aware like std::pmr::vector: copies get the default resource unless one is passed, moves
+// and assignments keep the resource of the destination.
+template <typename T, size_t N>
+class SmallVector {
+    static_assert(std::is_trivially_copyable_v<T>, "SmallVector only supports trivially copyable types");
+
+  public:
+    using value_type = T;
+    using size_type = size_t;
+    using difference_type = std::ptrdiff_t;
+    using reference = T &;
+    using const_reference = const T &;
+    using pointer = T *;
+    using const_pointer = const T *;
+    using iterator = T *;
+    using const_iterator = const T *;
+    using allocator_type = std::pmr::polymorphic_allocator<std::byte>;
+
+    SmallVector() noexcept : SmallVector(allocator_type()) {}
+    explicit SmallVector(const allocator_type &allocator) noexcept : _resource(allocator.resource()) {}
+
+    SmallVector(std::initializer_list<T> values, const allocator_type &allocator = {}) : SmallVector(allocator) {
+        assign(values.begin(), values.end());
+    }
+
+    template <typename TIterator, typename = decltype(*std::declval<TIterator &>(), ++std::declval<TIterator &>())>
+    SmallVector(TIterator first, TIterator last, const allocator_type &allocator = {}) : SmallVector(allocator) {
+        assign(first, last);
+    }
+
+    SmallVector(const SmallVector &other) : SmallVector(other, allocator_type()) {}
+    SmallVector(const SmallVector &other, const allocator_type &allocator) : SmallVector(allocator) {
+        assign(other.begin(), other.end());
+    }
+
+    SmallVector(SmallVector &&other) noexcept : _resource(other._resource) { steal(other); }
+    SmallVector(SmallVector &&other, const allocator_type &allocator) : SmallVector(allocator) {
+        if (*_resource == *other._resource) {
+            steal(other);
+        } else {
+            assign(other.begin(), other.end());
+        }
+    }
+
+    ~SmallVector() { deallocate(); }
+
+    SmallVector &operator=(const SmallVector &other) {
+        if (this != &other) {
+            assign(other.begin(), other.end());
+        }
+        return *this;
+    }
+
+    SmallVector &operator=(SmallVector &&other) noexcept {
+        if (this == &other) {
+            return *this;
+        }
+        if (*_resource == *other._resource) {
+            deallocate();
+            steal(other);
+        } else {
+            assign(other.begin(), other.end());
+        }
+        return *this;
+    }
+
+    SmallVector &operator=(std::initializer_list<T> values) {
+        assign(values.begin(), values.end());
+        return *this;
+    }
+
+    template <typename TIterator>
+    void assign(TIterator first, TIterator last) {
+        clear();
+        if constexpr (std::is_base_of_v<std::forward_iterator_tag, typename std::iterator_traits<TIterator>::iterator_category>) {
+            reserve(size_t(std::distance(first, last)));
+        }
+        for (; first != last; ++first) {
+            push_back(*first);
+        }
+    }
+
+    allocator_type get_allocator() const { return allocator_type(_resource); }
+
+    iterator begin() { return _data; }
+    iterator end() { return _data + _size; }
+    const_iterator begin() const { return _data; }
+    const_iterator end() const { return _data + _size; }
+
+    T *data() { return _data; }
+    const T *data() const { return _data; }
+
+    size_t size() const { return _size; }
+    bool empty() const { return _size == 0; }
+    size_t capacity() const { return _capacity; }
+    static constexpr size_t inlineCapacity() { return N; }
+    bool isInline() const { return _data == inlineData(); }
+
+    T &operator[](size_t i) { return _data[i]; }
+    const T &operator[](size_t i) const { return _data[i]; }
+    T &front() { return _data[0]; }
+    const T &front() const { return _data[0]; }
+    T &back() { return _data[_size - 1]; }
+    const T &back() const { return _data[_size - 1]; }
+
+    void reserve(size_t capacity) {
+        if (capacity <= _capacity) {
+            return;
+        }
+        auto newData = static_cast<T *>(_resource->allocate(capacity * sizeof(T), alignof(T)));
+        if (_size > 0) {
+            std::memcpy(static_cast<void *>(newData), _data, _size * sizeof(T));
+        }
+        deallocate();
+        _data = newData;
+        _capacity = uint32_t(capacity);
+    }
+
+    void push_back(const T &value) {
+        if (_size == _capacity) {
+            T copy = value; // value may live in the current buffer
+            reserve(std::max<size_t>(1, _capacity * 2));
+            _data[_size++] = copy;
+            return;
+        }
+        _data[_size++] = value;
+    }
+
+    template <typename... TArgs>
+    T &emplace_back(TArgs &&...args) {
+        push_back(T(std::forward<TArgs>(args)...));
+        return back();
+    }
+
+    void pop_back() { --_size; }
+    void clear() { _size = 0; }
+
+    void resize(size_t size, const T &value = T()) {
+        reserve(size);
+        for (size_t i = _size; i < size; ++i) {
+            _data[i] = value;
+        }
+        _size = uint32_t(size);
+    }
+
+    iterator insert(const_iterator position, const T &value) {
+        size_t index = size_t(position - _data);
+        T copy = value;
+        if (_size == _capacity) {
+            reserve(std::max<size_t>(1, _capacity * 2));
+        }
+        std::memmove(static_cast<void *>(_data + index + 1), _data + index, (_size - index) * sizeof(T));
+        _data[index] = copy;
+        ++_size;
+        return _data + index;
+    }
+
+    iterator erase(const_iterator position) { return erase(position, position + 1); }
+    iterator erase(const_iterator first, const_iterator last) {
+        size_t index = size_t(first - _data);
+        size_t count = size_t(last - first);
+        std::memmove(static_cast<void *>(_data + index), _data + index + count, (_size - index - count) * sizeof(T));
+        _size -= uint32_t(count);
+        return _data + index;
+    }
+
+    bool operator==(const SmallVector &other) const { return std::equal(begin(), end(), other.begin(), other.end()); }
+    bool operator!=(const SmallVector &other) const { return !operator==(other); }
+
+  private:
+    T *inlineData() { return reinterpret_cast<T *>(_inline); }
+    const T *inlineData() const { return reinterpret_cast<const T *>(_inline); }
+
+    void deallocate() {
+        if (!isInline()) {
+            _resource->deallocate(_data, _capacity * sizeof(T), alignof(T));
+        }
+        _data = inlineData();
+        _capacity = N;
+    }
+
+    // takes the elements of other, which must use an equal resource
+    void steal(SmallVector &other) {
+        if (other.isInline()) {
+            _data = inlineData();
+            _capacity = N;
+            std::memcpy(_inline, other._inline, other._size * sizeof(T));
+        } else {
+            _data = other._data;
+            _capacity = other._capacity;
+        }
+        _size = other._size;
+        other._data = other.inlineData();
+        other._capacity = N;
+        other._size = 0;
+    }
+
+    T *_data = inlineData();
+    uint32_t _size = 0;
+    uint32_t _capacity = N;
+    std::pmr::memory_resource *_resource;
+    alignas(T) std::byte _inline[N * sizeof(T)];
+};
+
+} // namespace meshlib
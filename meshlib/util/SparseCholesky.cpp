@@ -0,0 +1,291 @@
+#include "SparseCholesky.hpp"
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+namespace meshlib {
+
+namespace {
+
+// parts this small are not dissected further
+constexpr size_t DissectionLeafSize = 64;
+
+class Dissection {
+  public:
+    explicit Dissection(const SymmetricMatrix &matrix) : _offsets(matrix.size() + 1, 0), _parts(matrix.size(), 0), _levels(matrix.size()) {
+        // both triangles, without the diagonal
+        for (size_t j = 0; j < matrix.size(); ++j) {
+            for (int p = matrix.offsets[j]; p < matrix.offsets[j + 1]; ++p) {
+                if (matrix.rows[p] != int(j)) {
+                    ++_offsets[matrix.rows[p] + 1];
+                    ++_offsets[j + 1];
+                }
+            }
+        }
+        for (size_t i = 1; i < _offsets.size(); ++i) {
+            _offsets[i] += _offsets[i - 1];
+        }
+        _neighbours.resize(_offsets.back());
+        std::vector<int> next(_offsets.begin(), _offsets.end() - 1);
+        for (size_t j = 0; j < matrix.size(); ++j) {
+            for (int p = matrix.offsets[j]; p < matrix.offsets[j + 1]; ++p) {
+                int i = matrix.rows[p];
+                if (i != int(j)) {
+                    _neighbours[next[i]++] = int(j);
+                    _neighbours[next[j]++] = i;
+                }
+            }
+        }
+        order.reserve(matrix.size());
+    }
+
+    // appends the vertices of part, all of which have _parts[v] == id, to order
+    void dissect(std::vector<int> part, int id) {
+        if (part.size() <= DissectionLeafSize) {
+            order.insert(order.end(), part.begin(), part.end());
+            return;
+        }
+        // levels from a vertex far from another one, which makes them many and thin
+        int start = breadthFirst(part, part[0], id);
+        breadthFirst(part, start, id);
+
+        std::vector<size_t> levelSizes;
+        size_t reached = 0;
+        for (auto v : part) {
+            if (_levels[v] >= 0) {
+                if (size_t(_levels[v]) >= levelSizes.size()) {
+                    levelSizes.resize(_levels[v] + 1, 0);
+                }
+                ++levelSizes[_levels[v]];
+                ++reached;
+            }
+        }
+        // the smallest level that leaves at least a third of the vertices on either side
+        int middle = -1;
+        for (size_t level = 0, below = 0; level < levelSizes.size(); below += levelSizes[level++]) {
+            bool isBalanced = 3 * below >= reached && 3 * (below + levelSizes[level]) <= 2 * reached;
+            if (isBalanced && (middle < 0 || levelSizes[level] < levelSizes[middle])) {
+                middle = int(level);
+            }
+        }
+        if (middle < 0) {
+            middle = 0;
+            for (size_t below = 0; middle + 1 < int(levelSizes.size()) && below + levelSizes[middle] <= reached / 2; ++middle) {
+                below += levelSizes[middle];
+            }
+        }
+
+        // the vertices that were not reached are in other components, so the middle level separates them as well
+        std::vector<int> first;
+        std::vector<int> second;
+        std::vector<int> separator;
+        for (auto v : part) {
+            if (_levels[v] >= 0 && _levels[v] < middle) {
+                first.push_back(v);
+            } else if (_levels[v] == middle) {
+                separator.push_back(v);
+            } else {
+                second.push_back(v);
+            }
+        }
+        if (first.empty() && second.empty()) {
+            order.insert(order.end(), part.begin(), part.end());
+            return;
+        }
+        int firstId = ++_partCount;
+        int secondId = ++_partCount;
+        for (auto v : first) {
+            _parts[v] = firstId;
+        }
+        for (auto v : second) {
+            _parts[v] = secondId;
+        }
+        for (auto v : separator) {
+            _parts[v] = -1;
+        }
+        part.clear();
+        part.shrink_to_fit();
+        dissect(std::move(first), firstId);
+        dissect(std::move(second), secondId);
+        order.insert(order.end(), separator.begin(), separator.end());
+    }
+
+    std::vector<int> order;
+
+  private:
+    // levels of the vertices of part from start, -1 if not reached; returns the last vertex reached
+    int breadthFirst(const std::vector<int> &part, int start, int id) {
+        for (auto v : part) {
+            _levels[v] = -1;
+        }
+        _queue.clear();
+        _queue.push_back(start);
+        _levels[start] = 0;
+        for (size_t q = 0; q < _queue.size(); ++q) {
+            int v = _queue[q];
+            for (int p = _offsets[v]; p < _offsets[v + 1]; ++p) {
+                int u = _neighbours[p];
+                if (_parts[u] == id && _levels[u] < 0) {
+                    _levels[u] = _levels[v] + 1;
+                    _queue.push_back(u);
+                }
+            }
+        }
+        return _queue.back();
+    }
+
+    std::vector<int> _offsets;
+    std::vector<int> _neighbours;
+    std::vector<int> _parts;
+    int _partCount = 0;
+    std::vector<int> _levels;
+    std::vector<int> _queue;
+};
+
+} // namespace
+
+std::vector<int> nestedDissectionOrder(const SymmetricMatrix &matrix) {
+    Dissection dissection(matrix);
+    std::vector<int> all(matrix.size());
+    for (size_t i = 0; i < all.size(); ++i) {
+        all[i] = int(i);
+    }
+    dissection.dissect(std::move(all), 0);
+    return std::move(dissection.order);
+}
+
+SparseCholesky::SparseCholesky(const SymmetricMatrix &pattern, std::vector<int> order) : _order(std::move(order)) {
+    int n = int(_order.size());
+    _inverseOrder.resize(n);
+    for (int k = 0; k < n; ++k) {
+        _inverseOrder[_order[k]] = k;
+    }
+
+    // upper triangle of the permuted matrix by columns
+    _upperOffsets.assign(n + 1, 0);
+    for (int j = 0; j < n; ++j) {
+        for (int p = pattern.offsets[j]; p < pattern.offsets[j + 1]; ++p) {
+            ++_upperOffsets[std::max(_inverseOrder[pattern.rows[p]], _inverseOrder[j]) + 1];
+        }
+    }
+    for (int k = 0; k < n; ++k) {
+        _upperOffsets[k + 1] += _upperOffsets[k];
+    }
+    _upperRows.resize(_upperOffsets.back());
+    _upperEntries.resize(_upperOffsets.back());
+    std::vector<int> next(_upperOffsets.begin(), _upperOffsets.end() - 1);
+    for (int j = 0; j < n; ++j) {
+        for (int p = pattern.offsets[j]; p < pattern.offsets[j + 1]; ++p) {
+            int row = _inverseOrder[pattern.rows[p]];
+            int column = _inverseOrder[j];
+            int q = next[std::max(row, column)]++;
+            _upperRows[q] = std::min(row, column);
+            _upperEntries[q] = p;
+        }
+    }
+
+    // elimination tree, with path compression through the ancestors
+    _parents.assign(n, -1);
+    std::vector<int> ancestors(n, -1);
+    for (int k = 0; k < n; ++k) {
+        for (int p = _upperOffsets[k]; p < _upperOffsets[k + 1]; ++p) {
+            for (int i = _upperRows[p], up; i != -1 && i < k; i = up) {
+                up = ancestors[i];
+                ancestors[i] = k;
+                if (up == -1) {
+                    _parents[i] = k;
+                }
+            }
+        }
+    }
+
+    // row k of L has the columns on the paths from the entries of column k up the tree
+    std::vector<int> counts(n, 1);
+    std::vector<int> marks(n, -1);
+    for (int k = 0; k < n; ++k) {
+        marks[k] = k;
+        for (int p = _upperOffsets[k]; p < _upperOffsets[k + 1]; ++p) {
+            for (int i = _upperRows[p]; marks[i] != k; i = _parents[i]) {
+                marks[i] = k;
+                ++counts[i];
+            }
+        }
+    }
+    _offsets.assign(n + 1, 0);
+    for (int k = 0; k < n; ++k) {
+        _offsets[k + 1] = _offsets[k] + counts[k];
+    }
+    _rows.resize(_offsets.back());
+    _values.resize(_offsets.back());
+}
+
+bool SparseCholesky::factor(const SymmetricMatrix &matrix) {
+    // up-looking: row k of L from a triangular solve with the rows above it
+    int n = int(size());
+    std::vector<double> x(n, 0);
+    std::vector<int> next(_offsets.begin(), _offsets.end() - 1);
+    std::vector<int> stack(n);
+    std::vector<int> marks(n, -1);
+    for (int k = 0; k < n; ++k) {
+        // pattern of row k in topological order at stack[top, n)
+        int top = n;
+        marks[k] = k;
+        for (int p = _upperOffsets[k]; p < _upperOffsets[k + 1]; ++p) {
+            int length = 0;
+            for (int i = _upperRows[p]; marks[i] != k; i = _parents[i]) {
+                stack[length++] = i;
+                marks[i] = k;
+            }
+            while (length > 0) {
+                stack[--top] = stack[--length];
+            }
+            x[_upperRows[p]] += matrix.values[_upperEntries[p]];
+        }
+        double diagonal = x[k];
+        x[k] = 0;
+        for (; top < n; ++top) {
+            int i = stack[top];
+            double value = x[i] / _values[_offsets[i]];
+            x[i] = 0;
+            for (int p = _offsets[i] + 1; p < next[i]; ++p) {
+                x[_rows[p]] -= _values[p] * value;
+            }
+            diagonal -= value * value;
+            int p = next[i]++;
+            _rows[p] = k;
+            _values[p] = value;
+        }
+        if (!(diagonal > 0)) {
+            return false;
+        }
+        int p = next[k]++;
+        _rows[p] = k;
+        _values[p] = std::sqrt(diagonal);
+    }
+    return true;
+}
+
+void SparseCholesky::solve(double *x) const {
+    int n = int(size());
+    std::vector<double> y(n);
+    for (int k = 0; k < n; ++k) {
+        y[k] = x[_order[k]];
+    }
+    for (int j = 0; j < n; ++j) {
+        y[j] /= _values[_offsets[j]];
+        for (int p = _offsets[j] + 1; p < _offsets[j + 1]; ++p) {
+            y[_rows[p]] -= _values[p] * y[j];
+        }
+    }
+    for (int j = n - 1; j >= 0; --j) {
+        for (int p = _offsets[j] + 1; p < _offsets[j + 1]; ++p) {
+            y[j] -= _values[p] * y[_rows[p]];
+        }
+        y[j] /= _values[_offsets[j]];
+    }
+    for (int k = 0; k < n; ++k) {
+        x[_order[k]] = y[k];
+    }
+}
+
+} // namespace meshlib
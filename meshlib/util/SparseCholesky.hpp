@@ -0,0 +1,53 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+
+namespace meshlib {
+
+// Symmetric sparse matrix given by its lower triangle in compressed columns: column j has the rows
+// rows[offsets[j]] to rows[offsets[j + 1] - 1], all >= j, with the values alongside
+struct SymmetricMatrix {
+    std::vector<int> offsets{0};
+    std::vector<int> rows;
+    std::vector<double> values;
+
+    size_t size() const { return offsets.size() - 1; }
+};
+
+// Fill-reducing order of the rows and columns of matrix, as the old index of each new one: nested dissection, where
+// a middle breadth-first level of each part separates it into two that are ordered first
+std::vector<int> nestedDissectionOrder(const SymmetricMatrix &matrix);
+
+// Cholesky factorization L L^T of a symmetric positive definite matrix with its rows and columns permuted, for
+// solving with the same matrix many times. The analysis depends only on the nonzero pattern, so a copy made after it
+// can factor another matrix with the same pattern without repeating it.
+class SparseCholesky {
+  public:
+    SparseCholesky() = default;
+    // order as from nestedDissectionOrder()
+    SparseCholesky(const SymmetricMatrix &pattern, std::vector<int> order);
+
+    size_t size() const { return _order.size(); }
+    // nonzeros of L
+    size_t factorSize() const { return _rows.size(); }
+
+    // false if matrix is not positive definite; it must have the analysed pattern
+    bool factor(const SymmetricMatrix &matrix);
+    // Overwrites the right-hand side x with the solution
+    void solve(double *x) const;
+
+  private:
+    std::vector<int> _order;
+    std::vector<int> _inverseOrder;
+    // the permuted matrix by columns of its upper triangle, as entries of the input matrix
+    std::vector<int> _upperOffsets;
+    std::vector<int> _upperRows;
+    std::vector<int> _upperEntries;
+    std::vector<int> _parents;
+    // columns of L, diagonal first
+    std::vector<int> _offsets;
+    std::vector<int> _rows;
+    std::vector<double> _values;
+};
+
+} // namespace meshlib
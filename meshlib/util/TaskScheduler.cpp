@@ -0,0 +1,262 @@
+#include "TaskScheduler.hpp"
+#include "SmallVector.hpp"
+#include <atomic>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace meshlib {
+
+namespace {
+
+// worker threads beyond this are never started, whatever the limit
+constexpr size_t MaxWorkerCount = 255;
+// times an idle worker looks for tasks again before it goes to sleep; waking up costs tens of microseconds
+constexpr int IdleSpinCount = 64;
+
+std::atomic<size_t> globalConcurrencyLimit = 0;
+thread_local size_t scopedConcurrencyLimit = 0;
+// index of the worker running on this thread, -1 for other threads
+thread_local int currentWorker = -1;
+
+size_t globalLimit() {
+    size_t limit = globalConcurrencyLimit.load(std::memory_order_relaxed);
+    return limit > 0 ? limit : hardwareThreadCount();
+}
+
+} // namespace
+
+namespace detail {
+
+struct alignas(64) TaskQueue {
+    std::mutex mutex;
+    std::deque<Task *> tasks;
+};
+
+} // namespace detail
+
+class TaskScheduler {
+  public:
+    static TaskScheduler &instance() {
+        static TaskScheduler scheduler;
+        return scheduler;
+    }
+
+    ~TaskScheduler() {
+        {
+            std::lock_guard lock(_sleepMutex);
+            _stopping = true;
+        }
+        _wake.notify_all();
+        for (auto &thread : _threads) {
+            thread.join();
+        }
+    }
+
+    // the queue for tasks created on this thread
+    detail::TaskQueue &currentQueue() { return currentWorker >= 0 ? _workerQueues[currentWorker] : _sharedQueue; }
+
+    void push(detail::Task *task, detail::TaskQueue &queue) {
+        startWorkers();
+        {
+            std::lock_guard lock(queue.mutex);
+            queue.tasks.push_back(task);
+            // pairs with the sleeping count being raised before the queued count is checked in work()
+            _queuedCount.fetch_add(1);
+        }
+        if (_sleepingCount.load() > 0) {
+            // the worker holds the mutex from checking the queued count until it waits
+            { std::lock_guard lock(_sleepMutex); }
+            _wake.notify_one();
+        }
+    }
+
+    // removes the tasks of group that no worker has taken yet from queue, oldest first
+    template <typename TTasks>
+    void reclaim(detail::TaskQueue &queue, const TaskGroup *group, TTasks &output) {
+        std::lock_guard lock(queue.mutex);
+        auto out = queue.tasks.begin();
+        size_t count = 0;
+        for (auto task : queue.tasks) {
+            if (task->group == group) {
+                output.push_back(task);
+                ++count;
+            } else {
+                *out++ = task;
+            }
+        }
+        queue.tasks.erase(out, queue.tasks.end());
+        _queuedCount.fetch_sub(count);
+    }
+
+    void limitChanged() {
+        { std::lock_guard lock(_sleepMutex); }
+        _wake.notify_all();
+    }
+
+  private:
+    TaskScheduler() : _workerQueues(new detail::TaskQueue[MaxWorkerCount]) {}
+
+    void startWorkers() {
+        size_t count = std::min(MaxWorkerCount, globalLimit() - 1);
+        if (_startedCount.load(std::memory_order_acquire) >= count) {
+            return;
+        }
+        std::lock_guard lock(_startMutex);
+        for (size_t index = _startedCount.load(); index < count; ++index) {
+            _threads.emplace_back([this, index] { work(index); });
+            _startedCount.store(index + 1, std::memory_order_release);
+        }
+    }
+
+    // workers beyond the current limit park, but the others still steal their queued tasks
+    bool isActive(size_t worker) const { return worker + 1 < globalLimit(); }
+
+    void work(size_t index) {
+        currentWorker = int(index);
+        int idleCount = 0;
+        while (true) {
+            if (auto task = isActive(index) ? take(index) : nullptr) {
+                task->group->execute(*task);
+                idleCount = 0;
+                continue;
+            }
+            if (++idleCount < IdleSpinCount) {
+                std::this_thread::yield();
+                continue;
+            }
+            std::unique_lock lock(_sleepMutex);
+            _sleepingCount.fetch_add(1);
+            _wake.wait(lock, [&] { return _stopping || (isActive(index) && _queuedCount.load() > 0); });
+            _sleepingCount.fetch_sub(1);
+            if (_stopping) {
+                return;
+            }
+            idleCount = 0;
+        }
+    }
+
+    // the newest task of the own queue, else the oldest task of another queue
+    detail::Task *take(size_t index) {
+        if (auto task = pop(_workerQueues[index], true)) {
+            return task;
+        }
+        size_t count = _startedCount.load(std::memory_order_acquire);
+        for (size_t i = 1; i < count; ++i) {
+            if (auto task = pop(_workerQueues[(index + i) % count], false)) {
+                return task;
+            }
+        }
+        return pop(_sharedQueue, false);
+    }
+
+    detail::Task *pop(detail::TaskQueue &queue, bool newest) {
+        std::lock_guard lock(queue.mutex);
+        if (queue.tasks.empty()) {
+            return nullptr;
+        }
+        detail::Task *task;
+        if (newest) {
+            task = queue.tasks.back();
+            queue.tasks.pop_back();
+        } else {
+            task = queue.tasks.front();
+            queue.tasks.pop_front();
+        }
+        _queuedCount.fetch_sub(1);
+        return task;
+    }
+
+    std::unique_ptr<detail::TaskQueue[]> _workerQueues;
+    // tasks created on threads outside the pool
+    detail::TaskQueue _sharedQueue;
+    std::atomic<size_t> _startedCount = 0;
+    std::mutex _startMutex;
+    std::vector<std::thread> _threads;
+
+    std::atomic<size_t> _queuedCount = 0;
+    std::atomic<size_t> _sleepingCount = 0;
+    std::mutex _sleepMutex;
+    std::condition_variable _wake;
+    bool _stopping = false;
+};
+
+void setConcurrencyLimit(size_t limit) {
+    globalConcurrencyLimit.store(std::min(limit, MaxWorkerCount + 1));
+    TaskScheduler::instance().limitChanged();
+}
+
+size_t concurrencyLimit() {
+    size_t limit = globalLimit();
+    return scopedConcurrencyLimit > 0 ? std::min(limit, scopedConcurrencyLimit) : limit;
+}
+
+ScopedConcurrencyLimit::ScopedConcurrencyLimit(size_t limit) : _previous(scopedConcurrencyLimit) {
+    limit = std::max<size_t>(1, limit);
+    scopedConcurrencyLimit = _previous > 0 ? std::min(_previous, limit) : limit;
+}
+
+ScopedConcurrencyLimit::~ScopedConcurrencyLimit() { scopedConcurrencyLimit = _previous; }
+
+TaskGroup::~TaskGroup() {
+    try {
+        wait();
+    } catch (...) {
+    }
+}
+
+void TaskGroup::submit(detail::Task &task) {
+    task.group = this;
+    task.concurrencyLimit = concurrencyLimit();
+    {
+        std::lock_guard lock(_mutex);
+        ++_pendingCount;
+    }
+    if (task.concurrencyLimit <= 1) {
+        execute(task);
+        return;
+    }
+    auto &scheduler = TaskScheduler::instance();
+    if (!_queue) {
+        _queue = &scheduler.currentQueue();
+    }
+    scheduler.push(&task, *_queue);
+}
+
+void TaskGroup::execute(detail::Task &task) {
+    size_t previousLimit = std::exchange(scopedConcurrencyLimit, task.concurrencyLimit);
+    try {
+        task.func();
+    } catch (...) {
+        std::lock_guard lock(_mutex);
+        if (!_exception) {
+            _exception = std::current_exception();
+        }
+    }
+    scopedConcurrencyLimit = previousLimit;
+    // wait() returns only after this lock is released, so the group is not destroyed under it
+    std::lock_guard lock(_mutex);
+    if (--_pendingCount == 0) {
+        _finished.notify_all();
+    }
+}
+
+void TaskGroup::wait() {
+    if (_queue) {
+        SmallVector<detail::Task *, 16> unstarted;
+        TaskScheduler::instance().reclaim(*_queue, this, unstarted);
+        for (auto task : unstarted) {
+            execute(*task);
+        }
+    }
+    {
+        std::unique_lock lock(_mutex);
+        _finished.wait(lock, [&] { return _pendingCount == 0; });
+    }
+    _tasks.clear();
+    if (_exception) {
+        std::rethrow_exception(std::exchange(_exception, nullptr));
+    }
+}
+
+} // namespace meshlib
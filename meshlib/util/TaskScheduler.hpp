@@ -0,0 +1,90 @@
+#pragma once
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace meshlib {
+
+// std::thread::hardware_concurrency() queries the system on every call, which costs microseconds
+inline size_t hardwareThreadCount() {
+    static const size_t count = std::max<size_t>(1, std::thread::hardware_concurrency());
+    return count;
+}
+
+// Most threads that the parallel algorithms use at once, including the calling thread; hardwareThreadCount() by
+// default. Lower it when meshlib shares the machine with other work, e.g. in a server; 0 restores the default.
+// Worker threads are started on demand up to the limit and park when it is lowered.
+void setConcurrencyLimit(size_t limit);
+// the limit for parallel work started from this thread: the global one, lowered by ScopedConcurrencyLimit
+size_t concurrencyLimit();
+
+// Lowers the concurrency limit for parallel work started from this thread while in scope, including the work that
+// its tasks start on other threads, e.g. to give one request of a server fewer threads than another
+class ScopedConcurrencyLimit {
+  public:
+    explicit ScopedConcurrencyLimit(size_t limit);
+    ~ScopedConcurrencyLimit();
+
+    ScopedConcurrencyLimit(const ScopedConcurrencyLimit &) = delete;
+    ScopedConcurrencyLimit &operator=(const ScopedConcurrencyLimit &) = delete;
+
+  private:
+    size_t _previous;
+};
+
+class TaskGroup;
+
+namespace detail {
+struct TaskQueue;
+struct Task {
+    std::function<void()> func;
+    TaskGroup *group = nullptr;
+    size_t concurrencyLimit = 1;
+};
+} // namespace detail
+
+// Runs functions on the worker threads of the shared scheduler. Every worker has a deque of tasks: it runs its newest
+// task first, so nested work stays on the thread that created it, and steals the oldest task of another worker when it
+// runs out. wait() runs the tasks of this group that no worker has taken yet on the calling thread and then blocks
+// until the others finish; it never picks up tasks of other groups, so thread-local state such as
+// RegionQuery::forCurrentThread() is not re-entered. The first exception thrown by a task is rethrown by wait().
+// run() and wait() are called by the thread that created the group; tasks may create groups of their own.
+class TaskGroup {
+  public:
+    TaskGroup() = default;
+    TaskGroup(const TaskGroup &) = delete;
+    TaskGroup &operator=(const TaskGroup &) = delete;
+    // waits, dropping exceptions
+    ~TaskGroup();
+
+    template <typename TFunc>
+    void run(TFunc &&func) {
+        auto &task = _tasks.emplace_back();
+        task.func = std::forward<TFunc>(func);
+        submit(task);
+    }
+
+    void wait();
+
+  private:
+    friend class TaskScheduler;
+
+    void submit(detail::Task &task);
+    void execute(detail::Task &task);
+
+    // stable addresses for the queues
+    std::deque<detail::Task> _tasks;
+    // the queue of the thread that owns the group, once it submitted a task
+    detail::TaskQueue *_queue = nullptr;
+    std::mutex _mutex;
+    std::condition_variable _finished;
+    size_t _pendingCount = 0;
+    std::exception_ptr _exception;
+};
+
+} // namespace meshlib